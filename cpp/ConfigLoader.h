@@ -64,6 +64,58 @@ private:
                 {"password", ""},
                 {"charset", "utf8mb4"}
             }},
+            {"pool", {
+                {"min_size", 10},
+                {"max_size", 50},
+                {"min_idle", 2},
+                {"max_idle", 20},
+                {"target_wait_ms", 5},
+                {"replica_min_size", 2}
+            }},
+            {"slow_query", {
+                {"threshold_ms", 200},
+                {"capacity", 256},
+                {"explain", true}
+            }},
+            {"executor", {
+                {"threads", 8},
+                {"queue_limit", 1024}
+            }},
+            {"admission", {
+                {"enabled", true},
+                {"default_endpoint_limit", 64},
+                {"endpoint_limits", {
+                    {"createOrderFromCart", 32},
+                    {"createOrderDirect", 32},
+                    {"processPayment", 32},
+                    {"payOrder", 32}
+                }},
+                {"user_rate_per_second", 20},
+                {"user_burst", 40},
+                {"initial_limit", 64},
+                {"min_limit", 8},
+                {"max_limit", 512}
+            }},
+            {"single_flight", {
+                {"product_ttl_ms", 0},
+                {"promotion_ttl_ms", 200}
+            }},
+            {"cart_store", {
+                {"flush_interval_ms", 200},
+                {"batch_rows", 500},
+                {"max_users", 200000}
+            }},
+            {"session", {
+                {"ttl_seconds", 1800},
+                {"snapshot_file", ""},
+                {"snapshot_interval_seconds", 60}
+            }},
+            {"tracing", {
+                {"enabled", false},
+                {"file", "emshop_trace.json"},
+                {"sample_percent", 100},
+                {"max_size_mb", 100}
+            }},
             {"server", {
                 {"port", 8888},
                 {"max_connections", 100},
@@ -102,6 +154,22 @@ private:
         if (!getEnv("DB_PASSWORD").empty()) 
             config["database"]["password"] = getEnv("DB_PASSWORD");
         
+        // 连接池配置
+        if (!getEnv("DB_POOL_MIN_SIZE").empty()) 
+            config["pool"]["min_size"] = std::stoi(getEnv("DB_POOL_MIN_SIZE"));
+        if (!getEnv("DB_POOL_MAX_SIZE").empty()) 
+            config["pool"]["max_size"] = std::stoi(getEnv("DB_POOL_MAX_SIZE"));
+        
+        // 慢查询配置
+        if (!getEnv("SLOW_QUERY_THRESHOLD_MS").empty()) 
+            config["slow_query"]["threshold_ms"] = std::stoi(getEnv("SLOW_QUERY_THRESHOLD_MS"));
+        
+        // 链路追踪配置
+        if (!getEnv("TRACE_ENABLED").empty()) 
+            config["tracing"]["enabled"] = (getEnv("TRACE_ENABLED") == "true" || getEnv("TRACE_ENABLED") == "1");
+        if (!getEnv("TRACE_FILE").empty()) 
+            config["tracing"]["file"] = getEnv("TRACE_FILE");
+        
         // 服务器配置
         if (!getEnv("SERVER_PORT").empty()) 
             config["server"]["port"] = std::stoi(getEnv("SERVER_PORT"));
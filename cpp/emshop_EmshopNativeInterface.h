@@ -47,6 +47,14 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_register
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_logout
   (JNIEnv *, jclass, jlong);
 
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    validateToken
+ * Signature: (Ljava/lang/String;)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_validateToken
+  (JNIEnv *, jclass, jstring);
+
 /*
  * Class:     emshop_EmshopNativeInterface
  * Method:    getUserInfo
@@ -71,6 +79,14 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_updateUserInfo
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getProductList
   (JNIEnv *, jclass, jstring, jint, jint);
 
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    getProductListByCursor
+ * Signature: (Ljava/lang/String;Ljava/lang/String;IZ)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getProductListByCursor
+  (JNIEnv *, jclass, jstring, jstring, jint, jboolean);
+
 /*
  * Class:     emshop_EmshopNativeInterface
  * Method:    getProductDetail
@@ -303,6 +319,14 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_requestRefund__JLjav
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getAllOrders
   (JNIEnv *, jclass, jstring, jint, jint, jstring, jstring);
 
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    getAllOrdersByCursor
+ * Signature: (Ljava/lang/String;Ljava/lang/String;ILjava/lang/String;Ljava/lang/String;Z)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getAllOrdersByCursor
+  (JNIEnv *, jclass, jstring, jstring, jint, jstring, jstring, jboolean);
+
 /*
  * Class:     emshop_EmshopNativeInterface
  * Method:    getActivePromotions
@@ -527,6 +551,78 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSystemLogs
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSystemMetrics
   (JNIEnv *, jclass);
 
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    getSlowQueryLog
+ * Signature: (Ljava/lang/String;)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSlowQueryLog
+  (JNIEnv *, jclass, jstring);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    runNativeBenchmark
+ * Signature: (Ljava/lang/String;Ljava/lang/String;)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_runNativeBenchmark
+  (JNIEnv *, jclass, jstring, jstring);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    beginTrace
+ * Signature: (Ljava/lang/String;Ljava/lang/String;)V
+ */
+JNIEXPORT void JNICALL Java_emshop_EmshopNativeInterface_beginTrace
+  (JNIEnv *, jclass, jstring, jstring);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    endTrace
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_emshop_EmshopNativeInterface_endTrace
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    getProductListDirect
+ * Signature: (Ljava/nio/ByteBuffer;Ljava/lang/String;II)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL Java_emshop_EmshopNativeInterface_getProductListDirect
+  (JNIEnv *, jclass, jobject, jstring, jint, jint);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    searchProductsDirect
+ * Signature: (Ljava/nio/ByteBuffer;Ljava/lang/String;IILjava/lang/String;DD)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL Java_emshop_EmshopNativeInterface_searchProductsDirect
+  (JNIEnv *, jclass, jobject, jstring, jint, jint, jstring, jdouble, jdouble);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    getOrderListDirect
+ * Signature: (Ljava/nio/ByteBuffer;J)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL Java_emshop_EmshopNativeInterface_getOrderListDirect
+  (JNIEnv *, jclass, jobject, jlong);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    getAllOrdersDirect
+ * Signature: (Ljava/nio/ByteBuffer;Ljava/lang/String;IILjava/lang/String;Ljava/lang/String;)Ljava/nio/ByteBuffer;
+ */
+JNIEXPORT jobject JNICALL Java_emshop_EmshopNativeInterface_getAllOrdersDirect
+  (JNIEnv *, jclass, jobject, jstring, jint, jint, jstring, jstring);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    releaseDirectBuffer
+ * Signature: (Ljava/nio/ByteBuffer;)V
+ */
+JNIEXPORT void JNICALL Java_emshop_EmshopNativeInterface_releaseDirectBuffer
+  (JNIEnv *, jclass, jobject);
+
 /*
  * Class:     emshop_EmshopNativeInterface
  * Method:    getActiveConnections
@@ -567,6 +663,30 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getDatabaseSchema
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_executeBatch
   (JNIEnv *, jclass, jstring);
 
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    executeCommandBatch
+ * Signature: (Ljava/lang/String;)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_executeCommandBatch
+  (JNIEnv *, jclass, jstring);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    registerCompletionHandler
+ * Signature: (Lemshop/NativeCompletionHandler;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_emshop_EmshopNativeInterface_registerCompletionHandler
+  (JNIEnv *, jclass, jobject);
+
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    submitCommand
+ * Signature: (JLjava/lang/String;Ljava/lang/String;)Z
+ */
+JNIEXPORT jboolean JNICALL Java_emshop_EmshopNativeInterface_submitCommand
+  (JNIEnv *, jclass, jlong, jstring, jstring);
+
 /*
  * Class:     emshop_EmshopNativeInterface
  * Method:    addUserAddress
@@ -743,6 +863,14 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getReviewStatistics
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getAllUsers
   (JNIEnv *, jclass, jint, jint, jstring);
 
+/*
+ * Class:     emshop_EmshopNativeInterface
+ * Method:    getAllUsersByCursor
+ * Signature: (Ljava/lang/String;ILjava/lang/String;Ljava/lang/String;Z)Ljava/lang/String;
+ */
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getAllUsersByCursor
+  (JNIEnv *, jclass, jstring, jint, jstring, jstring, jboolean);
+
 /*
  * Class:     emshop_EmshopNativeInterface
  * Method:    searchUsers
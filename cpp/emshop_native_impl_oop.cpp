@@ -17,10 +17,14 @@
 #include <string>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <condition_variable>
 #include <thread>
 #include <chrono>
 #include <queue>
+#include <future>
+#include <deque>
+#include <list>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -35,7 +39,15 @@
 #include <random>
 #include <iomanip>
 #include <ctime>
+#include <cmath>
 #include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <array>
+#include <limits>
+#include <tuple>
+#include <cerrno>
 
 // 特定配置
 #ifdef _WIN32
@@ -44,12 +56,26 @@
         #define NOMINMAX
     #endif
     #include <windows.h>
+    #include <psapi.h>
+    #include <ntsecapi.h>
+    #include <io.h>
+    #include <fcntl.h>
+    #include <sys/stat.h>
     #undef ERROR
+#else
+    #include <sys/resource.h>
+    #include <sys/random.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
 #endif
 
 // 第三方库头文件 
 #include <mysql.h>
+#include <errmsg.h>
+#include <mysqld_error.h>
 #include "nlohmann_json.hpp"
+#include "ConfigLoader.h"
 #include "emshop_EmshopNativeInterface.h"
 
 // 命名空间和别名 
@@ -69,6 +95,106 @@ namespace Constants {
     const int INITIAL_POOL_SIZE = 10;  // 初始连接数增加到10
     const int MAX_POOL_SIZE = 50;      // 最大连接数增加到50
     const int CONNECTION_TIMEOUT = 60; // 连接超时增加到60秒
+    const int MAX_POOL_SHARDS = 16;    // 连接池分片上限，实际分片数取CPU核数
+    const int CONNECTION_VALIDATE_IDLE_SECONDS = 30; // 空闲超过该时长的连接在借出前才做ping检查
+    const size_t STATEMENT_CACHE_SIZE = 64; // 每个连接缓存的预处理语句上限
+    
+    // 连接池自适应配置(默认值，可在config.json的pool节覆盖)
+    const int POOL_MIN_IDLE = 2;                // 目标空闲连接数下限
+    const int POOL_MAX_IDLE = 20;               // 目标空闲连接数上限
+    const int POOL_TARGET_WAIT_MS = 5;          // 借连接等待时间p99目标，超出后扩大预热
+    const int POOL_CONTROL_INTERVAL_MS = 1000;  // 目标空闲数调整周期
+    const int POOL_SHRINK_WINDOWS = 30;         // 连续多少个周期有富余空闲连接才下调目标
+    const int POOL_PREWARM_BATCH = 4;           // 后台每轮最多新建/关闭的连接数
+    
+    // 读写分离配置
+    const int REPLICA_INITIAL_POOL_SIZE = 2;         // 每个只读副本的初始连接数
+    const int REPLICA_HEALTH_CHECK_SECONDS = 5;      // 副本可用性与复制延迟检查间隔
+    const int REPLICA_MAX_LAG_SECONDS = 10;          // 复制延迟超过该值的副本不再接收读请求
+    const int READ_YOUR_WRITES_SECONDS = 5;          // 用户写入后该时长内的读请求固定走主库
+    const size_t READ_YOUR_WRITES_CAPACITY = 65536;  // 最多跟踪的近期写入用户数
+    
+    // 日志配置
+    const size_t LOG_RING_CAPACITY = 16384;  // 异步日志队列容量(必须是2的幂)
+    const int LOG_FLUSH_INTERVAL_MS = 100;   // 后台线程空闲时的最长等待时间
+    const int LOG_FULL_RETRIES = 64;         // 队列满时WARN/ERROR的重试次数，之后丢弃
+    const int LOG_MAX_FILE_MB = 50;          // 单个日志文件上限(可在config.json的logging节覆盖)
+    const int LOG_MAX_FILES = 10;            // 保留的历史日志文件数
+    
+    // 商品目录缓存配置
+    const size_t CATALOG_CACHE_SHARDS = 16;          // 缓存分片数
+    const size_t CATALOG_CACHE_CAPACITY = 4096;      // 每类缓存的最大条目数
+    const int CATALOG_DETAIL_TTL_SECONDS = 60;       // 商品详情/分类缓存有效期
+    const int CATALOG_LIST_TTL_SECONDS = 30;         // 商品列表缓存有效期
+    const int LIST_TOTAL_CACHE_TTL_SECONDS = 30;     // 游标分页总数缓存有效期
+    const size_t SINGLE_FLIGHT_SHARDS = 16;          // 请求合并表的分片数
+    const int SINGLE_FLIGHT_PRODUCT_TTL_MS = 0;      // 单商品查询结果的复用时间(可在config.json的single_flight节覆盖)，0表示只合并并发调用
+    const int SINGLE_FLIGHT_PROMOTION_TTL_MS = 200;  // 有效促销查询结果的复用时间
+    
+    // 购物车写回存储配置
+    const size_t CART_STORE_SHARDS = 64;             // 内存购物车分片数
+    const size_t CART_STORE_MAX_USERS = 200000;      // 内存中最多保留的购物车数(可在config.json的cart_store节覆盖)
+    const int CART_FLUSH_INTERVAL_MS = 200;          // 修改写回cart表的周期
+    const size_t CART_FLUSH_BATCH_ROWS = 500;        // 每个写回事务的最大行数，脏行积压到该值时提前写回
+    const int CART_FLUSH_MAX_BACKOFF_MS = 5000;      // 写回失败后的最长重试间隔
+    const int CART_FLUSH_MAX_ATTEMPTS = 5;           // 单个用户不可重试的写回失败达到该次数后，丢弃内存购物车并从cart表重新加载
+    
+    // 会话存储配置
+    const size_t SESSION_STORE_SHARDS = 64;          // 会话表分片数
+    const int SESSION_TTL_SECONDS = 1800;            // 会话空闲有效期，每次校验后顺延(可在config.json的session节覆盖)
+    const size_t SESSION_WHEEL_SLOTS = 4096;         // 过期时间轮格数(1秒一格)，更长的有效期按圈数处理
+    const int SESSION_SNAPSHOT_INTERVAL_SECONDS = 60; // 配置了快照文件时的写入间隔
+    
+    // 业务分段锁配置
+    const size_t BUSINESS_LOCK_STRIPES = 256;        // 每张锁表的分段数
+    
+    // 批量写入配置
+    const size_t BULK_INSERT_MAX_ROWS = 1000;                    // 单条多行INSERT的最大行数
+    const size_t BULK_INSERT_MAX_STATEMENT_BYTES = 4 * 1024 * 1024; // 单条语句上限(同时受max_allowed_packet限制)
+    
+    // 商品搜索索引配置
+    const int SEARCH_INDEX_REFRESH_SECONDS = 600;     // 全量重建间隔(兜底其他进程直接改库)
+    const int SEARCH_INDEX_LOAD_BATCH = 5000;         // 全量加载每批读取的商品数
+    const int SEARCH_INDEX_RETRY_SECONDS = 30;        // 重建失败后再次尝试的间隔
+    const size_t SEARCH_PREFIX_EXPANSION_LIMIT = 64;  // 英文前缀匹配最多展开的词项数
+    
+    // 异步查询引擎配置
+    const size_t ASYNC_QUERY_THREADS = 8;             // I/O线程数(每个线程同一时刻占用一个连接)
+    const size_t ASYNC_QUERY_QUEUE_LIMIT = 4096;      // 排队上限，超出后由调用线程直接执行
+    
+    // 服务命令执行器配置
+    const int COMMAND_EXECUTOR_THREADS = 8;           // 工作线程数(可在config.json的executor节覆盖，0表示按CPU核数)
+    const size_t COMMAND_EXECUTOR_QUEUE_LIMIT = 1024; // 排队上限，超出后批量命令由调用线程执行，异步请求被拒绝
+    const size_t COMMAND_BATCH_MAX = 32;              // 单次批量命令数上限
+    
+    // 查询统计配置
+    const size_t QUERY_METRICS_MAX_FINGERPRINTS = 1024;  // 最多区分的SQL指纹数，超出后合并为"(其他)"
+    const size_t QUERY_METRICS_TOP_N = 20;               // 指标接口返回的慢查询指纹数
+    const size_t QUERY_FINGERPRINT_MAX_LENGTH = 2048;    // 指纹文本截断长度
+    const int SLOW_QUERY_THRESHOLD_MS = 200;             // 慢查询阈值(可在config.json的slow_query节覆盖)，0表示关闭
+    const size_t SLOW_QUERY_LOG_CAPACITY = 256;          // 慢查询环形缓冲区容量
+    const size_t SLOW_QUERY_SQL_MAX_LENGTH = 4096;       // 慢查询记录中SQL原文的截断长度
+    
+    // 链路追踪配置
+    const size_t TRACE_MAX_SPANS = 4096;            // 单次追踪最多记录的span数，超出后只计数
+    const size_t TRACE_EXPORT_QUEUE_LIMIT = 1024;   // 等待导出的追踪上限，超出后丢弃
+    const int TRACE_MAX_FILE_MB = 100;              // 追踪文件上限，超出后轮转为.1(可在config.json的tracing节覆盖)
+    
+    // JNI直接缓冲区配置
+    const size_t DIRECT_BUFFER_POOL_SIZE = 8;                        // 归还后留作复用的缓冲区数
+    const size_t DIRECT_BUFFER_MAX_POOLED_BYTES = 16 * 1024 * 1024;  // 容量超过该值的缓冲区归还后直接释放
+    const size_t DIRECT_BUFFER_LEASE_WARN = 1024;                    // 未归还的缓冲区超过该数量时告警(Java端漏调release)
+    
+    // 准入控制配置(可在config.json的admission节覆盖)
+    const int ADMISSION_ENDPOINT_LIMIT = 64;       // 单个JNI接口的默认并发上限
+    const int ADMISSION_USER_RATE = 20;            // 每个用户每秒补充的令牌数，0表示不限速
+    const int ADMISSION_USER_BURST = 40;           // 每个用户令牌桶的容量
+    const int ADMISSION_INITIAL_LIMIT = 64;        // 全局自适应并发上限的初值和范围
+    const int ADMISSION_MIN_LIMIT = 8;
+    const int ADMISSION_MAX_LIMIT = 512;
+    const double ADMISSION_RTT_TOLERANCE = 1.5;    // 短期延迟在长期基线的该倍数以内时不收缩上限
+    const size_t ADMISSION_USER_SHARDS = 16;
+    const size_t ADMISSION_USER_BUCKETS_PER_SHARD = 4096;  // 超出后清理已回满的令牌桶
     
     // 业务常量
     const int DEFAULT_PAGE_SIZE = 20;
@@ -124,62 +250,351 @@ enum class LogLevel {
 
 // 工具类定义
 
+// 异步日志：业务线程只把日志放进无锁环形队列(多生产者单消费者)，由后台线程批量格式化写出。
+// 级别检查在拼接消息之前完成，被过滤的日志不产生任何字符串开销。
+// 队列满时DEBUG/INFO直接丢弃，WARN/ERROR短暂让出CPU重试后再丢弃，丢弃数由后台线程定期汇报
 class Logger {
 private:
-    static std::mutex log_mutex_;
-    static LogLevel current_level_;
-    static std::ofstream log_file_;
+    static_assert((Constants::LOG_RING_CAPACITY & (Constants::LOG_RING_CAPACITY - 1)) == 0,
+                  "LOG_RING_CAPACITY必须是2的幂");
+    
+    struct Record {
+        std::atomic<size_t> sequence;
+        LogLevel level;
+        std::chrono::system_clock::time_point time;
+        std::string message;
+    };
+    
+    struct State {
+        std::atomic<int> level{static_cast<int>(LogLevel::INFO)};
+        
+        std::unique_ptr<Record[]> ring;
+        size_t mask = 0;
+        std::atomic<size_t> enqueue_pos{0};
+        size_t dequeue_pos = 0;                 // 仅后台线程访问
+        
+        std::atomic<bool> running{false};
+        std::atomic<bool> writer_idle{false};
+        std::atomic<uint64_t> dropped{0};
+        uint64_t reported_dropped = 0;          // 仅后台线程访问
+        std::mutex wakeup_mutex;
+        std::condition_variable wakeup;
+        std::thread writer;
+        std::mutex lifecycle_mutex;
+        
+        // 输出端(文件、控制台和时间前缀缓存)，由output_mutex保护
+        std::mutex output_mutex;
+        std::string path;
+        std::ofstream file;
+        size_t file_bytes = 0;
+        int file_day = -1;
+        size_t max_file_bytes = static_cast<size_t>(Constants::LOG_MAX_FILE_MB) * 1024 * 1024;
+        int max_files = Constants::LOG_MAX_FILES;
+        std::time_t cached_second = 0;
+        std::string cached_stamp;
+        
+        State() : ring(new Record[Constants::LOG_RING_CAPACITY]), mask(Constants::LOG_RING_CAPACITY - 1) {
+            for (size_t i = 0; i < Constants::LOG_RING_CAPACITY; ++i) {
+                ring[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+    };
+    
+    // 有意不析构：其他单例析构时仍可能写日志。进程退出时由ShutdownGuard冲刷队列
+    static State& state() {
+        static State* instance = new State();
+        return *instance;
+    }
+    
+    struct ShutdownGuard {
+        ~ShutdownGuard() { Logger::shutdown(); }
+    };
+    
+    static const char* levelName(LogLevel level) {
+        switch (level) {
+            case LogLevel::DEBUG: return "DEBUG";
+            case LogLevel::INFO: return "INFO";
+            case LogLevel::WARN: return "WARN";
+            case LogLevel::ERROR_LEVEL: return "ERROR";
+        }
+        return "INFO";
+    }
+    
+    static std::tm localTime(std::time_t seconds) {
+        std::tm result{};
+#ifdef _WIN32
+        localtime_s(&result, &seconds);
+#else
+        localtime_r(&seconds, &result);
+#endif
+        return result;
+    }
+    
+    template <typename T>
+    static void appendPart(std::string& out, const T& value) {
+        if constexpr (std::is_same<T, bool>::value) {
+            out.append(value ? "true" : "false");
+        } else if constexpr (std::is_same<T, char>::value) {
+            out.push_back(value);
+        } else if constexpr (std::is_arithmetic<T>::value) {
+            out.append(std::to_string(value));
+        } else {
+            out.append(value);
+        }
+    }
+    
+    // 按秒缓存时间前缀，同一秒内的日志不重复格式化时间
+    static void formatRecord(State& s, LogLevel level, std::chrono::system_clock::time_point time,
+                             const std::string& message, std::string& out) {
+        std::time_t seconds = std::chrono::system_clock::to_time_t(time);
+        if (seconds != s.cached_second || s.cached_stamp.empty()) {
+            std::tm tm = localTime(seconds);
+            char buffer[32];
+            std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+            s.cached_stamp = buffer;
+            s.cached_second = seconds;
+        }
+        out.append(s.cached_stamp);
+        out.append(" [");
+        out.append(levelName(level));
+        out.append("] ");
+        out.append(message);
+        out.push_back('\n');
+    }
+    
+    // 按大小或跨天轮转：emshop.log -> emshop.log.1 -> ... -> emshop.log.N(最旧的删除)
+    static void rotateIfNeeded(State& s, size_t incoming) {
+        if (!s.file.is_open()) {
+            return;
+        }
+        int today = localTime(std::time(nullptr)).tm_yday;
+        bool too_large = s.max_file_bytes > 0 && s.file_bytes > 0 && s.file_bytes + incoming > s.max_file_bytes;
+        bool new_day = s.file_day >= 0 && today != s.file_day && s.file_bytes > 0;
+        if (!too_large && !new_day) {
+            s.file_day = today;
+            return;
+        }
+        s.file.close();
+        if (s.max_files > 0) {
+            std::remove((s.path + "." + std::to_string(s.max_files)).c_str());
+            for (int i = s.max_files - 1; i >= 1; --i) {
+                std::rename((s.path + "." + std::to_string(i)).c_str(), (s.path + "." + std::to_string(i + 1)).c_str());
+            }
+            std::rename(s.path.c_str(), (s.path + ".1").c_str());
+        } else {
+            std::remove(s.path.c_str());
+        }
+        s.file.open(s.path, std::ios::app | std::ios::binary);
+        s.file_bytes = 0;
+        s.file_day = today;
+    }
+    
+    static void writeBatch(State& s, const std::string& batch) {
+        if (batch.empty()) {
+            return;
+        }
+        std::cout.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+        std::cout.flush();
+        rotateIfNeeded(s, batch.size());
+        if (s.file.is_open()) {
+            s.file.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+            s.file.flush();
+            s.file_bytes += batch.size();
+        }
+    }
+    
+    static bool tryEnqueue(State& s, LogLevel level, std::string& message) {
+        size_t pos = s.enqueue_pos.load(std::memory_order_relaxed);
+        Record* record = nullptr;
+        while (true) {
+            record = &s.ring[pos & s.mask];
+            size_t sequence = record->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (s.enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // 队列已满
+            } else {
+                pos = s.enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+        record->level = level;
+        record->time = std::chrono::system_clock::now();
+        record->message = std::move(message);
+        record->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // 取出队列中现有的日志并格式化到batch，返回条数
+    static size_t drain(State& s, std::string& batch) {
+        size_t count = 0;
+        while (count < Constants::LOG_RING_CAPACITY) {
+            Record& record = s.ring[s.dequeue_pos & s.mask];
+            if (record.sequence.load(std::memory_order_acquire) != s.dequeue_pos + 1) {
+                break;
+            }
+            formatRecord(s, record.level, record.time, record.message, batch);
+            record.message.clear();
+            record.sequence.store(s.dequeue_pos + Constants::LOG_RING_CAPACITY, std::memory_order_release);
+            ++s.dequeue_pos;
+            ++count;
+        }
+        return count;
+    }
+    
+    static void reportDropped(State& s, std::string& batch) {
+        uint64_t dropped = s.dropped.load(std::memory_order_relaxed);
+        if (dropped != s.reported_dropped) {
+            formatRecord(s, LogLevel::WARN, std::chrono::system_clock::now(),
+                         "日志队列已满，累计丢弃 " + std::to_string(dropped) + " 条日志", batch);
+            s.reported_dropped = dropped;
+        }
+    }
+    
+    static void writerLoop() {
+        State& s = state();
+        std::string batch;
+        batch.reserve(64 * 1024);
+        while (true) {
+            size_t count = 0;
+            {
+                // 正常运行时只有本线程写输出端，这把锁只在启停切换时才有竞争
+                std::lock_guard<std::mutex> lock(s.output_mutex);
+                batch.clear();
+                count = drain(s, batch);
+                reportDropped(s, batch);
+                writeBatch(s, batch);
+            }
+            if (count > 0) {
+                continue;
+            }
+            if (!s.running.load(std::memory_order_acquire)) {
+                return;  // 停止标志在最后一次取空队列之前设置，队列已写完
+            }
+            std::unique_lock<std::mutex> lock(s.wakeup_mutex);
+            s.writer_idle.store(true, std::memory_order_seq_cst);
+            s.wakeup.wait_for(lock, std::chrono::milliseconds(Constants::LOG_FLUSH_INTERVAL_MS));
+            s.writer_idle.store(false, std::memory_order_relaxed);
+        }
+    }
+    
+    // 后台线程未运行(初始化前或关闭后)时直接同步写出
+    static void writeSync(State& s, LogLevel level, const std::string& message) {
+        std::lock_guard<std::mutex> lock(s.output_mutex);
+        std::string line;
+        formatRecord(s, level, std::chrono::system_clock::now(), message, line);
+        writeBatch(s, line);
+    }
     
 public:
     static void initialize(const std::string& log_file_path = "emshop.log") {
-        std::lock_guard<std::mutex> lock(log_mutex_);
-        if (!log_file_.is_open()) {
-            log_file_.open(log_file_path, std::ios::app);
+        static ShutdownGuard guard;
+        State& s = state();
+        std::lock_guard<std::mutex> lifecycle(s.lifecycle_mutex);
+        {
+            std::lock_guard<std::mutex> lock(s.output_mutex);
+            if (!s.file.is_open()) {
+                s.path = log_file_path;
+                s.file.open(log_file_path, std::ios::app | std::ios::binary);
+                s.file.seekp(0, std::ios::end);
+                std::streamoff size = s.file.tellp();
+                s.file_bytes = size > 0 ? static_cast<size_t>(size) : 0;
+                s.file_day = localTime(std::time(nullptr)).tm_yday;
+            }
+        }
+        if (!s.running.load()) {
+            s.running.store(true, std::memory_order_release);
+            s.writer = std::thread(&Logger::writerLoop);
+        }
+    }
+    
+    // 日志文件轮转参数，max_file_mb为0表示不按大小轮转
+    static void configureRotation(int max_file_mb, int max_files) {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.output_mutex);
+        s.max_file_bytes = static_cast<size_t>(std::max(0, max_file_mb)) * 1024 * 1024;
+        s.max_files = std::max(0, max_files);
+    }
+    
+    // 停止后台线程并写完队列中的日志，之后的日志改为同步写出
+    static void shutdown() {
+        State& s = state();
+        std::lock_guard<std::mutex> lifecycle(s.lifecycle_mutex);
+        if (!s.running.load()) {
+            return;
+        }
+        s.running.store(false, std::memory_order_release);
+        s.wakeup.notify_one();
+        if (s.writer.joinable()) {
+            s.writer.join();
         }
+        std::lock_guard<std::mutex> lock(s.output_mutex);
+        std::string batch;
+        drain(s, batch);
+        writeBatch(s, batch);
     }
     
     static void setLevel(LogLevel level) {
-        current_level_ = level;
+        state().level.store(static_cast<int>(level), std::memory_order_relaxed);
     }
     
-    static void log(LogLevel level, const std::string& message) {
-        if (level < current_level_) return;
-        
-        std::lock_guard<std::mutex> lock(log_mutex_);
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
+    static bool isEnabled(LogLevel level) {
+        return static_cast<int>(level) >= state().level.load(std::memory_order_relaxed);
+    }
+    
+    static uint64_t droppedCount() {
+        return state().dropped.load(std::memory_order_relaxed);
+    }
+    
+    static void log(LogLevel level, std::string message) {
+        if (!isEnabled(level)) return;
         
-        std::string level_str;
-        switch (level) {
-            case LogLevel::DEBUG: level_str = "DEBUG"; break;
-            case LogLevel::INFO: level_str = "INFO"; break;
-            case LogLevel::WARN: level_str = "WARN"; break;
-            case LogLevel::ERROR_LEVEL: level_str = "ERROR"; break;
+        State& s = state();
+        if (!s.running.load(std::memory_order_acquire)) {
+            writeSync(s, level, message);
+            return;
         }
         
-        std::ostringstream oss;
-        oss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-        oss << " [" << level_str << "] " << message << std::endl;
-        
-        std::string log_entry = oss.str();
-        std::cout << log_entry;
-        if (log_file_.is_open()) {
-            log_file_ << log_entry;
-            log_file_.flush();
+        bool queued = tryEnqueue(s, level, message);
+        for (int attempt = 0; !queued && level >= LogLevel::WARN && attempt < Constants::LOG_FULL_RETRIES; ++attempt) {
+            std::this_thread::yield();
+            queued = tryEnqueue(s, level, message);
+        }
+        if (!queued) {
+            s.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (s.writer_idle.load(std::memory_order_seq_cst)) {
+            s.wakeup.notify_one();
         }
     }
     
-    static void debug(const std::string& message) { log(LogLevel::DEBUG, message); }
-    static void info(const std::string& message) { log(LogLevel::INFO, message); }
-    static void warn(const std::string& message) { log(LogLevel::WARN, message); }
-    static void error(const std::string& message) { log(LogLevel::ERROR_LEVEL, message); }
+    // 多个参数时先检查级别再拼接，如 Logger::debug("执行SQL: ", sql)；数值直接传入即可
+    template <typename... Args>
+    static void write(LogLevel level, const Args&... args) {
+        if (!isEnabled(level)) return;
+        std::string message;
+        (appendPart(message, args), ...);
+        log(level, std::move(message));
+    }
+    
+    static void debug(std::string message) { log(LogLevel::DEBUG, std::move(message)); }
+    static void info(std::string message) { log(LogLevel::INFO, std::move(message)); }
+    static void warn(std::string message) { log(LogLevel::WARN, std::move(message)); }
+    static void error(std::string message) { log(LogLevel::ERROR_LEVEL, std::move(message)); }
+    
+    template <typename... Args>
+    static void debug(const Args&... args) { write(LogLevel::DEBUG, args...); }
+    template <typename... Args>
+    static void info(const Args&... args) { write(LogLevel::INFO, args...); }
+    template <typename... Args>
+    static void warn(const Args&... args) { write(LogLevel::WARN, args...); }
+    template <typename... Args>
+    static void error(const Args&... args) { write(LogLevel::ERROR_LEVEL, args...); }
 };
 
-// 静态成员初始化
-std::mutex Logger::log_mutex_;
-LogLevel Logger::current_level_ = LogLevel::INFO;
-std::ofstream Logger::log_file_;
-
 class StringUtils {
 public:
     // 去除字符串两端空白字符
@@ -231,20 +646,548 @@ public:
         return std::regex_match(phone, pattern);
     }
     
-    // 生成随机字符串
+    // 从操作系统的密码学安全随机源读取字节，失败时返回false
+    static bool fillSecureRandom(unsigned char* buffer, size_t length) {
+#ifdef _WIN32
+        return RtlGenRandom(buffer, static_cast<ULONG>(length)) != FALSE;
+#else
+        size_t filled = 0;
+        while (filled < length) {
+            ssize_t n = getrandom(buffer + filled, length - filled, 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            filled += static_cast<size_t>(n);
+        }
+        return true;
+#endif
+    }
+    
+    // 生成随机字符串(用作登录令牌等凭据)，字符取自系统安全随机源，每个字符约5.95位熵；
+    // 随机源不可用时抛出异常而不是退化为可预测的伪随机数
     static std::string generateRandomString(size_t length) {
-        const std::string charset = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
-        std::random_device rd;
-        std::mt19937 generator(rd());
-        std::uniform_int_distribution<> distribution(0, charset.size() - 1);
+        static const char charset[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        const unsigned int charset_size = sizeof(charset) - 1;
+        // 丢弃不小于62的最大整数倍(248)的字节，保证各字符等概率
+        const unsigned int limit = 256 - 256 % charset_size;
         
         std::string result;
         result.reserve(length);
-        for (size_t i = 0; i < length; ++i) {
-            result += charset[distribution(generator)];
+        unsigned char buffer[64];
+        while (result.size() < length) {
+            if (!fillSecureRandom(buffer, sizeof(buffer))) {
+                throw std::runtime_error("系统安全随机源不可用");
+            }
+            for (size_t i = 0; i < sizeof(buffer) && result.size() < length; ++i) {
+                if (buffer[i] < limit) {
+                    result += charset[buffer[i] % charset_size];
+                }
+            }
         }
         return result;
     }
+    
+    // URL安全的Base64编码(无填充)
+    static std::string base64UrlEncode(const std::string& input) {
+        static const char* const alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+        std::string output;
+        output.reserve((input.size() + 2) / 3 * 4);
+        
+        unsigned int buffer = 0;
+        int bits = 0;
+        for (unsigned char c : input) {
+            buffer = (buffer << 8) | c;
+            bits += 8;
+            while (bits >= 6) {
+                bits -= 6;
+                output += alphabet[(buffer >> bits) & 0x3F];
+            }
+        }
+        if (bits > 0) {
+            output += alphabet[(buffer << (6 - bits)) & 0x3F];
+        }
+        return output;
+    }
+    
+    // URL安全的Base64解码，遇到非法字符返回false
+    static bool base64UrlDecode(const std::string& input, std::string& output) {
+        output.clear();
+        unsigned int buffer = 0;
+        int bits = 0;
+        for (char c : input) {
+            int value;
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '-' || c == '+') value = 62;
+            else if (c == '_' || c == '/') value = 63;
+            else if (c == '=') break;
+            else return false;
+            
+            buffer = (buffer << 6) | static_cast<unsigned int>(value);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                output += static_cast<char>((buffer >> bits) & 0xFF);
+            }
+        }
+        return true;
+    }
+};
+
+// 链路追踪：Java层的traceId经JNI绑定到当前线程，之后该线程上的数据库调用、连接池等待和
+// JSON序列化等由TraceSpan按纳秒计时。span栈和已完成的span都放在线程局部上下文中，不加锁；
+// 线程上没有进行中的追踪时TraceSpan只检查一次线程局部标志。
+// 追踪结束后整批span交给后台线程，按Chrome trace-event格式追加写入文件，
+// 可用chrome://tracing或Perfetto直接打开；同一trace_id在其他线程(如异步查询)上的span按tid区分
+class Tracer {
+private:
+    struct Span {
+        const char* name;      // 只接受字符串字面量
+        const char* category;
+        uint64_t id;
+        uint64_t parent;
+        int64_t start_ns;
+        int64_t end_ns;
+        std::string detail;
+    };
+    
+    struct Context {
+        bool active = false;
+        std::string trace_id;
+        std::string name;
+        uint32_t thread_id = 0;
+        uint64_t next_id = 0;   // 线程内单调递增，不随追踪重置，避免跨追踪的span错配
+        uint64_t root_id = 0;
+        int64_t start_ns = 0;
+        uint64_t dropped_spans = 0;
+        std::vector<uint64_t> open;
+        std::vector<Span> spans;
+    };
+    
+    struct FinishedTrace {
+        std::string trace_id;
+        std::string name;
+        uint32_t thread_id = 0;
+        uint64_t root_id = 0;
+        int64_t start_ns = 0;
+        int64_t end_ns = 0;
+        uint64_t dropped_spans = 0;
+        std::vector<Span> spans;
+    };
+    
+    std::atomic<bool> enabled_;
+    bool configured_enabled_;
+    int sample_percent_;
+    std::string path_;
+    size_t max_file_bytes_;
+    int64_t epoch_ns_;
+    long long pid_;
+    
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<FinishedTrace> queue_;
+    std::thread writer_;
+    bool running_;
+    
+    // 以下只由写线程访问
+    std::ofstream file_;
+    size_t file_bytes_;
+    std::unordered_set<uint32_t> named_threads_;
+    
+    std::atomic<uint64_t> exported_;
+    std::atomic<uint64_t> dropped_traces_;
+    std::atomic<uint64_t> dropped_spans_;
+    
+    Tracer()
+        : enabled_(false)
+        , configured_enabled_(false)
+        , sample_percent_(100)
+        , path_("emshop_trace.json")
+        , max_file_bytes_(static_cast<size_t>(Constants::TRACE_MAX_FILE_MB) * 1024 * 1024)
+        , epoch_ns_(nowNs())
+#ifdef _WIN32
+        , pid_(static_cast<long long>(GetCurrentProcessId()))
+#else
+        , pid_(static_cast<long long>(getpid()))
+#endif
+        , running_(false)
+        , file_bytes_(0)
+        , exported_(0)
+        , dropped_traces_(0)
+        , dropped_spans_(0) {
+        try {
+            ConfigLoader& config = ConfigLoader::getInstance();
+            configured_enabled_ = config.getBool("tracing", "enabled", false);
+            path_ = config.getString("tracing", "file", path_);
+            sample_percent_ = std::max(0, std::min(100, config.getInt("tracing", "sample_percent", 100)));
+            int max_mb = config.getInt("tracing", "max_size_mb", Constants::TRACE_MAX_FILE_MB);
+            max_file_bytes_ = static_cast<size_t>(std::max(1, max_mb)) * 1024 * 1024;
+        } catch (const std::exception& e) {
+            Logger::warn("读取链路追踪配置失败，使用默认值: " + std::string(e.what()));
+        }
+    }
+    
+    static Context& context() {
+        static thread_local Context ctx;
+        return ctx;
+    }
+    
+    static uint32_t nextThreadId() {
+        static std::atomic<uint32_t> counter(0);
+        return ++counter;
+    }
+    
+    // 按trace_id哈希采样，同一追踪在各线程上的采样结果一致
+    bool sampled(const std::string& trace_id) const {
+        if (sample_percent_ >= 100) {
+            return true;
+        }
+        uint64_t hash = 1469598103934665603ULL;
+        for (unsigned char c : trace_id) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        return static_cast<int>(hash % 100) < sample_percent_;
+    }
+    
+    static void appendSpan(Context& ctx, Span&& span) {
+        if (ctx.spans.size() >= Constants::TRACE_MAX_SPANS) {
+            ctx.dropped_spans++;
+            return;
+        }
+        ctx.spans.push_back(std::move(span));
+    }
+    
+    void appendEvent(std::string& out, const std::string& name, const char* category, uint32_t tid,
+                     int64_t start_ns, int64_t end_ns, const std::string& trace_id,
+                     uint64_t span_id, uint64_t parent_id, const std::string& detail) {
+        json event;
+        event["name"] = name;
+        event["cat"] = category;
+        event["ph"] = "X";
+        event["ts"] = static_cast<double>(start_ns - epoch_ns_) / 1000.0;
+        event["dur"] = static_cast<double>(std::max<int64_t>(0, end_ns - start_ns)) / 1000.0;
+        event["pid"] = pid_;
+        event["tid"] = tid;
+        json args;
+        args["trace_id"] = trace_id;
+        args["span_id"] = span_id;
+        args["parent_id"] = parent_id;
+        if (!detail.empty()) {
+            args["detail"] = detail;
+        }
+        event["args"] = std::move(args);
+        out += event.dump(-1, ' ', false, json::error_handler_t::replace);
+        out += ",\n";
+    }
+    
+    void appendTrace(std::string& out, const FinishedTrace& trace) {
+        if (named_threads_.insert(trace.thread_id).second) {
+            json meta;
+            meta["name"] = "thread_name";
+            meta["ph"] = "M";
+            meta["pid"] = pid_;
+            meta["tid"] = trace.thread_id;
+            meta["args"]["name"] = "native-" + std::to_string(trace.thread_id);
+            out += meta.dump();
+            out += ",\n";
+        }
+        std::string root_detail = trace.dropped_spans > 0
+            ? "dropped_spans=" + std::to_string(trace.dropped_spans) : std::string();
+        appendEvent(out, trace.name, "request", trace.thread_id, trace.start_ns, trace.end_ns,
+                    trace.trace_id, trace.root_id, 0, root_detail);
+        for (const Span& span : trace.spans) {
+            appendEvent(out, span.name, span.category, trace.thread_id, span.start_ns, span.end_ns,
+                        trace.trace_id, span.id, span.parent, span.detail);
+        }
+    }
+    
+    std::string processMetadata() const {
+        json meta;
+        meta["name"] = "process_name";
+        meta["ph"] = "M";
+        meta["pid"] = pid_;
+        meta["args"]["name"] = "emshop-native";
+        return meta.dump();
+    }
+    
+    // JSON数组格式：进程异常退出时末尾缺少"]"，Chrome和Perfetto仍可读取
+    void openFile() {
+        file_.open(path_, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!file_.is_open()) {
+            Logger::error("无法打开链路追踪文件: " + path_);
+            return;
+        }
+        std::string header = "[\n" + processMetadata() + ",\n";
+        file_.write(header.data(), static_cast<std::streamsize>(header.size()));
+        file_bytes_ = header.size();
+        named_threads_.clear();
+    }
+    
+    void closeFile() {
+        if (!file_.is_open()) {
+            return;
+        }
+        std::string footer = processMetadata() + "\n]\n";
+        file_.write(footer.data(), static_cast<std::streamsize>(footer.size()));
+        file_.close();
+    }
+    
+    // 上一份文件保留为.1，旧的.1删除
+    void rotateFile() {
+        closeFile();
+        std::remove((path_ + ".1").c_str());
+        std::rename(path_.c_str(), (path_ + ".1").c_str());
+        openFile();
+    }
+    
+    void writerLoop() {
+        while (true) {
+            std::deque<FinishedTrace> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ready_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    break;
+                }
+                batch.swap(queue_);
+            }
+            std::string out;
+            for (const FinishedTrace& trace : batch) {
+                try {
+                    appendTrace(out, trace);
+                } catch (const std::exception& e) {
+                    Logger::warn("链路追踪序列化失败: " + std::string(e.what()));
+                }
+            }
+            if (file_.is_open() && file_bytes_ + out.size() > max_file_bytes_) {
+                rotateFile();
+            }
+            if (file_.is_open()) {
+                file_.write(out.data(), static_cast<std::streamsize>(out.size()));
+                file_.flush();
+                file_bytes_ += out.size();
+                exported_ += batch.size();
+            } else {
+                dropped_traces_ += batch.size();
+            }
+        }
+        closeFile();
+    }
+    
+public:
+    static Tracer& getInstance() {
+        static Tracer instance;
+        return instance;
+    }
+    
+    Tracer(const Tracer&) = delete;
+    Tracer& operator=(const Tracer&) = delete;
+    
+    static int64_t toNs(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+    
+    static int64_t nowNs() {
+        return toNs(std::chrono::steady_clock::now());
+    }
+    
+    // 当前线程是否有进行中的追踪
+    static bool active() {
+        return context().active;
+    }
+    
+    // 当前线程的trace_id，没有进行中的追踪时返回空串；用于把追踪传递到其他线程
+    static std::string currentTraceId() {
+        const Context& ctx = context();
+        return ctx.active ? ctx.trace_id : std::string();
+    }
+    
+    // 供TraceSpan使用：压入span栈，没有进行中的追踪时返回0
+    static uint64_t openSpan() {
+        Context& ctx = context();
+        if (!ctx.active) {
+            return 0;
+        }
+        uint64_t id = ++ctx.next_id;
+        ctx.open.push_back(id);
+        return id;
+    }
+    
+    static void closeSpan(uint64_t id, const char* name, const char* category, int64_t start_ns, std::string detail) {
+        int64_t end_ns = nowNs();
+        Context& ctx = context();
+        // 追踪已在span结束前结束(或已换成下一个追踪)时丢弃
+        if (!ctx.active || ctx.open.empty() || ctx.open.back() != id) {
+            return;
+        }
+        ctx.open.pop_back();
+        appendSpan(ctx, Span{name, category, id, ctx.open.empty() ? 0 : ctx.open.back(),
+                             start_ns, end_ns, std::move(detail)});
+    }
+    
+    // 记录一段调用方自行计时、已经结束的span(如QueryTimer)，父span为当前栈顶
+    static void recordSpan(const char* name, const char* category, int64_t start_ns, int64_t end_ns,
+                           std::string detail) {
+        Context& ctx = context();
+        if (!ctx.active) {
+            return;
+        }
+        uint64_t id = ++ctx.next_id;
+        appendSpan(ctx, Span{name, category, id, ctx.open.empty() ? 0 : ctx.open.back(),
+                             start_ns, end_ns, std::move(detail)});
+    }
+    
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ || !configured_enabled_) {
+            return;
+        }
+        if (std::ifstream(path_).good()) {
+            std::remove((path_ + ".1").c_str());
+            std::rename(path_.c_str(), (path_ + ".1").c_str());
+        }
+        openFile();
+        running_ = true;
+        writer_ = std::thread(&Tracer::writerLoop, this);
+        enabled_ = true;
+        Logger::info("链路追踪已开启，输出文件: " + path_ + "，采样比例: " + std::to_string(sample_percent_) + "%");
+    }
+    
+    // 已排队的追踪写完后关闭文件；之后结束的追踪计入丢弃数
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                return;
+            }
+            enabled_ = false;
+            running_ = false;
+        }
+        ready_.notify_all();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        Logger::info("链路追踪已关闭，共导出 " + std::to_string(exported_.load()) + " 条追踪");
+    }
+    
+    bool isEnabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    
+    // 把追踪绑定到当前线程，未开启或未被采样时返回false；线程上已有进行中的追踪时先结束它
+    bool beginTrace(const std::string& trace_id, const std::string& name) {
+        Context& ctx = context();
+        if (ctx.active) {
+            endTrace();
+        }
+        if (!isEnabled() || trace_id.empty() || !sampled(trace_id)) {
+            return false;
+        }
+        if (ctx.thread_id == 0) {
+            ctx.thread_id = nextThreadId();
+        }
+        ctx.active = true;
+        ctx.trace_id = trace_id;
+        ctx.name = name.empty() ? "request" : name;
+        ctx.dropped_spans = 0;
+        ctx.spans.clear();
+        ctx.spans.reserve(64);
+        ctx.open.clear();
+        ctx.root_id = ++ctx.next_id;
+        ctx.open.push_back(ctx.root_id);
+        ctx.start_ns = nowNs();
+        return true;
+    }
+    
+    // 结束当前线程的追踪并交给后台线程导出；尚未结束的子span丢弃
+    void endTrace() {
+        Context& ctx = context();
+        if (!ctx.active) {
+            return;
+        }
+        ctx.active = false;
+        ctx.open.clear();
+        
+        FinishedTrace trace;
+        trace.trace_id = std::move(ctx.trace_id);
+        trace.name = std::move(ctx.name);
+        trace.thread_id = ctx.thread_id;
+        trace.root_id = ctx.root_id;
+        trace.start_ns = ctx.start_ns;
+        trace.end_ns = nowNs();
+        trace.dropped_spans = ctx.dropped_spans;
+        trace.spans = std::move(ctx.spans);
+        ctx.spans = std::vector<Span>();
+        if (trace.dropped_spans > 0) {
+            dropped_spans_ += trace.dropped_spans;
+        }
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_ || queue_.size() >= Constants::TRACE_EXPORT_QUEUE_LIMIT) {
+                dropped_traces_++;
+                return;
+            }
+            queue_.push_back(std::move(trace));
+        }
+        ready_.notify_one();
+    }
+    
+    json getStats() {
+        json stats;
+        stats["enabled"] = isEnabled();
+        stats["file"] = path_;
+        stats["sample_percent"] = sample_percent_;
+        stats["exported_traces"] = exported_.load();
+        stats["dropped_traces"] = dropped_traces_.load();
+        stats["dropped_spans"] = dropped_spans_.load();
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats["queue_depth"] = queue_.size();
+        return stats;
+    }
+};
+
+// 追踪范围：构造时入栈计时，析构时出栈记录；当前线程没有进行中的追踪时不做任何记录。
+// name和category须为字符串字面量
+class TraceSpan {
+private:
+    const char* name_;
+    const char* category_;
+    uint64_t id_;
+    int64_t start_ns_;
+    std::string detail_;
+    
+public:
+    TraceSpan(const char* name, const char* category)
+        : name_(name), category_(category), id_(Tracer::openSpan()), start_ns_(id_ ? Tracer::nowNs() : 0) {}
+    
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+    
+    bool active() const { return id_ != 0; }
+    
+    void setDetail(std::string detail) {
+        if (id_) {
+            detail_ = std::move(detail);
+        }
+    }
+    
+    ~TraceSpan() {
+        if (id_) {
+            Tracer::closeSpan(id_, name_, category_, start_ns_, std::move(detail_));
+        }
+    }
+};
+
+// 只读副本地址，用户名、密码、库名等其余连接参数与主库一致
+struct ReplicaEndpoint {
+    std::string host;
+    int port;
+    int weight;
 };
 
 // 数据库配置类
@@ -260,6 +1203,7 @@ private:
     int read_timeout_;
     int write_timeout_;
     bool auto_reconnect_;
+    std::vector<ReplicaEndpoint> replicas_;
     
     // 私有构造函数，防止外部实例化
     DatabaseConfig() 
@@ -273,6 +1217,11 @@ private:
         , read_timeout_(30)
         , write_timeout_(30)
         , auto_reconnect_(true) {
+        // 只读副本可通过环境变量配置，便于本地用多个MySQL实例测试读写分离
+        const char* replicas = std::getenv("EMSHOP_DB_REPLICAS");
+        if (replicas && *replicas) {
+            setReplicas(parseReplicaList(replicas));
+        }
         Logger::info("数据库配置初始化完成");
     }
     
@@ -298,6 +1247,7 @@ public:
     int getReadTimeout() const { return read_timeout_; }
     int getWriteTimeout() const { return write_timeout_; }
     bool getAutoReconnect() const { return auto_reconnect_; }
+    const std::vector<ReplicaEndpoint>& getReplicas() const { return replicas_; }
     
     // Setter 方法
     void setHost(const std::string& host) { 
@@ -340,6 +1290,43 @@ public:
         Logger::info("自动重连设置为: " + std::string(reconnect ? "启用" : "禁用"));
     }
     
+    // 需在连接池初始化之前设置
+    void setReplicas(const std::vector<ReplicaEndpoint>& replicas) {
+        replicas_ = replicas;
+        Logger::info("只读副本数量更新为: " + std::to_string(replicas.size()));
+    }
+    
+    // 解析副本列表，格式: host:port[*weight],host:port[*weight]
+    static std::vector<ReplicaEndpoint> parseReplicaList(const std::string& text) {
+        std::vector<ReplicaEndpoint> replicas;
+        std::stringstream ss(text);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            item = StringUtils::trim(item);
+            if (item.empty()) {
+                continue;
+            }
+            ReplicaEndpoint endpoint{item, Constants::DB_PORT, 1};
+            size_t star = item.find('*');
+            if (star != std::string::npos) {
+                endpoint.weight = std::max(1, std::atoi(item.c_str() + star + 1));
+                item = item.substr(0, star);
+            }
+            size_t colon = item.rfind(':');
+            if (colon != std::string::npos) {
+                endpoint.port = std::atoi(item.c_str() + colon + 1);
+                item = item.substr(0, colon);
+            }
+            endpoint.host = item;
+            if (!endpoint.host.empty() && endpoint.port > 0) {
+                replicas.push_back(endpoint);
+            } else {
+                Logger::warn("忽略无效的只读副本配置: " + item);
+            }
+        }
+        return replicas;
+    }
+    
     // 从配置文件加载配置
     bool loadFromFile(const std::string& config_file) {
         std::ifstream file(config_file);
@@ -363,6 +1350,17 @@ public:
                 if (db_config.contains("charset")) setCharset(db_config["charset"]);
                 if (db_config.contains("connection_timeout")) setConnectionTimeout(db_config["connection_timeout"]);
                 if (db_config.contains("auto_reconnect")) setAutoReconnect(db_config["auto_reconnect"]);
+                if (db_config.contains("replicas") && db_config["replicas"].is_array()) {
+                    std::vector<ReplicaEndpoint> replicas;
+                    for (const auto& item : db_config["replicas"]) {
+                        ReplicaEndpoint endpoint{item.value("host", std::string()), item.value("port", Constants::DB_PORT),
+                                                 std::max(1, item.value("weight", 1))};
+                        if (!endpoint.host.empty()) {
+                            replicas.push_back(endpoint);
+                        }
+                    }
+                    setReplicas(replicas);
+                }
             }
             
             Logger::info("配置文件加载成功: " + config_file);
@@ -392,6 +1390,11 @@ public:
             config["database"]["charset"] = charset_;
             config["database"]["connection_timeout"] = connection_timeout_;
             config["database"]["auto_reconnect"] = auto_reconnect_;
+            config["database"]["replicas"] = json::array();
+            for (const auto& replica : replicas_) {
+                config["database"]["replicas"].push_back({{"host", replica.host}, {"port", replica.port},
+                                                          {"weight", replica.weight}});
+            }
             
             file << config.dump(4);
             Logger::info("配置文件保存成功: " + config_file);
@@ -453,37 +1456,327 @@ public:
     }
 };
 
+// MySQL客户端库的布尔标志类型(5.7为my_bool，8.0为bool)
+using MySqlFlag = std::remove_pointer<decltype(MYSQL_BIND::is_null)>::type;
+
+// 预处理语句参数 - 支持整数、浮点、字符串和NULL四种类型
+struct SqlParam {
+    enum class Type {
+        NULL_VALUE,
+        INTEGER,
+        DOUBLE,
+        STRING
+    };
+
+    Type type;
+    long long int_value;
+    double double_value;
+    std::string string_value;
+
+    SqlParam() : type(Type::NULL_VALUE), int_value(0), double_value(0.0) {}
+    SqlParam(int value) : type(Type::INTEGER), int_value(value), double_value(0.0) {}
+    SqlParam(long value) : type(Type::INTEGER), int_value(value), double_value(0.0) {}
+    SqlParam(long long value) : type(Type::INTEGER), int_value(value), double_value(0.0) {}
+    SqlParam(double value) : type(Type::DOUBLE), int_value(0), double_value(value) {}
+    SqlParam(const std::string& value) : type(Type::STRING), int_value(0), double_value(0.0), string_value(value) {}
+    SqlParam(const char* value) : type(value ? Type::STRING : Type::NULL_VALUE), int_value(0), double_value(0.0),
+                                  string_value(value ? value : "") {}
+
+    static SqlParam null() { return SqlParam(); }
+};
 
-class DatabaseConnectionPool {
+// 预处理语句缓存 - 每个连接独立维护一份LRU缓存
+// 同一连接同一时刻只会被一个线程借出，因此缓存内部无需加锁
+class PreparedStatementCache {
 private:
-    std::queue<MYSQL*> available_connections_;
-    std::unordered_map<MYSQL*, std::chrono::steady_clock::time_point> connection_timestamps_;
-    std::mutex pool_mutex_;
-    std::condition_variable connection_available_;
-    std::atomic<int> total_connections_;
-    std::atomic<int> active_connections_;
-    int max_pool_size_;
-    bool initialized_;
-    std::thread maintenance_thread_;
-    std::atomic<bool> shutdown_flag_;
-    
-    DatabaseConnectionPool() 
-        : total_connections_(0)
-        , active_connections_(0)
-        , max_pool_size_(Constants::MAX_POOL_SIZE)
-        , initialized_(false)
-        , shutdown_flag_(false) {
+    using Entry = std::pair<std::string, MYSQL_STMT*>;
+
+    std::list<Entry> lru_list_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    size_t capacity_;
+    unsigned long thread_id_;  // 预处理语句所属的服务端会话，自动重连后会变化
+
+public:
+    explicit PreparedStatementCache(size_t capacity)
+        : capacity_(capacity > 0 ? capacity : 1), thread_id_(0) {}
+
+    ~PreparedStatementCache() {
+        clear();
     }
-    
-    // 创建新的数据库连接
-    MYSQL* createNewConnection() {
-        MYSQL* conn = mysql_init(nullptr);
-        if (!conn) {
-            Logger::error("MySQL初始化失败");
+
+    PreparedStatementCache(const PreparedStatementCache&) = delete;
+    PreparedStatementCache& operator=(const PreparedStatementCache&) = delete;
+
+    // 获取(或预处理)语句，hit返回是否命中缓存
+    MYSQL_STMT* acquire(MYSQL* conn, const std::string& sql, bool& hit, std::string& error) {
+        hit = false;
+
+        // 连接被自动重连过，旧会话上的语句句柄全部失效
+        unsigned long current_thread_id = mysql_thread_id(conn);
+        if (current_thread_id != thread_id_) {
+            clear();
+            thread_id_ = current_thread_id;
+        }
+
+        auto it = index_.find(sql);
+        if (it != index_.end()) {
+            lru_list_.splice(lru_list_.begin(), lru_list_, it->second);
+            hit = true;
+            return it->second->second;
+        }
+
+        MYSQL_STMT* stmt = mysql_stmt_init(conn);
+        if (!stmt) {
+            error = "初始化预处理语句失败: " + std::string(mysql_error(conn));
             return nullptr;
         }
-        
-        // 设置连接选项
+
+        if (mysql_stmt_prepare(stmt, sql.c_str(), sql.length()) != 0) {
+            error = "预处理SQL失败: " + std::string(mysql_stmt_error(stmt));
+            mysql_stmt_close(stmt);
+            return nullptr;
+        }
+
+        // 让store_result计算每列最大长度，便于一次性分配结果缓冲区
+        MySqlFlag update_max_length = 1;
+        mysql_stmt_attr_set(stmt, STMT_ATTR_UPDATE_MAX_LENGTH, &update_max_length);
+
+        lru_list_.emplace_front(sql, stmt);
+        index_[sql] = lru_list_.begin();
+
+        // 超出容量时淘汰最久未使用的语句
+        if (lru_list_.size() > capacity_) {
+            Entry& victim = lru_list_.back();
+            mysql_stmt_close(victim.second);
+            index_.erase(victim.first);
+            lru_list_.pop_back();
+        }
+
+        return stmt;
+    }
+
+    // 移除单条语句(语句在服务端已失效时使用)
+    void evict(const std::string& sql) {
+        auto it = index_.find(sql);
+        if (it == index_.end()) {
+            return;
+        }
+        mysql_stmt_close(it->second->second);
+        lru_list_.erase(it->second);
+        index_.erase(it);
+    }
+
+    void clear() {
+        for (auto& entry : lru_list_) {
+            mysql_stmt_close(entry.second);
+        }
+        lru_list_.clear();
+        index_.clear();
+    }
+
+    size_t size() const {
+        return lru_list_.size();
+    }
+};
+
+class DatabaseConnectionPool {
+private:
+    // 空闲连接及其最近一次归还时间
+    struct IdleConnection {
+        MYSQL* conn;
+        std::chrono::steady_clock::time_point last_used;
+    };
+    
+    // 连接池分片 - 每个分片独立加锁，线程优先使用自己的分片
+    struct alignas(64) PoolShard {
+        std::mutex mutex;
+        std::vector<IdleConnection> idle;  // 按LIFO使用，优先取最近归还的热连接
+    };
+    
+    // 连接池规模边界，主库取自config.json的pool节
+    struct PoolSizing {
+        int min_size;
+        int max_size;
+        int min_idle;
+        int max_idle;
+        int target_wait_ms;
+    };
+    
+    // 借连接等待时间直方图，第i个桶统计[2^i, 2^(i+1))微秒
+    struct WaitHistogram {
+        static const size_t BUCKETS = 32;
+        std::atomic<long long> counts[BUCKETS] = {};
+        
+        void record(long long micros) {
+            size_t bucket = 0;
+            while (micros > 1 && bucket + 1 < BUCKETS) {
+                micros >>= 1;
+                ++bucket;
+            }
+            counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+        
+        std::vector<long long> snapshot() const {
+            std::vector<long long> result(BUCKETS);
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                result[i] = counts[i].load(std::memory_order_relaxed);
+            }
+            return result;
+        }
+        
+        // 取出计数并清零，用于按周期统计
+        std::vector<long long> drain() {
+            std::vector<long long> result(BUCKETS);
+            for (size_t i = 0; i < BUCKETS; ++i) {
+                result[i] = counts[i].exchange(0);
+            }
+            return result;
+        }
+        
+        // 按桶上界估算百分位，返回毫秒
+        static double percentileMs(const std::vector<long long>& buckets, double quantile) {
+            long long total = 0;
+            for (long long count : buckets) {
+                total += count;
+            }
+            if (total == 0) {
+                return 0.0;
+            }
+            long long rank = static_cast<long long>(std::ceil(quantile * total));
+            long long seen = 0;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    return static_cast<double>(1LL << (i + 1)) / 1000.0;
+                }
+            }
+            return static_cast<double>(1LL << buckets.size()) / 1000.0;
+        }
+    };
+    
+    std::vector<std::unique_ptr<PoolShard>> shards_;
+    std::atomic<int> total_connections_;
+    std::atomic<int> active_connections_;
+    std::atomic<int> idle_connections_;
+    PoolSizing sizing_;
+    int max_pool_size_;
+    bool initialized_;
+    std::thread maintenance_thread_;
+    std::atomic<bool> shutdown_flag_;
+    
+    // 仅在所有分片都没有空闲连接时使用
+    std::mutex wait_mutex_;
+    std::condition_variable connection_available_;
+    std::atomic<int> waiting_threads_;
+    std::condition_variable maintenance_wakeup_;
+    
+    // 主库池连接配置中的主库，副本池连接指定的只读副本
+    bool is_replica_;
+    std::string host_;
+    int port_;
+    
+    // 借用遥测，由维护线程按周期汇总并据此调整目标空闲连接数
+    WaitHistogram window_waits_;
+    WaitHistogram total_waits_;
+    std::atomic<long long> max_wait_us_;
+    std::atomic<long long> borrows_;
+    std::atomic<long long> misses_;            // 借用时没有空闲连接
+    std::atomic<long long> window_misses_;
+    std::atomic<int> window_min_idle_;         // 本周期内空闲连接数的最低点
+    std::atomic<int> target_idle_;
+    std::atomic<bool> warmup_requested_;
+    std::atomic<long long> prewarmed_connections_;
+    std::atomic<long long> retired_connections_;
+    std::atomic<size_t> warm_shard_cursor_;
+    int surplus_windows_;                      // 仅维护线程访问
+    mutable std::mutex telemetry_mutex_;
+    std::vector<long long> last_window_waits_;
+    double borrow_rate_;                       // 每秒借用次数(指数平滑)
+    
+    // 预处理语句缓存，按连接隔离；主库池与副本池共用一份，
+    // 这样无论连接来自哪个池，BaseService都能用同一个入口取到缓存
+    struct StatementCacheRegistry {
+        std::unordered_map<MYSQL*, std::unique_ptr<PreparedStatementCache>> caches;
+        std::mutex mutex;
+        std::atomic<long long> hits{0};
+        std::atomic<long long> misses{0};
+    };
+    
+    static StatementCacheRegistry& statementCaches() {
+        static StatementCacheRegistry registry;
+        return registry;
+    }
+    
+    DatabaseConnectionPool(const std::string& host, int port, bool is_replica) 
+        : total_connections_(0)
+        , active_connections_(0)
+        , idle_connections_(0)
+        , sizing_(loadSizing(is_replica))
+        , max_pool_size_(sizing_.max_size)
+        , initialized_(false)
+        , shutdown_flag_(false)
+        , waiting_threads_(0)
+        , is_replica_(is_replica)
+        , host_(host)
+        , port_(port)
+        , max_wait_us_(0)
+        , borrows_(0)
+        , misses_(0)
+        , window_misses_(0)
+        , window_min_idle_(0)
+        , target_idle_(sizing_.min_idle)
+        , warmup_requested_(false)
+        , prewarmed_connections_(0)
+        , retired_connections_(0)
+        , warm_shard_cursor_(0)
+        , surplus_windows_(0)
+        , last_window_waits_(WaitHistogram::BUCKETS, 0)
+        , borrow_rate_(0.0) {
+        statementCaches();  // 保证注册表先于连接池构造、晚于连接池析构
+        unsigned int shard_count = std::thread::hardware_concurrency();
+        shard_count = std::max(1u, std::min(shard_count, static_cast<unsigned int>(Constants::MAX_POOL_SHARDS)));
+        for (unsigned int i = 0; i < shard_count; ++i) {
+            shards_.emplace_back(new PoolShard());
+        }
+    }
+    
+    // 读取连接池规模边界并做合法性修正，配置文件缺失或无法解析时使用Constants中的默认值
+    static PoolSizing loadSizing(bool is_replica) {
+        PoolSizing sizing{Constants::INITIAL_POOL_SIZE, Constants::MAX_POOL_SIZE, Constants::POOL_MIN_IDLE,
+                          Constants::POOL_MAX_IDLE, Constants::POOL_TARGET_WAIT_MS};
+        int replica_min_size = Constants::REPLICA_INITIAL_POOL_SIZE;
+        try {
+            ConfigLoader& config = ConfigLoader::getInstance();
+            sizing.min_size = config.getInt("pool", "min_size", sizing.min_size);
+            sizing.max_size = config.getInt("pool", "max_size", sizing.max_size);
+            sizing.min_idle = config.getInt("pool", "min_idle", sizing.min_idle);
+            sizing.max_idle = config.getInt("pool", "max_idle", sizing.max_idle);
+            sizing.target_wait_ms = config.getInt("pool", "target_wait_ms", sizing.target_wait_ms);
+            replica_min_size = config.getInt("pool", "replica_min_size", replica_min_size);
+        } catch (const std::exception& e) {
+            Logger::warn("读取连接池配置失败，使用默认值: ", e.what());
+        }
+        
+        if (is_replica) {
+            sizing.min_size = replica_min_size;
+        }
+        sizing.max_size = std::max(1, sizing.max_size);
+        sizing.min_size = std::max(1, std::min(sizing.min_size, sizing.max_size));
+        sizing.min_idle = std::max(0, std::min(sizing.min_idle, sizing.max_size));
+        sizing.max_idle = std::max(sizing.min_idle, std::min(sizing.max_idle, sizing.max_size));
+        sizing.target_wait_ms = std::max(1, sizing.target_wait_ms);
+        return sizing;
+    }
+    
+    // 创建新的数据库连接
+    MYSQL* createNewConnection() {
+        MYSQL* conn = mysql_init(nullptr);
+        if (!conn) {
+            Logger::error("MySQL初始化失败");
+            return nullptr;
+        }
+        
+        // 设置连接选项
         const DatabaseConfig& config = DatabaseConfig::getInstance();
         
         // 设置超时
@@ -499,16 +1792,18 @@ private:
         // 设置字符集
         mysql_options(conn, MYSQL_SET_CHARSET_NAME, config.getCharset().c_str());
         
-        // 建立连接
+        // 建立连接(副本池使用副本地址，其余参数与主库一致)
+        const std::string host = is_replica_ ? host_ : config.getHost();
+        const int port = is_replica_ ? port_ : config.getPort();
         if (!mysql_real_connect(conn, 
-                               config.getHost().c_str(),
+                               host.c_str(),
                                config.getUsername().c_str(),
                                config.getPassword().c_str(),
                                config.getDatabase().c_str(),
-                               config.getPort(),
+                               port,
                                nullptr, 
                                CLIENT_MULTI_RESULTS)) {
-            Logger::error("数据库连接失败: " + std::string(mysql_error(conn)));
+            Logger::error("数据库连接失败: ", mysql_error(conn));
             mysql_close(conn);
             return nullptr;
         }
@@ -521,69 +1816,286 @@ private:
             Logger::warn("设置数据库连接参数失败");
         }
         
-        Logger::info("创建新数据库连接: " + std::to_string(reinterpret_cast<uintptr_t>(conn)));
+        Logger::info("创建新数据库连接: ", reinterpret_cast<uintptr_t>(conn));
         return conn;
     }
     
+    // 关闭连接，先释放该连接上缓存的预处理语句
+    void closeConnection(MYSQL* conn) {
+        {
+            StatementCacheRegistry& registry = statementCaches();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.caches.erase(conn);
+        }
+        mysql_close(conn);
+    }
+    
     // 验证连接是否有效
     bool validateConnection(MYSQL* conn) {
         if (!conn) return false;
         
         // 使用ping检查连接状态
         if (mysql_ping(conn) != 0) {
-            Logger::warn("连接ping失败: " + std::string(mysql_error(conn)));
+            Logger::warn("连接ping失败: ", mysql_error(conn));
             return false;
         }
         
         return true;
     }
-    // 维护线程，定期清理过期连接
-    void maintenanceLoop() {
-        while (!shutdown_flag_) {
-            std::this_thread::sleep_for(std::chrono::seconds(60));  // 每分钟执行一次维护
-            std::unique_lock<std::mutex> lock(pool_mutex_);
-            auto now = std::chrono::steady_clock::now();
-            std::queue<MYSQL*> valid_connections;
-            
-            // 检查空闲连接，移除过期或无效的连接
-            while (!available_connections_.empty()) {
-                MYSQL* conn = available_connections_.front();
-                available_connections_.pop();
-                
-                auto it = connection_timestamps_.find(conn);
-                bool should_keep = true;
-                
-                if (it != connection_timestamps_.end()) {
-                    auto age = std::chrono::duration_cast<std::chrono::minutes>(now - it->second);
-                    if (age.count() > 30) {  // 连接超过30分钟未使用才清理
-                        should_keep = false;
-                        Logger::info("移除过期连接: " + std::to_string(reinterpret_cast<uintptr_t>(conn)));
-                    }
+    
+    // 当前线程优先使用的分片
+    size_t homeShardIndex() const {
+        static thread_local size_t home_index = std::hash<std::thread::id>()(std::this_thread::get_id());
+        return home_index % shards_.size();
+    }
+    
+    // 从分片中取一个空闲连接，本分片为空时依次尝试其他分片
+    bool tryTakeIdleConnection(IdleConnection& out) {
+        if (idle_connections_.load() <= 0) {
+            return false;
+        }
+        
+        size_t start = homeShardIndex();
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            PoolShard& shard = *shards_[(start + i) % shards_.size()];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (!shard.idle.empty()) {
+                out = shard.idle.back();
+                shard.idle.pop_back();
+                int remaining = --idle_connections_;
+                int low = window_min_idle_.load(std::memory_order_relaxed);
+                while (remaining < low && !window_min_idle_.compare_exchange_weak(low, remaining)) {
                 }
-                
-                if (should_keep && validateConnection(conn)) {
-                    valid_connections.push(conn);
-                } else {
-                    mysql_close(conn);
-                    connection_timestamps_.erase(conn);
-                    total_connections_--;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // 将空闲连接放回当前线程的分片
+    void putIdleConnection(MYSQL* conn) {
+        PoolShard& shard = *shards_[homeShardIndex()];
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.idle.push_back({conn, std::chrono::steady_clock::now()});
+            idle_connections_++;
+        }
+        notifyWaiters();
+    }
+    
+    // 唤醒等待连接的线程(没有等待者时不触碰全局锁)
+    void notifyWaiters() {
+        if (waiting_threads_.load() > 0) {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            connection_available_.notify_one();
+        }
+    }
+    
+    // 预留一个连接名额，成功后由调用方负责创建连接或归还名额
+    bool reserveConnectionSlot() {
+        int current = total_connections_.load();
+        while (current < max_pool_size_) {
+            if (total_connections_.compare_exchange_weak(current, current + 1)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // 记录一次借用的等待时间(从调用getConnection到拿到连接)
+    void recordBorrow(std::chrono::steady_clock::time_point started) {
+        long long micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        window_waits_.record(micros);
+        total_waits_.record(micros);
+        borrows_.fetch_add(1, std::memory_order_relaxed);
+        long long current_max = max_wait_us_.load(std::memory_order_relaxed);
+        while (micros > current_max && !max_wait_us_.compare_exchange_weak(current_max, micros)) {
+        }
+    }
+    
+    // 借用时没有空闲连接：请维护线程立即按目标补充空闲连接
+    void requestWarmup() {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        window_misses_.fetch_add(1, std::memory_order_relaxed);
+        if (!warmup_requested_.exchange(true)) {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            maintenance_wakeup_.notify_all();
+        }
+    }
+    
+    // 按一个调整周期的遥测更新目标空闲连接数，返回本周期空闲连接数的最低点
+    int adjustTargetIdle(double elapsed_seconds) {
+        std::vector<long long> window = window_waits_.drain();
+        long long window_borrows = 0;
+        for (long long count : window) {
+            window_borrows += count;
+        }
+        long long window_misses = window_misses_.exchange(0);
+        int low_idle = window_min_idle_.exchange(idle_connections_.load());
+        double p99_ms = WaitHistogram::percentileMs(window, 0.99);
+        
+        int target = target_idle_.load();
+        if (window_misses > 0 || p99_ms > sizing_.target_wait_ms) {
+            // 有借用方拿不到空闲连接或等待过长：按缺口放大目标，至少加一
+            target = std::min(sizing_.max_idle,
+                              target + std::max<int>(1, static_cast<int>(std::min<long long>(window_misses, target + 1))));
+            surplus_windows_ = 0;
+        } else if (low_idle > 0) {
+            // 整个周期都有连接闲置，持续一段时间后逐步下调
+            if (++surplus_windows_ >= Constants::POOL_SHRINK_WINDOWS) {
+                target = std::max(sizing_.min_idle, target - 1);
+                surplus_windows_ = 0;
+            }
+        } else {
+            surplus_windows_ = 0;
+        }
+        target_idle_ = target;
+        
+        std::lock_guard<std::mutex> lock(telemetry_mutex_);
+        last_window_waits_ = window;
+        double rate = elapsed_seconds > 0 ? window_borrows / elapsed_seconds : 0.0;
+        borrow_rate_ = borrow_rate_ * 0.7 + rate * 0.3;
+        return low_idle;
+    }
+    
+    // 后台预热：空闲连接不足目标或总数低于下限时新建连接，借用方不再承担建连延迟
+    void warmUp() {
+        int idle_deficit = target_idle_.load() - idle_connections_.load();
+        int size_deficit = sizing_.min_size - total_connections_.load();
+        int wanted = std::min(std::max(idle_deficit, size_deficit), Constants::POOL_PREWARM_BATCH);
+        for (int i = 0; i < wanted && !shutdown_flag_; ++i) {
+            if (!reserveConnectionSlot()) {
+                break;
+            }
+            MYSQL* conn = createNewConnection();
+            if (!conn) {
+                total_connections_--;
+                break;
+            }
+            size_t index = warm_shard_cursor_.fetch_add(1) % shards_.size();
+            {
+                std::lock_guard<std::mutex> lock(shards_[index]->mutex);
+                shards_[index]->idle.push_back({conn, std::chrono::steady_clock::now()});
+                idle_connections_++;
+            }
+            prewarmed_connections_++;
+            notifyWaiters();
+        }
+    }
+    
+    // 关闭整个周期都未被用到的多余空闲连接，总数不低于下限
+    void retireSurplus(int low_idle) {
+        int excess = std::min({idle_connections_.load() - target_idle_.load(), low_idle,
+                               total_connections_.load() - sizing_.min_size, Constants::POOL_PREWARM_BATCH});
+        if (excess <= 0) {
+            return;
+        }
+        std::vector<MYSQL*> retired;
+        for (auto& shard_ptr : shards_) {
+            if (static_cast<int>(retired.size()) >= excess) {
+                break;
+            }
+            std::lock_guard<std::mutex> lock(shard_ptr->mutex);
+            auto& idle = shard_ptr->idle;
+            // 分片头部是最久未用的连接
+            size_t count = std::min(idle.size(), static_cast<size_t>(excess - static_cast<int>(retired.size())));
+            for (size_t i = 0; i < count; ++i) {
+                retired.push_back(idle[i].conn);
+            }
+            idle.erase(idle.begin(), idle.begin() + count);
+            idle_connections_ -= static_cast<int>(count);
+        }
+        for (MYSQL* conn : retired) {
+            closeConnection(conn);
+            total_connections_--;
+            retired_connections_++;
+        }
+        if (!retired.empty()) {
+            Logger::debug("连接池缩容，关闭空闲连接数: ", retired.size());
+        }
+    }
+    
+    // 清理超过30分钟未使用的连接
+    void removeExpiredConnections() {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<MYSQL*> expired;
+        
+        // 只在分片锁内挑出过期连接，关闭操作放到锁外执行
+        for (auto& shard_ptr : shards_) {
+            std::lock_guard<std::mutex> lock(shard_ptr->mutex);
+            auto& idle = shard_ptr->idle;
+            auto keep_end = std::remove_if(idle.begin(), idle.end(), [&](const IdleConnection& item) {
+                auto age = std::chrono::duration_cast<std::chrono::minutes>(now - item.last_used);
+                if (age.count() > 30) {  // 连接超过30分钟未使用才清理
+                    expired.push_back(item.conn);
+                    return true;
                 }
+                return false;
+            });
+            idle_connections_ -= static_cast<int>(std::distance(keep_end, idle.end()));
+            idle.erase(keep_end, idle.end());
+        }
+        
+        for (MYSQL* conn : expired) {
+            Logger::info("移除过期连接: ", reinterpret_cast<uintptr_t>(conn));
+            closeConnection(conn);
+            total_connections_--;
+        }
+        if (!expired.empty()) {
+            notifyWaiters();
+        }
+        
+        Logger::debug("连接池维护完成，可用连接: ", idle_connections_.load(),
+                      "，总连接数: ", total_connections_.load(),
+                      "，目标空闲: ", target_idle_.load());
+    }
+    
+    // 维护线程：按周期调整目标空闲数并预热/缩容，借用方缺连接时被提前唤醒补充连接
+    void maintenanceLoop() {
+        auto window_start = std::chrono::steady_clock::now();
+        auto next_expiry_check = window_start + std::chrono::seconds(60);  // 每分钟清理一次过期连接
+        const auto interval = std::chrono::milliseconds(Constants::POOL_CONTROL_INTERVAL_MS);
+        
+        while (!shutdown_flag_) {
+            {
+                std::unique_lock<std::mutex> lock(wait_mutex_);
+                maintenance_wakeup_.wait_until(lock, window_start + interval, [this] {
+                    return shutdown_flag_.load() || warmup_requested_.load();
+                });
+            }
+            if (shutdown_flag_) {
+                break;
             }
+            warmup_requested_ = false;
             
-            available_connections_ = std::move(valid_connections);
+            auto now = std::chrono::steady_clock::now();
+            if (now - window_start >= interval) {
+                double elapsed = std::chrono::duration<double>(now - window_start).count();
+                window_start = now;
+                int low_idle = adjustTargetIdle(elapsed);
+                retireSurplus(low_idle);
+            }
+            warmUp();
             
-            Logger::debug("连接池维护完成，可用连接: " + std::to_string(available_connections_.size()) +
-                         "，总连接数: " + std::to_string(total_connections_.load()));
+            if (now >= next_expiry_check) {
+                next_expiry_check = now + std::chrono::seconds(60);
+                removeExpiredConnections();
+            }
         }
     }
     
 public:
-    // 获取单例实例
+    // 获取单例实例(主库连接池)
     static DatabaseConnectionPool& getInstance() {
-        static DatabaseConnectionPool instance;
+        static DatabaseConnectionPool instance(std::string(), 0, false);
         return instance;
     }
     
+    // 只读副本连接池，由ReplicaRouter持有
+    explicit DatabaseConnectionPool(const ReplicaEndpoint& endpoint)
+        : DatabaseConnectionPool(endpoint.host, endpoint.port, true) {}
+    
     // 禁用拷贝构造和赋值操作
     DatabaseConnectionPool(const DatabaseConnectionPool&) = delete;
     DatabaseConnectionPool& operator=(const DatabaseConnectionPool&) = delete;
@@ -595,21 +2107,25 @@ public:
             return true;
         }
         
-        Logger::info("初始化数据库连接池...");
+        Logger::info("初始化数据库连接池...", (is_replica_ ? " 只读副本 " + describeEndpoint() : std::string()));
+        shutdown_flag_ = false;
         
-        // 创建初始连接
-        for (int i = 0; i < Constants::INITIAL_POOL_SIZE; ++i) {
+        // 创建初始连接，均匀分布到各分片
+        auto now = std::chrono::steady_clock::now();
+        for (int i = 0; i < sizing_.min_size; ++i) {
             MYSQL* conn = createNewConnection();
             if (conn) {
-                available_connections_.push(conn);
-                connection_timestamps_[conn] = std::chrono::steady_clock::now();
+                PoolShard& shard = *shards_[i % shards_.size()];
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.idle.push_back({conn, now});
+                idle_connections_++;
                 total_connections_++;
             } else {
-                Logger::error("创建初始连接失败，索引: " + std::to_string(i));
+                Logger::error("创建初始连接失败，索引: ", i);
             }
         }
         
-        if (available_connections_.empty()) {
+        if (idle_connections_.load() == 0) {
             Logger::error("连接池初始化失败：无法创建任何连接");
             return false;
         }
@@ -618,92 +2134,111 @@ public:
         maintenance_thread_ = std::thread(&DatabaseConnectionPool::maintenanceLoop, this);
         
         initialized_ = true;
-        Logger::info("连接池初始化成功，创建了 " + std::to_string(available_connections_.size()) + " 个连接");
+        Logger::info("连接池初始化成功，创建了 ", idle_connections_.load(), " 个连接，分片数: ", shards_.size());
         return true;
     }
     
+    bool isInitialized() const { return initialized_; }
+    bool isReplica() const { return is_replica_; }
+    
+    // 连接地址，主库池返回配置中的主库地址
+    std::string describeEndpoint() const {
+        if (!is_replica_) {
+            const DatabaseConfig& config = DatabaseConfig::getInstance();
+            return config.getHost() + ":" + std::to_string(config.getPort());
+        }
+        return host_ + ":" + std::to_string(port_);
+    }
+    
     // 获取数据库连接
     MYSQL* getConnection() {
-        std::unique_lock<std::mutex> lock(pool_mutex_);
-        
-        // 等待可用连接，最多等待60秒（与CONNECTION_TIMEOUT一致）
-        if (!connection_available_.wait_for(lock, std::chrono::seconds(60), [this] { 
-            return !available_connections_.empty() || shutdown_flag_; 
-        })) {
-            Logger::error("获取数据库连接超时（60秒）- 活跃连接: " + 
-                         std::to_string(active_connections_.load()) + 
-                         ", 总连接: " + std::to_string(total_connections_.load()));
-            return nullptr;
-        }
-        
-        if (shutdown_flag_) {
-            return nullptr;
+        TraceSpan span("pool.wait", "pool");
+        if (is_replica_ && span.active()) {
+            span.setDetail(host_ + ":" + std::to_string(port_));
         }
         
-        MYSQL* conn = nullptr;
+        // 等待可用连接，最多等待60秒（与CONNECTION_TIMEOUT一致）
+        auto started = std::chrono::steady_clock::now();
+        auto deadline = started + std::chrono::seconds(Constants::CONNECTION_TIMEOUT);
+        bool missed = false;
         
-        // 从可用连接中获取一个
-        if (!available_connections_.empty()) {
-            conn = available_connections_.front();
-            available_connections_.pop();
-            connection_timestamps_.erase(conn);
-            active_connections_++;
+        while (!shutdown_flag_) {
+            IdleConnection idle{nullptr, {}};
+            if (tryTakeIdleConnection(idle)) {
+                // 只有空闲较久的连接才ping，刚归还的热连接直接使用
+                auto idle_seconds = std::chrono::duration_cast<std::chrono::seconds>(
+                    std::chrono::steady_clock::now() - idle.last_used).count();
+                if (idle_seconds >= Constants::CONNECTION_VALIDATE_IDLE_SECONDS && !validateConnection(idle.conn)) {
+                    closeConnection(idle.conn);
+                    total_connections_--;
+                    continue;
+                }
+                
+                active_connections_++;
+                recordBorrow(started);
+                Logger::debug("分配数据库连接: ", reinterpret_cast<uintptr_t>(idle.conn),
+                              "，活跃连接数: ", active_connections_.load());
+                return idle.conn;
+            }
+            
+            // 空闲连接耗尽说明预热不足，通知维护线程补充，供后续请求使用
+            if (!missed) {
+                missed = true;
+                requestWarmup();
+            }
             
-            // 验证连接有效性
-            if (!validateConnection(conn)) {
-                mysql_close(conn);
+            // 如果没有可用连接且未达到最大数量，当前请求自己创建新连接
+            if (reserveConnectionSlot()) {
+                MYSQL* conn = createNewConnection();
+                if (conn) {
+                    active_connections_++;
+                    recordBorrow(started);
+                    return conn;
+                }
                 total_connections_--;
-                active_connections_--;
-                conn = nullptr;
+                Logger::error("无法获取数据库连接");
+                return nullptr;
             }
-        }
-        
-        // 如果没有可用连接且未达到最大数量，创建新连接
-        if (!conn && total_connections_ < max_pool_size_) {
-            lock.unlock();  // 释放锁以避免阻塞其他操作
-            conn = createNewConnection();
-            lock.lock();
             
-            if (conn) {
-                total_connections_++;
-                active_connections_++;
+            // 所有分片都为空且已达上限，等待其他线程归还
+            std::unique_lock<std::mutex> lock(wait_mutex_);
+            waiting_threads_++;
+            bool ready = connection_available_.wait_until(lock, deadline, [this] {
+                return idle_connections_.load() > 0 || total_connections_.load() < max_pool_size_ || shutdown_flag_;
+            });
+            waiting_threads_--;
+            
+            if (!ready) {
+                Logger::error("获取数据库连接超时（60秒）- 活跃连接: ", active_connections_.load(),
+                              ", 总连接: ", total_connections_.load());
+                return nullptr;
             }
         }
         
-        if (conn) {
-            Logger::debug("分配数据库连接: " + std::to_string(reinterpret_cast<uintptr_t>(conn)) +
-                         "，活跃连接数: " + std::to_string(active_connections_.load()));
-        } else {
-            Logger::error("无法获取数据库连接");
-        }
-        
-        return conn;
+        return nullptr;
     }
     
     // 归还数据库连接
     void returnConnection(MYSQL* conn) {
         if (!conn) return;
         
-        std::lock_guard<std::mutex> lock(pool_mutex_);
+        active_connections_--;
         
-        // 验证连接仍然有效
-        if (validateConnection(conn)) {
-            available_connections_.push(conn);
-            connection_timestamps_[conn] = std::chrono::steady_clock::now();
-            active_connections_--;
-            
-            Logger::debug("归还数据库连接: " + std::to_string(reinterpret_cast<uintptr_t>(conn)) +
-                         "，可用连接数: " + std::to_string(available_connections_.size()));
-        } else {
-            // 连接无效，直接关闭
-            mysql_close(conn);
+        // 不在归还路径上ping；只根据最近一次调用的错误码判断连接是否已断开
+        unsigned int error_no = mysql_errno(conn);
+        if (shutdown_flag_ || error_no == CR_SERVER_GONE_ERROR || error_no == CR_SERVER_LOST) {
+            closeConnection(conn);
             total_connections_--;
-            active_connections_--;
-            Logger::warn("归还无效连接，已关闭: " + std::to_string(reinterpret_cast<uintptr_t>(conn)));
+            if (!shutdown_flag_) {
+                Logger::warn("归还无效连接，已关闭: ", reinterpret_cast<uintptr_t>(conn));
+                notifyWaiters();
+            }
+            return;
         }
         
-        // 通知等待连接的线程
-        connection_available_.notify_one();
+        putIdleConnection(conn);
+        Logger::debug("归还数据库连接: ", reinterpret_cast<uintptr_t>(conn),
+                      "，可用连接数: ", idle_connections_.load());
     }
     
     // 获取连接池状态
@@ -711,32 +2246,100 @@ public:
         json status;
         status["total_connections"] = total_connections_.load();
         status["active_connections"] = active_connections_.load();
-        status["available_connections"] = available_connections_.size();
+        status["available_connections"] = idle_connections_.load();
         status["max_pool_size"] = max_pool_size_;
+        status["min_pool_size"] = sizing_.min_size;
+        status["target_idle"] = target_idle_.load();
+        status["min_idle"] = sizing_.min_idle;
+        status["max_idle"] = sizing_.max_idle;
         status["initialized"] = initialized_;
+        status["shards"] = shards_.size();
+        status["waiting_threads"] = waiting_threads_.load();
+        status["role"] = is_replica_ ? "replica" : "primary";
+        status["endpoint"] = describeEndpoint();
+        status["borrows"] = borrows_.load();
+        status["misses"] = misses_.load();
+        status["prewarmed_connections"] = prewarmed_connections_.load();
+        status["retired_connections"] = retired_connections_.load();
+        
+        // 等待时间百分位按直方图桶上界估算
+        std::vector<long long> total_waits = total_waits_.snapshot();
+        json wait_time;
+        wait_time["p50_ms"] = WaitHistogram::percentileMs(total_waits, 0.50);
+        wait_time["p90_ms"] = WaitHistogram::percentileMs(total_waits, 0.90);
+        wait_time["p99_ms"] = WaitHistogram::percentileMs(total_waits, 0.99);
+        wait_time["p999_ms"] = WaitHistogram::percentileMs(total_waits, 0.999);
+        wait_time["max_ms"] = max_wait_us_.load() / 1000.0;
+        wait_time["target_ms"] = sizing_.target_wait_ms;
+        {
+            std::lock_guard<std::mutex> lock(telemetry_mutex_);
+            wait_time["last_window_p50_ms"] = WaitHistogram::percentileMs(last_window_waits_, 0.50);
+            wait_time["last_window_p99_ms"] = WaitHistogram::percentileMs(last_window_waits_, 0.99);
+            status["borrow_rate_per_second"] = borrow_rate_;
+        }
+        status["wait_time"] = wait_time;
+        
+        StatementCacheRegistry& registry = statementCaches();
+        json statement_cache;
+        {
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            statement_cache["connections"] = registry.caches.size();
+        }
+        statement_cache["capacity_per_connection"] = Constants::STATEMENT_CACHE_SIZE;
+        statement_cache["hits"] = registry.hits.load();
+        statement_cache["misses"] = registry.misses.load();
+        status["statement_cache"] = statement_cache;
         return status;
     }
     
+    // 获取连接对应的预处理语句缓存(调用方必须持有该连接)
+    PreparedStatementCache& getStatementCache(MYSQL* conn) {
+        StatementCacheRegistry& registry = statementCaches();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        std::unique_ptr<PreparedStatementCache>& cache = registry.caches[conn];
+        if (!cache) {
+            cache.reset(new PreparedStatementCache(Constants::STATEMENT_CACHE_SIZE));
+        }
+        return *cache;
+    }
+    
+    // 记录预处理语句缓存命中情况
+    void recordStatementCacheLookup(bool hit) {
+        if (hit) {
+            statementCaches().hits++;
+        } else {
+            statementCaches().misses++;
+        }
+    }
+    
     // 关闭连接池
     void shutdown() {
         Logger::info("开始关闭数据库连接池...");
         shutdown_flag_ = true;
         
+        // 唤醒维护线程和等待连接的线程
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex_);
+            maintenance_wakeup_.notify_all();
+            connection_available_.notify_all();
+        }
+        
         // 停止维护线程
         if (maintenance_thread_.joinable()) {
             maintenance_thread_.join();
         }
         
-        // 关闭所有连接
-        std::lock_guard<std::mutex> lock(pool_mutex_);
-        while (!available_connections_.empty()) {
-            MYSQL* conn = available_connections_.front();
-            available_connections_.pop();
-            mysql_close(conn);
-            Logger::debug("关闭数据库连接: " + std::to_string(reinterpret_cast<uintptr_t>(conn)));
+        // 关闭所有空闲连接
+        for (auto& shard_ptr : shards_) {
+            std::lock_guard<std::mutex> lock(shard_ptr->mutex);
+            for (const auto& item : shard_ptr->idle) {
+                closeConnection(item.conn);
+                Logger::debug("关闭数据库连接: ", reinterpret_cast<uintptr_t>(item.conn));
+            }
+            shard_ptr->idle.clear();
         }
         
-        connection_timestamps_.clear();
+        idle_connections_ = 0;
         total_connections_ = 0;
         active_connections_ = 0;
         initialized_ = false;
@@ -766,7 +2369,7 @@ public:
             }
             connection_owned_ = true;
         } catch (const std::exception& e) {
-            Logger::error("ConnectionGuard构造失败: " + std::string(e.what()));
+            Logger::error("ConnectionGuard构造失败: ", e.what());
             throw;
         }
     }
@@ -776,7 +2379,7 @@ public:
             try {
                 pool_.returnConnection(connection_);
             } catch (const std::exception& e) {
-                Logger::error("ConnectionGuard析构失败: " + std::string(e.what()));
+                Logger::error("ConnectionGuard析构失败: ", e.what());
             }
             connection_ = nullptr;
             connection_owned_ = false;
@@ -785,14 +2388,9 @@ public:
     
     MYSQL* get() const { return connection_; }
     
+    // 连接池在借出前已按空闲时长做过健康检查，这里不再额外ping
     bool isValid() const { 
-        if (!connection_) return false;
-        try {
-            return mysql_ping(connection_) == 0;
-        } catch (const std::exception& e) {
-            Logger::error("数据库连接检查失败: " + std::string(e.what()));
-            return false;
-        }
+        return connection_ != nullptr;
     }
     
     // 禁用拷贝，允许移动
@@ -809,7 +2407,7 @@ public:
                 try {
                     pool_.returnConnection(connection_);
                 } catch (const std::exception& e) {
-                    Logger::error("ConnectionGuard移动赋值失败: " + std::string(e.what()));
+                    Logger::error("ConnectionGuard移动赋值失败: ", e.what());
                 }
             }
             connection_ = other.connection_;
@@ -821,630 +2419,5778 @@ public:
     }
 };
 
-// 基础服务类 
-class BaseService {
-protected:
-    DatabaseConnectionPool& db_pool_;
-    static std::mutex column_cache_mutex_;
-    static std::unordered_map<std::string, std::unordered_map<std::string, bool>> column_exists_cache_;
-    
-    // 构造函数设为保护，防止直接实例化
-    BaseService() : db_pool_(DatabaseConnectionPool::getInstance()) {
-        if (!db_pool_.getPoolStatus()["initialized"].get<bool>()) {
-            throw std::runtime_error("数据库连接池未初始化");
-        }
-    }
-    
-public:
-    virtual ~BaseService() = default;
-    bool columnExists(const std::string& table_name, const std::string& column_name) const {
-        return hasColumn(table_name, column_name);
-    }
-    std::string combineColumns(const std::vector<std::string>& columns) const {
-        return joinColumns(columns);
-    }
-    
-    // 创建成功响应的模板方法
-    json createSuccessResponse(const json& data = json::object(), 
-                             const std::string& message = "操作成功") const {
-        json response;
-        response["success"] = true;
-        response["message"] = message;
-        response["data"] = data;
-        response["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
-            std::chrono::system_clock::now().time_since_epoch()).count();
-        return response;
-    }
-    
-    // 创建错误响应的模板方法
-    json createErrorResponse(const std::string& message, 
-                           int error_code = Constants::ERROR_CODE) const {
+// 异步查询引擎 - 固定数量的I/O线程各自从连接池借连接执行查询
+// 调用方提交后立即拿到future(或注册完成回调)，可以一次发起多条查询，
+// 让一个业务线程在等待期间同时占用多个池化连接；队列满或引擎未启动时由调用线程直接执行
+class AsyncQueryEngine {
+private:
+    struct Job {
+        std::function<json()> task;
+        std::shared_ptr<std::promise<json>> promise;
+        std::function<void(const json&)> on_complete;
+        std::string trace_id;  // 提交线程上进行中的追踪，I/O线程执行时沿用
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::deque<Job> queue_;
+    std::vector<std::thread> workers_;
+    bool running_;
+
+    std::atomic<long long> submitted_;
+    std::atomic<long long> completed_;
+    std::atomic<long long> caller_runs_;
+    std::atomic<long long> in_flight_;
+    std::atomic<long long> peak_in_flight_;
+
+    AsyncQueryEngine()
+        : running_(false)
+        , submitted_(0)
+        , completed_(0)
+        , caller_runs_(0)
+        , in_flight_(0)
+        , peak_in_flight_(0) {}
+
+    static json errorResult(const std::string& message) {
         json response;
         response["success"] = false;
         response["message"] = message;
-        response["error_code"] = error_code;
+        response["error_code"] = Constants::DATABASE_ERROR_CODE;
         response["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
             std::chrono::system_clock::now().time_since_epoch()).count();
         return response;
     }
+
+    // 执行任务并交付结果，任务异常转换为错误响应
+    void run(Job& job) {
+        long long now_in_flight = ++in_flight_;
+        long long peak = peak_in_flight_.load();
+        while (now_in_flight > peak && !peak_in_flight_.compare_exchange_weak(peak, now_in_flight)) {
+        }
+
+        // 在I/O线程上以同一trace_id开一段追踪；由调用线程直接执行时只是当前追踪下的一个span
+        bool own_trace = !job.trace_id.empty() && !Tracer::active() &&
+                         Tracer::getInstance().beginTrace(job.trace_id, "async.query");
+        json result;
+        {
+            TraceSpan span("async.task", "async");
+            try {
+                result = job.task();
+            } catch (const std::exception& e) {
+                result = errorResult("异步查询执行异常: " + std::string(e.what()));
+            } catch (...) {
+                result = errorResult("异步查询执行发生未知异常");
+            }
+        }
+        if (own_trace) {
+            Tracer::getInstance().endTrace();
+        }
+        in_flight_--;
+        completed_++;
+
+        if (job.on_complete) {
+            try {
+                job.on_complete(result);
+            } catch (const std::exception& e) {
+                Logger::error("异步查询回调异常: " + std::string(e.what()));
+            } catch (...) {
+                Logger::error("异步查询回调发生未知异常");
+            }
+        }
+        job.promise->set_value(std::move(result));
+    }
+
+    void workerLoop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                not_empty_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            run(job);
+        }
+    }
+
+public:
+    static AsyncQueryEngine& getInstance() {
+        static AsyncQueryEngine instance;
+        return instance;
+    }
+
+    AsyncQueryEngine(const AsyncQueryEngine&) = delete;
+    AsyncQueryEngine& operator=(const AsyncQueryEngine&) = delete;
+
+    void start(size_t thread_count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_) {
+            return;
+        }
+        running_ = true;
+        for (size_t i = 0; i < std::max<size_t>(1, thread_count); ++i) {
+            workers_.emplace_back(&AsyncQueryEngine::workerLoop, this);
+        }
+        Logger::info("异步查询引擎已启动，I/O线程数: " + std::to_string(workers_.size()));
+    }
+
+    // 停止接收新任务，已排队的任务执行完后退出
+    void shutdown() {
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                return;
+            }
+            running_ = false;
+            workers.swap(workers_);
+        }
+        not_empty_.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        Logger::info("异步查询引擎已关闭");
+    }
+
+    // 提交查询任务；on_complete在I/O线程上调用，需自行保证线程安全且不应阻塞
+    std::future<json> submit(std::function<json()> task,
+                             std::function<void(const json&)> on_complete = nullptr) {
+        Job job;
+        job.task = std::move(task);
+        job.promise = std::make_shared<std::promise<json>>();
+        job.on_complete = std::move(on_complete);
+        job.trace_id = Tracer::currentTraceId();
+        std::future<json> future = job.promise->get_future();
+        submitted_++;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (running_ && queue_.size() < Constants::ASYNC_QUERY_QUEUE_LIMIT) {
+                queue_.push_back(std::move(job));
+                not_empty_.notify_one();
+                return future;
+            }
+        }
+
+        caller_runs_++;
+        run(job);
+        return future;
+    }
+
+    json getStats() const {
+        json stats;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats["running"] = running_;
+            stats["threads"] = workers_.size();
+            stats["queued"] = queue_.size();
+        }
+        stats["submitted"] = submitted_.load();
+        stats["completed"] = completed_.load();
+        stats["caller_runs"] = caller_runs_.load();
+        stats["in_flight"] = in_flight_.load();
+        stats["peak_in_flight"] = peak_in_flight_.load();
+        return stats;
+    }
+
+    ~AsyncQueryEngine() {
+        shutdown();
+    }
+};
+
+// 原生请求执行器 - 有界的工作窃取线程池，执行完整的服务调用(异步查询引擎只执行单条SQL)。
+// 每个工作线程有自己的双端队列：外部线程提交的任务轮流放入各线程队列，工作线程内部提交的任务
+// 放入自己的队列尾部；工作线程优先从自己队列尾部取任务，为空时从其他线程队列头部窃取。
+// 批量命令和异步JNI请求都在这里执行；服务调用内部仍可使用异步查询引擎，两个线程池互相独立，
+// 不会出现工作线程占满后等待自己队列中的任务而死锁。排队总数有上限，超出时submit由调用线程
+// 直接执行，trySubmit返回false由调用方决定如何处理
+class NativeRequestExecutor {
+private:
+    struct Task {
+        std::function<json()> work;
+        std::function<void(json&&)> complete;
+        std::string trace_id;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    mutable std::shared_mutex state_mutex_;  // 提交方持共享锁，启停持独占锁，保护queues_和workers_
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<bool> running_;
+    size_t queue_limit_;
+
+    std::mutex idle_mutex_;
+    std::condition_variable work_available_;
+    std::atomic<size_t> pending_;     // 已入队尚未被取走的任务数
+    std::atomic<size_t> next_queue_;
+
+    std::atomic<long long> submitted_;
+    std::atomic<long long> completed_;
+    std::atomic<long long> caller_runs_;
+    std::atomic<long long> rejected_;
+    std::atomic<long long> steals_;
+    std::atomic<long long> active_;
+    std::atomic<long long> peak_active_;
+
+    NativeRequestExecutor()
+        : running_(false)
+        , queue_limit_(Constants::COMMAND_EXECUTOR_QUEUE_LIMIT)
+        , pending_(0)
+        , next_queue_(0)
+        , submitted_(0)
+        , completed_(0)
+        , caller_runs_(0)
+        , rejected_(0)
+        , steals_(0)
+        , active_(0)
+        , peak_active_(0) {}
+
+    // 当前线程在本执行器中的工作线程序号，非工作线程为-1
+    static int& currentWorker() {
+        thread_local int index = -1;
+        return index;
+    }
+
+    static json errorResult(const std::string& message) {
+        json response;
+        response["success"] = false;
+        response["message"] = message;
+        response["error_code"] = Constants::ERROR_CODE;
+        return response;
+    }
+
+    void run(Task& task) {
+        long long now_active = ++active_;
+        long long peak = peak_active_.load();
+        while (now_active > peak && !peak_active_.compare_exchange_weak(peak, now_active)) {
+        }
+
+        bool own_trace = !task.trace_id.empty() && !Tracer::active() &&
+                         Tracer::getInstance().beginTrace(task.trace_id, "native.request");
+        json result;
+        {
+            TraceSpan span("executor.task", "executor");
+            try {
+                result = task.work();
+            } catch (const std::exception& e) {
+                result = errorResult("服务命令执行异常: " + std::string(e.what()));
+            } catch (...) {
+                result = errorResult("服务命令执行发生未知异常");
+            }
+        }
+        if (own_trace) {
+            Tracer::getInstance().endTrace();
+        }
+        active_--;
+        completed_++;
+        try {
+            task.complete(std::move(result));
+        } catch (const std::exception& e) {
+            Logger::error("服务命令完成回调异常: " + std::string(e.what()));
+        }
+    }
+
+    // 先取自己队列尾部(最近提交，缓存较热)，再从其他队列头部窃取
+    bool takeTask(size_t index, Task& task) {
+        size_t count = queues_.size();
+        for (size_t k = 0; k < count; ++k) {
+            WorkerQueue& queue = *queues_[(index + k) % count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (k == 0) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                steals_++;
+            }
+            pending_--;
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index) {
+        currentWorker() = static_cast<int>(index);
+        while (true) {
+            Task task;
+            if (takeTask(index, task)) {
+                run(task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idle_mutex_);
+            if (pending_.load() > 0) {
+                continue;  // 任务已计数但尚未放入队列，重新扫描
+            }
+            if (!running_.load()) {
+                return;  // 停止后排空所有队列才退出
+            }
+            work_available_.wait(lock, [this]() { return pending_.load() > 0 || !running_.load(); });
+        }
+    }
+
+    // 放入队列，执行器未运行或排队已满时返回false
+    bool enqueue(Task& task) {
+        std::shared_lock<std::shared_mutex> state(state_mutex_);
+        if (!running_.load()) {
+            return false;
+        }
+        if (pending_.fetch_add(1) >= queue_limit_) {
+            pending_--;
+            return false;
+        }
+        int worker = currentWorker();
+        size_t index = worker >= 0 && static_cast<size_t>(worker) < queues_.size()
+            ? static_cast<size_t>(worker)
+            : next_queue_.fetch_add(1) % queues_.size();
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        // 先经过idle_mutex_再通知，避免工作线程检查完条件、尚未等待时错过通知
+        { std::lock_guard<std::mutex> lock(idle_mutex_); }
+        work_available_.notify_one();
+        return true;
+    }
+
+public:
+    static NativeRequestExecutor& getInstance() {
+        static NativeRequestExecutor instance;
+        return instance;
+    }
+
+    NativeRequestExecutor(const NativeRequestExecutor&) = delete;
+    NativeRequestExecutor& operator=(const NativeRequestExecutor&) = delete;
+
+    void start(size_t thread_count, size_t queue_limit) {
+        std::unique_lock<std::shared_mutex> state(state_mutex_);
+        if (running_.load()) {
+            return;
+        }
+        size_t count = std::max<size_t>(1, thread_count);
+        queue_limit_ = std::max<size_t>(1, queue_limit);
+        queues_.clear();
+        for (size_t i = 0; i < count; ++i) {
+            queues_.push_back(std::make_unique<WorkerQueue>());
+        }
+        running_ = true;
+        for (size_t i = 0; i < count; ++i) {
+            workers_.emplace_back(&NativeRequestExecutor::workerLoop, this, i);
+        }
+        Logger::info("原生请求执行器已启动，工作线程数: " + std::to_string(count) +
+                     "，排队上限: " + std::to_string(queue_limit_));
+    }
+
+    // 停止接收新任务，已排队的任务执行完后退出；须在服务实例销毁前调用
+    void shutdown() {
+        std::vector<std::thread> workers;
+        {
+            std::unique_lock<std::shared_mutex> state(state_mutex_);
+            if (!running_.load()) {
+                return;
+            }
+            running_ = false;
+            workers.swap(workers_);
+        }
+        { std::lock_guard<std::mutex> lock(idle_mutex_); }
+        work_available_.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+        {
+            std::unique_lock<std::shared_mutex> state(state_mutex_);
+            queues_.clear();
+        }
+        Logger::info("原生请求执行器已关闭");
+    }
+
+    // 提交并等待结果；排队已满、执行器未启动或在工作线程上调用时由调用线程直接执行
+    // (工作线程阻塞等待自己提交的任务，所有线程都这样做时会死锁)
+    std::future<json> submit(std::function<json()> work) {
+        auto promise = std::make_shared<std::promise<json>>();
+        std::future<json> future = promise->get_future();
+        Task task;
+        task.work = std::move(work);
+        task.complete = [promise](json&& result) { promise->set_value(std::move(result)); };
+        task.trace_id = Tracer::currentTraceId();
+        submitted_++;
+
+        if (currentWorker() >= 0 || !enqueue(task)) {
+            caller_runs_++;
+            run(task);
+        }
+        return future;
+    }
+
+    // 提交后立即返回，结果在工作线程上交给complete；排队已满或执行器未启动时返回false且不执行
+    bool trySubmit(std::function<json()> work, std::function<void(json&&)> complete) {
+        Task task;
+        task.work = std::move(work);
+        task.complete = std::move(complete);
+        task.trace_id = Tracer::currentTraceId();
+        if (!enqueue(task)) {
+            rejected_++;
+            return false;
+        }
+        submitted_++;
+        return true;
+    }
+
+    json getStats() const {
+        json stats;
+        {
+            std::shared_lock<std::shared_mutex> state(state_mutex_);
+            stats["running"] = running_.load();
+            stats["threads"] = workers_.size();
+            stats["queue_limit"] = queue_limit_;
+        }
+        stats["queued"] = pending_.load();
+        stats["submitted"] = submitted_.load();
+        stats["completed"] = completed_.load();
+        stats["caller_runs"] = caller_runs_.load();
+        stats["rejected"] = rejected_.load();
+        stats["steals"] = steals_.load();
+        stats["active"] = active_.load();
+        stats["peak_active"] = peak_active_.load();
+        return stats;
+    }
+
+    ~NativeRequestExecutor() {
+        shutdown();
+    }
+};
+
+// 流式JSON输出缓冲区 - 直接把MySQL行数据写成最终的JSON文本，跳过nlohmann::json中间对象
+// 列表类接口只转发查询结果，用它可以省掉逐个单元格的字符串/JSON节点分配
+class JsonWriter {
+private:
+    std::string buffer_;
+
+    // 判断文本是否为合法的JSON数字(ZEROFILL等格式需要退回字符串)
+    static bool isJsonNumber(const char* data, size_t length) {
+        size_t i = 0;
+        if (i < length && data[i] == '-') ++i;
+        if (i >= length) return false;
+        if (data[i] == '0') {
+            ++i;
+        } else if (data[i] >= '1' && data[i] <= '9') {
+            while (i < length && std::isdigit(static_cast<unsigned char>(data[i]))) ++i;
+        } else {
+            return false;
+        }
+        if (i < length && data[i] == '.') {
+            ++i;
+            size_t digits_start = i;
+            while (i < length && std::isdigit(static_cast<unsigned char>(data[i]))) ++i;
+            if (i == digits_start) return false;
+        }
+        if (i < length && (data[i] == 'e' || data[i] == 'E')) {
+            ++i;
+            if (i < length && (data[i] == '+' || data[i] == '-')) ++i;
+            size_t digits_start = i;
+            while (i < length && std::isdigit(static_cast<unsigned char>(data[i]))) ++i;
+            if (i == digits_start) return false;
+        }
+        return i == length;
+    }
+
+public:
+    JsonWriter() {
+        buffer_.reserve(4096);
+    }
+
+    // 清空内容但保留已分配的容量，便于同一线程重复使用
+    void clear() { buffer_.clear(); }
+    // 与外部缓冲区交换内容，用于把生成好的响应整体交出而不复制
+    void swapBuffer(std::string& other) { buffer_.swap(other); }
+    const std::string& str() const { return buffer_; }
+    const char* c_str() const { return buffer_.c_str(); }
+    size_t size() const { return buffer_.size(); }
+
+    // 回退到之前记录的长度，丢弃之后写入的内容(用于失败重试)
+    void truncate(size_t length) {
+        if (length < buffer_.size()) {
+            buffer_.resize(length);
+        }
+    }
+
+    JsonWriter& raw(const char* data, size_t length) {
+        buffer_.append(data, length);
+        return *this;
+    }
+
+    JsonWriter& raw(const std::string& text) {
+        buffer_.append(text);
+        return *this;
+    }
+
+    JsonWriter& raw(char c) {
+        buffer_.push_back(c);
+        return *this;
+    }
+
+    // 写入带引号的转义字符串，无需转义的片段整段拷贝
+    JsonWriter& string(const char* data, size_t length) {
+        buffer_.push_back('"');
+        size_t run_start = 0;
+        for (size_t i = 0; i < length; ++i) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            buffer_.append(data + run_start, i - run_start);
+            switch (c) {
+                case '"': buffer_.append("\\\""); break;
+                case '\\': buffer_.append("\\\\"); break;
+                case '\n': buffer_.append("\\n"); break;
+                case '\r': buffer_.append("\\r"); break;
+                case '\t': buffer_.append("\\t"); break;
+                case '\b': buffer_.append("\\b"); break;
+                case '\f': buffer_.append("\\f"); break;
+                default: {
+                    char escaped[7];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    buffer_.append(escaped, 6);
+                    break;
+                }
+            }
+            run_start = i + 1;
+        }
+        buffer_.append(data + run_start, length - run_start);
+        buffer_.push_back('"');
+        return *this;
+    }
+
+    JsonWriter& string(const std::string& text) {
+        return string(text.data(), text.size());
+    }
+
+    // 写入对象键(含冒号)，first为false时先写逗号
+    JsonWriter& key(const char* name, bool first = false) {
+        if (!first) buffer_.push_back(',');
+        string(name, std::strlen(name));
+        buffer_.push_back(':');
+        return *this;
+    }
+
+    JsonWriter& number(long long value) {
+        buffer_.append(std::to_string(value));
+        return *this;
+    }
+
+    // 其他少量标量(浮点、布尔等)复用nlohmann的格式化，保证与dump()输出一致
+    JsonWriter& value(const json& scalar) {
+        buffer_.append(scalar.dump());
+        return *this;
+    }
+
+    // 以JSON数组形式写出整个结果集，列名在每个结果集中只转义一次
+    size_t appendResultSet(MYSQL_RES* result) {
+        buffer_.push_back('[');
+        if (!result) {
+            buffer_.push_back(']');
+            return 0;
+        }
+
+        unsigned int num_fields = mysql_num_fields(result);
+        MYSQL_FIELD* fields = mysql_fetch_fields(result);
+
+        // 预先生成每列的 "name": 前缀
+        std::vector<std::string> prefixes(num_fields);
+        {
+            JsonWriter name_writer;
+            for (unsigned int i = 0; i < num_fields; ++i) {
+                name_writer.clear();
+                name_writer.raw(i == 0 ? '{' : ',');
+                const char* name = fields[i].name ? fields[i].name : "unknown_field";
+                name_writer.string(name, std::strlen(name));
+                name_writer.raw(':');
+                prefixes[i] = name_writer.str();
+            }
+        }
+
+        size_t row_count = 0;
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result))) {
+            unsigned long* lengths = mysql_fetch_lengths(result);
+            if (!lengths) {
+                continue;
+            }
+
+            if (row_count > 0) buffer_.push_back(',');
+            if (num_fields == 0) buffer_.push_back('{');
+
+            for (unsigned int i = 0; i < num_fields; ++i) {
+                buffer_.append(prefixes[i]);
+
+                if (row[i] == nullptr) {
+                    buffer_.append("null");
+                    continue;
+                }
+
+                switch (fields[i].type) {
+                    case MYSQL_TYPE_TINY:
+                    case MYSQL_TYPE_SHORT:
+                    case MYSQL_TYPE_LONG:
+                    case MYSQL_TYPE_LONGLONG:
+                    case MYSQL_TYPE_INT24:
+                    case MYSQL_TYPE_DECIMAL:
+                    case MYSQL_TYPE_NEWDECIMAL:
+                    case MYSQL_TYPE_FLOAT:
+                    case MYSQL_TYPE_DOUBLE:
+                        // 数值列的文本表示本身就是JSON数字，直接拷贝
+                        if (isJsonNumber(row[i], lengths[i])) {
+                            buffer_.append(row[i], lengths[i]);
+                        } else {
+                            string(row[i], lengths[i]);
+                        }
+                        break;
+
+                    case MYSQL_TYPE_BIT: {
+                        bool bit_value = (lengths[i] == 1 && (row[i][0] == '1' || row[i][0] == '\x01'));
+                        buffer_.append(bit_value ? "true" : "false");
+                        break;
+                    }
+
+                    default:
+                        string(row[i], lengths[i]);
+                        break;
+                }
+            }
+            buffer_.push_back('}');
+            ++row_count;
+        }
+
+        buffer_.push_back(']');
+        return row_count;
+    }
+};
+
+// 分片TTL缓存 - 按键哈希分片加锁，每个分片内按LRU淘汰
+// Value应当是拷贝代价低的类型(如shared_ptr)，get时在分片锁内拷贝
+// 每个分片带失效代数：回源前用generation取得代数，回源后用带代数的put写入，
+// 期间该分片发生过erase/clear时丢弃这次写入，避免读到旧数据的请求在失效之后把旧值写回
+template <typename Value>
+class ShardedTtlCache {
+private:
+    struct Entry {
+        Value value;
+        std::chrono::steady_clock::time_point expires_at;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> lru;  // 表头为最近使用
+        uint64_t generation = 0;     // 每次erase/clear递增
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t capacity_per_shard_;
+    std::chrono::seconds ttl_;
+
+    std::atomic<long long> hits_;
+    std::atomic<long long> misses_;
+    std::atomic<long long> evictions_;
+    std::atomic<long long> expirations_;
+    std::atomic<long long> invalidations_;
+    std::atomic<long long> stale_puts_;
+
+    Shard& shardFor(const std::string& key) const {
+        return *shards_[std::hash<std::string>()(key) % shards_.size()];
+    }
+
+    void putLocked(Shard& shard, const std::string& key, const Value& value) {
+        auto expires_at = std::chrono::steady_clock::now() + ttl_;
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            it->second.value = value;
+            it->second.expires_at = expires_at;
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+            return;
+        }
+
+        shard.lru.push_front(key);
+        shard.entries.emplace(key, Entry{value, expires_at, shard.lru.begin()});
+
+        while (shard.entries.size() > capacity_per_shard_) {
+            shard.entries.erase(shard.lru.back());
+            shard.lru.pop_back();
+            evictions_++;
+        }
+    }
+
+public:
+    ShardedTtlCache(size_t shard_count, size_t capacity, std::chrono::seconds ttl)
+        : capacity_per_shard_(std::max<size_t>(1, capacity / std::max<size_t>(1, shard_count)))
+        , ttl_(ttl)
+        , hits_(0)
+        , misses_(0)
+        , evictions_(0)
+        , expirations_(0)
+        , invalidations_(0)
+        , stale_puts_(0) {
+        for (size_t i = 0; i < std::max<size_t>(1, shard_count); ++i) {
+            shards_.emplace_back(new Shard());
+        }
+    }
+
+    ShardedTtlCache(const ShardedTtlCache&) = delete;
+    ShardedTtlCache& operator=(const ShardedTtlCache&) = delete;
+
+    bool get(const std::string& key, Value& out) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            misses_++;
+            return false;
+        }
+        if (std::chrono::steady_clock::now() >= it->second.expires_at) {
+            shard.lru.erase(it->second.lru_it);
+            shard.entries.erase(it);
+            expirations_++;
+            misses_++;
+            return false;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second.lru_it);
+        out = it->second.value;
+        hits_++;
+        return true;
+    }
+
+    void put(const std::string& key, const Value& value) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        putLocked(shard, key, value);
+    }
+
+    // 键所在分片的当前失效代数，回源前取得
+    uint64_t generation(const std::string& key) const {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.generation;
+    }
+
+    // 仅当取得代数之后分片未发生失效时写入，返回是否写入
+    bool put(const std::string& key, const Value& value, uint64_t generation) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.generation != generation) {
+            stale_puts_++;
+            return false;
+        }
+        putLocked(shard, key, value);
+        return true;
+    }
+
+    // 主动失效单个键，返回是否存在；键不存在时同样推进代数，挡住进行中的回源
+    bool erase(const std::string& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.generation++;
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end()) {
+            return false;
+        }
+        shard.lru.erase(it->second.lru_it);
+        shard.entries.erase(it);
+        invalidations_++;
+        return true;
+    }
+
+    // 清空全部条目，返回清除的数量
+    size_t clear() {
+        size_t removed = 0;
+        for (auto& shard_ptr : shards_) {
+            std::lock_guard<std::mutex> lock(shard_ptr->mutex);
+            shard_ptr->generation++;
+            removed += shard_ptr->entries.size();
+            shard_ptr->entries.clear();
+            shard_ptr->lru.clear();
+        }
+        invalidations_ += static_cast<long long>(removed);
+        return removed;
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& shard_ptr : shards_) {
+            std::lock_guard<std::mutex> lock(shard_ptr->mutex);
+            total += shard_ptr->entries.size();
+        }
+        return total;
+    }
+
+    json stats() const {
+        json result;
+        long long hits = hits_.load();
+        long long misses = misses_.load();
+        result["keys"] = size();
+        result["capacity"] = capacity_per_shard_ * shards_.size();
+        result["shards"] = shards_.size();
+        result["ttl_seconds"] = ttl_.count();
+        result["hits"] = hits;
+        result["misses"] = misses;
+        result["hit_rate"] = (hits + misses) > 0 ? 100.0 * hits / (hits + misses) : 0.0;
+        result["expired_keys"] = expirations_.load();
+        result["evicted_keys"] = evictions_.load();
+        result["invalidated_keys"] = invalidations_.load();
+        result["stale_puts_dropped"] = stale_puts_.load();
+        return result;
+    }
+};
+
+// 请求合并(single-flight)统计的公共部分：各实例构造时登记，指标接口按名称汇总
+class SingleFlightStats {
+private:
+    static std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+    static std::vector<const SingleFlightStats*>& registry() {
+        static std::vector<const SingleFlightStats*> instances;
+        return instances;
+    }
+
+protected:
+    std::string name_;
+    std::chrono::milliseconds ttl_;
+    std::atomic<long long> executions_;   // 实际执行次数
+    std::atomic<long long> coalesced_;    // 等待进行中的同键调用而未执行的次数
+    std::atomic<long long> ttl_hits_;     // 命中刚完成结果(micro-TTL内)的次数
+    std::atomic<long long> failures_;
+
+    SingleFlightStats(std::string name, std::chrono::milliseconds ttl)
+        : name_(std::move(name)), ttl_(ttl), executions_(0), coalesced_(0), ttl_hits_(0), failures_(0) {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        registry().push_back(this);
+    }
+
+    ~SingleFlightStats() {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto& instances = registry();
+        instances.erase(std::remove(instances.begin(), instances.end(), this), instances.end());
+    }
+
+public:
+    SingleFlightStats(const SingleFlightStats&) = delete;
+    SingleFlightStats& operator=(const SingleFlightStats&) = delete;
+
+    json stats() const {
+        long long executions = executions_.load();
+        long long shared = coalesced_.load() + ttl_hits_.load();
+        json result;
+        result["micro_ttl_ms"] = ttl_.count();
+        result["executions"] = executions;
+        result["coalesced"] = coalesced_.load();
+        result["ttl_hits"] = ttl_hits_.load();
+        result["failures"] = failures_.load();
+        result["shared_rate"] = executions + shared > 0 ? 100.0 * shared / (executions + shared) : 0.0;
+        return result;
+    }
+
+    static json collectStats() {
+        json result = json::object();
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const SingleFlightStats* instance : registry()) {
+            result[instance->name_] = instance->stats();
+        }
+        return result;
+    }
+};
+
+// 请求合并 - 同一时刻键相同的读调用只执行一次，其余调用等待并共享这次执行的结果。
+// 可选的micro-TTL让刚完成的结果在很短时间内继续被复用；为0时结果完成即丢弃，只合并并发调用。
+// 执行抛出异常时所有等待者收到同一异常，结果不保留。写操作后调用forget，之后的调用重新执行，
+// 已在等待的调用仍拿到写之前开始的那次结果
+template <typename Value>
+class SingleFlight : public SingleFlightStats {
+private:
+    struct Call {
+        std::promise<Value> promise;
+        std::shared_future<Value> future;
+        bool done = false;
+        std::chrono::steady_clock::time_point done_at;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Call>> calls;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    Shard& shardFor(const std::string& key) {
+        return *shards_[std::hash<std::string>()(key) % shards_.size()];
+    }
+
+    // 只移除仍指向call的条目，forget之后新发起的调用不受影响
+    void finish(Shard& shard, const std::string& key, const std::shared_ptr<Call>& call, bool keep) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.calls.find(key);
+        if (it == shard.calls.end() || it->second != call) {
+            return;
+        }
+        if (keep && ttl_.count() > 0) {
+            call->done = true;
+            call->done_at = std::chrono::steady_clock::now();
+        } else {
+            shard.calls.erase(it);
+        }
+    }
+
+public:
+    SingleFlight(std::string name, size_t shard_count, std::chrono::milliseconds micro_ttl)
+        : SingleFlightStats(std::move(name), micro_ttl) {
+        for (size_t i = 0; i < std::max<size_t>(1, shard_count); ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    // keep判断结果能否在micro-TTL内复用(如失败响应不复用)，不影响已在等待的调用
+    template <typename Fn>
+    Value run(const std::string& key, Fn&& fn, const std::function<bool(const Value&)>& keep = nullptr) {
+        Shard& shard = shardFor(key);
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        auto it = shard.calls.find(key);
+        if (it != shard.calls.end()) {
+            std::shared_ptr<Call> existing = it->second;
+            if (!existing->done) {
+                coalesced_++;
+                std::shared_future<Value> future = existing->future;
+                lock.unlock();
+                return future.get();
+            }
+            if (std::chrono::steady_clock::now() - existing->done_at < ttl_) {
+                ttl_hits_++;
+                std::shared_future<Value> future = existing->future;
+                lock.unlock();
+                return future.get();
+            }
+            shard.calls.erase(it);
+        }
+        std::shared_ptr<Call> call = std::make_shared<Call>();
+        call->future = call->promise.get_future().share();
+        shard.calls.emplace(key, call);
+        lock.unlock();
+
+        executions_++;
+        try {
+            Value value = fn();
+            bool reusable = !keep || keep(value);
+            call->promise.set_value(value);
+            finish(shard, key, call, reusable);
+            return value;
+        } catch (...) {
+            failures_++;
+            call->promise.set_exception(std::current_exception());
+            finish(shard, key, call, false);
+            throw;
+        }
+    }
+
+    void forget(const std::string& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.calls.erase(key);
+    }
+
+    void clear() {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->calls.clear();
+        }
+    }
+};
+
+// 读取config.json的single_flight节中的复用时间配置
+inline std::chrono::milliseconds singleFlightTtl(const char* key, int default_ms) {
+    int ttl_ms = default_ms;
+    try {
+        ttl_ms = ConfigLoader::getInstance().getInt("single_flight", key, default_ms);
+    } catch (const std::exception& e) {
+        Logger::warn("读取请求合并配置失败，使用默认值: " + std::string(e.what()));
+    }
+    return std::chrono::milliseconds(std::max(0, ttl_ms));
+}
+
+// 分段锁表 - 按键哈希到固定数量的互斥锁，不同用户/订单的操作落在不同分段上并行执行
+// 同一线程不可对同一张表重复加锁(互斥锁不可重入)，多键加锁请使用lockAll
+class StripedLockManager {
+private:
+    struct alignas(64) Stripe {
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<Stripe>> stripes_;
+
+public:
+    explicit StripedLockManager(size_t stripe_count) {
+        stripes_.reserve(std::max<size_t>(1, stripe_count));
+        for (size_t i = 0; i < std::max<size_t>(1, stripe_count); ++i) {
+            stripes_.push_back(std::make_unique<Stripe>());
+        }
+    }
+
+    size_t stripeIndex(long long key) const {
+        return std::hash<long long>()(key) % stripes_.size();
+    }
+
+    size_t stripeIndex(const std::string& key) const {
+        return std::hash<std::string>()(key) % stripes_.size();
+    }
+
+    std::unique_lock<std::mutex> lock(long long key) {
+        TraceSpan span("lock.wait", "lock");
+        return std::unique_lock<std::mutex>(stripes_[stripeIndex(key)]->mutex);
+    }
+
+    std::unique_lock<std::mutex> lock(const std::string& key) {
+        TraceSpan span("lock.wait", "lock");
+        return std::unique_lock<std::mutex>(stripes_[stripeIndex(key)]->mutex);
+    }
+
+    // 同时锁定多个键：分段去重后按下标升序加锁，保证任意两组键之间不会死锁
+    std::vector<std::unique_lock<std::mutex>> lockAll(const std::vector<long long>& keys) {
+        TraceSpan span("lock.wait", "lock");
+        std::vector<size_t> indexes;
+        indexes.reserve(keys.size());
+        for (long long key : keys) {
+            indexes.push_back(stripeIndex(key));
+        }
+        std::sort(indexes.begin(), indexes.end());
+        indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+
+        std::vector<std::unique_lock<std::mutex>> locks;
+        locks.reserve(indexes.size());
+        for (size_t index : indexes) {
+            locks.emplace_back(stripes_[index]->mutex);
+        }
+        return locks;
+    }
+
+    size_t stripeCount() const { return stripes_.size(); }
+};
+
+// 只读副本路由 - 为每个副本维护独立连接池，按权重和复制延迟把读请求分发到健康副本
+// 后台线程定期检查副本可用性与复制延迟；刚发生写入的用户在短时间内固定读主库(read-your-writes)
+// 未配置副本、所有副本不可用或延迟过高时，pickReplica返回nullptr，调用方使用主库
+class ReplicaRouter {
+private:
+    struct Replica {
+        ReplicaEndpoint endpoint;
+        std::unique_ptr<DatabaseConnectionPool> pool;
+        std::atomic<bool> healthy{false};
+        std::atomic<long long> lag_seconds{-1};   // -1表示尚未探测或复制中断
+        std::atomic<long long> routed{0};
+        std::atomic<long long> failures{0};
+    };
+    
+    std::vector<std::unique_ptr<Replica>> replicas_;
+    ShardedTtlCache<bool> recent_writers_;
+    std::thread health_thread_;
+    std::mutex health_mutex_;
+    std::condition_variable health_wakeup_;
+    std::atomic<bool> running_;
+    std::atomic<long long> primary_reads_;
+    std::atomic<long long> sticky_reads_;
+    
+    ReplicaRouter()
+        : recent_writers_(Constants::CATALOG_CACHE_SHARDS, Constants::READ_YOUR_WRITES_CAPACITY,
+                          std::chrono::seconds(Constants::READ_YOUR_WRITES_SECONDS))
+        , running_(false)
+        , primary_reads_(0)
+        , sticky_reads_(0) {}
+    
+    // 读取复制延迟：非副本实例(没有复制状态)视为0，复制线程中断(NULL)返回-1
+    static long long queryReplicationLag(MYSQL* conn) {
+        if (mysql_query(conn, "SHOW REPLICA STATUS") != 0 &&
+            mysql_query(conn, "SHOW SLAVE STATUS") != 0) {  // MySQL 8.0.22之前的语法
+            return -1;
+        }
+        MYSQL_RES* result = mysql_store_result(conn);
+        if (!result) {
+            return mysql_field_count(conn) == 0 ? 0 : -1;
+        }
+        
+        long long lag = 0;
+        MYSQL_ROW row = mysql_fetch_row(result);
+        if (row) {
+            lag = -1;
+            unsigned int field_count = mysql_num_fields(result);
+            MYSQL_FIELD* fields = mysql_fetch_fields(result);
+            for (unsigned int i = 0; i < field_count; ++i) {
+                std::string name = fields[i].name;
+                if (name == "Seconds_Behind_Source" || name == "Seconds_Behind_Master") {
+                    lag = row[i] ? std::atoll(row[i]) : -1;
+                    break;
+                }
+            }
+        }
+        mysql_free_result(result);
+        return lag;
+    }
+    
+    // 检查单个副本，副本启动时不可用的在这里补做连接池初始化
+    void probe(Replica& replica) {
+        if (!replica.pool->isInitialized() && !replica.pool->initialize()) {
+            replica.healthy = false;
+            return;
+        }
+        
+        long long lag = -1;
+        MYSQL* conn = replica.pool->getConnection();
+        if (conn) {
+            lag = queryReplicationLag(conn);
+            replica.pool->returnConnection(conn);
+        }
+        
+        bool was_healthy = replica.healthy.load();
+        bool healthy = lag >= 0 && lag <= Constants::REPLICA_MAX_LAG_SECONDS;
+        replica.lag_seconds = lag;
+        replica.healthy = healthy;
+        if (was_healthy != healthy) {
+            Logger::warn("只读副本 " + replica.pool->describeEndpoint() + (healthy ? " 恢复可用" : " 不可用") +
+                         "，复制延迟: " + std::to_string(lag) + "秒");
+        }
+    }
+    
+    void healthLoop() {
+        while (running_) {
+            {
+                std::unique_lock<std::mutex> lock(health_mutex_);
+                health_wakeup_.wait_for(lock, std::chrono::seconds(Constants::REPLICA_HEALTH_CHECK_SECONDS), [this] {
+                    return !running_.load();
+                });
+            }
+            if (!running_) {
+                break;
+            }
+            for (auto& replica : replicas_) {
+                probe(*replica);
+            }
+        }
+    }
+    
+public:
+    static ReplicaRouter& getInstance() {
+        static ReplicaRouter instance;
+        return instance;
+    }
+    
+    ReplicaRouter(const ReplicaRouter&) = delete;
+    ReplicaRouter& operator=(const ReplicaRouter&) = delete;
+    
+    // 创建副本连接池并同步完成首次探测；没有配置副本时不启动后台线程
+    void initialize(const std::vector<ReplicaEndpoint>& endpoints) {
+        if (running_ || endpoints.empty()) {
+            return;
+        }
+        
+        // 重新初始化时沿用已有的副本对象，只重建连接
+        if (replicas_.empty()) {
+            for (const auto& endpoint : endpoints) {
+                std::unique_ptr<Replica> replica(new Replica());
+                replica->endpoint = endpoint;
+                replica->pool.reset(new DatabaseConnectionPool(endpoint));
+                replicas_.push_back(std::move(replica));
+            }
+        }
+        for (auto& replica : replicas_) {
+            probe(*replica);
+        }
+        
+        running_ = true;
+        health_thread_ = std::thread(&ReplicaRouter::healthLoop, this);
+        Logger::info("读写分离已启用，只读副本数: " + std::to_string(replicas_.size()));
+    }
+    
+    /**
+     * 为一次读请求选择副本
+     * @param sticky_user_id 发起读请求的用户，近期有写入时返回主库(0表示不区分用户)
+     * @return 副本连接池，返回nullptr表示使用主库
+     */
+    DatabaseConnectionPool* pickReplica(long sticky_user_id = 0) {
+        if (!running_) {
+            return nullptr;
+        }
+        
+        bool wrote_recently = false;
+        if (sticky_user_id > 0 && recent_writers_.get(std::to_string(sticky_user_id), wrote_recently)) {
+            sticky_reads_++;
+            primary_reads_++;
+            return nullptr;
+        }
+        
+        // 延迟越大权重越低，但不低于配置权重的10%
+        std::vector<std::pair<Replica*, double>> candidates;
+        candidates.reserve(replicas_.size());
+        double total_weight = 0.0;
+        for (auto& replica : replicas_) {
+            if (!replica->healthy) {
+                continue;
+            }
+            double lag = static_cast<double>(std::max(0LL, replica->lag_seconds.load()));
+            double weight = replica->endpoint.weight * std::max(0.1, 1.0 - lag / Constants::REPLICA_MAX_LAG_SECONDS);
+            candidates.emplace_back(replica.get(), weight);
+            total_weight += weight;
+        }
+        if (candidates.empty()) {
+            primary_reads_++;
+            return nullptr;
+        }
+        
+        static thread_local std::mt19937 generator(std::random_device{}());
+        double pick = std::uniform_real_distribution<double>(0.0, total_weight)(generator);
+        size_t chosen = 0;
+        while (chosen + 1 < candidates.size() && pick >= candidates[chosen].second) {
+            pick -= candidates[chosen].second;
+            chosen++;
+        }
+        candidates[chosen].first->routed++;
+        return candidates[chosen].first->pool.get();
+    }
+    
+    // 记录用户写入，之后READ_YOUR_WRITES_SECONDS内该用户的读请求走主库
+    void markUserWrite(long user_id) {
+        if (running_ && user_id > 0) {
+            recent_writers_.put(std::to_string(user_id), true);
+        }
+    }
+    
+    // 副本上的查询出现连接级错误时立即摘除，等下一轮探测恢复
+    void reportFailure(DatabaseConnectionPool* pool) {
+        for (auto& replica : replicas_) {
+            if (replica->pool.get() == pool) {
+                replica->failures++;
+                if (replica->healthy.exchange(false)) {
+                    Logger::warn("只读副本 " + pool->describeEndpoint() + " 查询失败，暂停路由");
+                }
+                return;
+            }
+        }
+    }
+    
+    json getStatus() const {
+        json status;
+        status["enabled"] = running_.load();
+        status["primary_reads"] = primary_reads_.load();
+        status["sticky_reads"] = sticky_reads_.load();
+        status["read_your_writes_seconds"] = Constants::READ_YOUR_WRITES_SECONDS;
+        status["max_lag_seconds"] = Constants::REPLICA_MAX_LAG_SECONDS;
+        status["replicas"] = json::array();
+        for (const auto& replica : replicas_) {
+            json item;
+            item["endpoint"] = replica->pool->describeEndpoint();
+            item["weight"] = replica->endpoint.weight;
+            item["healthy"] = replica->healthy.load();
+            item["lag_seconds"] = replica->lag_seconds.load();
+            item["routed_reads"] = replica->routed.load();
+            item["failures"] = replica->failures.load();
+            item["pool"] = replica->pool->getPoolStatus();
+            status["replicas"].push_back(item);
+        }
+        return status;
+    }
+    
+    // 停止探测并关闭副本连接池；副本对象保留到进程退出，避免与仍在进行的读请求竞争
+    void shutdown() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(health_mutex_);
+            health_wakeup_.notify_all();
+        }
+        if (health_thread_.joinable()) {
+            health_thread_.join();
+        }
+        for (auto& replica : replicas_) {
+            replica->healthy = false;
+            replica->pool->shutdown();
+        }
+        recent_writers_.clear();
+        Logger::info("读写分离已停止");
+    }
+    
+    ~ReplicaRouter() {
+        shutdown();
+    }
+};
+
+// 数据库结构快照 - 当前库所有表及其列名(均为小写)，创建后只读
+struct SchemaSnapshot {
+    uint64_t version = 0;  // 0表示尚未成功加载
+    std::chrono::system_clock::time_point loaded_at;
+    std::unordered_map<std::string, std::unordered_set<std::string>> tables;
+    size_t column_count = 0;
+    
+    bool loaded() const { return version > 0; }
+    
+    bool hasTable(const std::string& table) const {
+        return tables.find(table) != tables.end();
+    }
+    
+    // table和column须为小写
+    bool hasColumn(const std::string& table, const std::string& column) const {
+        auto it = tables.find(table);
+        return it != tables.end() && it->second.count(column) > 0;
+    }
+    
+    // 返回候选列中第一个存在的列名，都不存在时返回fallback
+    std::string firstColumn(const std::string& table, std::initializer_list<const char*> candidates,
+                            const std::string& fallback = std::string()) const {
+        for (const char* candidate : candidates) {
+            if (hasColumn(table, candidate)) {
+                return candidate;
+            }
+        }
+        return fallback;
+    }
+};
+
+// 数据库结构目录 - 启动时用一条information_schema查询加载全部表和列，
+// 之后列存在性判断只查内存快照；表结构变更后可调用refresh()整体替换快照
+class SchemaCatalog {
+private:
+    std::shared_ptr<const SchemaSnapshot> snapshot_;  // 通过std::atomic_load/atomic_store访问
+    std::atomic<uint64_t> version_;
+    std::mutex refresh_mutex_;
+    
+    SchemaCatalog() : snapshot_(std::make_shared<const SchemaSnapshot>()), version_(0) {}
+    
+public:
+    static SchemaCatalog& getInstance() {
+        static SchemaCatalog instance;
+        return instance;
+    }
+    
+    SchemaCatalog(const SchemaCatalog&) = delete;
+    SchemaCatalog& operator=(const SchemaCatalog&) = delete;
+    
+    std::shared_ptr<const SchemaSnapshot> snapshot() const {
+        return std::atomic_load(&snapshot_);
+    }
+    
+    uint64_t version() const {
+        return version_.load(std::memory_order_acquire);
+    }
+    
+    // 重新加载整个库的表结构，失败时保留原快照
+    bool refresh() {
+        std::lock_guard<std::mutex> lock(refresh_mutex_);
+        auto started = std::chrono::steady_clock::now();
+        std::shared_ptr<SchemaSnapshot> fresh = std::make_shared<SchemaSnapshot>();
+        try {
+            ConnectionGuard conn(DatabaseConnectionPool::getInstance());
+            const char* sql = "SELECT LOWER(TABLE_NAME), LOWER(COLUMN_NAME) FROM information_schema.COLUMNS "
+                              "WHERE TABLE_SCHEMA = DATABASE()";
+            if (mysql_query(conn.get(), sql) != 0) {
+                Logger::error("加载数据库结构失败: " + std::string(mysql_error(conn.get())));
+                return false;
+            }
+            MYSQL_RES* result = mysql_store_result(conn.get());
+            if (!result) {
+                Logger::error("读取数据库结构失败: " + std::string(mysql_error(conn.get())));
+                return false;
+            }
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result))) {
+                if (row[0] && row[1]) {
+                    fresh->tables[row[0]].insert(row[1]);
+                    fresh->column_count++;
+                }
+            }
+            mysql_free_result(result);
+        } catch (const std::exception& e) {
+            Logger::error("加载数据库结构异常: " + std::string(e.what()));
+            return false;
+        }
+        
+        fresh->version = version_.load() + 1;
+        fresh->loaded_at = std::chrono::system_clock::now();
+        std::atomic_store(&snapshot_, std::shared_ptr<const SchemaSnapshot>(fresh));
+        version_.store(fresh->version, std::memory_order_release);
+        
+        auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        Logger::info("数据库结构已加载，表: " + std::to_string(fresh->tables.size()) + "，列: " +
+                     std::to_string(fresh->column_count) + "，版本: " + std::to_string(fresh->version) +
+                     "，耗时: " + std::to_string(elapsed_ms) + "ms");
+        return true;
+    }
+    
+    // 启动时加载失败的情况下，首次使用时再补加载
+    std::shared_ptr<const SchemaSnapshot> loadedSnapshot() {
+        std::shared_ptr<const SchemaSnapshot> current = snapshot();
+        if (!current->loaded()) {
+            refresh();
+            current = snapshot();
+        }
+        return current;
+    }
+    
+    json getStats() const {
+        std::shared_ptr<const SchemaSnapshot> current = snapshot();
+        json stats;
+        stats["loaded"] = current->loaded();
+        stats["version"] = current->version;
+        stats["tables"] = current->tables.size();
+        stats["columns"] = current->column_count;
+        if (current->loaded()) {
+            stats["loaded_at"] = static_cast<long long>(std::chrono::system_clock::to_time_t(current->loaded_at));
+        }
+        return stats;
+    }
+};
+
+// 由结构快照派生的数据(列名映射、预拼好的SQL片段)：按快照版本缓存，
+// 快照刷新后首次访问时重新生成，其余访问只是一次原子读
+template <typename T>
+class SchemaBound {
+private:
+    struct Holder {
+        uint64_t version;
+        T value;
+    };
+    
+    std::function<T(const SchemaSnapshot&)> build_;
+    mutable std::shared_ptr<const Holder> holder_;  // 通过std::atomic_load/atomic_store访问
+    
+public:
+    explicit SchemaBound(std::function<T(const SchemaSnapshot&)> build) : build_(std::move(build)) {}
+    
+    SchemaBound(const SchemaBound&) = delete;
+    SchemaBound& operator=(const SchemaBound&) = delete;
+    
+    std::shared_ptr<const T> get() const {
+        std::shared_ptr<const Holder> current = std::atomic_load(&holder_);
+        if (!current || current->version != SchemaCatalog::getInstance().version()) {
+            std::shared_ptr<const SchemaSnapshot> snapshot = SchemaCatalog::getInstance().loadedSnapshot();
+            current = std::make_shared<const Holder>(Holder{snapshot->version, build_(*snapshot)});
+            std::atomic_store(&holder_, current);
+        }
+        return std::shared_ptr<const T>(current, &current->value);
+    }
+};
+
+class BaseService;
+
+// 查询延迟统计：SQL按指纹(去掉字面量后的语句形状)归并，每个线程各自累计，读取时合并。
+// 延迟用对数-线性直方图记录：每个2的幂区间再等分8份，相对误差约12.5%
+class QueryMetrics {
+public:
+    struct LatencyHistogram {
+        static constexpr int SUB_BUCKET_BITS = 3;
+        static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static constexpr int MAX_MAGNITUDE = 34;  // 最大约2^34微秒(约4.8小时)，更大的值计入最后一个桶
+        static constexpr int BUCKETS = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+        
+        static int bucketOf(uint64_t micros) {
+            if (micros < static_cast<uint64_t>(SUB_BUCKETS)) {
+                return static_cast<int>(micros);
+            }
+            int magnitude = 0;
+            for (uint64_t v = micros; v > 1; v >>= 1) {
+                ++magnitude;
+            }
+            if (magnitude > MAX_MAGNITUDE) {
+                return BUCKETS - 1;
+            }
+            int shift = magnitude - SUB_BUCKET_BITS;
+            int sub = static_cast<int>(micros >> shift) - SUB_BUCKETS;
+            return (shift + 1) * SUB_BUCKETS + sub;
+        }
+        
+        // 桶的上界(微秒)
+        static uint64_t upperBoundOf(int bucket) {
+            if (bucket < SUB_BUCKETS) {
+                return static_cast<uint64_t>(bucket) + 1;
+            }
+            int shift = bucket / SUB_BUCKETS - 1;
+            uint64_t sub = static_cast<uint64_t>(bucket % SUB_BUCKETS);
+            return (SUB_BUCKETS + sub + 1) << shift;
+        }
+    };
+    
+    struct QueryStats {
+        uint64_t count = 0;
+        uint64_t errors = 0;
+        uint64_t rows_returned = 0;
+        uint64_t rows_affected = 0;
+        uint64_t total_us = 0;
+        uint64_t max_us = 0;
+        std::vector<uint64_t> buckets;
+        
+        void record(uint64_t micros, bool ok, uint64_t rows, uint64_t affected) {
+            if (buckets.empty()) {
+                buckets.assign(LatencyHistogram::BUCKETS, 0);
+            }
+            ++count;
+            if (!ok) {
+                ++errors;
+            }
+            rows_returned += rows;
+            rows_affected += affected;
+            total_us += micros;
+            max_us = std::max(max_us, micros);
+            buckets[LatencyHistogram::bucketOf(micros)]++;
+        }
+        
+        void merge(const QueryStats& other) {
+            if (other.buckets.empty()) {
+                return;
+            }
+            if (buckets.empty()) {
+                buckets.assign(LatencyHistogram::BUCKETS, 0);
+            }
+            count += other.count;
+            errors += other.errors;
+            rows_returned += other.rows_returned;
+            rows_affected += other.rows_affected;
+            total_us += other.total_us;
+            max_us = std::max(max_us, other.max_us);
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                buckets[i] += other.buckets[i];
+            }
+        }
+        
+        double percentileMs(double quantile) const {
+            if (count == 0) {
+                return 0.0;
+            }
+            uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * count));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < buckets.size(); ++i) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    return std::min(LatencyHistogram::upperBoundOf(static_cast<int>(i)), max_us) / 1000.0;
+                }
+            }
+            return max_us / 1000.0;
+        }
+        
+        json toJson() const {
+            json item;
+            item["count"] = count;
+            item["errors"] = errors;
+            item["rows_returned"] = rows_returned;
+            item["rows_affected"] = rows_affected;
+            item["total_ms"] = total_us / 1000.0;
+            item["avg_ms"] = count > 0 ? total_us / 1000.0 / count : 0.0;
+            item["p50_ms"] = percentileMs(0.50);
+            item["p90_ms"] = percentileMs(0.90);
+            item["p99_ms"] = percentileMs(0.99);
+            item["p999_ms"] = percentileMs(0.999);
+            item["max_ms"] = max_us / 1000.0;
+            return item;
+        }
+    };
+    
+private:
+    static constexpr uint64_t OTHER_FINGERPRINT = 0;  // 指纹数超出上限后的查询统一计入这里
+    
+    // 每个线程独占一份，记录时只有本线程竞争这把锁，读取方合并时才会短暂争用
+    struct ThreadShard {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, QueryStats> stats;
+    };
+    
+    struct ShardHandle {
+        std::shared_ptr<ThreadShard> shard;
+        ShardHandle() : shard(std::make_shared<ThreadShard>()) {
+            QueryMetrics::getInstance().attachShard(shard);
+        }
+        ~ShardHandle() {
+            QueryMetrics::getInstance().retireShard(shard);
+        }
+    };
+    
+    std::mutex shards_mutex_;
+    std::vector<std::shared_ptr<ThreadShard>> shards_;
+    std::unordered_map<uint64_t, QueryStats> retired_;  // 已退出线程的累计数据
+    
+    mutable std::shared_mutex texts_mutex_;
+    std::unordered_map<uint64_t, std::string> texts_;
+    
+    QueryMetrics() {
+        texts_[OTHER_FINGERPRINT] = "(其他)";
+    }
+    
+    void attachShard(const std::shared_ptr<ThreadShard>& shard) {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        shards_.push_back(shard);
+    }
+    
+    void retireShard(const std::shared_ptr<ThreadShard>& shard) {
+        std::lock_guard<std::mutex> lock(shards_mutex_);
+        {
+            std::lock_guard<std::mutex> shard_lock(shard->mutex);
+            for (const auto& entry : shard->stats) {
+                retired_[entry.first].merge(entry.second);
+            }
+        }
+        shards_.erase(std::remove(shards_.begin(), shards_.end(), shard), shards_.end());
+    }
+    
+    static ThreadShard& localShard() {
+        thread_local ShardHandle handle;
+        return *handle.shard;
+    }
+    
+    // 登记指纹文本，指纹总数达到上限时返回false
+    bool registerFingerprint(uint64_t hash, const std::string& fingerprint) {
+        {
+            std::shared_lock<std::shared_mutex> lock(texts_mutex_);
+            if (texts_.count(hash)) {
+                return true;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(texts_mutex_);
+        if (texts_.count(hash)) {
+            return true;
+        }
+        if (texts_.size() >= Constants::QUERY_METRICS_MAX_FINGERPRINTS) {
+            return false;
+        }
+        texts_.emplace(hash, fingerprint);
+        return true;
+    }
+    
+    static bool isWordChar(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' ||
+               static_cast<unsigned char>(c) >= 0x80;
+    }
+    
+    // 把"?,?,?"压成"?+"(IN后的单个?同样处理)，再把连续相同的括号组(如多行VALUES)压成一个
+    static std::string collapseLists(const std::string& text) {
+        std::string out;
+        out.reserve(text.size());
+        for (size_t i = 0; i < text.size(); ++i) {
+            out.push_back(text[i]);
+            if (text[i] != '?') {
+                continue;
+            }
+            size_t j = i + 1;
+            bool repeated = false;
+            while (true) {
+                size_t k = j;
+                if (k < text.size() && text[k] == ' ') ++k;
+                if (k >= text.size() || text[k] != ',') break;
+                ++k;
+                if (k < text.size() && text[k] == ' ') ++k;
+                if (k >= text.size() || text[k] != '?' || (k + 1 < text.size() && isWordChar(text[k + 1]))) break;
+                j = k + 1;
+                repeated = true;
+            }
+            bool single_in = !repeated && out.size() >= 4 && out.compare(out.size() - 4, 4, "in(?") == 0 &&
+                             (out.size() == 4 || !isWordChar(out[out.size() - 5])) &&
+                             j < text.size() && text[j] == ')';
+            if (repeated || single_in) {
+                out.push_back('+');
+                i = j - 1;
+            }
+        }
+        
+        std::string result;
+        result.reserve(out.size());
+        for (size_t i = 0; i < out.size(); ++i) {
+            result.push_back(out[i]);
+            if (out[i] != ')') {
+                continue;
+            }
+            size_t open = result.rfind('(');
+            if (open == std::string::npos) {
+                continue;
+            }
+            std::string group = result.substr(open);
+            size_t j = i + 1;
+            while (true) {
+                size_t k = j;
+                if (k < out.size() && out[k] == ' ') ++k;
+                if (k >= out.size() || out[k] != ',') break;
+                ++k;
+                if (k < out.size() && out[k] == ' ') ++k;
+                if (out.compare(k, group.size(), group) != 0) break;
+                j = k + group.size();
+            }
+            i = j - 1;
+        }
+        return result;
+    }
+    
+public:
+    static QueryMetrics& getInstance() {
+        static QueryMetrics instance;
+        return instance;
+    }
+    
+    QueryMetrics(const QueryMetrics&) = delete;
+    QueryMetrics& operator=(const QueryMetrics&) = delete;
+    
+    // 生成SQL指纹：字符串和数字字面量替换为?，去掉注释，关键字小写，连续空白合并，
+    // IN列表和多行VALUES折叠，因此只有参数或排版不同的语句得到相同指纹
+    static std::string fingerprint(const std::string& sql) {
+        std::string out;
+        out.reserve(std::min(sql.size(), Constants::QUERY_FINGERPRINT_MAX_LENGTH));
+        bool pending_space = false;
+        // 逗号、比较符和括号两侧不保留空白，"id = ?"和"id=?"得到同一指纹
+        auto emit = [&](char next) {
+            if (pending_space && !out.empty() && !std::strchr(",=<>!(", out.back()) && !std::strchr(",=<>!()", next)) {
+                out.push_back(' ');
+            }
+            pending_space = false;
+        };
+        
+        size_t i = 0;
+        const size_t n = sql.size();
+        while (i < n && out.size() < Constants::QUERY_FINGERPRINT_MAX_LENGTH) {
+            char c = sql[i];
+            if (std::isspace(static_cast<unsigned char>(c))) {
+                pending_space = true;
+                ++i;
+            } else if (c == '\'' || c == '"') {
+                ++i;
+                while (i < n) {
+                    if (sql[i] == '\\') {
+                        i += 2;
+                    } else if (sql[i] == c) {
+                        if (i + 1 < n && sql[i + 1] == c) {
+                            i += 2;
+                        } else {
+                            ++i;
+                            break;
+                        }
+                    } else {
+                        ++i;
+                    }
+                }
+                emit('?');
+                out.push_back('?');
+            } else if (c == '`') {
+                size_t end = sql.find('`', i + 1);
+                end = end == std::string::npos ? n : end + 1;
+                emit('`');
+                out.append(sql, i, end - i);
+                i = end;
+            } else if (c == '/' && i + 1 < n && sql[i + 1] == '*') {
+                size_t end = sql.find("*/", i + 2);
+                i = end == std::string::npos ? n : end + 2;
+                pending_space = true;
+            } else if ((c == '-' && i + 2 < n && sql[i + 1] == '-' && std::isspace(static_cast<unsigned char>(sql[i + 2]))) ||
+                       c == '#') {
+                size_t end = sql.find('\n', i);
+                i = end == std::string::npos ? n : end;
+                pending_space = true;
+            } else if (std::isdigit(static_cast<unsigned char>(c)) &&
+                       (out.empty() || pending_space || !isWordChar(out.back()))) {
+                while (i < n && (std::isalnum(static_cast<unsigned char>(sql[i])) || sql[i] == '.')) {
+                    ++i;
+                }
+                emit('?');
+                out.push_back('?');
+            } else {
+                emit(c);
+                out.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+                ++i;
+            }
+        }
+        while (!out.empty() && out.back() == ';') {
+            out.pop_back();
+        }
+        return collapseLists(out);
+    }
+    
+    // FNV-1a
+    static uint64_t hashFingerprint(const std::string& fingerprint) {
+        uint64_t hash = 1469598103934665603ULL;
+        for (unsigned char c : fingerprint) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash == OTHER_FINGERPRINT ? 1 : hash;
+    }
+    
+    void record(const std::string& text, uint64_t hash, uint64_t micros, bool ok, uint64_t rows, uint64_t affected) {
+        ThreadShard& shard = localShard();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.stats.find(hash);
+        if (it == shard.stats.end()) {
+            if (!registerFingerprint(hash, text)) {
+                hash = OTHER_FINGERPRINT;
+            }
+            it = shard.stats.emplace(hash, QueryStats()).first;
+        }
+        it->second.record(micros, ok, rows, affected);
+    }
+    
+    // 合并所有线程的数据，按累计耗时取前top_n个指纹
+    json getStats(size_t top_n = Constants::QUERY_METRICS_TOP_N) {
+        std::unordered_map<uint64_t, QueryStats> merged;
+        size_t threads = 0;
+        {
+            std::lock_guard<std::mutex> lock(shards_mutex_);
+            merged = retired_;
+            threads = shards_.size();
+            for (const auto& shard : shards_) {
+                std::lock_guard<std::mutex> shard_lock(shard->mutex);
+                for (const auto& entry : shard->stats) {
+                    merged[entry.first].merge(entry.second);
+                }
+            }
+        }
+        
+        QueryStats total;
+        std::vector<std::pair<uint64_t, const QueryStats*>> ranked;
+        ranked.reserve(merged.size());
+        for (const auto& entry : merged) {
+            total.merge(entry.second);
+            ranked.emplace_back(entry.first, &entry.second);
+        }
+        std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+            return a.second->total_us > b.second->total_us;
+        });
+        if (ranked.size() > top_n) {
+            ranked.resize(top_n);
+        }
+        
+        json stats;
+        stats["summary"] = total.toJson();
+        stats["fingerprints"] = merged.size();
+        stats["threads"] = threads;
+        stats["top_queries"] = json::array();
+        std::shared_lock<std::shared_mutex> lock(texts_mutex_);
+        for (const auto& entry : ranked) {
+            json item = entry.second->toJson();
+            auto text = texts_.find(entry.first);
+            item["fingerprint"] = text != texts_.end() ? text->second : std::string();
+            stats["top_queries"].push_back(item);
+        }
+        return stats;
+    }
+};
+
+// 慢查询日志：耗时超过阈值的查询写入定长环形缓冲区。每个慢查询指纹第一次出现时，
+// 由后台线程从连接池另借一条连接执行EXPLAIN，保存执行计划，不占用发起查询的连接和线程
+class SlowQueryLog {
+public:
+    struct Entry {
+        std::time_t timestamp = 0;
+        uint64_t fingerprint_hash = 0;
+        std::string fingerprint;
+        std::string sql;
+        double duration_ms = 0.0;
+        uint64_t rows_returned = 0;
+        uint64_t rows_affected = 0;
+        std::string service;
+        bool success = true;
+    };
+    
+private:
+    std::atomic<long long> threshold_us_;  // 小于等于0表示关闭
+    bool explain_enabled_;
+    
+    mutable std::mutex mutex_;
+    std::vector<Entry> ring_;
+    size_t capacity_;
+    size_t next_;
+    uint64_t total_recorded_;
+    std::unordered_map<uint64_t, json> plans_;  // 指纹 -> 执行计划或未采集原因
+    
+    std::deque<std::pair<uint64_t, std::string>> explain_queue_;
+    std::condition_variable explain_ready_;
+    std::thread explain_thread_;
+    bool running_;
+    
+    SlowQueryLog()
+        : threshold_us_(static_cast<long long>(Constants::SLOW_QUERY_THRESHOLD_MS) * 1000)
+        , explain_enabled_(true)
+        , capacity_(Constants::SLOW_QUERY_LOG_CAPACITY)
+        , next_(0)
+        , total_recorded_(0)
+        , running_(false) {
+        try {
+            ConfigLoader& config = ConfigLoader::getInstance();
+            threshold_us_ = static_cast<long long>(
+                config.getInt("slow_query", "threshold_ms", Constants::SLOW_QUERY_THRESHOLD_MS)) * 1000;
+            int capacity = config.getInt("slow_query", "capacity", static_cast<int>(capacity_));
+            capacity_ = static_cast<size_t>(std::max(1, capacity));
+            explain_enabled_ = config.getBool("slow_query", "explain", explain_enabled_);
+        } catch (const std::exception& e) {
+            Logger::warn("读取慢查询配置失败，使用默认值: " + std::string(e.what()));
+        }
+        ring_.reserve(capacity_);
+    }
+    
+    // EXPLAIN支持的语句类型
+    static bool isExplainable(const std::string& fingerprint) {
+        static const char* const prefixes[] = {"select", "with", "update", "delete", "insert", "replace"};
+        for (const char* prefix : prefixes) {
+            size_t len = std::strlen(prefix);
+            if (fingerprint.compare(0, len, prefix) == 0 &&
+                (fingerprint.size() == len || !std::isalnum(static_cast<unsigned char>(fingerprint[len])))) {
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    void storePlan(uint64_t hash, json plan) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        plans_[hash] = std::move(plan);
+    }
+    
+    // 直接调用MySQL接口而不经过BaseService，EXPLAIN本身不计入查询统计和慢查询日志
+    json explain(const std::string& sql) {
+        json plan;
+        plan["captured_at"] = static_cast<long long>(std::time(nullptr));
+        try {
+            ConnectionGuard conn(DatabaseConnectionPool::getInstance());
+            std::string explain_sql = "EXPLAIN " + sql;
+            if (mysql_query(conn.get(), explain_sql.c_str()) != 0) {
+                plan["status"] = "failed";
+                plan["error"] = mysql_error(conn.get());
+                return plan;
+            }
+            MYSQL_RES* result = mysql_store_result(conn.get());
+            if (!result) {
+                plan["status"] = "failed";
+                plan["error"] = mysql_error(conn.get());
+                return plan;
+            }
+            unsigned int num_fields = mysql_num_fields(result);
+            MYSQL_FIELD* fields = mysql_fetch_fields(result);
+            json rows = json::array();
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result))) {
+                json item = json::object();
+                for (unsigned int i = 0; i < num_fields; ++i) {
+                    item[fields[i].name] = row[i] ? json(row[i]) : json(nullptr);
+                }
+                rows.push_back(item);
+            }
+            mysql_free_result(result);
+            plan["status"] = "captured";
+            plan["rows"] = rows;
+        } catch (const std::exception& e) {
+            plan["status"] = "failed";
+            plan["error"] = e.what();
+        }
+        return plan;
+    }
+    
+    void explainLoop() {
+        while (true) {
+            std::pair<uint64_t, std::string> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                explain_ready_.wait(lock, [this]() { return !running_ || !explain_queue_.empty(); });
+                if (!running_) {
+                    return;
+                }
+                task = std::move(explain_queue_.front());
+                explain_queue_.pop_front();
+            }
+            storePlan(task.first, explain(task.second));
+        }
+    }
+    
+public:
+    static SlowQueryLog& getInstance() {
+        static SlowQueryLog instance;
+        return instance;
+    }
+    
+    SlowQueryLog(const SlowQueryLog&) = delete;
+    SlowQueryLog& operator=(const SlowQueryLog&) = delete;
+    
+    void start() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (running_ || !explain_enabled_) {
+            return;
+        }
+        running_ = true;
+        explain_thread_ = std::thread(&SlowQueryLog::explainLoop, this);
+    }
+    
+    // 须在连接池关闭前调用；尚未执行的EXPLAIN直接丢弃
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!running_) {
+                return;
+            }
+            running_ = false;
+            for (const auto& task : explain_queue_) {
+                plans_.erase(task.first);
+            }
+            explain_queue_.clear();
+        }
+        explain_ready_.notify_all();
+        if (explain_thread_.joinable()) {
+            explain_thread_.join();
+        }
+    }
+    
+    bool isSlow(uint64_t micros) const {
+        long long threshold = threshold_us_.load(std::memory_order_relaxed);
+        return threshold > 0 && static_cast<long long>(micros) >= threshold;
+    }
+    
+    int thresholdMs() const {
+        return static_cast<int>(threshold_us_.load() / 1000);
+    }
+    
+    void setThresholdMs(int threshold_ms) {
+        threshold_us_.store(static_cast<long long>(threshold_ms) * 1000);
+    }
+    
+    // prepared为true时SQL中含参数占位符，无法直接EXPLAIN
+    void record(const std::string& sql, const std::string& fingerprint, uint64_t hash, uint64_t micros,
+                bool ok, uint64_t rows, uint64_t affected, const std::string& service, bool prepared) {
+        Entry entry;
+        entry.timestamp = std::time(nullptr);
+        entry.fingerprint_hash = hash;
+        entry.fingerprint = fingerprint;
+        entry.sql = sql.size() > Constants::SLOW_QUERY_SQL_MAX_LENGTH
+            ? sql.substr(0, Constants::SLOW_QUERY_SQL_MAX_LENGTH) + "..." : sql;
+        entry.duration_ms = micros / 1000.0;
+        entry.rows_returned = rows;
+        entry.rows_affected = affected;
+        entry.service = service;
+        entry.success = ok;
+        
+        bool queued = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (ring_.size() < capacity_) {
+                ring_.push_back(std::move(entry));
+            } else {
+                ring_[next_] = std::move(entry);
+            }
+            next_ = (next_ + 1) % capacity_;
+            ++total_recorded_;
+            
+            // EXPLAIN线程未启动(服务初始化之前)时不登记，之后再次出现时补采
+            if (!plans_.count(hash) && plans_.size() < Constants::QUERY_METRICS_MAX_FINGERPRINTS &&
+                (running_ || !explain_enabled_)) {
+                json plan;
+                if (!explain_enabled_) {
+                    plan["status"] = "disabled";
+                } else if (prepared) {
+                    plan["status"] = "skipped";
+                    plan["error"] = "预处理语句含参数占位符";
+                } else if (!isExplainable(fingerprint)) {
+                    plan["status"] = "skipped";
+                    plan["error"] = "该语句类型不支持EXPLAIN";
+                } else {
+                    plan["status"] = "pending";
+                    explain_queue_.emplace_back(hash, sql);
+                    queued = true;
+                }
+                plans_[hash] = plan;
+            }
+        }
+        if (queued) {
+            explain_ready_.notify_one();
+        }
+        Logger::warn("慢查询(" + std::to_string(micros / 1000) + "ms, " + service + "): " + fingerprint);
+    }
+    
+    // 最近的limit条慢查询(新的在前)，附带涉及指纹的执行计划
+    json getEntries(size_t limit) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        json result;
+        result["threshold_ms"] = threshold_us_.load() / 1000;
+        result["capacity"] = capacity_;
+        result["total_recorded"] = total_recorded_;
+        result["explain_enabled"] = explain_enabled_;
+        
+        json entries = json::array();
+        json plans = json::object();
+        size_t count = std::min(limit, ring_.size());
+        for (size_t i = 0; i < count; ++i) {
+            size_t index = (next_ + capacity_ - 1 - i) % capacity_;
+            if (index >= ring_.size()) {
+                continue;
+            }
+            const Entry& entry = ring_[index];
+            std::string key = std::to_string(entry.fingerprint_hash);
+            json item;
+            item["timestamp"] = static_cast<long long>(entry.timestamp);
+            item["fingerprint_id"] = key;
+            item["fingerprint"] = entry.fingerprint;
+            item["sql"] = entry.sql;
+            item["duration_ms"] = entry.duration_ms;
+            item["rows_returned"] = entry.rows_returned;
+            item["rows_affected"] = entry.rows_affected;
+            item["service"] = entry.service;
+            item["success"] = entry.success;
+            entries.push_back(item);
+            
+            auto plan = plans_.find(entry.fingerprint_hash);
+            if (plan != plans_.end() && !plans.contains(key)) {
+                plans[key] = plan->second;
+            }
+        }
+        result["entries"] = entries;
+        result["plans"] = plans;
+        return result;
+    }
+    
+    // 清空记录和已采集的执行计划，下次出现时重新EXPLAIN
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ring_.clear();
+        next_ = 0;
+        for (auto it = plans_.begin(); it != plans_.end();) {
+            if (it->second.value("status", "") == "pending") {
+                ++it;
+            } else {
+                it = plans_.erase(it);
+            }
+        }
+    }
+};
+
+// 单条查询的计时范围：析构时记录耗时，没有调用succeeded()的按失败计；
+// 超过慢查询阈值的同时写入慢查询日志。析构函数在BaseService定义之后实现
+class QueryTimer {
+private:
+    const std::string& sql_;
+    const BaseService* service_;
+    bool prepared_;
+    std::chrono::steady_clock::time_point started_;
+    bool ok_;
+    uint64_t rows_;
+    uint64_t affected_;
+    
+public:
+    explicit QueryTimer(const std::string& sql, const BaseService* service = nullptr, bool prepared = false)
+        : sql_(sql), service_(service), prepared_(prepared), started_(std::chrono::steady_clock::now()),
+          ok_(false), rows_(0), affected_(0) {}
+    
+    QueryTimer(const QueryTimer&) = delete;
+    QueryTimer& operator=(const QueryTimer&) = delete;
+    
+    void succeeded(uint64_t rows_returned, uint64_t rows_affected = 0) {
+        ok_ = true;
+        rows_ = rows_returned;
+        affected_ = rows_affected;
+    }
+    
+    ~QueryTimer();
+};
+
+// 进程资源采样：CPU时间、常驻内存和系统内存。CPU使用率按两次采样之间的差值计算
+class ProcessMetrics {
+private:
+    std::mutex mutex_;
+    std::chrono::steady_clock::time_point started_;
+    std::chrono::steady_clock::time_point last_sample_at_;
+    double last_cpu_seconds_;
+    
+    ProcessMetrics()
+        : started_(std::chrono::steady_clock::now()), last_sample_at_(started_), last_cpu_seconds_(processCpuSeconds()) {}
+    
+    static double processCpuSeconds() {
+#ifdef _WIN32
+        FILETIME creation, exit_time, kernel, user;
+        if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit_time, &kernel, &user)) {
+            return 0.0;
+        }
+        auto toSeconds = [](const FILETIME& ft) {
+            ULARGE_INTEGER value;
+            value.LowPart = ft.dwLowDateTime;
+            value.HighPart = ft.dwHighDateTime;
+            return value.QuadPart / 1e7;
+        };
+        return toSeconds(kernel) + toSeconds(user);
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0.0;
+        }
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+               usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#endif
+    }
+    
+#ifdef __linux__
+    // 读取/proc下"键: 数值 kB"格式文件中的一项
+    static long long readProcValue(const char* path, const std::string& key) {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':') {
+                try {
+                    return std::stoll(line.substr(key.size() + 1));
+                } catch (const std::exception&) {
+                    return -1;
+                }
+            }
+        }
+        return -1;
+    }
+#endif
+    
+public:
+    static ProcessMetrics& getInstance() {
+        static ProcessMetrics instance;
+        return instance;
+    }
+    
+    ProcessMetrics(const ProcessMetrics&) = delete;
+    ProcessMetrics& operator=(const ProcessMetrics&) = delete;
+    
+    long long uptimeSeconds() const {
+        return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - started_).count();
+    }
+    
+    json sample() {
+        json metrics;
+        unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+        metrics["cpu_cores"] = cores;
+        metrics["uptime_seconds"] = uptimeSeconds();
+        
+        double cpu_seconds = processCpuSeconds();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto now = std::chrono::steady_clock::now();
+            double wall = std::chrono::duration<double>(now - last_sample_at_).count();
+            double usage = wall > 0 ? (cpu_seconds - last_cpu_seconds_) / wall / cores * 100.0 : 0.0;
+            metrics["cpu_usage_percent"] = std::max(0.0, std::min(100.0, usage));
+            last_sample_at_ = now;
+            last_cpu_seconds_ = cpu_seconds;
+        }
+        metrics["cpu_time_seconds"] = cpu_seconds;
+        
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            metrics["rss_mb"] = counters.WorkingSetSize / (1024.0 * 1024.0);
+            metrics["peak_rss_mb"] = counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+        }
+        MEMORYSTATUSEX memory;
+        memory.dwLength = sizeof(memory);
+        if (GlobalMemoryStatusEx(&memory)) {
+            metrics["total_memory_mb"] = static_cast<long long>(memory.ullTotalPhys / (1024 * 1024));
+            metrics["available_memory_mb"] = static_cast<long long>(memory.ullAvailPhys / (1024 * 1024));
+        }
+#elif defined(__linux__)
+        long long rss_kb = readProcValue("/proc/self/status", "VmRSS");
+        long long peak_kb = readProcValue("/proc/self/status", "VmHWM");
+        long long threads = readProcValue("/proc/self/status", "Threads");
+        long long total_kb = readProcValue("/proc/meminfo", "MemTotal");
+        long long available_kb = readProcValue("/proc/meminfo", "MemAvailable");
+        if (rss_kb >= 0) metrics["rss_mb"] = rss_kb / 1024.0;
+        if (peak_kb >= 0) metrics["peak_rss_mb"] = peak_kb / 1024.0;
+        if (threads >= 0) metrics["threads"] = threads;
+        if (total_kb >= 0) metrics["total_memory_mb"] = total_kb / 1024;
+        if (available_kb >= 0) metrics["available_memory_mb"] = available_kb / 1024;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0) {
+            metrics["peak_rss_mb"] = usage.ru_maxrss / 1024.0;
+        }
+#endif
+        return metrics;
+    }
+};
+
+// 购物车写回存储 - 内存中的购物车是读写的权威数据。修改只更新内存并标记脏行，后台线程按固定间隔
+// 把脏行合并成批量UPSERT/DELETE写回cart表，同一行在一个周期内的多次修改只写一次。
+// 购物车首次访问时从cart表懒加载，重启后自然恢复；进程异常退出会丢失最后一个周期内尚未写回的修改。
+// 直接读cart表的路径(下单)须持有用户锁并先调用flushUser，下单清空cart表后调用markPersistedEmpty
+class CartStore {
+public:
+    struct Line {
+        long product_id = 0;
+        int quantity = 0;
+        bool selected = true;
+        std::string created_at;
+        uint64_t seq = 0;  // 加入顺序，用于按加入时间倒序展示
+    };
+    
+private:
+    struct UserCart {
+        std::unordered_map<long, Line> lines;
+        std::unordered_set<long> dirty;  // 待写回的商品ID，行已不存在表示删除
+        bool cleared = false;            // 写回时先删除该用户的全部行，再写入当前所有行
+        std::chrono::steady_clock::time_point last_access;
+        
+        bool isDirty() const { return cleared || !dirty.empty(); }
+    };
+    
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<long, UserCart> carts;
+        std::unordered_set<long> dirty_users;
+    };
+    
+    // 一个用户的一次写回内容
+    struct PendingWrite {
+        long user_id = 0;
+        bool clear = false;
+        std::vector<Line> upserts;
+        std::vector<long> deletes;
+        
+        size_t rows() const { return (clear ? 1 : 0) + upserts.size() + deletes.size(); }
+    };
+    
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t max_users_;
+    std::chrono::milliseconds flush_interval_;
+    size_t batch_rows_;
+    
+    std::atomic<uint64_t> next_seq_;
+    std::atomic<long long> dirty_rows_;
+    std::atomic<long long> edits_;
+    std::atomic<long long> coalesced_;
+    std::atomic<long long> rows_written_;
+    std::atomic<long long> batches_;
+    std::atomic<long long> flush_failures_;
+    std::atomic<long long> dropped_;
+    std::atomic<long long> loads_;
+    std::atomic<long long> evictions_;
+    std::atomic<long long> last_flush_us_;
+    
+    std::mutex flush_mutex_;  // 串行化写回，保证同一行的先后两次写回按顺序落库
+    std::unordered_map<long, int> failed_attempts_;  // 用户连续不可重试的写回失败次数，由flush_mutex_保护
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::thread flusher_;
+    bool running_;
+    
+    CartStore()
+        : max_users_(Constants::CART_STORE_MAX_USERS)
+        , flush_interval_(Constants::CART_FLUSH_INTERVAL_MS)
+        , batch_rows_(Constants::CART_FLUSH_BATCH_ROWS)
+        , next_seq_(1), dirty_rows_(0), edits_(0), coalesced_(0), rows_written_(0), batches_(0)
+        , flush_failures_(0), dropped_(0), loads_(0), evictions_(0), last_flush_us_(0)
+        , running_(false) {
+        for (size_t i = 0; i < Constants::CART_STORE_SHARDS; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+    }
+    
+    Shard& shardFor(long user_id) {
+        return *shards_[static_cast<size_t>(user_id) % shards_.size()];
+    }
+    
+    static std::string currentTimestamp() {
+        std::time_t seconds = std::time(nullptr);
+        std::tm tm{};
+#ifdef _WIN32
+        localtime_s(&tm, &seconds);
+#else
+        localtime_r(&seconds, &tm);
+#endif
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tm);
+        return buffer;
+    }
+    
+    // 从cart表读取用户购物车，按加入时间分配顺序号
+    UserCart loadFromDatabase(long user_id) {
+        ConnectionGuard conn(DatabaseConnectionPool::getInstance());
+        std::string sql = "SELECT product_id, quantity, selected, created_at FROM cart WHERE user_id = " +
+                          std::to_string(user_id) + " ORDER BY created_at ASC, cart_id ASC";
+        QueryTimer timer(sql);
+        if (mysql_query(conn.get(), sql.c_str()) != 0) {
+            throw std::runtime_error("加载购物车失败: " + std::string(mysql_error(conn.get())));
+        }
+        MYSQL_RES* result = mysql_store_result(conn.get());
+        if (!result) {
+            throw std::runtime_error("加载购物车失败: " + std::string(mysql_error(conn.get())));
+        }
+        timer.succeeded(mysql_num_rows(result));
+        UserCart cart;
+        MYSQL_ROW row;
+        while ((row = mysql_fetch_row(result))) {
+            Line line;
+            line.product_id = row[0] ? std::stol(row[0]) : 0;
+            line.quantity = row[1] ? std::stoi(row[1]) : 0;
+            line.selected = !row[2] || std::strcmp(row[2], "0") != 0;
+            line.created_at = row[3] ? row[3] : currentTimestamp();
+            line.seq = next_seq_++;
+            cart.lines[line.product_id] = std::move(line);
+        }
+        mysql_free_result(result);
+        loads_++;
+        return cart;
+    }
+    
+    // 取得用户购物车(未加载时先从cart表加载)，返回时lock持有分片锁。
+    // 加载在分片锁外进行，并发加载同一用户时先放入的为准
+    UserCart& acquire(long user_id, std::unique_lock<std::mutex>& lock) {
+        Shard& shard = shardFor(user_id);
+        lock = std::unique_lock<std::mutex>(shard.mutex);
+        auto it = shard.carts.find(user_id);
+        if (it == shard.carts.end()) {
+            lock.unlock();
+            UserCart loaded = loadFromDatabase(user_id);
+            lock.lock();
+            it = shard.carts.emplace(user_id, std::move(loaded)).first;
+        }
+        it->second.last_access = std::chrono::steady_clock::now();
+        return it->second;
+    }
+    
+    // 调用方持有分片锁
+    void markDirty(long user_id, UserCart& cart, long product_id) {
+        edits_++;
+        if (cart.cleared || !cart.dirty.insert(product_id).second) {
+            coalesced_++;
+        } else if (++dirty_rows_ >= static_cast<long long>(batch_rows_)) {
+            wake_.notify_one();
+        }
+        shardFor(user_id).dirty_users.insert(user_id);
+    }
+    
+    // 取出用户的待写回内容并清除脏标记，调用方持有分片锁
+    PendingWrite takePending(Shard& shard, long user_id, UserCart& cart) {
+        PendingWrite write;
+        write.user_id = user_id;
+        write.clear = cart.cleared;
+        if (cart.cleared) {
+            for (const auto& entry : cart.lines) {
+                write.upserts.push_back(entry.second);
+            }
+        } else {
+            for (long product_id : cart.dirty) {
+                auto it = cart.lines.find(product_id);
+                if (it != cart.lines.end()) {
+                    write.upserts.push_back(it->second);
+                } else {
+                    write.deletes.push_back(product_id);
+                }
+            }
+        }
+        dirty_rows_ -= static_cast<long long>(cart.dirty.size() + (cart.cleared ? 1 : 0));
+        cart.dirty.clear();
+        cart.cleared = false;
+        shard.dirty_users.erase(user_id);
+        return write;
+    }
+    
+    // 写回失败时恢复脏标记，下个周期重新写入当时的最新内容
+    void restorePending(const PendingWrite& write) {
+        Shard& shard = shardFor(write.user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.carts.find(write.user_id);
+        if (it == shard.carts.end()) {
+            return;
+        }
+        UserCart& cart = it->second;
+        if (write.clear && !cart.cleared) {
+            cart.cleared = true;
+            dirty_rows_++;
+        }
+        for (const Line& line : write.upserts) {
+            if (cart.dirty.insert(line.product_id).second) {
+                dirty_rows_++;
+            }
+        }
+        for (long product_id : write.deletes) {
+            if (cart.dirty.insert(product_id).second) {
+                dirty_rows_++;
+            }
+        }
+        shard.dirty_users.insert(write.user_id);
+    }
+    
+    // 在一个事务中执行[begin,end)的写回：先整车删除，再删除单行，最后批量UPSERT
+    bool executeWrites(const std::vector<PendingWrite>& writes, size_t begin, size_t end,
+                       unsigned int& error_no, std::string& error) {
+        error_no = 0;
+        std::string clear_sql;
+        std::string delete_sql;
+        std::string upsert_sql;
+        for (size_t i = begin; i < end; ++i) {
+            const PendingWrite& write = writes[i];
+            std::string user = std::to_string(write.user_id);
+            if (write.clear) {
+                clear_sql += (clear_sql.empty() ? "DELETE FROM cart WHERE user_id IN (" : ",") + user;
+            }
+            for (long product_id : write.deletes) {
+                delete_sql += (delete_sql.empty() ? "DELETE FROM cart WHERE (user_id, product_id) IN (" : ",");
+                delete_sql += "(" + user + "," + std::to_string(product_id) + ")";
+            }
+            for (const Line& line : write.upserts) {
+                upsert_sql += (upsert_sql.empty()
+                    ? "INSERT INTO cart (user_id, product_id, quantity, selected, created_at, updated_at) VALUES "
+                    : ",");
+                upsert_sql += "(" + user + "," + std::to_string(line.product_id) + "," +
+                              std::to_string(line.quantity) + "," + (line.selected ? "1" : "0") +
+                              ",'" + line.created_at + "',NOW())";
+            }
+        }
+        std::vector<std::string> statements;
+        if (!clear_sql.empty()) {
+            statements.push_back(clear_sql + ")");
+        }
+        if (!delete_sql.empty()) {
+            statements.push_back(delete_sql + ")");
+        }
+        if (!upsert_sql.empty()) {
+            statements.push_back(upsert_sql + " ON DUPLICATE KEY UPDATE quantity = VALUES(quantity), "
+                                              "selected = VALUES(selected), updated_at = NOW()");
+        }
+        if (statements.empty()) {
+            return true;
+        }
+        
+        try {
+            ConnectionGuard conn(DatabaseConnectionPool::getInstance());
+            auto run = [&](const std::string& sql) {
+                if (mysql_query(conn.get(), sql.c_str()) == 0) {
+                    return true;
+                }
+                error_no = mysql_errno(conn.get());
+                error = mysql_error(conn.get());
+                return false;
+            };
+            if (!run("START TRANSACTION")) {
+                return false;
+            }
+            for (const std::string& sql : statements) {
+                // 与其他查询一样计入查询指标和慢查询日志
+                QueryTimer timer(sql);
+                if (!run(sql)) {
+                    mysql_query(conn.get(), "ROLLBACK");
+                    return false;
+                }
+                timer.succeeded(0, mysql_affected_rows(conn.get()));
+            }
+            if (!run("COMMIT")) {
+                mysql_query(conn.get(), "ROLLBACK");
+                return false;
+            }
+            return true;
+        } catch (const std::exception& e) {
+            error = e.what();
+            return false;
+        }
+    }
+    
+    // 丢弃用户的内存购物车(包括尚未写回的修改)，下次访问时从cart表重新加载。调用方持有flush_mutex_
+    void discardCart(long user_id) {
+        Shard& shard = shardFor(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.carts.find(user_id);
+        if (it == shard.carts.end()) {
+            return;
+        }
+        const UserCart& cart = it->second;
+        dirty_rows_ -= static_cast<long long>(cart.dirty.size() + (cart.cleared ? 1 : 0));
+        shard.dirty_users.erase(user_id);
+        shard.carts.erase(it);
+    }
+    
+    // 写回[begin,end)，可重试的失败(连接不可用、断线、锁等待超时、死锁)整段放入retry；
+    // 其他失败二分定位到单个用户，单个用户的失败(如商品或用户已删除导致外键约束失败)同样放入retry，
+    // 连续失败CART_FLUSH_MAX_ATTEMPTS次后认为无法写回，丢弃该用户的内存购物车，下次访问时从cart表重新加载
+    void writeRange(const std::vector<PendingWrite>& writes, size_t begin, size_t end,
+                    std::vector<size_t>& retry) {
+        unsigned int error_no = 0;
+        std::string error;
+        if (executeWrites(writes, begin, end, error_no, error)) {
+            for (size_t i = begin; i < end; ++i) {
+                rows_written_ += static_cast<long long>(writes[i].rows());
+                if (!failed_attempts_.empty()) {
+                    failed_attempts_.erase(writes[i].user_id);
+                }
+            }
+            batches_++;
+            return;
+        }
+        flush_failures_++;
+        bool retryable = error_no == 0 || error_no == CR_SERVER_GONE_ERROR || error_no == CR_SERVER_LOST ||
+                         error_no == 1205 || error_no == 1213;
+        if (retryable) {
+            Logger::warn("购物车写回失败，稍后重试: " + error);
+            for (size_t i = begin; i < end; ++i) {
+                retry.push_back(i);
+            }
+            return;
+        }
+        if (end - begin > 1) {
+            size_t mid = begin + (end - begin) / 2;
+            writeRange(writes, begin, mid, retry);
+            writeRange(writes, mid, end, retry);
+            return;
+        }
+        long user_id = writes[begin].user_id;
+        int attempts = ++failed_attempts_[user_id];
+        if (attempts < Constants::CART_FLUSH_MAX_ATTEMPTS) {
+            Logger::warn("购物车写回失败，用户 ", user_id, " 第 ", attempts, " 次，稍后重试: ", error);
+            retry.push_back(begin);
+            return;
+        }
+        Logger::error("购物车写回连续失败 ", attempts, " 次，丢弃用户 ", user_id,
+                      " 的内存购物车并从cart表重新加载: ", error);
+        failed_attempts_.erase(user_id);
+        dropped_++;
+        discardCart(user_id);
+    }
+    
+    // 按batch_rows_分块写回，一个用户的内容不跨块。返回是否全部写回，调用方持有flush_mutex_
+    bool writeAll(const std::vector<PendingWrite>& writes) {
+        if (writes.empty()) {
+            return true;
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<size_t> retry;
+        size_t begin = 0;
+        size_t rows = 0;
+        for (size_t i = 0; i < writes.size(); ++i) {
+            rows += writes[i].rows();
+            if (rows >= batch_rows_ || i + 1 == writes.size()) {
+                writeRange(writes, begin, i + 1, retry);
+                begin = i + 1;
+                rows = 0;
+            }
+        }
+        for (size_t index : retry) {
+            restorePending(writes[index]);
+        }
+        last_flush_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        return retry.empty();
+    }
+    
+    // 内存中的购物车超过上限时，淘汰各分片中最久未访问且已写回的购物车。
+    // 持有flush_mutex_，避免淘汰正在写回的购物车后写回失败无处恢复
+    void evictIdle() {
+        std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+        size_t per_shard = std::max<size_t>(1, max_users_ / shards_.size());
+        for (auto& shard_ptr : shards_) {
+            Shard& shard = *shard_ptr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.carts.size() <= per_shard) {
+                continue;
+            }
+            std::vector<std::pair<std::chrono::steady_clock::time_point, long>> idle;
+            for (const auto& entry : shard.carts) {
+                if (!entry.second.isDirty()) {
+                    idle.emplace_back(entry.second.last_access, entry.first);
+                }
+            }
+            size_t excess = std::min(idle.size(), shard.carts.size() - per_shard);
+            std::nth_element(idle.begin(), idle.begin() + excess, idle.end());
+            for (size_t i = 0; i < excess; ++i) {
+                shard.carts.erase(idle[i].second);
+            }
+            evictions_ += static_cast<long long>(excess);
+        }
+    }
+    
+    void flushLoop() {
+        std::chrono::milliseconds wait = flush_interval_;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(wake_mutex_);
+                // 写回失败退避期间不因脏行积压提前唤醒
+                bool backing_off = wait != flush_interval_;
+                wake_.wait_for(lock, wait, [this, backing_off]() {
+                    return !running_ || (!backing_off && dirty_rows_.load() >= static_cast<long long>(batch_rows_));
+                });
+                if (!running_) {
+                    return;
+                }
+            }
+            if (flushAll()) {
+                wait = flush_interval_;
+            } else {
+                wait = std::min(wait * 2, std::chrono::milliseconds(Constants::CART_FLUSH_MAX_BACKOFF_MS));
+            }
+            evictIdle();
+        }
+    }
+    
+public:
+    static CartStore& getInstance() {
+        static CartStore instance;
+        return instance;
+    }
+    
+    CartStore(const CartStore&) = delete;
+    CartStore& operator=(const CartStore&) = delete;
+    
+    void start() {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        if (running_) {
+            return;
+        }
+        try {
+            ConfigLoader& config = ConfigLoader::getInstance();
+            flush_interval_ = std::chrono::milliseconds(std::max(1,
+                config.getInt("cart_store", "flush_interval_ms", Constants::CART_FLUSH_INTERVAL_MS)));
+            batch_rows_ = static_cast<size_t>(std::max(1,
+                config.getInt("cart_store", "batch_rows", static_cast<int>(Constants::CART_FLUSH_BATCH_ROWS))));
+            max_users_ = static_cast<size_t>(std::max(1,
+                config.getInt("cart_store", "max_users", static_cast<int>(Constants::CART_STORE_MAX_USERS))));
+        } catch (const std::exception& e) {
+            Logger::warn("读取购物车存储配置失败，使用默认值: " + std::string(e.what()));
+        }
+        running_ = true;
+        flusher_ = std::thread(&CartStore::flushLoop, this);
+    }
+    
+    // 须在连接池关闭前调用：停止后台线程并写回全部修改，然后清空内存(停机期间cart表可能被修改)
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            if (!running_) {
+                return;
+            }
+            running_ = false;
+        }
+        wake_.notify_all();
+        if (flusher_.joinable()) {
+            flusher_.join();
+        }
+        if (!flushAll()) {
+            Logger::error("关闭时购物车写回失败，丢弃 " + std::to_string(dirty_rows_.load()) + " 行未写回的修改");
+        }
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->carts.clear();
+            shard->dirty_users.clear();
+        }
+        dirty_rows_ = 0;
+    }
+    
+    // 按加入时间倒序返回购物车中的商品
+    std::vector<Line> getLines(long user_id) {
+        std::unique_lock<std::mutex> lock;
+        UserCart& cart = acquire(user_id, lock);
+        std::vector<Line> lines;
+        lines.reserve(cart.lines.size());
+        for (const auto& entry : cart.lines) {
+            lines.push_back(entry.second);
+        }
+        lock.unlock();
+        std::sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) { return a.seq > b.seq; });
+        return lines;
+    }
+    
+    // 购物车中该商品的数量，不存在时为0
+    int quantityOf(long user_id, long product_id) {
+        std::unique_lock<std::mutex> lock;
+        UserCart& cart = acquire(user_id, lock);
+        auto it = cart.lines.find(product_id);
+        return it == cart.lines.end() ? 0 : it->second.quantity;
+    }
+    
+    // 加入商品，已存在时累加数量。返回加入后的行，created表示是否为新加入
+    Line add(long user_id, long product_id, int quantity, bool& created) {
+        std::unique_lock<std::mutex> lock;
+        UserCart& cart = acquire(user_id, lock);
+        auto it = cart.lines.find(product_id);
+        created = it == cart.lines.end();
+        if (created) {
+            Line line;
+            line.product_id = product_id;
+            line.created_at = currentTimestamp();
+            line.seq = next_seq_++;
+            it = cart.lines.emplace(product_id, std::move(line)).first;
+        }
+        it->second.quantity += quantity;
+        markDirty(user_id, cart, product_id);
+        return it->second;
+    }
+    
+    // 商品不在购物车中时返回false
+    bool setQuantity(long user_id, long product_id, int quantity) {
+        std::unique_lock<std::mutex> lock;
+        UserCart& cart = acquire(user_id, lock);
+        auto it = cart.lines.find(product_id);
+        if (it == cart.lines.end()) {
+            return false;
+        }
+        it->second.quantity = quantity;
+        markDirty(user_id, cart, product_id);
+        return true;
+    }
+    
+    bool remove(long user_id, long product_id) {
+        std::unique_lock<std::mutex> lock;
+        UserCart& cart = acquire(user_id, lock);
+        if (cart.lines.erase(product_id) == 0) {
+            return false;
+        }
+        markDirty(user_id, cart, product_id);
+        return true;
+    }
+    
+    // product_id<=0表示全部商品，返回状态实际改变的行数
+    size_t setSelected(long user_id, long product_id, bool selected) {
+        std::unique_lock<std::mutex> lock;
+        UserCart& cart = acquire(user_id, lock);
+        size_t changed = 0;
+        for (auto& entry : cart.lines) {
+            if ((product_id <= 0 || entry.first == product_id) && entry.second.selected != selected) {
+                entry.second.selected = selected;
+                markDirty(user_id, cart, entry.first);
+                ++changed;
+            }
+        }
+        return changed;
+    }
+    
+    // 返回清空前的商品数
+    size_t clear(long user_id) {
+        std::unique_lock<std::mutex> lock;
+        UserCart& cart = acquire(user_id, lock);
+        size_t removed = cart.lines.size();
+        cart.lines.clear();
+        edits_++;
+        dirty_rows_ -= static_cast<long long>(cart.dirty.size());
+        cart.dirty.clear();
+        if (cart.cleared) {
+            coalesced_++;
+        } else {
+            cart.cleared = true;
+            dirty_rows_++;
+        }
+        shardFor(user_id).dirty_users.insert(user_id);
+        return removed;
+    }
+    
+    // 立即写回该用户的修改，返回后cart表与内存一致。调用方须持有该用户的业务锁，避免写回后又有新修改
+    bool flushUser(long user_id) {
+        std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+        std::vector<PendingWrite> writes;
+        {
+            Shard& shard = shardFor(user_id);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.carts.find(user_id);
+            if (it == shard.carts.end() || !it->second.isDirty()) {
+                return true;
+            }
+            writes.push_back(takePending(shard, user_id, it->second));
+        }
+        return writeAll(writes);
+    }
+    
+    // 写回所有脏购物车，返回是否全部成功
+    bool flushAll() {
+        std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+        std::vector<PendingWrite> writes;
+        for (auto& shard_ptr : shards_) {
+            Shard& shard = *shard_ptr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            std::vector<long> users(shard.dirty_users.begin(), shard.dirty_users.end());
+            for (long user_id : users) {
+                auto it = shard.carts.find(user_id);
+                if (it == shard.carts.end()) {
+                    shard.dirty_users.erase(user_id);
+                    continue;
+                }
+                writes.push_back(takePending(shard, user_id, it->second));
+            }
+        }
+        return writeAll(writes);
+    }
+    
+    // 下单已在事务中删除该用户的cart行，内存购物车同步为空(不再写回)
+    void markPersistedEmpty(long user_id) {
+        Shard& shard = shardFor(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        UserCart& cart = shard.carts[user_id];
+        dirty_rows_ -= static_cast<long long>(cart.dirty.size() + (cart.cleared ? 1 : 0));
+        cart.lines.clear();
+        cart.dirty.clear();
+        cart.cleared = false;
+        cart.last_access = std::chrono::steady_clock::now();
+        shard.dirty_users.erase(user_id);
+    }
+    
+    json getStats() {
+        size_t carts = 0;
+        size_t dirty_carts = 0;
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            carts += shard->carts.size();
+            dirty_carts += shard->dirty_users.size();
+        }
+        long long edits = edits_.load();
+        json stats;
+        stats["carts_in_memory"] = carts;
+        stats["dirty_carts"] = dirty_carts;
+        stats["pending_rows"] = std::max(0LL, dirty_rows_.load());
+        stats["edits"] = edits;
+        stats["coalesced_edits"] = coalesced_.load();
+        stats["coalesce_rate"] = edits > 0 ? 100.0 * coalesced_.load() / edits : 0.0;
+        stats["rows_written"] = rows_written_.load();
+        stats["batches"] = batches_.load();
+        stats["flush_failures"] = flush_failures_.load();
+        stats["dropped_carts"] = dropped_.load();
+        stats["loads"] = loads_.load();
+        stats["evictions"] = evictions_.load();
+        stats["last_flush_ms"] = last_flush_us_.load() / 1000.0;
+        stats["flush_interval_ms"] = flush_interval_.count();
+        stats["batch_rows"] = batch_rows_;
+        stats["max_users"] = max_users_;
+        return stats;
+    }
+};
+
+// 会话存储 - 令牌格式为"32位随机串_用户ID"，按令牌中的用户ID分片，每个用户保留一个会话，
+// 校验和续期只锁一个分片，都是O(1)。会话有效期按最后一次校验滑动延长。
+// 过期清理使用每个分片一个时间轮(1秒一格)：续期只改过期时间不移动时间轮条目，
+// 清理线程扫到条目时未过期的按新的过期时间重新挂入。
+// 配置了快照文件时定期及关闭时写入未过期的会话，启动时加载，重启后用户无需重新登录
+class SessionStore {
+private:
+    static const size_t SECRET_LENGTH = 32;
+    
+    struct Session {
+        std::array<char, SECRET_LENGTH> secret;
+        uint32_t expires_tick = 0;  // 过期时刻(相对store启动的秒数)
+        uint32_t wheel_tick = 0;    // 当前挂在时间轮上的时刻，与条目不一致的条目已失效
+    };
+    
+    struct WheelEntry {
+        long user_id;
+        uint32_t tick;
+    };
+    
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<long, Session> sessions;
+        std::vector<std::vector<WheelEntry>> wheel;
+        uint32_t swept_tick = 0;  // 已清理到的时刻
+    };
+    
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::chrono::steady_clock::time_point epoch_;
+    uint32_t ttl_seconds_;
+    std::string snapshot_file_;
+    int snapshot_interval_seconds_;
+    
+    std::atomic<long long> active_;
+    std::atomic<long long> created_;
+    std::atomic<long long> validated_;
+    std::atomic<long long> rejected_;
+    std::atomic<long long> expired_;
+    std::atomic<long long> revoked_;
+    std::atomic<long long> snapshot_sessions_;
+    std::atomic<long long> last_snapshot_at_;
+    
+    // 每秒登录/过期/登出数的指数滑动平均(约1分钟窗口)，仅清理线程写入
+    mutable std::mutex rate_mutex_;
+    double created_rate_;
+    double expired_rate_;
+    double revoked_rate_;
+    
+    std::mutex sweeper_mutex_;
+    std::condition_variable sweeper_cv_;
+    std::thread sweeper_;
+    bool running_;
+    
+    uint32_t nowTick() const {
+        return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - epoch_).count());
+    }
+    
+    Shard& shardFor(long user_id) {
+        return *shards_[static_cast<size_t>(user_id) % shards_.size()];
+    }
+    
+    // 拆出令牌中的随机串和用户ID，格式不符时返回0
+    static long parseToken(const std::string& token, const char*& secret) {
+        if (token.size() < SECRET_LENGTH + 2 || token[SECRET_LENGTH] != '_') {
+            return 0;
+        }
+        long user_id = 0;
+        for (size_t i = SECRET_LENGTH + 1; i < token.size(); ++i) {
+            char c = token[i];
+            if (c < '0' || c > '9' || user_id > (std::numeric_limits<long>::max() - 9) / 10) {
+                return 0;
+            }
+            user_id = user_id * 10 + (c - '0');
+        }
+        secret = token.data();
+        return user_id;
+    }
+    
+    // 比较耗时与不匹配的位置无关
+    static bool secretEquals(const std::array<char, SECRET_LENGTH>& expected, const char* actual) {
+        unsigned char diff = 0;
+        for (size_t i = 0; i < SECRET_LENGTH; ++i) {
+            diff |= static_cast<unsigned char>(expected[i] ^ actual[i]);
+        }
+        return diff == 0;
+    }
+    
+    // 调用方持有分片锁
+    void schedule(Shard& shard, long user_id, Session& session) {
+        session.wheel_tick = session.expires_tick;
+        shard.wheel[session.expires_tick % shard.wheel.size()].push_back({user_id, session.expires_tick});
+    }
+    
+    // 调用方持有分片锁
+    void insert(Shard& shard, long user_id, const char* secret, uint32_t expires_tick) {
+        auto result = shard.sessions.emplace(user_id, Session());
+        if (result.second) {
+            active_++;
+        } else {
+            revoked_++;  // 重新登录顶替旧会话
+        }
+        Session& session = result.first->second;
+        std::copy(secret, secret + SECRET_LENGTH, session.secret.begin());
+        session.expires_tick = expires_tick;
+        schedule(shard, user_id, session);
+    }
+    
+    // 清理分片中到期时刻不晚于now的时间轮格子，一次最多转一圈
+    void sweepShard(Shard& shard, uint32_t now) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size_t slots = shard.wheel.size();
+        uint32_t from = now - shard.swept_tick > slots ? now - static_cast<uint32_t>(slots) : shard.swept_tick;
+        for (uint32_t tick = from + 1; tick <= now; ++tick) {
+            std::vector<WheelEntry> entries;
+            entries.swap(shard.wheel[tick % slots]);
+            for (const WheelEntry& entry : entries) {
+                auto it = shard.sessions.find(entry.user_id);
+                if (it == shard.sessions.end() || it->second.wheel_tick != entry.tick) {
+                    continue;
+                }
+                if (entry.tick > now) {
+                    shard.wheel[tick % slots].push_back(entry);  // 下一圈才到期
+                } else if (it->second.expires_tick <= now) {
+                    shard.sessions.erase(it);
+                    active_--;
+                    expired_++;
+                } else {
+                    schedule(shard, entry.user_id, it->second);
+                }
+            }
+        }
+        shard.swept_tick = now;
+    }
+    
+    void updateRates(long long created, long long expired, long long revoked, double seconds) {
+        const double alpha = std::min(1.0, seconds / 60.0);
+        std::lock_guard<std::mutex> lock(rate_mutex_);
+        created_rate_ += alpha * (created / seconds - created_rate_);
+        expired_rate_ += alpha * (expired / seconds - expired_rate_);
+        revoked_rate_ += alpha * (revoked / seconds - revoked_rate_);
+    }
+    
+    void sweepLoop() {
+        auto last = std::chrono::steady_clock::now();
+        auto last_snapshot = last;
+        long long last_created = created_.load();
+        long long last_expired = expired_.load();
+        long long last_revoked = revoked_.load();
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(sweeper_mutex_);
+                sweeper_cv_.wait_for(lock, std::chrono::seconds(1), [this]() { return !running_; });
+                if (!running_) {
+                    return;
+                }
+            }
+            uint32_t now = nowTick();
+            for (auto& shard : shards_) {
+                sweepShard(*shard, now);
+            }
+            
+            auto current = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(current - last).count();
+            if (seconds > 0) {
+                long long created = created_.load();
+                long long expired = expired_.load();
+                long long revoked = revoked_.load();
+                updateRates(created - last_created, expired - last_expired, revoked - last_revoked, seconds);
+                last_created = created;
+                last_expired = expired;
+                last_revoked = revoked;
+            }
+            last = current;
+            
+            if (!snapshot_file_.empty() && snapshot_interval_seconds_ > 0 &&
+                current - last_snapshot >= std::chrono::seconds(snapshot_interval_seconds_)) {
+                writeSnapshot();
+                last_snapshot = current;
+            }
+        }
+    }
+    
+    // 以仅属主可读写(0600)的权限写入文件，快照中是有效的登录令牌，不能按默认umask让其他用户读到
+    static bool writePrivateFile(const std::string& path, const std::string& content) {
+#ifdef _WIN32
+        int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+        if (fd < 0) {
+            return false;
+        }
+        bool ok = _write(fd, content.data(), static_cast<unsigned int>(content.size())) == static_cast<int>(content.size());
+        ok = _commit(fd) == 0 && ok;
+        return _close(fd) == 0 && ok;
+#else
+        // 先删除残留的临时文件，O_EXCL保证新建的文件使用这里给出的权限
+        ::unlink(path.c_str());
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+        if (fd < 0) {
+            return false;
+        }
+        size_t written = 0;
+        bool ok = true;
+        while (written < content.size()) {
+            ssize_t n = ::write(fd, content.data() + written, content.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                ok = false;
+                break;
+            }
+            written += static_cast<size_t>(n);
+        }
+        ok = ok && ::fsync(fd) == 0;
+        return ::close(fd) == 0 && ok;
+#endif
+    }
+    
+    // 用临时文件原子替换目标文件，替换过程中目标文件始终是完整的旧版本或新版本
+    static bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+    
+    // 快照每行为"用户ID 随机串 过期时间(Unix秒)"，先写临时文件再替换，写到一半崩溃不会破坏旧快照
+    bool writeSnapshot() {
+        std::vector<std::tuple<long, std::string, long long>> rows;
+        uint32_t now = nowTick();
+        long long now_epoch = static_cast<long long>(std::time(nullptr));
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            for (const auto& entry : shard->sessions) {
+                if (entry.second.expires_tick > now) {
+                    rows.emplace_back(entry.first, std::string(entry.second.secret.data(), SECRET_LENGTH),
+                                      now_epoch + (entry.second.expires_tick - now));
+                }
+            }
+        }
+        std::ostringstream out;
+        out << "emshop-sessions 1\n";
+        for (const auto& row : rows) {
+            out << std::get<0>(row) << ' ' << std::get<1>(row) << ' ' << std::get<2>(row) << '\n';
+        }
+        std::string temp_file = snapshot_file_ + ".tmp";
+        if (!writePrivateFile(temp_file, out.str())) {
+            Logger::warn("写入会话快照失败: " + temp_file);
+            std::remove(temp_file.c_str());
+            return false;
+        }
+        if (!replaceFile(temp_file, snapshot_file_)) {
+            Logger::warn("替换会话快照失败: " + snapshot_file_);
+            return false;
+        }
+        snapshot_sessions_ = static_cast<long long>(rows.size());
+        last_snapshot_at_ = now_epoch;
+        return true;
+    }
+    
+    void loadSnapshot() {
+        std::ifstream in(snapshot_file_);
+        if (!in) {
+            return;
+        }
+        std::string header;
+        if (!std::getline(in, header) || header != "emshop-sessions 1") {
+            Logger::warn("会话快照格式不符，忽略: " + snapshot_file_);
+            return;
+        }
+        uint32_t now = nowTick();
+        long long now_epoch = static_cast<long long>(std::time(nullptr));
+        size_t loaded = 0;
+        long user_id;
+        std::string secret;
+        long long expires_at;
+        while (in >> user_id >> secret >> expires_at) {
+            if (user_id <= 0 || secret.size() != SECRET_LENGTH || expires_at <= now_epoch) {
+                continue;
+            }
+            long long remaining = std::min<long long>(expires_at - now_epoch, ttl_seconds_);
+            Shard& shard = shardFor(user_id);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            insert(shard, user_id, secret.data(), now + static_cast<uint32_t>(remaining));
+            ++loaded;
+        }
+        Logger::info("从快照恢复会话 " + std::to_string(loaded) + " 个: " + snapshot_file_);
+    }
+    
+public:
+    SessionStore()
+        : epoch_(std::chrono::steady_clock::now())
+        , ttl_seconds_(Constants::SESSION_TTL_SECONDS)
+        , snapshot_interval_seconds_(Constants::SESSION_SNAPSHOT_INTERVAL_SECONDS)
+        , active_(0), created_(0), validated_(0), rejected_(0), expired_(0), revoked_(0)
+        , snapshot_sessions_(0), last_snapshot_at_(0)
+        , created_rate_(0.0), expired_rate_(0.0), revoked_rate_(0.0)
+        , running_(false) {
+        try {
+            ConfigLoader& config = ConfigLoader::getInstance();
+            ttl_seconds_ = static_cast<uint32_t>(std::max(1,
+                config.getInt("session", "ttl_seconds", Constants::SESSION_TTL_SECONDS)));
+            snapshot_file_ = config.getString("session", "snapshot_file", "");
+            snapshot_interval_seconds_ = config.getInt("session", "snapshot_interval_seconds",
+                                                       Constants::SESSION_SNAPSHOT_INTERVAL_SECONDS);
+        } catch (const std::exception& e) {
+            Logger::warn("读取会话配置失败，使用默认值: " + std::string(e.what()));
+        }
+        for (size_t i = 0; i < Constants::SESSION_STORE_SHARDS; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+            shards_.back()->wheel.resize(Constants::SESSION_WHEEL_SLOTS);
+        }
+    }
+    
+    ~SessionStore() {
+        shutdown();
+    }
+    
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+    
+    // 加载快照并启动清理线程
+    void start() {
+        std::lock_guard<std::mutex> lock(sweeper_mutex_);
+        if (running_) {
+            return;
+        }
+        if (!snapshot_file_.empty()) {
+            loadSnapshot();
+        }
+        running_ = true;
+        sweeper_ = std::thread(&SessionStore::sweepLoop, this);
+    }
+    
+    // 停止清理线程，配置了快照文件时写入最终快照
+    void shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(sweeper_mutex_);
+            if (!running_) {
+                return;
+            }
+            running_ = false;
+        }
+        sweeper_cv_.notify_all();
+        if (sweeper_.joinable()) {
+            sweeper_.join();
+        }
+        if (!snapshot_file_.empty() && writeSnapshot()) {
+            Logger::info("会话快照已写入: " + snapshot_file_ + ", 会话数: " + std::to_string(snapshot_sessions_.load()));
+        }
+    }
+    
+    // 为用户创建会话(顶替该用户原有会话)，返回令牌
+    std::string create(long user_id) {
+        std::string token = StringUtils::generateRandomString(SECRET_LENGTH) + "_" + std::to_string(user_id);
+        Shard& shard = shardFor(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        insert(shard, user_id, token.data(), nowTick() + ttl_seconds_);
+        created_++;
+        return token;
+    }
+    
+    // 校验令牌并把有效期顺延ttl，返回用户ID；无效或已过期返回0
+    long validate(const std::string& token, uint32_t* expires_in = nullptr) {
+        const char* secret = nullptr;
+        long user_id = parseToken(token, secret);
+        if (user_id <= 0) {
+            rejected_++;
+            return 0;
+        }
+        uint32_t now = nowTick();
+        Shard& shard = shardFor(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.sessions.find(user_id);
+        if (it == shard.sessions.end() || it->second.expires_tick <= now || !secretEquals(it->second.secret, secret)) {
+            rejected_++;
+            return 0;
+        }
+        it->second.expires_tick = now + ttl_seconds_;
+        validated_++;
+        if (expires_in) {
+            *expires_in = ttl_seconds_;
+        }
+        return user_id;
+    }
+    
+    // 注销用户的会话，返回是否存在
+    bool revoke(long user_id) {
+        Shard& shard = shardFor(user_id);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.sessions.erase(user_id) == 0) {
+            return false;
+        }
+        active_--;
+        revoked_++;
+        return true;
+    }
+    
+    json getStats() const {
+        json stats;
+        stats["active_sessions"] = active_.load();
+        stats["created"] = created_.load();
+        stats["validated"] = validated_.load();
+        stats["rejected"] = rejected_.load();
+        stats["expired"] = expired_.load();
+        stats["revoked"] = revoked_.load();
+        {
+            std::lock_guard<std::mutex> lock(rate_mutex_);
+            stats["logins_per_second"] = created_rate_;
+            stats["expirations_per_second"] = expired_rate_;
+            stats["revocations_per_second"] = revoked_rate_;
+        }
+        stats["ttl_seconds"] = ttl_seconds_;
+        stats["shards"] = shards_.size();
+        if (!snapshot_file_.empty()) {
+            stats["snapshot_file"] = snapshot_file_;
+            stats["snapshot_sessions"] = snapshot_sessions_.load();
+            stats["last_snapshot_at"] = last_snapshot_at_.load();
+        }
+        return stats;
+    }
+};
+
+// 基础服务类 
+class BaseService {
+protected:
+    DatabaseConnectionPool& db_pool_;
+    
+    // 业务锁表由所有服务共享，同一用户(购物车/下单/领券)或同一订单的操作跨服务互斥
+    static StripedLockManager& userLocks() {
+        static StripedLockManager locks(Constants::BUSINESS_LOCK_STRIPES);
+        return locks;
+    }
+    
+    static StripedLockManager& orderLocks() {
+        static StripedLockManager locks(Constants::BUSINESS_LOCK_STRIPES);
+        return locks;
+    }
+    
+    static StripedLockManager& couponLocks() {
+        static StripedLockManager locks(Constants::BUSINESS_LOCK_STRIPES);
+        return locks;
+    }
+    
+    // 事务作用域 - 整个事务固定使用同一条连接，FOR UPDATE行锁与提交都作用在同一会话上，
+    // 也省去了逐条语句借还连接的开销。析构时未提交的事务自动回滚，提前return无需手动ROLLBACK
+    class Transaction {
+    private:
+        TraceSpan span_;  // 先于连接构造、后于连接析构，覆盖借连接到提交/回滚的全过程
+        BaseService& service_;
+        ConnectionGuard guard_;
+        bool active_;
+
+    public:
+        explicit Transaction(BaseService& service)
+            : span_("db.transaction", "db"), service_(service), guard_(service.db_pool_), active_(false) {
+            if (mysql_autocommit(guard_.get(), 0) != 0) {
+                throw std::runtime_error("开启事务失败: " + std::string(mysql_error(guard_.get())));
+            }
+            active_ = true;
+        }
+
+        ~Transaction() {
+            rollback();
+        }
+
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+        json query(const std::string& sql) {
+            return service_.executeQueryWithConnection(guard_.get(), sql);
+        }
+
+        json prepared(const std::string& sql, const std::vector<SqlParam>& params = {}) {
+            return service_.executePreparedWithConnection(guard_.get(), sql, params);
+        }
+
+        json bulkInsert(const std::string& table, const std::vector<std::string>& columns,
+                        const std::vector<std::vector<SqlParam>>& rows, bool ignore_errors = false) {
+            return service_.executeBulkInsertWithConnection(guard_.get(), table, columns, rows, ignore_errors);
+        }
+
+        // 提交失败时事务已回滚
+        bool commit() {
+            if (!active_) {
+                return false;
+            }
+            active_ = false;
+            bool committed = mysql_commit(guard_.get()) == 0;
+            if (!committed) {
+                service_.logError("提交事务失败: " + std::string(mysql_error(guard_.get())));
+                mysql_rollback(guard_.get());
+            }
+            mysql_autocommit(guard_.get(), 1);
+            return committed;
+        }
+
+        void rollback() {
+            if (!active_) {
+                return;
+            }
+            active_ = false;
+            if (mysql_rollback(guard_.get()) != 0) {
+                service_.logWarn("回滚事务失败: " + std::string(mysql_error(guard_.get())));
+            }
+            mysql_autocommit(guard_.get(), 1);
+        }
+
+        bool isActive() const { return active_; }
+        MYSQL* connection() const { return guard_.get(); }
+        
+        // 用事务自己的连接转义字符串，事务期间不再为转义另借一条连接
+        std::string escape(const std::string& input) const {
+            std::string escaped;
+            escaped.resize(input.length() * 2 + 1);
+            unsigned long escaped_length = mysql_real_escape_string(
+                guard_.get(), &escaped[0], input.c_str(), input.length());
+            escaped.resize(escaped_length);
+            return escaped;
+        }
+    };
+    
+    // 构造函数设为保护，防止直接实例化
+    BaseService() : db_pool_(DatabaseConnectionPool::getInstance()) {
+        if (!db_pool_.getPoolStatus()["initialized"].get<bool>()) {
+            throw std::runtime_error("数据库连接池未初始化");
+        }
+    }
+    
+public:
+    virtual ~BaseService() = default;
+    bool columnExists(const std::string& table_name, const std::string& column_name) const {
+        return hasColumn(table_name, column_name);
+    }
+    std::string combineColumns(const std::vector<std::string>& columns) const {
+        return joinColumns(columns);
+    }
+    
+    // 创建成功响应的模板方法
+    json createSuccessResponse(const json& data = json::object(), 
+                             const std::string& message = "操作成功") const {
+        json response;
+        response["success"] = true;
+        response["message"] = message;
+        response["data"] = data;
+        response["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        return response;
+    }
+    
+    // 创建错误响应的模板方法
+    json createErrorResponse(const std::string& message, 
+                           int error_code = Constants::ERROR_CODE) const {
+        json response;
+        response["success"] = false;
+        response["message"] = message;
+        response["error_code"] = error_code;
+        response["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        return response;
+    }
+    
+    // 流式成功响应 - 先写入{"data":，数据写完后再补齐其余字段(键顺序与dump()一致)
+    void beginSuccessResponse(JsonWriter& out) const {
+        out.raw("{\"data\":");
+    }
+    
+    void endSuccessResponse(JsonWriter& out, const std::string& message = "操作成功") const {
+        out.key("message").string(message);
+        out.key("success").raw("true");
+        out.key("timestamp").number(std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        out.raw('}');
+    }
+    
+    // 流式错误响应 - 丢弃已写入的部分内容
+    void writeErrorResponse(JsonWriter& out, const std::string& message,
+                            int error_code = Constants::ERROR_CODE) const {
+        out.clear();
+        out.raw(createErrorResponse(message, error_code).dump());
+    }
+    
+    // 日志记录方法
+    // 日志辅助方法：级别未开启时既不取服务名也不拼接参数，
+    // 参数可分开传入，如 logDebug("执行SQL: ", sql)
+    template <typename... Args>
+    void logAt(LogLevel level, const Args&... args) const {
+        if (Logger::isEnabled(level)) {
+            Logger::write(level, "[", getServiceName(), "] ", args...);
+        }
+    }
+    
+    template <typename... Args>
+    void logInfo(const Args&... args) const { logAt(LogLevel::INFO, args...); }
+    
+    template <typename... Args>
+    void logWarn(const Args&... args) const { logAt(LogLevel::WARN, args...); }
+    
+    template <typename... Args>
+    void logError(const Args&... args) const { logAt(LogLevel::ERROR_LEVEL, args...); }
+    
+    template <typename... Args>
+    void logDebug(const Args&... args) const { logAt(LogLevel::DEBUG, args...); }
+
+    virtual std::string getServiceName() const = 0;
+    
+    // 慢查询阈值(毫秒)，对所有服务生效；0表示不记录慢查询
+    static int getSlowQueryThresholdMs() {
+        return SlowQueryLog::getInstance().thresholdMs();
+    }
+    
+    static void setSlowQueryThresholdMs(int threshold_ms) {
+        SlowQueryLog::getInstance().setThresholdMs(std::max(0, threshold_ms));
+    }
+    
+    // 执行查询的通用方法 - 使用外部连接(用于事务)
+    json executeQueryWithConnection(MYSQL* conn, const std::string& sql) {
+        MYSQL_RES* result = nullptr;
+        try {
+            if (!conn) {
+                logError("连接指针为空");
+                return createErrorResponse("数据库连接无效", Constants::DATABASE_ERROR_CODE);
+            }
+            
+            // 连接在借出时已由连接池检查过；事务中途不做ping，避免自动重连后丢失事务上下文
+            
+            logDebug("执行SQL: ", sql);
+            QueryTimer timer(sql, this);
+            
+            if (mysql_query(conn, sql.c_str()) != 0) {
+                std::string error_msg = "SQL执行失败: " + std::string(mysql_error(conn));
+                logError(error_msg);
+                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+            }
+            
+            // 如果是SELECT查询，获取结果
+            result = mysql_store_result(conn);
+            if (result) {
+                json data = parseResultSet(result);
+                mysql_free_result(result);
+                result = nullptr;
+                timer.succeeded(data.size());
+                return createSuccessResponse(data);
+            } else if (mysql_field_count(conn) == 0) {
+                // 非SELECT查询（INSERT, UPDATE, DELETE等）
+                json data;
+                data["affected_rows"] = static_cast<int>(mysql_affected_rows(conn));
+                data["insert_id"] = static_cast<long>(mysql_insert_id(conn));
+                timer.succeeded(0, mysql_affected_rows(conn));
+                return createSuccessResponse(data);
+            } else {
+                std::string error_msg = "获取查询结果失败: " + std::string(mysql_error(conn));
+                logError(error_msg);
+                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+            }
+            
+        } catch (const std::exception& e) {
+            if (result) {
+                mysql_free_result(result);
+                result = nullptr;
+            }
+            std::string error_msg = "查询执行异常: " + std::string(e.what());
+            logError(error_msg);
+            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+        } catch (...) {
+            if (result) {
+                mysql_free_result(result);
+                result = nullptr;
+            }
+            std::string error_msg = "查询执行发生未知异常";
+            logError(error_msg);
+            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+        }
+    }
+    
+    // 执行查询的通用方法 - 修复内存安全问题
+    json executeQuery(const std::string& sql, const json& params = json::object()) {
+        MYSQL_RES* result = nullptr;
+        try {
+            ConnectionGuard conn(db_pool_);
+            if (!conn.isValid()) {
+                logError("数据库连接无效");
+                return createErrorResponse("数据库连接无效", Constants::DATABASE_ERROR_CODE);
+            }
+            
+            logDebug("执行SQL: ", sql);
+            QueryTimer timer(sql, this);
+            
+            if (mysql_query(conn.get(), sql.c_str()) != 0) {
+                std::string error_msg = "SQL执行失败: " + std::string(mysql_error(conn.get()));
+                logError(error_msg);
+                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+            }
+            
+            // 如果是SELECT查询，获取结果
+            result = mysql_store_result(conn.get());
+            if (result) {
+                json data = parseResultSet(result);
+                mysql_free_result(result);
+                result = nullptr; // 标记已释放
+                timer.succeeded(data.size());
+                return createSuccessResponse(data);
+            } else if (mysql_field_count(conn.get()) == 0) {
+                // 非SELECT查询（INSERT, UPDATE, DELETE等）
+                json data;
+                data["affected_rows"] = static_cast<int>(mysql_affected_rows(conn.get()));
+                data["insert_id"] = static_cast<long>(mysql_insert_id(conn.get()));
+                timer.succeeded(0, mysql_affected_rows(conn.get()));
+                return createSuccessResponse(data);
+            } else {
+                std::string error_msg = "获取查询结果失败: " + std::string(mysql_error(conn.get()));
+                logError(error_msg);
+                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+            }
+            
+        } catch (const std::exception& e) {
+            // 确保在异常情况下也释放MySQL结果集
+            if (result) {
+                mysql_free_result(result);
+                result = nullptr;
+            }
+            std::string error_msg = "查询执行异常: " + std::string(e.what());
+            logError(error_msg);
+            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+        } catch (...) {
+            // 捕获所有其他异常
+            if (result) {
+                mysql_free_result(result);
+                result = nullptr;
+            }
+            std::string error_msg = "查询执行发生未知异常";
+            logError(error_msg);
+            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+        }
+    }
+    
+    // 执行预处理语句 - 使用外部连接(用于事务)
+    // 返回格式与executeQueryWithConnection一致：SELECT返回行数组，其余返回affected_rows/insert_id
+    json executePreparedWithConnection(MYSQL* conn, const std::string& sql,
+                                       const std::vector<SqlParam>& params = {}) {
+        if (!conn) {
+            logError("连接指针为空");
+            return createErrorResponse("数据库连接无效", Constants::DATABASE_ERROR_CODE);
+        }
+
+        logDebug("执行预处理SQL: ", sql);
+        QueryTimer timer(sql, this, !params.empty());
+
+        try {
+            PreparedStatementCache& cache = db_pool_.getStatementCache(conn);
+
+            // 语句在服务端失效(表结构变更等)时重新预处理一次
+            for (int attempt = 0; attempt < 2; ++attempt) {
+                std::string error_msg;
+                bool hit = false;
+                MYSQL_STMT* stmt = cache.acquire(conn, sql, hit, error_msg);
+                db_pool_.recordStatementCacheLookup(hit);
+                if (!stmt) {
+                    logError(error_msg);
+                    return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+                }
+
+                json data;
+                unsigned int error_no = 0;
+                if (runPreparedStatement(stmt, params, data, error_msg, error_no)) {
+                    if (data.is_array()) {
+                        timer.succeeded(data.size());
+                    } else {
+                        timer.succeeded(0, data.value("affected_rows", 0LL));
+                    }
+                    return createSuccessResponse(data);
+                }
+
+                if (attempt == 0 && (error_no == ER_UNKNOWN_STMT_HANDLER || error_no == ER_NEED_REPREPARE)) {
+                    logWarn("预处理语句已失效，重新预处理: " + error_msg);
+                    cache.evict(sql);
+                    continue;
+                }
+
+                // 连接已断开，该连接上的所有语句句柄都不可再用
+                if (error_no == CR_SERVER_GONE_ERROR || error_no == CR_SERVER_LOST) {
+                    cache.clear();
+                }
+
+                logError(error_msg);
+                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+            }
+        } catch (const std::exception& e) {
+            std::string error_msg = "预处理查询执行异常: " + std::string(e.what());
+            logError(error_msg);
+            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+        }
+
+        return createErrorResponse("预处理查询执行失败", Constants::DATABASE_ERROR_CODE);
+    }
+
+    // 执行预处理语句 - 自动借用连接
+    json executePrepared(const std::string& sql, const std::vector<SqlParam>& params = {}) {
+        try {
+            ConnectionGuard conn(db_pool_);
+            return executePreparedWithConnection(conn.get(), sql, params);
+        } catch (const std::exception& e) {
+            std::string error_msg = "预处理查询执行异常: " + std::string(e.what());
+            logError(error_msg);
+            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+        }
+    }
+
+    // ==================== 读写分离 ====================
+    // 只读查询优先路由到只读副本，副本出错时在主库上重试一次。
+    // sticky_user_id为发起请求的用户，该用户近期有写入时直接读主库，保证能读到自己的写入。
+    // 事务内的查询和读后写的场景(如SELECT ... FOR UPDATE)必须继续使用主库接口
+
+    // 副本查询失败的处理：连接级错误时摘除副本，随后由调用方回退到主库
+    void handleReplicaFailure(DatabaseConnectionPool* replica, unsigned int error_no, const std::string& reason) {
+        if (error_no == 0 || error_no == CR_SERVER_GONE_ERROR || error_no == CR_SERVER_LOST) {
+            ReplicaRouter::getInstance().reportFailure(replica);
+        }
+        logWarn("只读副本 " + replica->describeEndpoint() + " 查询失败，改用主库: " + reason);
+    }
+
+    json executeReadQuery(const std::string& sql, long sticky_user_id = 0) {
+        DatabaseConnectionPool* replica = ReplicaRouter::getInstance().pickReplica(sticky_user_id);
+        if (replica) {
+            try {
+                ConnectionGuard conn(*replica);
+                json result = executeQueryWithConnection(conn.get(), sql);
+                if (result["success"].get<bool>()) {
+                    return result;
+                }
+                handleReplicaFailure(replica, mysql_errno(conn.get()), result.value("message", std::string()));
+            } catch (const std::exception& e) {
+                handleReplicaFailure(replica, 0, e.what());
+            }
+        }
+        return executeQuery(sql);
+    }
+
+    json executeReadPrepared(const std::string& sql, const std::vector<SqlParam>& params = {},
+                             long sticky_user_id = 0) {
+        DatabaseConnectionPool* replica = ReplicaRouter::getInstance().pickReplica(sticky_user_id);
+        if (replica) {
+            try {
+                ConnectionGuard conn(*replica);
+                json result = executePreparedWithConnection(conn.get(), sql, params);
+                if (result["success"].get<bool>()) {
+                    return result;
+                }
+                handleReplicaFailure(replica, mysql_errno(conn.get()), result.value("message", std::string()));
+            } catch (const std::exception& e) {
+                handleReplicaFailure(replica, 0, e.what());
+            }
+        }
+        return executePrepared(sql, params);
+    }
+
+    std::future<json> executeReadQueryAsync(const std::string& sql, long sticky_user_id = 0,
+                                            std::function<void(const json&)> on_complete = nullptr) {
+        return AsyncQueryEngine::getInstance().submit(
+            [this, sql, sticky_user_id]() { return executeReadQuery(sql, sticky_user_id); }, std::move(on_complete));
+    }
+
+    // 用户写入成功后调用，之后一段时间内该用户的读请求走主库
+    void markUserWrite(long user_id) {
+        ReplicaRouter::getInstance().markUserWrite(user_id);
+    }
+
+    // ==================== 批量写入 ====================
+    // 多行INSERT：按行数上限和max_allowed_packet切块，每块一条语句。
+    // 返回data.inserted/failed/ignored/statements，以及与rows一一对应的row_results(true=已写入，false=失败)。
+    // 普通模式下出错的块会二分重试以定位失败行；ignore_errors为true时使用INSERT IGNORE，
+    // 被服务端跳过的行无法逐行区分，所在块的row_results记为null
+    json executeBulkInsertWithConnection(MYSQL* conn, const std::string& table,
+                                         const std::vector<std::string>& columns,
+                                         const std::vector<std::vector<SqlParam>>& rows,
+                                         bool ignore_errors = false) {
+        if (!conn) {
+            logError("连接指针为空");
+            return createErrorResponse("数据库连接无效", Constants::DATABASE_ERROR_CODE);
+        }
+        if (table.empty() || columns.empty()) {
+            return createErrorResponse("批量写入缺少表名或列名", Constants::VALIDATION_ERROR_CODE);
+        }
+
+        json row_results = json::array();
+        std::vector<std::string> tuples(rows.size());
+        std::vector<size_t> pending;
+        pending.reserve(rows.size());
+        long long failed = 0;
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (rows[i].size() != columns.size()) {
+                row_results.push_back(false);
+                ++failed;
+                continue;
+            }
+            row_results.push_back(nullptr);
+            tuples[i] = renderSqlTuple(conn, rows[i]);
+            pending.push_back(i);
+        }
+
+        const std::string head = std::string(ignore_errors ? "INSERT IGNORE INTO " : "INSERT INTO ") +
+                                 table + " (" + joinColumns(columns) + ") VALUES ";
+        const size_t byte_limit = bulkInsertByteLimit(conn);
+
+        long long inserted = 0;
+        long long ignored = 0;
+        int statements = 0;
+        std::string last_error;
+
+        // 执行[begin,end)对应的一条多行INSERT，失败时二分定位出错行
+        std::function<void(size_t, size_t)> run_chunk = [&](size_t begin, size_t end) {
+            std::string sql = head;
+            for (size_t i = begin; i < end; ++i) {
+                if (i > begin) {
+                    sql += ',';
+                }
+                sql += tuples[pending[i]];
+            }
+
+            json result = executeQueryWithConnection(conn, sql);
+            ++statements;
+            size_t count = end - begin;
+            if (result["success"].get<bool>()) {
+                long long affected = result["data"].value("affected_rows", 0LL);
+                inserted += affected;
+                if (!ignore_errors || affected == static_cast<long long>(count)) {
+                    for (size_t i = begin; i < end; ++i) {
+                        row_results[pending[i]] = true;
+                    }
+                } else {
+                    ignored += static_cast<long long>(count) - affected;
+                }
+                return;
+            }
+
+            last_error = result.value("message", std::string("批量写入失败"));
+            unsigned int error_no = mysql_errno(conn);
+            bool connection_lost = error_no == CR_SERVER_GONE_ERROR || error_no == CR_SERVER_LOST;
+            if (count == 1 || connection_lost) {
+                for (size_t i = begin; i < end; ++i) {
+                    row_results[pending[i]] = false;
+                }
+                failed += static_cast<long long>(count);
+                return;
+            }
+            size_t mid = begin + count / 2;
+            run_chunk(begin, mid);
+            run_chunk(mid, end);
+        };
+
+        size_t chunk_begin = 0;
+        size_t chunk_bytes = head.size();
+        for (size_t i = 0; i < pending.size(); ++i) {
+            size_t tuple_bytes = tuples[pending[i]].size() + 1;
+            bool full = i - chunk_begin >= Constants::BULK_INSERT_MAX_ROWS ||
+                        chunk_bytes + tuple_bytes > byte_limit;
+            if (i > chunk_begin && full) {
+                run_chunk(chunk_begin, i);
+                chunk_begin = i;
+                chunk_bytes = head.size();
+            }
+            chunk_bytes += tuple_bytes;
+        }
+        if (chunk_begin < pending.size()) {
+            run_chunk(chunk_begin, pending.size());
+        }
+
+        json data;
+        data["total"] = rows.size();
+        data["inserted"] = inserted;
+        data["failed"] = failed;
+        data["ignored"] = ignored;
+        data["statements"] = statements;
+        data["row_results"] = std::move(row_results);
+        if (!last_error.empty()) {
+            data["last_error"] = last_error;
+        }
+
+        logDebug("批量写入 ", table, ": 共 ", rows.size(), " 行, 写入 ",
+                 inserted, " 行, 失败 ", failed, " 行, 语句数 ",
+                 statements);
+        return createSuccessResponse(data);
+    }
+
+    // 批量写入 - 自动借用连接(各块独立提交)
+    json executeBulkInsert(const std::string& table, const std::vector<std::string>& columns,
+                           const std::vector<std::vector<SqlParam>>& rows, bool ignore_errors = false) {
+        try {
+            ConnectionGuard conn(db_pool_);
+            return executeBulkInsertWithConnection(conn.get(), table, columns, rows, ignore_errors);
+        } catch (const std::exception& e) {
+            std::string error_msg = "批量写入异常: " + std::string(e.what());
+            logError(error_msg);
+            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+        }
+    }
+
+    // 把一行参数渲染为SQL值元组，字符串用连接的字符集转义
+    std::string renderSqlTuple(MYSQL* conn, const std::vector<SqlParam>& row) const {
+        std::string tuple = "(";
+        for (size_t i = 0; i < row.size(); ++i) {
+            if (i > 0) {
+                tuple += ", ";
+            }
+            const SqlParam& value = row[i];
+            switch (value.type) {
+                case SqlParam::Type::NULL_VALUE:
+                    tuple += "NULL";
+                    break;
+                case SqlParam::Type::INTEGER:
+                    tuple += std::to_string(value.int_value);
+                    break;
+                case SqlParam::Type::DOUBLE: {
+                    std::ostringstream oss;
+                    oss << std::setprecision(15) << value.double_value;
+                    tuple += oss.str();
+                    break;
+                }
+                case SqlParam::Type::STRING: {
+                    std::string escaped(value.string_value.size() * 2 + 1, '\0');
+                    unsigned long length = mysql_real_escape_string(
+                        conn, &escaped[0], value.string_value.c_str(), value.string_value.size());
+                    escaped.resize(length);
+                    tuple += "'" + escaped + "'";
+                    break;
+                }
+            }
+        }
+        tuple += ")";
+        return tuple;
+    }
+
+    // 单条批量语句的字节上限：取服务端max_allowed_packet(预留协议开销)与配置上限的较小值
+    size_t bulkInsertByteLimit(MYSQL* conn) {
+        static std::atomic<size_t> server_packet_limit{0};
+        size_t packet_limit = server_packet_limit.load(std::memory_order_relaxed);
+        if (packet_limit == 0) {
+            json result = executeQueryWithConnection(conn, "SELECT @@max_allowed_packet AS max_packet");
+            if (result["success"].get<bool>() && !result["data"].empty()) {
+                const json& value = result["data"][0]["max_packet"];
+                if (value.is_number_unsigned() || value.is_number_integer()) {
+                    packet_limit = value.get<size_t>();
+                } else if (value.is_string()) {
+                    packet_limit = static_cast<size_t>(std::strtoull(value.get<std::string>().c_str(), nullptr, 10));
+                }
+            }
+            if (packet_limit == 0) {
+                return Constants::BULK_INSERT_MAX_STATEMENT_BYTES / 4;
+            }
+            server_packet_limit.store(packet_limit, std::memory_order_relaxed);
+        }
+        size_t usable = packet_limit > 2048 ? packet_limit - 1024 : packet_limit;
+        return std::min(usable, Constants::BULK_INSERT_MAX_STATEMENT_BYTES);
+    }
+
+    // ==================== 异步查询 ====================
+    // 查询交给异步引擎的I/O线程执行，调用方可以先发起多条查询再依次get()
+    std::future<json> executeQueryAsync(const std::string& sql,
+                                        std::function<void(const json&)> on_complete = nullptr) {
+        return AsyncQueryEngine::getInstance().submit(
+            [this, sql]() { return executeQuery(sql); }, std::move(on_complete));
+    }
+
+    std::future<json> executePreparedAsync(const std::string& sql, const std::vector<SqlParam>& params = {},
+                                           std::function<void(const json&)> on_complete = nullptr) {
+        return AsyncQueryEngine::getInstance().submit(
+            [this, sql, params]() { return executePrepared(sql, params); }, std::move(on_complete));
+    }
+
+    // 绑定参数并执行预处理语句，结果按列类型转换为JSON
+    bool runPreparedStatement(MYSQL_STMT* stmt, const std::vector<SqlParam>& params, json& data,
+                              std::string& error_msg, unsigned int& error_no) const {
+        auto fail = [&](const std::string& prefix) {
+            error_no = mysql_stmt_errno(stmt);
+            error_msg = prefix + std::string(mysql_stmt_error(stmt));
+            return false;
+        };
+
+        if (mysql_stmt_param_count(stmt) != params.size()) {
+            error_msg = "预处理参数数量不匹配，需要 " + std::to_string(mysql_stmt_param_count(stmt)) +
+                        " 个，实际 " + std::to_string(params.size()) + " 个";
+            return false;
+        }
+
+        // 绑定输入参数，缓冲区直接指向params中的值
+        std::vector<MYSQL_BIND> param_binds(params.size());
+        std::vector<unsigned long> param_lengths(params.size());
+        for (size_t i = 0; i < params.size(); ++i) {
+            const SqlParam& param = params[i];
+            MYSQL_BIND& bind = param_binds[i];
+            switch (param.type) {
+                case SqlParam::Type::INTEGER:
+                    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                    bind.buffer = const_cast<long long*>(&param.int_value);
+                    break;
+                case SqlParam::Type::DOUBLE:
+                    bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                    bind.buffer = const_cast<double*>(&param.double_value);
+                    break;
+                case SqlParam::Type::STRING:
+                    param_lengths[i] = static_cast<unsigned long>(param.string_value.length());
+                    bind.buffer_type = MYSQL_TYPE_STRING;
+                    bind.buffer = const_cast<char*>(param.string_value.data());
+                    bind.buffer_length = param_lengths[i];
+                    bind.length = &param_lengths[i];
+                    break;
+                case SqlParam::Type::NULL_VALUE:
+                default:
+                    bind.buffer_type = MYSQL_TYPE_NULL;
+                    break;
+            }
+        }
+
+        if (!param_binds.empty() && mysql_stmt_bind_param(stmt, param_binds.data()) != 0) {
+            return fail("绑定预处理参数失败: ");
+        }
+
+        if (mysql_stmt_execute(stmt) != 0) {
+            return fail("SQL执行失败: ");
+        }
+
+        MYSQL_RES* metadata = mysql_stmt_result_metadata(stmt);
+        if (!metadata) {
+            if (mysql_stmt_field_count(stmt) == 0) {
+                // 非SELECT查询（INSERT, UPDATE, DELETE等）
+                data = json::object();
+                data["affected_rows"] = static_cast<int>(mysql_stmt_affected_rows(stmt));
+                data["insert_id"] = static_cast<long>(mysql_stmt_insert_id(stmt));
+                return true;
+            }
+            return fail("获取查询结果失败: ");
+        }
+
+        if (mysql_stmt_store_result(stmt) != 0) {
+            mysql_free_result(metadata);
+            return fail("获取查询结果失败: ");
+        }
+
+        unsigned int num_fields = mysql_num_fields(metadata);
+        MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+
+        // 整数/浮点列直接取二进制值，其余列按字符串取回
+        std::vector<MYSQL_BIND> result_binds(num_fields);
+        std::vector<long long> int_values(num_fields);
+        std::vector<double> double_values(num_fields);
+        std::vector<std::vector<char>> string_buffers(num_fields);
+        std::vector<unsigned long> lengths(num_fields);
+        // MySqlFlag可能是bool，不能用std::vector<bool>取元素地址
+        std::unique_ptr<MySqlFlag[]> is_null(new MySqlFlag[num_fields]());
+        std::unique_ptr<MySqlFlag[]> truncated(new MySqlFlag[num_fields]());
+
+        for (unsigned int i = 0; i < num_fields; ++i) {
+            MYSQL_BIND& bind = result_binds[i];
+            switch (fields[i].type) {
+                case MYSQL_TYPE_TINY:
+                case MYSQL_TYPE_SHORT:
+                case MYSQL_TYPE_LONG:
+                case MYSQL_TYPE_LONGLONG:
+                case MYSQL_TYPE_INT24:
+                    bind.buffer_type = MYSQL_TYPE_LONGLONG;
+                    bind.buffer = &int_values[i];
+                    bind.is_unsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+                    break;
+                case MYSQL_TYPE_FLOAT:
+                case MYSQL_TYPE_DOUBLE:
+                    bind.buffer_type = MYSQL_TYPE_DOUBLE;
+                    bind.buffer = &double_values[i];
+                    break;
+                default: {
+                    // 时间类型的max_length是二进制长度，需预留格式化后的字符串长度
+                    unsigned long buffer_size = std::max<unsigned long>(fields[i].max_length, 32);
+                    string_buffers[i].resize(buffer_size + 1);
+                    bind.buffer_type = MYSQL_TYPE_STRING;
+                    bind.buffer = string_buffers[i].data();
+                    bind.buffer_length = buffer_size;
+                    break;
+                }
+            }
+            bind.length = &lengths[i];
+            bind.is_null = &is_null[i];
+            bind.error = &truncated[i];
+        }
+
+        if (mysql_stmt_bind_result(stmt, result_binds.data()) != 0) {
+            mysql_free_result(metadata);
+            mysql_stmt_free_result(stmt);
+            return fail("绑定结果集失败: ");
+        }
+
+        json rows = json::array();
+        int fetch_status = 0;
+        while ((fetch_status = mysql_stmt_fetch(stmt)) == 0 || fetch_status == MYSQL_DATA_TRUNCATED) {
+            json row_obj = json::object();
+            for (unsigned int i = 0; i < num_fields; ++i) {
+                std::string field_name = fields[i].name ? fields[i].name : "unknown_field";
+
+                if (is_null[i]) {
+                    row_obj[field_name] = nullptr;
+                    continue;
+                }
+
+                if (result_binds[i].buffer_type == MYSQL_TYPE_LONGLONG) {
+                    row_obj[field_name] = int_values[i];
+                    continue;
+                }
+                if (result_binds[i].buffer_type == MYSQL_TYPE_DOUBLE) {
+                    row_obj[field_name] = double_values[i];
+                    continue;
+                }
+
+                std::string field_value;
+                if (truncated[i]) {
+                    // 缓冲区不足时按实际长度单独取回该列
+                    field_value.assign(lengths[i], '\0');
+                    MYSQL_BIND column_bind;
+                    std::memset(&column_bind, 0, sizeof(column_bind));
+                    unsigned long column_length = 0;
+                    column_bind.buffer_type = MYSQL_TYPE_STRING;
+                    column_bind.buffer = &field_value[0];
+                    column_bind.buffer_length = lengths[i];
+                    column_bind.length = &column_length;
+                    mysql_stmt_fetch_column(stmt, &column_bind, i, 0);
+                } else {
+                    field_value.assign(string_buffers[i].data(), lengths[i]);
+                }
+
+                switch (fields[i].type) {
+                    case MYSQL_TYPE_DECIMAL:
+                    case MYSQL_TYPE_NEWDECIMAL:
+                        try {
+                            row_obj[field_name] = std::stod(field_value);
+                        } catch (const std::exception& e) {
+                            logWarn("浮点类型转换失败，使用字符串: " + std::string(e.what()));
+                            row_obj[field_name] = field_value;
+                        }
+                        break;
+
+                    case MYSQL_TYPE_BIT:
+                        row_obj[field_name] = (field_value == "1" ||
+                                               (!field_value.empty() && field_value.back() == '\x01'));
+                        break;
+
+                    default:
+                        row_obj[field_name] = field_value;
+                        break;
+                }
+            }
+            rows.push_back(row_obj);
+        }
+
+        mysql_free_result(metadata);
+        mysql_stmt_free_result(stmt);
+
+        if (fetch_status != MYSQL_NO_DATA) {
+            return fail("读取结果集失败: ");
+        }
+
+        data = rows;
+        return true;
+    }
+
+    // 执行查询并把结果行直接写成JSON数组，不构建中间JSON对象
+    bool writeQueryRows(const std::string& sql, JsonWriter& out, std::string& error_msg) {
+        return writeQueryRowsWithPool(db_pool_, sql, out, error_msg);
+    }
+
+    // 只读版本：优先在副本上执行，失败时丢弃已写入的部分并在主库上重试
+    bool writeReadQueryRows(const std::string& sql, JsonWriter& out, std::string& error_msg,
+                            long sticky_user_id = 0) {
+        DatabaseConnectionPool* replica = ReplicaRouter::getInstance().pickReplica(sticky_user_id);
+        if (replica) {
+            size_t mark = out.size();
+            unsigned int error_no = 0;
+            if (writeQueryRowsWithPool(*replica, sql, out, error_msg, &error_no)) {
+                return true;
+            }
+            out.truncate(mark);
+            handleReplicaFailure(replica, error_no, error_msg);
+            error_msg.clear();
+        }
+        return writeQueryRowsWithPool(db_pool_, sql, out, error_msg);
+    }
+
+    bool writeQueryRowsWithPool(DatabaseConnectionPool& pool, const std::string& sql, JsonWriter& out,
+                                std::string& error_msg, unsigned int* error_no = nullptr) {
+        MYSQL_RES* result = nullptr;
+        try {
+            ConnectionGuard conn(pool);
+            auto recordError = [&]() {
+                if (error_no) {
+                    *error_no = mysql_errno(conn.get());
+                }
+            };
+            
+            logDebug("执行SQL: ", sql);
+            QueryTimer timer(sql, this);
+            
+            if (mysql_query(conn.get(), sql.c_str()) != 0) {
+                error_msg = "SQL执行失败: " + std::string(mysql_error(conn.get()));
+                recordError();
+                logError(error_msg);
+                return false;
+            }
+            
+            // 逐行从网络读取，不在客户端缓存整个结果集
+            result = mysql_use_result(conn.get());
+            if (!result) {
+                error_msg = "获取查询结果失败: " + std::string(mysql_error(conn.get()));
+                recordError();
+                logError(error_msg);
+                return false;
+            }
+            
+            size_t rows = out.appendResultSet(result);
+            bool fetch_failed = mysql_errno(conn.get()) != 0;
+            if (fetch_failed) {
+                error_msg = "读取查询结果失败: " + std::string(mysql_error(conn.get()));
+                recordError();
+            }
+            mysql_free_result(result);
+            result = nullptr;
+            
+            if (fetch_failed) {
+                logError(error_msg);
+                return false;
+            }
+            timer.succeeded(rows);
+            return true;
+            
+        } catch (const std::exception& e) {
+            if (result) {
+                mysql_free_result(result);
+            }
+            error_msg = "查询执行异常: " + std::string(e.what());
+            logError(error_msg);
+            return false;
+        }
+    }
+    
+    // 解析MySQL结果集为JSON - 修复内存安全问题
+    json parseResultSet(MYSQL_RES* result) const {
+        json rows = json::array();
+        
+        if (!result) {
+            logWarn("MySQL结果集为空");
+            return rows;
+        }
+        
+        try {
+            // 获取字段信息
+            int num_fields = mysql_num_fields(result);
+            MYSQL_FIELD* fields = mysql_fetch_fields(result);
+            
+            if (!fields || num_fields <= 0) {
+                logWarn("MySQL字段信息无效");
+                return rows;
+            }
+            
+            // 逐行读取数据
+            MYSQL_ROW row;
+            while ((row = mysql_fetch_row(result))) {
+                json row_obj;
+                unsigned long* lengths = mysql_fetch_lengths(result);
+                
+                if (!lengths) {
+                    logWarn("无法获取MySQL行数据长度");
+                    continue;
+                }
+                
+                for (int i = 0; i < num_fields; i++) {
+                    std::string field_name = fields[i].name ? fields[i].name : "unknown_field";
+                    
+                    if (row[i] == nullptr) {
+                        row_obj[field_name] = nullptr;
+                    } else {
+                        std::string field_value(row[i], lengths[i]);
+                        
+                        // 根据字段类型进行适当的类型转换
+                        switch (fields[i].type) {
+                            case MYSQL_TYPE_TINY:
+                            case MYSQL_TYPE_SHORT:
+                            case MYSQL_TYPE_LONG:
+                            case MYSQL_TYPE_LONGLONG:
+                            case MYSQL_TYPE_INT24:
+                                try {
+                                    row_obj[field_name] = std::stoll(field_value);
+                                } catch (const std::exception& e) {
+                                    logWarn("整数类型转换失败，使用字符串: " + std::string(e.what()));
+                                    row_obj[field_name] = field_value;
+                                }
+                                break;
+                            
+                            case MYSQL_TYPE_DECIMAL:
+                            case MYSQL_TYPE_NEWDECIMAL:
+                            case MYSQL_TYPE_FLOAT:
+                            case MYSQL_TYPE_DOUBLE:
+                                try {
+                                    row_obj[field_name] = std::stod(field_value);
+                                } catch (const std::exception& e) {
+                                    logWarn("浮点类型转换失败，使用字符串: " + std::string(e.what()));
+                                    row_obj[field_name] = field_value;
+                                }
+                                break;
+                            
+                            case MYSQL_TYPE_BIT:
+                                row_obj[field_name] = (field_value == "1");
+                                break;
+                            
+                            default:
+                                row_obj[field_name] = field_value;
+                                break;
+                        }
+                    }
+                }
+                rows.push_back(row_obj);
+            }
+            
+        } catch (const std::exception& e) {
+            logError("解析结果集异常: " + std::string(e.what()));
+            // 返回已解析的数据，而不是完全失败
+        } catch (...) {
+            logError("解析结果集发生未知异常");
+            // 返回已解析的数据，而不是完全失败
+        }
+        
+        return rows;
+    }
+    
+    // 转义SQL字符串
+    std::string escapeSQLString(const std::string& input) const {
+        try {
+            ConnectionGuard conn(db_pool_);
+            if (!conn.isValid()) {
+                throw std::runtime_error("数据库连接无效");
+            }
+            
+            std::string escaped;
+            escaped.resize(input.length() * 2 + 1);
+            
+            unsigned long escaped_length = mysql_real_escape_string(
+                conn.get(), &escaped[0], input.c_str(), input.length());
+            
+            escaped.resize(escaped_length);
+            return escaped;
+            
+        } catch (const std::exception& e) {
+            logError("SQL字符串转义失败: " + std::string(e.what()));
+            std::string result = input;
+            std::replace(result.begin(), result.end(), '\'', ' ');
+            std::replace(result.begin(), result.end(), '\"', ' ');
+            std::replace(result.begin(), result.end(), '\\', ' ');
+            return result;
+        }
+    }
+    
+    // 验证分页参数
+    std::pair<int, int> validatePaginationParams(int page, int page_size) const {
+        if (page < 1) page = 1;
+        if (page_size < 1) page_size = Constants::DEFAULT_PAGE_SIZE;
+        if (page_size > Constants::MAX_PAGE_SIZE) page_size = Constants::MAX_PAGE_SIZE;
+        return {page, page_size};
+    }
+    
+    // 生成分页SQL
+    std::string addPaginationToSQL(const std::string& sql, int page, int page_size) const {
+        int offset = (page - 1) * page_size;
+        return sql + " LIMIT " + std::to_string(page_size) + " OFFSET " + std::to_string(offset);
+    }
+
+    // ==================== 游标(keyset)分页 ====================
+    // 游标对调用方不透明，内部为 {"k": 排序键, "i": 主键} 的Base64编码
+    std::string encodePageCursor(const json& sort_key, long long id) const {
+        json cursor;
+        cursor["k"] = sort_key;
+        cursor["i"] = id;
+        return StringUtils::base64UrlEncode(cursor.dump());
+    }
+    
+    // 游标由客户端传回，排序键只接受null、字符串、整数和浮点数，其他类型(对象、数组、布尔)视为无效游标
+    bool decodePageCursor(const std::string& cursor, json& sort_key, long long& id) const {
+        std::string decoded;
+        if (!StringUtils::base64UrlDecode(cursor, decoded)) {
+            return false;
+        }
+        json parsed = json::parse(decoded, nullptr, false);
+        if (parsed.is_discarded() || !parsed.is_object() || !parsed.contains("i") ||
+            !parsed["i"].is_number_integer()) {
+            return false;
+        }
+        sort_key = parsed.contains("k") ? parsed["k"] : json();
+        if (!sort_key.is_null() && !sort_key.is_string() && !sort_key.is_number_integer() &&
+            !sort_key.is_number_float()) {
+            return false;
+        }
+        id = parsed["i"].get<long long>();
+        return true;
+    }
+    
+    // 生成"排在游标之后"的条件，排序为 sort_column DESC, id_column DESC
+    // sort_column为空时仅按主键翻页。MySQL降序时NULL排在最后，行比较遇到NULL结果为NULL，
+    // 因此排序键非NULL时要额外带上排序列为NULL的行，游标停在NULL段内时只在NULL段内按主键翻页
+    std::string buildKeysetCondition(const std::string& sort_column, const std::string& id_column,
+                                     const json& sort_key, long long id) const {
+        std::string id_value = std::to_string(id);
+        if (sort_column.empty()) {
+            return id_column + " < " + id_value;
+        }
+        if (sort_key.is_null()) {
+            return "(" + sort_column + " IS NULL AND " + id_column + " < " + id_value + ")";
+        }
+        std::string key_value;
+        if (sort_key.is_string()) {
+            key_value = "'" + escapeSQLString(sort_key.get<std::string>()) + "'";
+        } else if (sort_key.is_number_integer()) {
+            key_value = sort_key.is_number_unsigned() ? std::to_string(sort_key.get<unsigned long long>())
+                                                      : std::to_string(sort_key.get<long long>());
+        } else {
+            std::ostringstream oss;
+            oss << std::setprecision(17) << sort_key.get<double>();
+            key_value = oss.str();
+        }
+        return "((" + sort_column + ", " + id_column + ") < (" + key_value + ", " + id_value + ") OR " +
+               sort_column + " IS NULL)";
+    }
+    
+    // 生成keyset分页的排序与LIMIT子句，多取一行用于判断是否还有下一页
+    std::string buildKeysetOrderAndLimit(const std::string& sort_column, const std::string& id_column,
+                                         int page_size) const {
+        std::string order = sort_column.empty() ? id_column + " DESC"
+                                                : sort_column + " DESC, " + id_column + " DESC";
+        return " ORDER BY " + order + " LIMIT " + std::to_string(page_size + 1);
+    }
+    
+    // 处理多取的一行并生成下一页游标，rows为查询返回的行数组
+    json finishKeysetPage(json& rows, int page_size, const std::string& sort_field,
+                          const std::string& id_field) const {
+        json page_info;
+        bool has_more = rows.is_array() && static_cast<int>(rows.size()) > page_size;
+        if (has_more) {
+            rows.erase(rows.size() - 1);
+        }
+        page_info["page_size"] = page_size;
+        page_info["has_more"] = has_more;
+        page_info["next_cursor"] = nullptr;
+        if (has_more && !rows.empty()) {
+            const json& last = rows.back();
+            json sort_key = (!sort_field.empty() && last.contains(sort_field)) ? last[sort_field] : json();
+            long long last_id = last.contains(id_field) && last[id_field].is_number_integer()
+                                ? last[id_field].get<long long>() : 0;
+            page_info["next_cursor"] = encodePageCursor(sort_key, last_id);
+        }
+        return page_info;
+    }
+    
+    // 带缓存的总数查询，供游标分页按需返回总数(允许短时间内不精确)
+    long long getCachedCount(const std::string& count_sql, bool& from_cache) {
+        static ShardedTtlCache<long long> count_cache(Constants::CATALOG_CACHE_SHARDS, 1024,
+                                                      std::chrono::seconds(Constants::LIST_TOTAL_CACHE_TTL_SECONDS));
+        long long total = 0;
+        from_cache = count_cache.get(count_sql, total);
+        if (from_cache) {
+            return total;
+        }
+        json count_result = executeReadQuery(count_sql);
+        if (count_result["success"].get<bool>() && !count_result["data"].empty()) {
+            const json& row = count_result["data"][0];
+            if (!row.empty() && row.begin()->is_number_integer()) {
+                total = row.begin()->get<long long>();
+            }
+            count_cache.put(count_sql, total);
+        }
+        return total;
+    }
+
+    // 列存在性判断只查内存中的结构快照
+    bool hasColumn(const std::string& table_name, const std::string& column_name) const {
+        return SchemaCatalog::getInstance().loadedSnapshot()->hasColumn(StringUtils::toLower(table_name),
+                                                                        StringUtils::toLower(column_name));
+    }
+
+    std::string qualifyColumn(const std::string& table_alias, const std::string& table_name,
+                              const std::vector<std::string>& candidates) const {
+        for (const auto& candidate : candidates) {
+            if (hasColumn(table_name, candidate)) {
+                return (table_alias.empty() ? candidate : table_alias + "." + candidate);
+            }
+        }
+        return "";
+    }
+
+    std::string aliasColumn(const std::string& expression, const std::string& alias, const std::string& default_value = "NULL") const {
+        if (expression.empty()) {
+            return default_value + " AS " + alias;
+        }
+        return expression + " AS " + alias;
+    }
+
+    std::string joinColumns(const std::vector<std::string>& columns) const {
+        if (columns.empty()) {
+            return "";
+        }
+        std::ostringstream oss;
+        for (size_t i = 0; i < columns.size(); ++i) {
+            if (i > 0) {
+                oss << ", ";
+            }
+            oss << columns[i];
+        }
+        return oss.str();
+    }
+};
+
+
+// ====================================================================
+QueryTimer::~QueryTimer() {
+    try {
+        auto finished = std::chrono::steady_clock::now();
+        auto micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            finished - started_).count());
+        std::string text = QueryMetrics::fingerprint(sql_);
+        uint64_t hash = QueryMetrics::hashFingerprint(text);
+        QueryMetrics::getInstance().record(text, hash, micros, ok_, rows_, affected_);
+        
+        if (Tracer::active()) {
+            Tracer::recordSpan(prepared_ ? "db.execute" : "db.query", "db",
+                               Tracer::toNs(started_), Tracer::toNs(finished), text);
+        }
+        
+        SlowQueryLog& slow_log = SlowQueryLog::getInstance();
+        if (slow_log.isSlow(micros)) {
+            slow_log.record(sql_, text, hash, micros, ok_, rows_, affected_,
+                            service_ ? service_->getServiceName() : std::string(), prepared_);
+        }
+    } catch (...) {
+        // 统计失败不影响查询本身
+    }
+}
+
+// 服务模块Include区域
+// BaseService定义完成后,才能include服务类的实现
+// ====================================================================
+#include "services/UserService.h"
+#include "services/UserService.cpp"
+#include "services/ProductSearchIndex.h"
+#include "services/ProductSearchIndex.cpp"
+#include "services/ProductService.h"
+#include "services/ProductService.cpp"
+#include "services/CartService.h"
+#include "services/CartService.cpp"
+#include "services/AddressService.h"
+#include "services/AddressService.cpp"
+#include "services/CouponService.h"
+#include "services/CouponService.cpp"
+#include "services/ReviewService.h"
+#include "services/ReviewService.cpp"
+#include "services/OrderService.h"
+#include "services/OrderService.cpp"
+#include "services/BenchmarkService.h"
+#include "services/BenchmarkService.cpp"
+
+// 服务管理器类
+class EmshopServiceManager {
+private:
+    std::unique_ptr<UserService> user_service_;
+    std::unique_ptr<ProductService> product_service_;
+    std::unique_ptr<CartService> cart_service_;
+    std::unique_ptr<AddressService> address_service_;
+    std::unique_ptr<OrderService> order_service_;
+    std::unique_ptr<CouponService> coupon_service_;
+    std::unique_ptr<ReviewService> review_service_;
+    std::unique_ptr<BenchmarkService> benchmark_service_;
+    bool initialized_;
+    std::mutex init_mutex_;
+    
+    EmshopServiceManager() : initialized_(false) {}
+    
+public:
+    // 获取单例实例
+    static EmshopServiceManager& getInstance() {
+        static EmshopServiceManager instance;
+        return instance;
+    }
+    
+    // 禁用拷贝构造和赋值操作
+    EmshopServiceManager(const EmshopServiceManager&) = delete;
+    EmshopServiceManager& operator=(const EmshopServiceManager&) = delete;
+    
+    // 初始化所有服务
+    bool initialize() {
+        std::lock_guard<std::mutex> lock(init_mutex_);
+        
+        if (initialized_) {
+            Logger::warn("服务管理器已经初始化");
+            return true;
+        }
+        
+        Logger::info("初始化Emshop服务管理器...");
+        
+        // 运行时长和CPU使用率从这里开始计
+        ProcessMetrics::getInstance();
+        
+        try {
+            // 初始化日志系统
+            Logger::initialize();
+            Logger::setLevel(LogLevel::INFO);
+            try {
+                ConfigLoader& config = ConfigLoader::getInstance();
+                Logger::configureRotation(config.getInt("logging", "max_size_mb", Constants::LOG_MAX_FILE_MB),
+                                          config.getInt("logging", "max_files", Constants::LOG_MAX_FILES));
+            } catch (const std::exception& e) {
+                Logger::warn("读取日志配置失败，使用默认值: " + std::string(e.what()));
+            }
+            
+            // 初始化数据库连接池
+            DatabaseConnectionPool& pool = DatabaseConnectionPool::getInstance();
+            if (!pool.initialize()) {
+                Logger::error("数据库连接池初始化失败");
+                return false;
+            }
+            
+            // 一次性加载表结构，服务按快照预先确定列名和SQL片段
+            if (!SchemaCatalog::getInstance().refresh()) {
+                Logger::warn("数据库结构加载失败，将在首次使用时重试");
+            }
+            
+            // 连接只读副本(未配置时读请求全部走主库)
+            ReplicaRouter::getInstance().initialize(DatabaseConfig::getInstance().getReplicas());
+            
+            // 启动异步查询引擎
+            AsyncQueryEngine::getInstance().start(Constants::ASYNC_QUERY_THREADS);
+            
+            // 启动服务命令执行器
+            int executor_threads = Constants::COMMAND_EXECUTOR_THREADS;
+            int executor_queue_limit = static_cast<int>(Constants::COMMAND_EXECUTOR_QUEUE_LIMIT);
+            try {
+                executor_threads = ConfigLoader::getInstance().getInt("executor", "threads", executor_threads);
+                executor_queue_limit = ConfigLoader::getInstance().getInt("executor", "queue_limit", executor_queue_limit);
+            } catch (const std::exception& e) {
+                Logger::warn("读取执行器配置失败，使用默认值: " + std::string(e.what()));
+            }
+            if (executor_threads <= 0) {
+                executor_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+            }
+            NativeRequestExecutor::getInstance().start(static_cast<size_t>(executor_threads),
+                                                       static_cast<size_t>(std::max(1, executor_queue_limit)));
+            
+            // 启动慢查询EXPLAIN线程
+            SlowQueryLog::getInstance().start();
+            
+            // 启动购物车写回线程
+            CartStore::getInstance().start();
+            
+            // 启动链路追踪导出线程(配置未开启时不启动)
+            Tracer::getInstance().start();
+            
+            // 创建服务实例
+            user_service_.reset(new UserService());
+            product_service_.reset(new ProductService());
+            cart_service_.reset(new CartService());
+            address_service_.reset(new AddressService());
+            order_service_.reset(new OrderService(*product_service_));
+            coupon_service_.reset(new CouponService());
+            review_service_.reset(new ReviewService());
+            benchmark_service_.reset(new BenchmarkService());
+            
+            initialized_ = true;
+            Logger::info("Emshop服务管理器初始化成功");
+            return true;
+            
+        } catch (const std::exception& e) {
+            Logger::error("服务管理器初始化异常: " + std::string(e.what()));
+            return false;
+        }
+    }
+    
+    // 获取用户服务
+    UserService& getUserService() {
+        if (!initialized_) {
+            throw std::runtime_error("服务管理器未初始化");
+        }
+        return *user_service_;
+    }
+    
+    // 获取商品服务
+    ProductService& getProductService() {
+        if (!initialized_) {
+            throw std::runtime_error("服务管理器未初始化");
+        }
+        return *product_service_;
+    }
+    
+    // 获取购物车服务
+    CartService& getCartService() {
+        if (!initialized_) {
+            throw std::runtime_error("服务管理器未初始化");
+        }
+        return *cart_service_;
+    }
+    
+    // 获取地址服务
+    AddressService& getAddressService() {
+        if (!initialized_) {
+            throw std::runtime_error("服务管理器未初始化");
+        }
+        return *address_service_;
+    }
+    
+    // 获取订单服务
+    OrderService& getOrderService() {
+        if (!initialized_) {
+            throw std::runtime_error("服务管理器未初始化");
+        }
+        return *order_service_;
+    }
+    
+    // 获取优惠券服务
+    CouponService& getCouponService() {
+        if (!initialized_) {
+            throw std::runtime_error("服务管理器未初始化");
+        }
+        return *coupon_service_;
+    }
+    
+    // 获取评论服务
+    ReviewService& getReviewService() {
+        if (!initialized_) {
+            throw std::runtime_error("服务管理器未初始化");
+        }
+        return *review_service_;
+    }
+    
+    // 获取本地基准测试服务
+    BenchmarkService& getBenchmarkService() {
+        if (!initialized_) {
+            throw std::runtime_error("服务管理器未初始化");
+        }
+        return *benchmark_service_;
+    }
+    
+    // 获取数据库连接池服务
+    DatabaseConnectionPool& getDatabaseService() {
+        return DatabaseConnectionPool::getInstance();
+    }
+    
+    // 获取只读查询使用的连接池(有可用副本时返回副本，否则返回主库)
+    DatabaseConnectionPool& getReadDatabaseService(long sticky_user_id = 0) {
+        DatabaseConnectionPool* replica = ReplicaRouter::getInstance().pickReplica(sticky_user_id);
+        return replica ? *replica : DatabaseConnectionPool::getInstance();
+    }
+    
+    // 检查是否已初始化
+    bool isInitialized() const {
+        return initialized_;
+    }
+    
+    // 表结构变更(如执行升级脚本)后重新加载结构快照，各服务的列名映射随之更新
+    bool refreshSchemaCatalog() {
+        return SchemaCatalog::getInstance().refresh();
+    }
+    
+    // 关闭服务管理器
+    void shutdown() {
+        std::lock_guard<std::mutex> lock(init_mutex_);
+        
+        if (!initialized_) {
+            return;
+        }
+        
+        Logger::info("关闭Emshop服务管理器...");
+        
+        // 先停服务命令执行器和异步引擎，排队中的任务仍可使用服务和连接池完成
+        NativeRequestExecutor::getInstance().shutdown();
+        AsyncQueryEngine::getInstance().shutdown();
+        
+        // 重置服务实例
+        benchmark_service_.reset();
+        review_service_.reset();
+        coupon_service_.reset();
+        order_service_.reset();
+        address_service_.reset();
+        cart_service_.reset();
+        product_service_.reset();
+        user_service_.reset();
+        
+        // 写回内存购物车中尚未落库的修改
+        CartStore::getInstance().shutdown();
+        
+        // 关闭副本连接池和主库连接池(EXPLAIN线程使用主库连接，先停)
+        SlowQueryLog::getInstance().shutdown();
+        ReplicaRouter::getInstance().shutdown();
+        DatabaseConnectionPool::getInstance().shutdown();
+        
+        // 最后停追踪导出，已结束的追踪全部写入文件
+        Tracer::getInstance().shutdown();
+        
+        initialized_ = false;
+        Logger::info("Emshop服务管理器已关闭");
+    }
+    
+    ~EmshopServiceManager() {
+        shutdown();
+    }
+};
+
+// 可按名称调用的服务命令，名称与对应的JNI方法一致。批量命令接口只接受只读命令，
+// 各命令互不依赖，分发到服务命令执行器并发执行，结果按请求顺序返回
+class ServiceCommandRegistry {
+public:
+    struct Command {
+        bool read_only;
+        std::function<json(const json&)> handler;
+    };
+    
+private:
+    static long longParam(const json& params, const char* key) {
+        if (!params.contains(key) || !params[key].is_number_integer()) {
+            throw std::invalid_argument(std::string("缺少整数参数: ") + key);
+        }
+        return params[key].get<long>();
+    }
+    
+    static json errorResult(const std::string& message, int error_code) {
+        json response;
+        response["success"] = false;
+        response["message"] = message;
+        response["error_code"] = error_code;
+        return response;
+    }
+    
+    static const std::unordered_map<std::string, Command>& commands() {
+        static const std::unordered_map<std::string, Command> registry = {
+            {"getCart", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getCartService().getCart(longParam(p, "user_id"));
+            }}},
+            {"getUserAddresses", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getAddressService().getUserAddresses(longParam(p, "user_id"));
+            }}},
+            {"getUserCoupons", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getCouponService().getUserCoupons(longParam(p, "user_id"));
+            }}},
+            {"getAvailableCoupons", {true, [](const json&) {
+                return EmshopServiceManager::getInstance().getCouponService().getAvailableCoupons();
+            }}},
+            {"getAvailableCouponsForOrder", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getCouponService().getAvailableCouponsForOrder(
+                    longParam(p, "user_id"), p.value("order_amount", 0.0));
+            }}},
+            {"getProductList", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getProductService().getProductList(
+                    p.value("category", std::string("all")), p.value("page", 1),
+                    p.value("page_size", Constants::DEFAULT_PAGE_SIZE));
+            }}},
+            {"getProductDetail", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getProductService().getProductDetail(longParam(p, "product_id"));
+            }}},
+            {"getCategories", {true, [](const json&) {
+                return EmshopServiceManager::getInstance().getProductService().getCategories();
+            }}},
+            {"getOrderList", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getOrderService().getUserOrders(longParam(p, "user_id"));
+            }}},
+            {"getUserInfo", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getUserService().getUserInfo(longParam(p, "user_id"));
+            }}},
+            {"getNotifications", {true, [](const json& p) {
+                return EmshopServiceManager::getInstance().getOrderService().getNotifications(
+                    longParam(p, "user_id"), p.value("unread_only", false));
+            }}},
+            // 以下为写命令，只能通过异步请求接口单独提交，不参与批量执行
+            {"addToCart", {false, [](const json& p) {
+                return EmshopServiceManager::getInstance().getCartService().addToCart(
+                    longParam(p, "user_id"), longParam(p, "product_id"), p.value("quantity", 1));
+            }}},
+            {"createOrderFromCart", {false, [](const json& p) {
+                return EmshopServiceManager::getInstance().getOrderService().createOrderFromCart(
+                    longParam(p, "user_id"), longParam(p, "address_id"),
+                    p.value("coupon_code", std::string()), p.value("remark", std::string()));
+            }}},
+            {"createOrderDirect", {false, [](const json& p) {
+                return EmshopServiceManager::getInstance().getOrderService().createOrderDirect(
+                    longParam(p, "user_id"), longParam(p, "product_id"), p.value("quantity", 1),
+                    longParam(p, "address_id"), p.value("coupon_code", std::string()),
+                    p.value("remark", std::string()));
+            }}}
+        };
+        return registry;
+    }
     
-    // 日志记录方法
-    void logInfo(const std::string& message) const {
-        Logger::info("[" + getServiceName() + "] " + message);
-    }
-    
-    void logWarn(const std::string& message) const {
-        Logger::warn("[" + getServiceName() + "] " + message);
-    }
-    
-    void logError(const std::string& message) const {
-        Logger::error("[" + getServiceName() + "] " + message);
-    }
-    
-    void logDebug(const std::string& message) const {
-        Logger::debug("[" + getServiceName() + "] " + message);
+public:
+    static const Command* find(const std::string& name) {
+        auto it = commands().find(name);
+        return it == commands().end() ? nullptr : &it->second;
     }
-
-    virtual std::string getServiceName() const = 0;
     
-    // 执行查询的通用方法 - 使用外部连接(用于事务)
-    json executeQueryWithConnection(MYSQL* conn, const std::string& sql) {
-        MYSQL_RES* result = nullptr;
+    // 执行单条命令，参数错误和服务异常都转换为错误响应
+    static json execute(const Command& command, const json& params) {
         try {
-            if (!conn) {
-                logError("连接指针为空");
-                return createErrorResponse("数据库连接无效", Constants::DATABASE_ERROR_CODE);
-            }
-            
-            // 在执行查询前检查连接是否有效,如果无效则尝试重连
-            if (mysql_ping(conn) != 0) {
-                logWarn("连接已失效，尝试重新连接...");
-                // 注意: mysql_ping 会自动尝试重连(如果设置了MYSQL_OPT_RECONNECT)
-                if (mysql_ping(conn) != 0) {
-                    std::string error_msg = "连接验证失败: " + std::string(mysql_error(conn));
-                    logError(error_msg);
-                    return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
-                }
-                logInfo("连接重新建立成功");
-            }
-            
-            logDebug("执行SQL: " + sql);
-            
-            if (mysql_query(conn, sql.c_str()) != 0) {
-                std::string error_msg = "SQL执行失败: " + std::string(mysql_error(conn));
-                logError(error_msg);
-                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
-            }
-            
-            // 如果是SELECT查询，获取结果
-            result = mysql_store_result(conn);
-            if (result) {
-                json data = parseResultSet(result);
-                mysql_free_result(result);
-                result = nullptr;
-                return createSuccessResponse(data);
-            } else if (mysql_field_count(conn) == 0) {
-                // 非SELECT查询（INSERT, UPDATE, DELETE等）
-                json data;
-                data["affected_rows"] = static_cast<int>(mysql_affected_rows(conn));
-                data["insert_id"] = static_cast<long>(mysql_insert_id(conn));
-                return createSuccessResponse(data);
+            return command.handler(params);
+        } catch (const std::invalid_argument& e) {
+            return errorResult(e.what(), Constants::VALIDATION_ERROR_CODE);
+        } catch (const json::exception& e) {
+            return errorResult("命令参数格式错误: " + std::string(e.what()), Constants::VALIDATION_ERROR_CODE);
+        }
+    }
+    
+    // commands: [{"id": 可选标识, "command": 命令名, "params": {...}}]
+    static json executeBatch(const json& commands) {
+        if (!commands.is_array() || commands.empty()) {
+            return errorResult("批量命令不能为空", Constants::VALIDATION_ERROR_CODE);
+        }
+        if (commands.size() > Constants::COMMAND_BATCH_MAX) {
+            return errorResult("单次批量命令不能超过" + std::to_string(Constants::COMMAND_BATCH_MAX) + "条",
+                               Constants::VALIDATION_ERROR_CODE);
+        }
+        
+        auto started = std::chrono::steady_clock::now();
+        size_t count = commands.size();
+        std::vector<json> results(count);
+        std::vector<std::future<json>> futures(count);
+        std::vector<size_t> runnable;
+        for (size_t i = 0; i < count; ++i) {
+            const json& item = commands[i];
+            std::string name = item.is_object() ? item.value("command", std::string()) : std::string();
+            const Command* command = find(name);
+            if (!command) {
+                results[i] = errorResult("未知命令: " + name, Constants::VALIDATION_ERROR_CODE);
+            } else if (!command->read_only) {
+                results[i] = errorResult("批量接口只支持只读命令: " + name, Constants::VALIDATION_ERROR_CODE);
             } else {
-                std::string error_msg = "获取查询结果失败: " + std::string(mysql_error(conn));
-                logError(error_msg);
-                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
-            }
-            
-        } catch (const std::exception& e) {
-            if (result) {
-                mysql_free_result(result);
-                result = nullptr;
+                runnable.push_back(i);
             }
-            std::string error_msg = "查询执行异常: " + std::string(e.what());
-            logError(error_msg);
-            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
-        } catch (...) {
-            if (result) {
-                mysql_free_result(result);
-                result = nullptr;
+        }
+        
+        // 第一条命令留在当前线程执行，其余提交到执行器
+        NativeRequestExecutor& executor = NativeRequestExecutor::getInstance();
+        for (size_t k = 1; k < runnable.size(); ++k) {
+            size_t i = runnable[k];
+            const Command* command = find(commands[i]["command"].get<std::string>());
+            json params = commands[i].value("params", json::object());
+            futures[i] = executor.submit([command, params]() { return execute(*command, params); });
+        }
+        if (!runnable.empty()) {
+            size_t i = runnable[0];
+            results[i] = execute(*find(commands[i]["command"].get<std::string>()),
+                                 commands[i].value("params", json::object()));
+        }
+        for (size_t k = 1; k < runnable.size(); ++k) {
+            results[runnable[k]] = futures[runnable[k]].get();
+        }
+        
+        json items = json::array();
+        int failed = 0;
+        for (size_t i = 0; i < count; ++i) {
+            bool ok = results[i].value("success", false);
+            if (!ok) {
+                failed++;
             }
-            std::string error_msg = "查询执行发生未知异常";
-            logError(error_msg);
-            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+            json item;
+            item["id"] = commands[i].is_object() && commands[i].contains("id") ? commands[i]["id"] : json(i);
+            item["command"] = commands[i].is_object() ? commands[i].value("command", std::string()) : std::string();
+            item["success"] = ok;
+            item["result"] = std::move(results[i]);
+            items.push_back(std::move(item));
+        }
+        
+        json data;
+        data["results"] = std::move(items);
+        data["total"] = count;
+        data["failed"] = failed;
+        data["elapsed_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        
+        json response;
+        response["success"] = true;
+        response["message"] = failed == 0 ? "批量命令执行成功" : "批量命令部分失败";
+        response["data"] = std::move(data);
+        return response;
+    }
+};
+
+// JNI直接缓冲区的内存池：直接缓冲区接口把响应所在的字符串借给Java，NewDirectByteBuffer直接指向其数据，
+// 不再复制和转码；Java用完后调用releaseDirectBuffer归还。归还的字符串保留容量放回空闲列表，
+// 下一次响应直接在其中生成。借出期间Java端可能仍在读取，池不会主动收回
+class DirectBufferPool {
+private:
+    std::mutex mutex_;
+    std::unordered_map<const void*, std::unique_ptr<std::string>> leased_;
+    std::vector<std::unique_ptr<std::string>> free_;
+    size_t leased_bytes_;
+    uint64_t leases_;
+    uint64_t reuses_;
+    uint64_t releases_;
+    bool lease_warned_;
+    
+    DirectBufferPool()
+        : leased_bytes_(0), leases_(0), reuses_(0), releases_(0), lease_warned_(false) {}
+    
+    // 调用方须持有mutex_；不适合复用的缓冲区留在holder中，由调用方在锁外释放
+    void poolLocked(std::unique_ptr<std::string>& holder) {
+        if (holder->capacity() <= Constants::DIRECT_BUFFER_MAX_POOLED_BYTES &&
+            free_.size() < Constants::DIRECT_BUFFER_POOL_SIZE) {
+            holder->clear();
+            free_.push_back(std::move(holder));
         }
     }
     
-    // 执行查询的通用方法 - 修复内存安全问题
-    json executeQuery(const std::string& sql, const json& params = json::object()) {
-        MYSQL_RES* result = nullptr;
-        try {
-            ConnectionGuard conn(db_pool_);
-            if (!conn.isValid()) {
-                logError("数据库连接无效");
-                return createErrorResponse("数据库连接无效", Constants::DATABASE_ERROR_CODE);
-            }
-            
-            logDebug("执行SQL: " + sql);
-            
-            if (mysql_query(conn.get(), sql.c_str()) != 0) {
-                std::string error_msg = "SQL执行失败: " + std::string(mysql_error(conn.get()));
-                logError(error_msg);
-                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
-            }
-            
-            // 如果是SELECT查询，获取结果
-            result = mysql_store_result(conn.get());
-            if (result) {
-                json data = parseResultSet(result);
-                mysql_free_result(result);
-                result = nullptr; // 标记已释放
-                return createSuccessResponse(data);
-            } else if (mysql_field_count(conn.get()) == 0) {
-                // 非SELECT查询（INSERT, UPDATE, DELETE等）
-                json data;
-                data["affected_rows"] = static_cast<int>(mysql_affected_rows(conn.get()));
-                data["insert_id"] = static_cast<long>(mysql_insert_id(conn.get()));
-                return createSuccessResponse(data);
-            } else {
-                std::string error_msg = "获取查询结果失败: " + std::string(mysql_error(conn.get()));
-                logError(error_msg);
-                return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+public:
+    static DirectBufferPool& getInstance() {
+        static DirectBufferPool instance;
+        return instance;
+    }
+    
+    DirectBufferPool(const DirectBufferPool&) = delete;
+    DirectBufferPool& operator=(const DirectBufferPool&) = delete;
+    
+    // 取一个空缓冲区，优先复用已归还的
+    std::string acquire() {
+        std::unique_ptr<std::string> holder;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!free_.empty()) {
+                holder = std::move(free_.back());
+                free_.pop_back();
+                reuses_++;
             }
-            
-        } catch (const std::exception& e) {
-            // 确保在异常情况下也释放MySQL结果集
-            if (result) {
-                mysql_free_result(result);
-                result = nullptr;
+        }
+        if (!holder) {
+            std::string buffer;
+            buffer.reserve(4096);
+            return buffer;
+        }
+        return std::move(*holder);
+    }
+    
+    // 借出缓冲区并返回数据地址，地址在release之前保持有效
+    const char* lease(std::string&& data) {
+        auto holder = std::make_unique<std::string>(std::move(data));
+        const char* address = holder->data();
+        std::lock_guard<std::mutex> lock(mutex_);
+        leased_bytes_ += holder->size();
+        leases_++;
+        leased_.emplace(address, std::move(holder));
+        if (leased_.size() > Constants::DIRECT_BUFFER_LEASE_WARN && !lease_warned_) {
+            lease_warned_ = true;
+            Logger::warn("未归还的直接缓冲区过多: " + std::to_string(leased_.size()) +
+                         "，请检查Java端是否调用releaseDirectBuffer");
+        }
+        return address;
+    }
+    
+    // 归还借出的缓冲区；不是本池借出的地址(如调用方自备的缓冲区)返回false
+    bool release(const void* address) {
+        std::unique_ptr<std::string> holder;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = leased_.find(address);
+            if (it == leased_.end()) {
+                return false;
             }
-            std::string error_msg = "查询执行异常: " + std::string(e.what());
-            logError(error_msg);
-            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
-        } catch (...) {
-            // 捕获所有其他异常
-            if (result) {
-                mysql_free_result(result);
-                result = nullptr;
+            holder = std::move(it->second);
+            leased_.erase(it);
+            leased_bytes_ -= holder->size();
+            releases_++;
+            if (leased_.size() <= Constants::DIRECT_BUFFER_LEASE_WARN / 2) {
+                lease_warned_ = false;
             }
-            std::string error_msg = "查询执行发生未知异常";
-            logError(error_msg);
-            return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+            poolLocked(holder);
         }
+        return true;
     }
     
-    // 解析MySQL结果集为JSON - 修复内存安全问题
-    json parseResultSet(MYSQL_RES* result) const {
-        json rows = json::array();
+    // 回收没有借出过的缓冲区(响应已复制到调用方的缓冲区)
+    void recycle(std::string&& data) {
+        auto holder = std::make_unique<std::string>(std::move(data));
+        std::lock_guard<std::mutex> lock(mutex_);
+        poolLocked(holder);
+    }
+    
+    json getStats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        json stats;
+        stats["leased"] = leased_.size();
+        stats["leased_bytes"] = leased_bytes_;
+        stats["pooled"] = free_.size();
+        stats["total_leases"] = leases_;
+        stats["reuses"] = reuses_;
+        stats["releases"] = releases_;
+        return stats;
+    }
+};
+
+// JNI 辅助函数
+class JNIStringConverter {
+public:
+    // 安全的Java字符串转C++字符串 - 修复内存安全问题
+    static std::string jstringToString(JNIEnv* env, jstring jstr) {
+        if (!env || !jstr) {
+            return "";
+        }
         
-        if (!result) {
-            logWarn("MySQL结果集为空");
-            return rows;
+        const char* chars = env->GetStringUTFChars(jstr, nullptr);
+        if (!chars) {
+            return "";
         }
         
-        try {
-            // 获取字段信息
-            int num_fields = mysql_num_fields(result);
-            MYSQL_FIELD* fields = mysql_fetch_fields(result);
-            
-            if (!fields || num_fields <= 0) {
-                logWarn("MySQL字段信息无效");
-                return rows;
+        std::string result(chars);
+        env->ReleaseStringUTFChars(jstr, chars);
+        return result;
+    }
+    
+    // 按标准UTF-8创建Java字符串。NewStringUTF要求modified UTF-8，4字节字符(emoji等)会被破坏，
+    // 所以只在出现4字节序列时转成UTF-16再用NewString创建；非法字节替换为U+FFFD
+    static jstring utf8ToJstring(JNIEnv* env, const char* data, size_t length) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        size_t i = 0;
+        while (i < length && bytes[i] < 0xF0) {
+            ++i;
+        }
+        if (i == length) {
+            return env->NewStringUTF(data);
+        }
+        
+        std::u16string utf16;
+        utf16.reserve(length);
+        i = 0;
+        while (i < length) {
+            unsigned char lead = bytes[i];
+            uint32_t code_point = 0;
+            size_t count = 0;
+            if (lead < 0x80) {
+                code_point = lead;
+                count = 1;
+            } else if ((lead & 0xE0) == 0xC0) {
+                code_point = lead & 0x1F;
+                count = 2;
+            } else if ((lead & 0xF0) == 0xE0) {
+                code_point = lead & 0x0F;
+                count = 3;
+            } else if ((lead & 0xF8) == 0xF0) {
+                code_point = lead & 0x07;
+                count = 4;
             }
-            
-            // 逐行读取数据
-            MYSQL_ROW row;
-            while ((row = mysql_fetch_row(result))) {
-                json row_obj;
-                unsigned long* lengths = mysql_fetch_lengths(result);
-                
-                if (!lengths) {
-                    logWarn("无法获取MySQL行数据长度");
-                    continue;
-                }
-                
-                for (int i = 0; i < num_fields; i++) {
-                    std::string field_name = fields[i].name ? fields[i].name : "unknown_field";
-                    
-                    if (row[i] == nullptr) {
-                        row_obj[field_name] = nullptr;
-                    } else {
-                        std::string field_value(row[i], lengths[i]);
-                        
-                        // 根据字段类型进行适当的类型转换
-                        switch (fields[i].type) {
-                            case MYSQL_TYPE_TINY:
-                            case MYSQL_TYPE_SHORT:
-                            case MYSQL_TYPE_LONG:
-                            case MYSQL_TYPE_LONGLONG:
-                            case MYSQL_TYPE_INT24:
-                                try {
-                                    row_obj[field_name] = std::stoll(field_value);
-                                } catch (const std::exception& e) {
-                                    logWarn("整数类型转换失败，使用字符串: " + std::string(e.what()));
-                                    row_obj[field_name] = field_value;
-                                }
-                                break;
-                            
-                            case MYSQL_TYPE_DECIMAL:
-                            case MYSQL_TYPE_NEWDECIMAL:
-                            case MYSQL_TYPE_FLOAT:
-                            case MYSQL_TYPE_DOUBLE:
-                                try {
-                                    row_obj[field_name] = std::stod(field_value);
-                                } catch (const std::exception& e) {
-                                    logWarn("浮点类型转换失败，使用字符串: " + std::string(e.what()));
-                                    row_obj[field_name] = field_value;
-                                }
-                                break;
-                            
-                            case MYSQL_TYPE_BIT:
-                                row_obj[field_name] = (field_value == "1");
-                                break;
-                            
-                            default:
-                                row_obj[field_name] = field_value;
-                                break;
-                        }
-                    }
+            bool valid = count > 0 && i + count <= length;
+            for (size_t k = 1; valid && k < count; ++k) {
+                if ((bytes[i + k] & 0xC0) != 0x80) {
+                    valid = false;
+                } else {
+                    code_point = (code_point << 6) | (bytes[i + k] & 0x3F);
                 }
-                rows.push_back(row_obj);
             }
-            
-        } catch (const std::exception& e) {
-            logError("解析结果集异常: " + std::string(e.what()));
-            // 返回已解析的数据，而不是完全失败
-        } catch (...) {
-            logError("解析结果集发生未知异常");
-            // 返回已解析的数据，而不是完全失败
+            if (!valid || code_point > 0x10FFFF) {
+                utf16.push_back(static_cast<char16_t>(0xFFFD));
+                ++i;
+                continue;
+            }
+            i += count;
+            if (code_point >= 0x10000) {
+                code_point -= 0x10000;
+                utf16.push_back(static_cast<char16_t>(0xD800 + (code_point >> 10)));
+                utf16.push_back(static_cast<char16_t>(0xDC00 + (code_point & 0x3FF)));
+            } else {
+                utf16.push_back(static_cast<char16_t>(code_point));
+            }
         }
-        
-        return rows;
+        return env->NewString(reinterpret_cast<const jchar*>(utf16.data()), static_cast<jsize>(utf16.size()));
     }
     
-    // 转义SQL字符串
-    std::string escapeSQLString(const std::string& input) const {
+    // 安全的C++字符串转Java字符串
+    static jstring stringToJstring(JNIEnv* env, const std::string& str) {
+        if (!env) {
+            return nullptr;
+        }
+        return utf8ToJstring(env, str.c_str(), str.size());
+    }
+    
+    // 安全的JSON对象转Java字符串 - 添加异常处理
+    static jstring jsonToJstring(JNIEnv* env, const json& obj) {
+        if (!env) {
+            return nullptr;
+        }
         try {
-            ConnectionGuard conn(db_pool_);
-            if (!conn.isValid()) {
-                throw std::runtime_error("数据库连接无效");
+            std::string json_str;
+            {
+                TraceSpan span("json.serialize", "json");
+                json_str = obj.dump();
             }
-            
-            std::string escaped;
-            escaped.resize(input.length() * 2 + 1);
-            
-            unsigned long escaped_length = mysql_real_escape_string(
-                conn.get(), &escaped[0], input.c_str(), input.length());
-            
-            escaped.resize(escaped_length);
-            return escaped;
-            
+            TraceSpan span("jni.new_string", "jni");
+            return utf8ToJstring(env, json_str.c_str(), json_str.size());
         } catch (const std::exception& e) {
-            logError("SQL字符串转义失败: " + std::string(e.what()));
-            std::string result = input;
-            std::replace(result.begin(), result.end(), '\'', ' ');
-            std::replace(result.begin(), result.end(), '\"', ' ');
-            std::replace(result.begin(), result.end(), '\\', ' ');
-            return result;
+            Logger::error("JSON转换失败: " + std::string(e.what()));
+            return env->NewStringUTF("{\"success\":false,\"message\":\"JSON转换错误\"}");
         }
     }
     
-    // 验证分页参数
-    std::pair<int, int> validatePaginationParams(int page, int page_size) const {
-        if (page < 1) page = 1;
-        if (page_size < 1) page_size = Constants::DEFAULT_PAGE_SIZE;
-        if (page_size > Constants::MAX_PAGE_SIZE) page_size = Constants::MAX_PAGE_SIZE;
-        return {page, page_size};
+    // 流式JSON缓冲区转Java字符串，缓冲区内容已是最终格式，无需再次序列化
+    static jstring writerToJstring(JNIEnv* env, const JsonWriter& writer) {
+        if (!env) {
+            return nullptr;
+        }
+        TraceSpan span("jni.new_string", "jni");
+        return utf8ToJstring(env, writer.c_str(), writer.size());
     }
     
-    // 生成分页SQL
-    std::string addPaginationToSQL(const std::string& sql, int page, int page_size) const {
-        int offset = (page - 1) * page_size;
-        return sql + " LIMIT " + std::to_string(page_size) + " OFFSET " + std::to_string(offset);
+    // 调用方自备的直接缓冲区容量足够时把响应复制进去，并把position/limit设为[0, 响应长度)
+    static bool copyToTarget(JNIEnv* env, jobject target, const char* data, size_t length) {
+        if (!target) {
+            return false;
+        }
+        void* address = env->GetDirectBufferAddress(target);
+        jlong capacity = env->GetDirectBufferCapacity(target);
+        if (!address || capacity < static_cast<jlong>(length)) {
+            return false;
+        }
+        std::memcpy(address, data, length);
+        
+        static const jmethodID clear_method = [env]() {
+            jclass buffer_class = env->FindClass("java/nio/Buffer");
+            jmethodID method = env->GetMethodID(buffer_class, "clear", "()Ljava/nio/Buffer;");
+            env->DeleteLocalRef(buffer_class);
+            return method;
+        }();
+        static const jmethodID limit_method = [env]() {
+            jclass buffer_class = env->FindClass("java/nio/Buffer");
+            jmethodID method = env->GetMethodID(buffer_class, "limit", "(I)Ljava/nio/Buffer;");
+            env->DeleteLocalRef(buffer_class);
+            return method;
+        }();
+        env->DeleteLocalRef(env->CallObjectMethod(target, clear_method));
+        env->DeleteLocalRef(env->CallObjectMethod(target, limit_method, static_cast<jint>(length)));
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            return false;
+        }
+        return true;
     }
-
-    bool hasColumn(const std::string& table_name, const std::string& column_name) const {
-        std::string table_lower = StringUtils::toLower(table_name);
-        std::string column_lower = StringUtils::toLower(column_name);
-
-        {
-            std::lock_guard<std::mutex> lock(column_cache_mutex_);
-            auto table_it = column_exists_cache_.find(table_lower);
-            if (table_it != column_exists_cache_.end()) {
-                auto col_it = table_it->second.find(column_lower);
-                if (col_it != table_it->second.end()) {
-                    return col_it->second;
-                }
-            }
+    
+    // 借出池中的缓冲区并包装为直接缓冲区，不复制
+    static jobject leaseDirectBuffer(JNIEnv* env, std::string&& data) {
+        size_t length = data.size();
+        const char* address = DirectBufferPool::getInstance().lease(std::move(data));
+        jobject buffer = env->NewDirectByteBuffer(const_cast<char*>(address), static_cast<jlong>(length));
+        if (!buffer) {
+            DirectBufferPool::getInstance().release(address);
         }
-
-        bool exists = false;
+        return buffer;
+    }
+    
+    // 直接缓冲区版本的响应输出(UTF-8原样交给Java，不经过NewStringUTF)：
+    // target容量足够时写入target并返回它，否则返回借出的池化缓冲区；两种情况Java用完都调用releaseDirectBuffer
+    static jobject writerToDirectBuffer(JNIEnv* env, jobject target, JsonWriter& writer) {
+        if (!env) {
+            return nullptr;
+        }
+        TraceSpan span("jni.direct_buffer", "jni");
+        if (copyToTarget(env, target, writer.c_str(), writer.size())) {
+            return target;
+        }
+        // 响应整体换出，线程的JsonWriter换入一个池中的空缓冲区继续使用
+        std::string data = DirectBufferPool::getInstance().acquire();
+        writer.swapBuffer(data);
+        return leaseDirectBuffer(env, std::move(data));
+    }
+    
+    static jobject jsonToDirectBuffer(JNIEnv* env, jobject target, const json& obj) {
+        if (!env) {
+            return nullptr;
+        }
+        std::string data;
         try {
-            ConnectionGuard conn(db_pool_);
-            if (!conn.isValid()) {
-                return false;
-            }
-
-            std::string sql = "SELECT 1 FROM information_schema.COLUMNS WHERE TABLE_SCHEMA = DATABASE() "
-                              "AND TABLE_NAME = '" + table_lower + "' AND COLUMN_NAME = '" + column_lower + "' LIMIT 1";
+            TraceSpan span("json.serialize", "json");
+            data = obj.dump();
+        } catch (const std::exception& e) {
+            Logger::error("JSON转换失败: " + std::string(e.what()));
+            data = "{\"success\":false,\"message\":\"JSON转换错误\"}";
+        }
+        TraceSpan span("jni.direct_buffer", "jni");
+        if (copyToTarget(env, target, data.data(), data.size())) {
+            DirectBufferPool::getInstance().recycle(std::move(data));
+            return target;
+        }
+        return leaseDirectBuffer(env, std::move(data));
+    }
+    
+    // 当前线程复用的流式JSON缓冲区
+    static JsonWriter& threadLocalWriter() {
+        static thread_local JsonWriter writer;
+        writer.clear();
+        return writer;
+    }
+};
 
-            if (mysql_query(conn.get(), sql.c_str()) == 0) {
-                MYSQL_RES* res = mysql_store_result(conn.get());
-                if (res) {
-                    exists = mysql_num_rows(res) > 0;
-                    mysql_free_result(res);
-                }
+// 异步请求完成通知 - 缓存JavaVM和Java端处理器的全局引用，执行器线程完成请求后附加到JVM，
+// 调用处理器的onNativeComplete(long, String)把结果交回Java。执行器线程首次回调时以守护线程
+// 附加，线程退出时自动分离；回调期间持共享锁，更换或注销处理器要等正在进行的回调结束
+class NativeCompletionDispatcher {
+private:
+    mutable std::shared_mutex mutex_;
+    JavaVM* vm_;
+    jobject handler_;
+    jmethodID method_;
+    std::atomic<long long> delivered_;
+    std::atomic<long long> dropped_;
+    std::atomic<long long> callback_errors_;
+
+    NativeCompletionDispatcher()
+        : vm_(nullptr), handler_(nullptr), method_(nullptr), delivered_(0), dropped_(0), callback_errors_(0) {}
+
+    struct ThreadAttachment {
+        JavaVM* vm = nullptr;
+        ~ThreadAttachment() {
+            if (vm) {
+                vm->DetachCurrentThread();
             }
-        } catch (const std::exception& e) {
-            logWarn("检查列存在性失败: " + std::string(e.what()));
-        } catch (...) {
-            logWarn("检查列存在性发生未知异常");
         }
+    };
 
-        {
-            std::lock_guard<std::mutex> lock(column_cache_mutex_);
-            column_exists_cache_[table_lower][column_lower] = exists;
+    static JNIEnv* attachCurrentThread(JavaVM* vm) {
+        JNIEnv* env = nullptr;
+        if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_8) == JNI_OK) {
+            return env;
+        }
+        static thread_local ThreadAttachment attachment;
+        if (vm->AttachCurrentThreadAsDaemon(reinterpret_cast<void**>(&env), nullptr) != JNI_OK) {
+            return nullptr;
         }
+        attachment.vm = vm;
+        return env;
+    }
 
-        return exists;
+public:
+    static NativeCompletionDispatcher& getInstance() {
+        static NativeCompletionDispatcher instance;
+        return instance;
     }
 
-    std::string qualifyColumn(const std::string& table_alias, const std::string& table_name,
-                              const std::vector<std::string>& candidates) const {
-        for (const auto& candidate : candidates) {
-            if (hasColumn(table_name, candidate)) {
-                return (table_alias.empty() ? candidate : table_alias + "." + candidate);
+    NativeCompletionDispatcher(const NativeCompletionDispatcher&) = delete;
+    NativeCompletionDispatcher& operator=(const NativeCompletionDispatcher&) = delete;
+
+    // handler为null时注销；处理器须有void onNativeComplete(long, String)方法
+    bool registerHandler(JNIEnv* env, jobject handler) {
+        JavaVM* vm = nullptr;
+        jobject global = nullptr;
+        jmethodID method = nullptr;
+        if (handler) {
+            if (env->GetJavaVM(&vm) != JNI_OK) {
+                return false;
+            }
+            jclass cls = env->GetObjectClass(handler);
+            method = env->GetMethodID(cls, "onNativeComplete", "(JLjava/lang/String;)V");
+            env->DeleteLocalRef(cls);
+            if (!method || env->ExceptionCheck()) {
+                env->ExceptionClear();
+                Logger::error("异步完成处理器缺少onNativeComplete(long, String)方法");
+                return false;
             }
+            global = env->NewGlobalRef(handler);
         }
-        return "";
-    }
 
-    std::string aliasColumn(const std::string& expression, const std::string& alias, const std::string& default_value = "NULL") const {
-        if (expression.empty()) {
-            return default_value + " AS " + alias;
+        jobject previous;
+        {
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            previous = handler_;
+            handler_ = global;
+            method_ = method;
+            if (vm) {
+                vm_ = vm;
+            }
         }
-        return expression + " AS " + alias;
+        if (previous) {
+            env->DeleteGlobalRef(previous);
+        }
+        Logger::info(handler ? "异步完成处理器已注册" : "异步完成处理器已注销");
+        return true;
     }
 
-    std::string joinColumns(const std::vector<std::string>& columns) const {
-        if (columns.empty()) {
-            return "";
+    bool hasHandler() const {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        return handler_ != nullptr;
+    }
+
+    // 在执行器线程上调用，把结果交给Java；处理器未注册或附加失败时丢弃并计数
+    void deliver(jlong request_id, const json& response) {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        if (!handler_) {
+            dropped_++;
+            Logger::warn("异步完成处理器未注册，丢弃请求结果: " + std::to_string(request_id));
+            return;
         }
-        std::ostringstream oss;
-        for (size_t i = 0; i < columns.size(); ++i) {
-            if (i > 0) {
-                oss << ", ";
-            }
-            oss << columns[i];
+        JNIEnv* env = attachCurrentThread(vm_);
+        if (!env) {
+            dropped_++;
+            Logger::error("执行器线程附加到JVM失败，丢弃请求结果: " + std::to_string(request_id));
+            return;
+        }
+        // 执行器线程不会返回Java，局部引用须逐个释放
+        jstring text = JNIStringConverter::jsonToJstring(env, response);
+        env->CallVoidMethod(handler_, method_, request_id, text);
+        if (env->ExceptionCheck()) {
+            env->ExceptionClear();
+            callback_errors_++;
+            Logger::error("异步完成处理器抛出异常，请求: " + std::to_string(request_id));
+        } else {
+            delivered_++;
+        }
+        if (text) {
+            env->DeleteLocalRef(text);
         }
-        return oss.str();
     }
-};
 
-std::mutex BaseService::column_cache_mutex_;
-std::unordered_map<std::string, std::unordered_map<std::string, bool>> BaseService::column_exists_cache_;
+    json getStats() const {
+        json stats;
+        stats["handler_registered"] = hasHandler();
+        stats["delivered"] = delivered_.load();
+        stats["dropped"] = dropped_.load();
+        stats["callback_errors"] = callback_errors_.load();
+        return stats;
+    }
+};
 
-// ====================================================================
-// 服务模块Include区域
-// BaseService定义完成后,才能include服务类的实现
-// ====================================================================
-#include "services/UserService.h"
-#include "services/UserService.cpp"
-#include "services/ProductService.h"
-#include "services/ProductService.cpp"
-#include "services/CartService.h"
-#include "services/CartService.cpp"
-#include "services/AddressService.h"
-#include "services/AddressService.cpp"
-#include "services/CouponService.h"
-#include "services/CouponService.cpp"
-#include "services/ReviewService.h"
-#include "services/ReviewService.cpp"
-#include "services/OrderService.h"
-#include "services/OrderService.cpp"
+// 准入控制 - 在JNI入口决定请求立即执行还是直接以ERROR_SYSTEM_BUSY拒绝，避免数据库变慢时
+// 请求在连接池中排队等待最长60秒。依次检查三项，任一不满足即拒绝：
+// 1. 接口并发上限：admission.endpoint_limits按接口名配置，未配置的接口使用default_endpoint_limit；
+// 2. 全局自适应并发上限：梯度算法，短期平均延迟相对无排队时的基线升高时按比例收缩上限，
+//    延迟回落后逐步放大，使在途请求数维持在数据库能及时处理的水平；
+// 3. 用户令牌桶：限制单个用户的请求速率(匿名请求不检查)
+class AdmissionController {
+public:
+    struct EndpointState {
+        std::atomic<int> in_flight{0};
+        std::atomic<long long> admitted{0};
+        std::atomic<long long> rejected{0};
+        int limit = Constants::ADMISSION_ENDPOINT_LIMIT;
+    };
 
-// 服务管理器类
-class EmshopServiceManager {
 private:
-    std::unique_ptr<UserService> user_service_;
-    std::unique_ptr<ProductService> product_service_;
-    std::unique_ptr<CartService> cart_service_;
-    std::unique_ptr<AddressService> address_service_;
-    std::unique_ptr<OrderService> order_service_;
-    std::unique_ptr<CouponService> coupon_service_;
-    std::unique_ptr<ReviewService> review_service_;
-    bool initialized_;
-    std::mutex init_mutex_;
-    
-    EmshopServiceManager() : initialized_(false) {}
-    
-public:
-    // 获取单例实例
-    static EmshopServiceManager& getInstance() {
-        static EmshopServiceManager instance;
-        return instance;
-    }
-    
-    // 禁用拷贝构造和赋值操作
-    EmshopServiceManager(const EmshopServiceManager&) = delete;
-    EmshopServiceManager& operator=(const EmshopServiceManager&) = delete;
-    
-    // 初始化所有服务
-    bool initialize() {
-        std::lock_guard<std::mutex> lock(init_mutex_);
-        
-        if (initialized_) {
-            Logger::warn("服务管理器已经初始化");
-            return true;
-        }
-        
-        Logger::info("初始化Emshop服务管理器...");
-        
+    struct UserBucket {
+        double tokens;
+        std::chrono::steady_clock::time_point refilled_at;
+    };
+
+    struct alignas(64) UserShard {
+        std::mutex mutex;
+        std::unordered_map<long, UserBucket> buckets;
+    };
+
+    bool enabled_;
+    int default_endpoint_limit_;
+    std::unordered_map<std::string, int> configured_limits_;
+    double user_rate_;
+    double user_burst_;
+    int min_limit_;
+    int max_limit_;
+
+    mutable std::shared_mutex endpoints_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<EndpointState>> endpoints_;
+    std::vector<std::unique_ptr<UserShard>> user_shards_;
+
+    // 自适应上限：limit_供入口无锁读取，其余状态在limit_mutex_下更新
+    std::atomic<int> limit_;
+    std::atomic<int> in_flight_;
+    std::mutex limit_mutex_;
+    double estimated_limit_;
+    double short_rtt_ms_;
+    double long_rtt_ms_;
+
+    std::atomic<long long> admitted_;
+    std::atomic<long long> rejected_endpoint_;
+    std::atomic<long long> rejected_adaptive_;
+    std::atomic<long long> rejected_user_;
+
+    AdmissionController()
+        : enabled_(true)
+        , default_endpoint_limit_(Constants::ADMISSION_ENDPOINT_LIMIT)
+        , user_rate_(Constants::ADMISSION_USER_RATE)
+        , user_burst_(Constants::ADMISSION_USER_BURST)
+        , min_limit_(Constants::ADMISSION_MIN_LIMIT)
+        , max_limit_(Constants::ADMISSION_MAX_LIMIT)
+        , limit_(Constants::ADMISSION_INITIAL_LIMIT)
+        , in_flight_(0)
+        , estimated_limit_(Constants::ADMISSION_INITIAL_LIMIT)
+        , short_rtt_ms_(0.0)
+        , long_rtt_ms_(0.0)
+        , admitted_(0)
+        , rejected_endpoint_(0)
+        , rejected_adaptive_(0)
+        , rejected_user_(0) {
+        int initial_limit = Constants::ADMISSION_INITIAL_LIMIT;
         try {
-            // 初始化日志系统
-            Logger::initialize();
-            Logger::setLevel(LogLevel::INFO);
-            
-            // 初始化数据库连接池
-            DatabaseConnectionPool& pool = DatabaseConnectionPool::getInstance();
-            if (!pool.initialize()) {
-                Logger::error("数据库连接池初始化失败");
-                return false;
+            ConfigLoader& config = ConfigLoader::getInstance();
+            enabled_ = config.getBool("admission", "enabled", enabled_);
+            default_endpoint_limit_ = config.getInt("admission", "default_endpoint_limit", default_endpoint_limit_);
+            user_rate_ = config.getInt("admission", "user_rate_per_second", static_cast<int>(user_rate_));
+            user_burst_ = config.getInt("admission", "user_burst", static_cast<int>(user_burst_));
+            min_limit_ = config.getInt("admission", "min_limit", min_limit_);
+            max_limit_ = config.getInt("admission", "max_limit", max_limit_);
+            initial_limit = config.getInt("admission", "initial_limit", initial_limit);
+            json section = config.getConfig().value("admission", json::object());
+            if (section.contains("endpoint_limits") && section["endpoint_limits"].is_object()) {
+                for (auto it = section["endpoint_limits"].begin(); it != section["endpoint_limits"].end(); ++it) {
+                    if (it.value().is_number_integer()) {
+                        configured_limits_[it.key()] = std::max(1, it.value().get<int>());
+                    }
+                }
             }
-            
-            // 创建服务实例
-            user_service_.reset(new UserService());
-            product_service_.reset(new ProductService());
-            cart_service_.reset(new CartService());
-            address_service_.reset(new AddressService());
-            order_service_.reset(new OrderService());
-            coupon_service_.reset(new CouponService());
-            review_service_.reset(new ReviewService());
-            
-            initialized_ = true;
-            Logger::info("Emshop服务管理器初始化成功");
-            return true;
-            
         } catch (const std::exception& e) {
-            Logger::error("服务管理器初始化异常: " + std::string(e.what()));
-            return false;
+            Logger::warn("读取准入控制配置失败，使用默认值: " + std::string(e.what()));
         }
-    }
-    
-    // 获取用户服务
-    UserService& getUserService() {
-        if (!initialized_) {
-            throw std::runtime_error("服务管理器未初始化");
+        default_endpoint_limit_ = std::max(1, default_endpoint_limit_);
+        min_limit_ = std::max(1, min_limit_);
+        max_limit_ = std::max(min_limit_, max_limit_);
+        initial_limit = std::min(max_limit_, std::max(min_limit_, initial_limit));
+        limit_ = initial_limit;
+        estimated_limit_ = initial_limit;
+        user_burst_ = std::max(1.0, user_burst_);
+        for (size_t i = 0; i < Constants::ADMISSION_USER_SHARDS; ++i) {
+            user_shards_.push_back(std::make_unique<UserShard>());
         }
-        return *user_service_;
     }
-    
-    // 获取商品服务
-    ProductService& getProductService() {
-        if (!initialized_) {
-            throw std::runtime_error("服务管理器未初始化");
+
+    EndpointState& endpointState(const std::string& endpoint) {
+        {
+            std::shared_lock<std::shared_mutex> lock(endpoints_mutex_);
+            auto it = endpoints_.find(endpoint);
+            if (it != endpoints_.end()) {
+                return *it->second;
+            }
         }
-        return *product_service_;
-    }
-    
-    // 获取购物车服务
-    CartService& getCartService() {
-        if (!initialized_) {
-            throw std::runtime_error("服务管理器未初始化");
+        std::unique_lock<std::shared_mutex> lock(endpoints_mutex_);
+        auto& slot = endpoints_[endpoint];
+        if (!slot) {
+            slot = std::make_unique<EndpointState>();
+            auto configured = configured_limits_.find(endpoint);
+            slot->limit = configured != configured_limits_.end() ? configured->second : default_endpoint_limit_;
         }
-        return *cart_service_;
+        return *slot;
     }
-    
-    // 获取地址服务
-    AddressService& getAddressService() {
-        if (!initialized_) {
-            throw std::runtime_error("服务管理器未初始化");
+
+    bool takeUserToken(long user_id) {
+        if (user_id <= 0 || user_rate_ <= 0) {
+            return true;
         }
-        return *address_service_;
-    }
-    
-    // 获取订单服务
-    OrderService& getOrderService() {
-        if (!initialized_) {
-            throw std::runtime_error("服务管理器未初始化");
+        UserShard& shard = *user_shards_[static_cast<size_t>(user_id) % user_shards_.size()];
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.buckets.size() >= Constants::ADMISSION_USER_BUCKETS_PER_SHARD) {
+            // 已回满的令牌桶与新建的等价，清理掉
+            for (auto it = shard.buckets.begin(); it != shard.buckets.end();) {
+                double elapsed = std::chrono::duration<double>(now - it->second.refilled_at).count();
+                if (it->second.tokens + elapsed * user_rate_ >= user_burst_) {
+                    it = shard.buckets.erase(it);
+                } else {
+                    ++it;
+                }
+            }
         }
-        return *order_service_;
-    }
-    
-    // 获取优惠券服务
-    CouponService& getCouponService() {
-        if (!initialized_) {
-            throw std::runtime_error("服务管理器未初始化");
+        auto inserted = shard.buckets.emplace(user_id, UserBucket{user_burst_, now});
+        UserBucket& bucket = inserted.first->second;
+        double elapsed = std::chrono::duration<double>(now - bucket.refilled_at).count();
+        bucket.tokens = std::min(user_burst_, bucket.tokens + elapsed * user_rate_);
+        bucket.refilled_at = now;
+        if (bucket.tokens < 1.0) {
+            return false;
         }
-        return *coupon_service_;
+        bucket.tokens -= 1.0;
+        return true;
     }
-    
-    // 获取评论服务
-    ReviewService& getReviewService() {
-        if (!initialized_) {
-            throw std::runtime_error("服务管理器未初始化");
+
+    // 梯度算法：gradient = clamp(容忍系数 * 基线延迟 / 短期延迟, 0.5, 1)，
+    // 新上限 = 上限 * gradient + sqrt(上限)，再做平滑。在途请求不到上限一半时不放大上限
+    void onSample(double rtt_ms, int in_flight) {
+        std::unique_lock<std::mutex> lock(limit_mutex_, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;  // 其他线程正在更新，丢弃本次样本，避免入口串行化
         }
-        return *review_service_;
+        if (short_rtt_ms_ <= 0.0) {
+            short_rtt_ms_ = rtt_ms;
+            long_rtt_ms_ = rtt_ms;
+        }
+        short_rtt_ms_ = short_rtt_ms_ * 0.9 + rtt_ms * 0.1;
+        // 基线取接近无排队时的延迟：更低的样本立即生效，更高的样本只缓慢抬升基线，
+        // 既不会被排队延迟带高，也能在数据库整体变慢后逐步适应
+        long_rtt_ms_ = rtt_ms < long_rtt_ms_ ? rtt_ms : long_rtt_ms_ * 0.999 + rtt_ms * 0.001;
+
+        double gradient = std::max(0.5, std::min(1.0, Constants::ADMISSION_RTT_TOLERANCE * long_rtt_ms_ /
+                                                          std::max(0.001, short_rtt_ms_)));
+        double next = estimated_limit_ * gradient + std::sqrt(estimated_limit_);
+        if (in_flight < estimated_limit_ / 2) {
+            next = std::min(next, estimated_limit_);
+        }
+        estimated_limit_ = estimated_limit_ * 0.8 + next * 0.2;
+        estimated_limit_ = std::min<double>(max_limit_, std::max<double>(min_limit_, estimated_limit_));
+        limit_.store(static_cast<int>(estimated_limit_));
     }
-    
-    // 获取数据库连接池服务
-    DatabaseConnectionPool& getDatabaseService() {
-        return DatabaseConnectionPool::getInstance();
+
+public:
+    static AdmissionController& getInstance() {
+        static AdmissionController instance;
+        return instance;
     }
-    
-    // 检查是否已初始化
-    bool isInitialized() const {
-        return initialized_;
+
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    bool isEnabled() const { return enabled_; }
+
+    // 通过时返回nullptr并占用名额，state指向接口状态；拒绝时返回原因
+    const char* tryAcquire(const std::string& endpoint, long user_id, EndpointState*& state) {
+        state = nullptr;
+        if (!enabled_) {
+            return nullptr;
+        }
+        EndpointState& ep = endpointState(endpoint);
+        if (ep.in_flight.fetch_add(1) >= ep.limit) {
+            ep.in_flight--;
+            ep.rejected++;
+            rejected_endpoint_++;
+            return "endpoint_limit";
+        }
+        if (in_flight_.fetch_add(1) >= limit_.load()) {
+            in_flight_--;
+            ep.in_flight--;
+            ep.rejected++;
+            rejected_adaptive_++;
+            return "adaptive_limit";
+        }
+        if (!takeUserToken(user_id)) {
+            in_flight_--;
+            ep.in_flight--;
+            ep.rejected++;
+            rejected_user_++;
+            return "user_rate";
+        }
+        ep.admitted++;
+        admitted_++;
+        state = &ep;
+        return nullptr;
     }
-    
-    // 关闭服务管理器
-    void shutdown() {
-        std::lock_guard<std::mutex> lock(init_mutex_);
-        
-        if (!initialized_) {
+
+    // sample为false时只归还名额，不计入延迟(请求未真正执行)
+    void release(EndpointState* state, std::chrono::steady_clock::duration elapsed, bool sample) {
+        if (!state) {
             return;
         }
-        
-        Logger::info("关闭Emshop服务管理器...");
-        
-        // 重置服务实例
-        review_service_.reset();
-        coupon_service_.reset();
-        order_service_.reset();
-        address_service_.reset();
-        cart_service_.reset();
-        product_service_.reset();
-        user_service_.reset();
-        
-        // 关闭数据库连接池
-        DatabaseConnectionPool::getInstance().shutdown();
-        
-        initialized_ = false;
-        Logger::info("Emshop服务管理器已关闭");
+        int in_flight = in_flight_.fetch_sub(1);
+        state->in_flight--;
+        if (sample) {
+            onSample(std::chrono::duration<double, std::milli>(elapsed).count(), in_flight);
+        }
     }
-    
-    ~EmshopServiceManager() {
-        shutdown();
+
+    json rejection(const char* reason) {
+        long long retry_after_ms;
+        if (std::strcmp(reason, "user_rate") == 0) {
+            retry_after_ms = static_cast<long long>(1000.0 / std::max(0.001, user_rate_));
+        } else {
+            std::lock_guard<std::mutex> lock(limit_mutex_);
+            retry_after_ms = static_cast<long long>(std::max(10.0, short_rtt_ms_));
+        }
+        json response;
+        response["success"] = false;
+        response["message"] = "系统繁忙，请稍后重试";
+        response["error_code"] = Constants::ERROR_SYSTEM_BUSY;
+        response["data"]["reason"] = reason;
+        response["data"]["retry_after_ms"] = retry_after_ms;
+        return response;
     }
-};
 
-// JNI 辅助函数
-class JNIStringConverter {
-public:
-    // 安全的Java字符串转C++字符串 - 修复内存安全问题
-    static std::string jstringToString(JNIEnv* env, jstring jstr) {
-        if (!env || !jstr) {
-            return "";
+    json getStats() {
+        json stats;
+        stats["enabled"] = enabled_;
+        stats["limit"] = limit_.load();
+        stats["in_flight"] = in_flight_.load();
+        stats["admitted"] = admitted_.load();
+        stats["rejected"]["endpoint_limit"] = rejected_endpoint_.load();
+        stats["rejected"]["adaptive_limit"] = rejected_adaptive_.load();
+        stats["rejected"]["user_rate"] = rejected_user_.load();
+        {
+            std::lock_guard<std::mutex> lock(limit_mutex_);
+            stats["short_rtt_ms"] = short_rtt_ms_;
+            stats["long_rtt_ms"] = long_rtt_ms_;
         }
-        
-        const char* chars = env->GetStringUTFChars(jstr, nullptr);
-        if (!chars) {
-            return "";
+        json endpoints = json::object();
+        {
+            std::shared_lock<std::shared_mutex> lock(endpoints_mutex_);
+            for (const auto& entry : endpoints_) {
+                json ep;
+                ep["limit"] = entry.second->limit;
+                ep["in_flight"] = entry.second->in_flight.load();
+                ep["admitted"] = entry.second->admitted.load();
+                ep["rejected"] = entry.second->rejected.load();
+                endpoints[entry.first] = std::move(ep);
+            }
         }
-        
-        std::string result(chars);
-        env->ReleaseStringUTFChars(jstr, chars);
-        return result;
+        stats["endpoints"] = std::move(endpoints);
+        return stats;
     }
-    
-    // 安全的C++字符串转Java字符串
-    static jstring stringToJstring(JNIEnv* env, const std::string& str) {
-        if (!env) {
-            return nullptr;
-        }
-        return env->NewStringUTF(str.c_str());
+};
+
+// 准入凭证：构造时做准入检查，finish或析构时释放名额并把本次耗时反馈给自适应上限
+class AdmissionTicket {
+private:
+    AdmissionController::EndpointState* state_;
+    const char* reason_;
+    std::chrono::steady_clock::time_point started_;
+
+public:
+    AdmissionTicket(const std::string& endpoint, long user_id)
+        : state_(nullptr)
+        , reason_(AdmissionController::getInstance().tryAcquire(endpoint, user_id, state_))
+        , started_(std::chrono::steady_clock::now()) {}
+
+    AdmissionTicket(const AdmissionTicket&) = delete;
+    AdmissionTicket& operator=(const AdmissionTicket&) = delete;
+
+    ~AdmissionTicket() {
+        finish();
     }
-    
-    // 安全的JSON对象转Java字符串 - 添加异常处理
-    static jstring jsonToJstring(JNIEnv* env, const json& obj) {
-        if (!env) {
-            return nullptr;
+
+    bool admitted() const { return reason_ == nullptr; }
+
+    json rejection() const {
+        return AdmissionController::getInstance().rejection(reason_ ? reason_ : "unknown");
+    }
+
+    void finish() {
+        if (state_) {
+            AdmissionController::getInstance().release(state_, std::chrono::steady_clock::now() - started_, true);
+            state_ = nullptr;
         }
-        try {
-            std::string json_str = obj.dump();
-            return env->NewStringUTF(json_str.c_str());
-        } catch (const std::exception& e) {
-            Logger::error("JSON转换失败: " + std::string(e.what()));
-            return env->NewStringUTF("{\"success\":false,\"message\":\"JSON转换错误\"}");
+    }
+
+    // 请求最终没有执行时归还名额，不把耗时反馈给自适应上限
+    void cancel() {
+        if (state_) {
+            AdmissionController::getInstance().release(state_, std::chrono::steady_clock::duration::zero(), false);
+            state_ = nullptr;
         }
     }
 };
@@ -1695,11 +8441,47 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getProductList
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("getProductList", 0);
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
+    try {
+        std::string cat = JNIStringConverter::jstringToString(env, category);
+        
+        ProductService& productService = EmshopServiceManager::getInstance().getProductService();
+        JsonWriter& writer = JNIStringConverter::threadLocalWriter();
+        productService.writeProductList(writer, cat, static_cast<int>(page), static_cast<int>(pageSize));
+        
+        return JNIStringConverter::writerToJstring(env, writer);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "获取商品列表异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+}
+
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getProductListByCursor
+  (JNIEnv *env, jclass cls, jstring category, jstring cursor, jint pageSize, jboolean includeTotal) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+    
     try {
         std::string cat = JNIStringConverter::jstringToString(env, category);
+        std::string cursor_str = JNIStringConverter::jstringToString(env, cursor);
         
         ProductService& productService = EmshopServiceManager::getInstance().getProductService();
-        json result = productService.getProductList(cat, static_cast<int>(page), static_cast<int>(pageSize));
+        json result = productService.getProductListByCursor(cat, cursor_str, static_cast<int>(pageSize),
+                                                            includeTotal == JNI_TRUE);
         
         return JNIStringConverter::jsonToJstring(env, result);
         
@@ -1724,17 +8506,23 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_searchProducts
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("searchProducts", 0);
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
         std::string keyword_str = JNIStringConverter::jstringToString(env, keyword);
         std::string sort_by_str = JNIStringConverter::jstringToString(env, sortBy);
         
         ProductService& productService = EmshopServiceManager::getInstance().getProductService();
-        json result = productService.searchProducts(keyword_str, static_cast<int>(page), 
-                                                   static_cast<int>(pageSize), sort_by_str,
-                                                   static_cast<double>(minPrice), 
-                                                   static_cast<double>(maxPrice));
+        JsonWriter& writer = JNIStringConverter::threadLocalWriter();
+        productService.writeSearchProducts(writer, keyword_str, static_cast<int>(page), 
+                                           static_cast<int>(pageSize), sort_by_str,
+                                           static_cast<double>(minPrice), 
+                                           static_cast<double>(maxPrice));
         
-        return JNIStringConverter::jsonToJstring(env, result);
+        return JNIStringConverter::writerToJstring(env, writer);
         
     } catch (const std::exception& e) {
         json error_response;
@@ -1756,6 +8544,11 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getProductDetail
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("getProductDetail", 0);
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
         ProductService& productService = EmshopServiceManager::getInstance().getProductService();
         json result = productService.getProductDetail(static_cast<long>(productId));
@@ -1808,6 +8601,11 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_addToCart
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("addToCart", static_cast<long>(userId));
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
         CartService& cartService = EmshopServiceManager::getInstance().getCartService();
         json result = cartService.addToCart(static_cast<long>(userId), 
@@ -1836,6 +8634,11 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getCart
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("getCart", static_cast<long>(userId));
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
         CartService& cartService = EmshopServiceManager::getInstance().getCartService();
         json result = cartService.getCart(static_cast<long>(userId));
@@ -2035,10 +8838,51 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getLowStockProducts
 
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_logout
   (JNIEnv *env, jclass cls, jlong userId) {
-    json response;
-    response["success"] = true;
-    response["message"] = "登出成功";
-    return JNIStringConverter::jsonToJstring(env, response);
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+    
+    try {
+        UserService& userService = EmshopServiceManager::getInstance().getUserService();
+        json result = userService.logoutUser(static_cast<long>(userId));
+        return JNIStringConverter::jsonToJstring(env, result);
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "登出过程发生异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+}
+
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_validateToken
+  (JNIEnv *env, jclass cls, jstring token) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+    
+    try {
+        std::string token_str = JNIStringConverter::jstringToString(env, token);
+        UserService& userService = EmshopServiceManager::getInstance().getUserService();
+        json result = userService.validateToken(token_str);
+        return JNIStringConverter::jsonToJstring(env, result);
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "校验令牌异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
 }
 
 // ====================================================================
@@ -2177,6 +9021,11 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_createOrderFromCart
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("createOrderFromCart", static_cast<long>(userId));
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
         std::string coupon_code = couponCode ? JNIStringConverter::jstringToString(env, couponCode) : "";
         std::string remark_str = remark ? JNIStringConverter::jstringToString(env, remark) : "";
@@ -2207,6 +9056,11 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getOrderList
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("getOrderList", static_cast<long>(userId));
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
         OrderService& orderService = EmshopServiceManager::getInstance().getOrderService();
         json result = orderService.getUserOrders(static_cast<long>(userId));
@@ -2239,11 +9093,50 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getAllOrders
                 std::string end_date_str = endDate ? JNIStringConverter::jstringToString(env, endDate) : std::string("");
 
                 OrderService& orderService = EmshopServiceManager::getInstance().getOrderService();
-                json result = orderService.getAllOrders(status_str,
-                                                                                                static_cast<int>(page),
-                                                                                                static_cast<int>(pageSize),
-                                                                                                start_date_str,
-                                                                                                end_date_str);
+                JsonWriter& writer = JNIStringConverter::threadLocalWriter();
+                orderService.writeAllOrders(writer,
+                                            status_str,
+                                            static_cast<int>(page),
+                                            static_cast<int>(pageSize),
+                                            start_date_str,
+                                            end_date_str);
+
+                return JNIStringConverter::writerToJstring(env, writer);
+
+        } catch (const std::exception& e) {
+                json error_response;
+                error_response["success"] = false;
+                error_response["message"] = "获取全部订单异常: " + std::string(e.what());
+                error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+                return JNIStringConverter::jsonToJstring(env, error_response);
+        }
+}
+
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getAllOrdersByCursor
+    (JNIEnv *env, jclass cls, jstring status, jstring cursor, jint pageSize, jstring startDate, jstring endDate,
+     jboolean includeTotal) {
+
+        if (!ensureServiceManagerInitialized()) {
+                json error_response;
+                error_response["success"] = false;
+                error_response["message"] = "服务未初始化";
+                error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+                return JNIStringConverter::jsonToJstring(env, error_response);
+        }
+
+        try {
+                std::string status_str = status ? JNIStringConverter::jstringToString(env, status) : std::string("all");
+                std::string cursor_str = JNIStringConverter::jstringToString(env, cursor);
+                std::string start_date_str = startDate ? JNIStringConverter::jstringToString(env, startDate) : std::string("");
+                std::string end_date_str = endDate ? JNIStringConverter::jstringToString(env, endDate) : std::string("");
+
+                OrderService& orderService = EmshopServiceManager::getInstance().getOrderService();
+                json result = orderService.getAllOrdersByCursor(status_str,
+                                                                cursor_str,
+                                                                static_cast<int>(pageSize),
+                                                                start_date_str,
+                                                                end_date_str,
+                                                                includeTotal == JNI_TRUE);
 
                 return JNIStringConverter::jsonToJstring(env, result);
 
@@ -2293,6 +9186,11 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_payOrder
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("payOrder", 0);
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
         std::string payment_method = JNIStringConverter::jstringToString(env, paymentMethod);
         
@@ -2367,6 +9265,10 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_createOrderDirect
         error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
+    AdmissionTicket admission("createOrderDirect", static_cast<long>(userId));
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
     try {
         std::string coupon = couponCode ? JNIStringConverter::jstringToString(env, couponCode) : std::string("");
         std::string remark_str = remark ? JNIStringConverter::jstringToString(env, remark) : std::string("");
@@ -2808,6 +9710,37 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getAllUsers
     }
 }
 
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getAllUsersByCursor
+  (JNIEnv *env, jclass cls, jstring cursor, jint pageSize, jstring status, jstring keyword, jboolean includeTotal) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+    
+    try {
+        std::string cursor_str = JNIStringConverter::jstringToString(env, cursor);
+        std::string status_str = status ? JNIStringConverter::jstringToString(env, status) : "all";
+        std::string keyword_str = JNIStringConverter::jstringToString(env, keyword);
+        
+        UserService& userService = EmshopServiceManager::getInstance().getUserService();
+        json result = userService.getAllUsersByCursor(cursor_str, static_cast<int>(pageSize), status_str,
+                                                      keyword_str, includeTotal == JNI_TRUE);
+        
+        return JNIStringConverter::jsonToJstring(env, result);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "获取用户列表异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+}
+
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_searchUsers
   (JNIEnv *env, jclass cls, jstring keyword, jint page, jint pageSize) {
 
@@ -2850,22 +9783,46 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSystemStatistics
     try {
         std::string period_str = period ? JNIStringConverter::jstringToString(env, period) : "day";
         
-        // 模拟系统统计数据
+        std::string interval = "1 DAY";
+        if (period_str == "week") {
+            interval = "7 DAY";
+        } else if (period_str == "month") {
+            interval = "1 MONTH";
+        } else if (period_str == "year") {
+            interval = "1 YEAR";
+        }
+        
+        std::shared_ptr<const SchemaSnapshot> schema = SchemaCatalog::getInstance().loadedSnapshot();
+        std::string user_created = schema->firstColumn("users", {"created_at", "create_time"});
+        std::string order_created = schema->firstColumn("orders", {"created_at", "create_time"});
+        std::string since = "DATE_SUB(NOW(), INTERVAL " + interval + ")";
+        // 已取消和已退款的订单不计入销售额
+        std::string revenue_filter = "status NOT IN ('cancelled', 'refunded')";
+        
+        std::string sql = "SELECT (SELECT COUNT(*) FROM users) AS total_users, "
+                          "(SELECT COUNT(*) FROM products) AS total_products, "
+                          "(SELECT COUNT(*) FROM orders) AS total_orders, "
+                          "(SELECT COALESCE(SUM(total_amount), 0) FROM orders WHERE " + revenue_filter + ") AS total_revenue";
+        sql += user_created.empty() ? ", NULL AS new_users"
+                                    : ", (SELECT COUNT(*) FROM users WHERE " + user_created + " >= " + since + ") AS new_users";
+        if (order_created.empty()) {
+            sql += ", NULL AS period_orders, NULL AS period_revenue";
+        } else {
+            sql += ", (SELECT COUNT(*) FROM orders WHERE " + order_created + " >= " + since + ") AS period_orders"
+                   ", (SELECT COALESCE(SUM(total_amount), 0) FROM orders WHERE " + order_created + " >= " + since +
+                   " AND " + revenue_filter + ") AS period_revenue";
+        }
+        
+        json query_result = EmshopServiceManager::getInstance().getProductService().executeReadQuery(sql);
+        if (!query_result["success"].get<bool>()) {
+            return JNIStringConverter::jsonToJstring(env, query_result);
+        }
+        
         json result;
         result["success"] = true;
         result["message"] = "获取系统统计成功";
-        result["period"] = period_str;
-        
-        json statistics;
-        statistics["total_users"] = 1250;
-        statistics["total_products"] = 450;
-        statistics["total_orders"] = 3200;
-        statistics["total_revenue"] = 125600.50;
-        statistics["new_users_today"] = 15;
-        statistics["orders_today"] = 45;
-        statistics["revenue_today"] = 2800.75;
-        
-        result["data"] = statistics;
+        result["period"] = period_str;
+        result["data"] = query_result["data"].empty() ? json::object() : query_result["data"][0];
         
         return JNIStringConverter::jsonToJstring(env, result);
         
@@ -3287,55 +10244,16 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getCartSummary
     }
     
     try {
-        auto conn = EmshopServiceManager::getInstance().getDatabaseService().getConnection();
-        if (!conn) {
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "数据库连接失败";
-            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
-        
-        std::string query = "SELECT COUNT(*) as item_count, SUM(c.quantity * p.price) as total_amount FROM cart c "
-                           "JOIN products p ON c.product_id = p.id WHERE c.user_id = " + std::to_string(userId);
-        
-        if (mysql_query(conn, query.c_str()) != 0) {
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "查询购物车摘要失败";
-            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
-        
-        MYSQL_RES* result = mysql_store_result(conn);
-        if (!result) {
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "获取查询结果失败";
-            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
-        
-        json summary;
-        MYSQL_ROW row = mysql_fetch_row(result);
-        if (row) {
-            summary["item_count"] = row[0] ? std::stoi(row[0]) : 0;
-            summary["total_amount"] = row[1] ? std::stod(row[1]) : 0.0;
-        } else {
-            summary["item_count"] = 0;
-            summary["total_amount"] = 0.0;
+        json result = EmshopServiceManager::getInstance().getCartService().getCartSummary(userId);
+        if (!result["success"].get<bool>()) {
+            return JNIStringConverter::jsonToJstring(env, result);
         }
         
-        mysql_free_result(result);
-        EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-        
         json response;
         response["success"] = true;
         response["message"] = "获取购物车摘要成功";
         response["user_id"] = userId;
-        response["summary"] = summary;
+        response["summary"] = result["data"];
         
         return JNIStringConverter::jsonToJstring(env, response);
         
@@ -3361,147 +10279,17 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_checkout
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("checkout", static_cast<long>(userId));
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
-        auto conn = EmshopServiceManager::getInstance().getDatabaseService().getConnection();
-        if (!conn) {
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "数据库连接失败";
-            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
-        
-        // 开始事务
-        mysql_autocommit(conn, 0);
-        
-        // 获取购物车内容
-        std::string cart_query = "SELECT c.product_id, c.quantity, p.price, p.stock FROM cart c "
-                                "JOIN products p ON c.product_id = p.id WHERE c.user_id = " + std::to_string(userId);
-        
-        if (mysql_query(conn, cart_query.c_str()) != 0) {
-            mysql_rollback(conn);
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "查询购物车失败";
-            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
-        
-        MYSQL_RES* cart_result = mysql_store_result(conn);
-        if (!cart_result || mysql_num_rows(cart_result) == 0) {
-            if (cart_result) mysql_free_result(cart_result);
-            mysql_rollback(conn);
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "购物车为空";
-            error_response["error_code"] = Constants::VALIDATION_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
-        
-        double total_amount = 0.0;
-        std::vector<std::tuple<long, int, double>> cart_items;
-        
-        MYSQL_ROW row;
-        while ((row = mysql_fetch_row(cart_result))) {
-            long product_id = std::stoll(row[0]);
-            int quantity = std::stoi(row[1]);
-            double price = std::stod(row[2]);
-            int stock = std::stoi(row[3]);
-            
-            if (quantity > stock) {
-                mysql_free_result(cart_result);
-                mysql_rollback(conn);
-                EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-                json error_response;
-                error_response["success"] = false;
-                error_response["message"] = "商品库存不足，商品ID: " + std::to_string(product_id);
-                error_response["error_code"] = Constants::VALIDATION_ERROR_CODE;
-                return JNIStringConverter::jsonToJstring(env, error_response);
-            }
-            
-            cart_items.push_back(std::make_tuple(product_id, quantity, price));
-            total_amount += quantity * price;
-        }
-        mysql_free_result(cart_result);
-        
-        // 创建订单
-        auto now = std::time(nullptr);
-        std::string order_query = "INSERT INTO orders (user_id, total_amount, status, created_at) VALUES (" +
-                                 std::to_string(userId) + ", " + std::to_string(total_amount) + ", 'pending', FROM_UNIXTIME(" + std::to_string(now) + "))";
-        
-        if (mysql_query(conn, order_query.c_str()) != 0) {
-            mysql_rollback(conn);
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "创建订单失败";
-            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
-        
-        long order_id = mysql_insert_id(conn);
-        
-        // 创建订单项并更新库存
-        for (const auto& item : cart_items) {
-            long product_id = std::get<0>(item);
-            int quantity = std::get<1>(item);
-            double price = std::get<2>(item);
-            
-            std::string item_query = "INSERT INTO order_items (order_id, product_id, quantity, price) VALUES (" +
-                                   std::to_string(order_id) + ", " + std::to_string(product_id) + ", " +
-                                   std::to_string(quantity) + ", " + std::to_string(price) + ")";
-            
-            if (mysql_query(conn, item_query.c_str()) != 0) {
-                mysql_rollback(conn);
-                EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-                json error_response;
-                error_response["success"] = false;
-                error_response["message"] = "创建订单项失败";
-                error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-                return JNIStringConverter::jsonToJstring(env, error_response);
-            }
-            
-            // 更新库存
-            std::string stock_query = "UPDATE products SET stock = stock - " + std::to_string(quantity) +
-                                    " WHERE id = " + std::to_string(product_id);
-            
-            if (mysql_query(conn, stock_query.c_str()) != 0) {
-                mysql_rollback(conn);
-                EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-                json error_response;
-                error_response["success"] = false;
-                error_response["message"] = "更新库存失败";
-                error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-                return JNIStringConverter::jsonToJstring(env, error_response);
-            }
-        }
-        
-        // 清空购物车
-        std::string clear_cart_query = "DELETE FROM cart WHERE user_id = " + std::to_string(userId);
-        if (mysql_query(conn, clear_cart_query.c_str()) != 0) {
-            mysql_rollback(conn);
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "清空购物车失败";
-            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
-        
-        // 提交事务
-        mysql_commit(conn);
-        EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-        
-        json response;
-        response["success"] = true;
-        response["message"] = "订单创建成功";
-        response["order_id"] = order_id;
-        response["total_amount"] = total_amount;
-        response["status"] = "pending";
+        // 与createOrderFromCart共用下单流程：持有用户锁写回内存购物车、在同一事务中扣减库存并清空购物车
+        OrderService& orderService = EmshopServiceManager::getInstance().getOrderService();
+        json result = orderService.checkout(static_cast<long>(userId));
         
-        return JNIStringConverter::jsonToJstring(env, response);
+        return JNIStringConverter::jsonToJstring(env, result);
         
     } catch (const std::exception& e) {
         json error_response;
@@ -3750,6 +10538,14 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_trackOrder
 
 // ==================== 促销策略接口实现 ====================
 
+// 有效促销列表的请求合并：大促期间各用户的查询完全相同，并发调用共享一次查询，
+// 结果在短时间内继续复用；新建促销后丢弃已完成的结果
+static SingleFlight<json>& activePromotionsFlight() {
+    static SingleFlight<json> flight("active_promotions", 1,
+                                     singleFlightTtl("promotion_ttl_ms", Constants::SINGLE_FLIGHT_PROMOTION_TTL_MS));
+    return flight;
+}
+
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getActivePromotions
   (JNIEnv *env, jclass cls) {
     
@@ -3764,75 +10560,76 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getActivePromotions
     try {
         ProductService& productService = EmshopServiceManager::getInstance().getProductService();
 
-        bool has_discount_type = productService.columnExists("promotions", "discount_type");
-        bool has_type = productService.columnExists("promotions", "type");
-        bool has_status = productService.columnExists("promotions", "status");
-        bool has_is_active = productService.columnExists("promotions", "is_active");
-        bool has_discount_value = productService.columnExists("promotions", "discount_value");
-        bool has_value = productService.columnExists("promotions", "value");
-        bool has_min_amount = productService.columnExists("promotions", "min_amount");
-        bool has_max_discount = productService.columnExists("promotions", "max_discount");
-
-        std::vector<std::string> select_fields = {
-            "id",
-            "name",
-            "description"
+        // 促销表的SELECT部分和状态条件只依赖表结构，随结构快照版本重建
+        struct PromotionQuery {
+            std::string select_sql;        // 以WHERE 1=1结尾
+            std::string active_condition;
+            bool has_start_date = false;
+            bool has_end_date = false;
         };
+        static SchemaBound<PromotionQuery> promotion_query([](const SchemaSnapshot& snapshot) {
+            PromotionQuery query;
+            std::string discount_type = snapshot.firstColumn("promotions", {"discount_type", "type"});
+            std::string discount_value = snapshot.firstColumn("promotions", {"discount_value", "value"});
+            bool has_status = snapshot.hasColumn("promotions", "status");
+            bool has_is_active = snapshot.hasColumn("promotions", "is_active");
+            query.has_start_date = snapshot.hasColumn("promotions", "start_date");
+            query.has_end_date = snapshot.hasColumn("promotions", "end_date");
+
+            std::vector<std::string> select_fields = {
+                "id",
+                "name",
+                "description",
+                (discount_type.empty() ? std::string("NULL") : discount_type) + " AS discount_type",
+                (discount_value.empty() ? std::string("NULL") : discount_value) + " AS discount_value"
+            };
+            if (snapshot.hasColumn("promotions", "min_amount")) {
+                select_fields.push_back("min_amount");
+            }
+            if (snapshot.hasColumn("promotions", "max_discount")) {
+                select_fields.push_back("max_discount");
+            }
+            if (query.has_start_date) {
+                select_fields.push_back("start_date");
+            }
+            if (query.has_end_date) {
+                select_fields.push_back("end_date");
+            }
+            if (has_is_active) {
+                select_fields.push_back("is_active");
+            } else if (has_status) {
+                select_fields.push_back("status");
+            }
 
-        if (has_discount_type) {
-            select_fields.push_back("discount_type AS discount_type");
-        } else if (has_type) {
-            select_fields.push_back("type AS discount_type");
-        } else {
-            select_fields.push_back("NULL AS discount_type");
-        }
-
-        if (has_discount_value) {
-            select_fields.push_back("discount_value AS discount_value");
-        } else if (has_value) {
-            select_fields.push_back("value AS discount_value");
-        } else {
-            select_fields.push_back("NULL AS discount_value");
-        }
-
-        if (has_min_amount) {
-            select_fields.push_back("min_amount");
-        }
-
-        if (has_max_discount) {
-            select_fields.push_back("max_discount");
-        }
-
-        if (productService.columnExists("promotions", "start_date")) {
-            select_fields.push_back("start_date");
-        }
-        if (productService.columnExists("promotions", "end_date")) {
-            select_fields.push_back("end_date");
-        }
-
-        if (has_is_active) {
-            select_fields.push_back("is_active");
-        } else if (has_status) {
-            select_fields.push_back("status");
-        }
+            query.select_sql = "SELECT ";
+            for (size_t i = 0; i < select_fields.size(); ++i) {
+                if (i > 0) query.select_sql += ", ";
+                query.select_sql += select_fields[i];
+            }
+            query.select_sql += " FROM promotions WHERE 1=1";
+            if (has_status) {
+                query.active_condition = " AND status = 'active'";
+            } else if (has_is_active) {
+                query.active_condition = " AND is_active = true";
+            }
+            return query;
+        });
 
-    std::string sql = "SELECT " + productService.combineColumns(select_fields) + " FROM promotions WHERE 1=1";
+        std::shared_ptr<const PromotionQuery> query = promotion_query.get();
+        std::string sql = query->select_sql;
 
         auto now = std::time(nullptr);
-        if (productService.columnExists("promotions", "start_date")) {
+        if (query->has_start_date) {
             sql += " AND (start_date IS NULL OR start_date <= FROM_UNIXTIME(" + std::to_string(now) + "))";
         }
-        if (productService.columnExists("promotions", "end_date")) {
+        if (query->has_end_date) {
             sql += " AND (end_date IS NULL OR end_date >= FROM_UNIXTIME(" + std::to_string(now) + "))";
         }
+        sql += query->active_condition;
 
-        if (has_status) {
-            sql += " AND status = 'active'";
-        } else if (has_is_active) {
-            sql += " AND is_active = true";
-        }
-
-        json query_result = productService.executeQuery(sql);
+        json query_result = activePromotionsFlight().run("active", [&productService, &sql]() {
+            return productService.executeQuery(sql);
+        }, [](const json& result) { return result.value("success", false); });
         if (!query_result["success"].get<bool>()) {
             return JNIStringConverter::jsonToJstring(env, query_result);
         }
@@ -3899,6 +10696,7 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_createPromotion
         
         long promotion_id = mysql_insert_id(conn);
         EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+        activePromotionsFlight().forget("active");
         
         json response;
         response["success"] = true;
@@ -5012,7 +11810,14 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSalesStatistics
         std::string start_str = JNIStringConverter::jstringToString(env, startDate);
         std::string end_str = JNIStringConverter::jstringToString(env, endDate);
         
-        auto conn = EmshopServiceManager::getInstance().getDatabaseService().getConnection();
+        // 统计查询走只读副本，副本取不到连接时退回主库
+        DatabaseConnectionPool* pool = &EmshopServiceManager::getInstance().getReadDatabaseService();
+        auto conn = pool->getConnection();
+        if (!conn && pool->isReplica()) {
+            ReplicaRouter::getInstance().reportFailure(pool);
+            pool = &EmshopServiceManager::getInstance().getDatabaseService();
+            conn = pool->getConnection();
+        }
         if (!conn) {
             json error_response;
             error_response["success"] = false;
@@ -5025,7 +11830,7 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSalesStatistics
                            "FROM orders WHERE created_at BETWEEN '" + start_str + "' AND '" + end_str + "' AND status != 'cancelled'";
         
         if (mysql_query(conn, query.c_str()) != 0) {
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+            pool->returnConnection(conn);
             json error_response;
             error_response["success"] = false;
             error_response["message"] = "查询销售统计失败";
@@ -5035,7 +11840,7 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSalesStatistics
         
         MYSQL_RES* result = mysql_store_result(conn);
         if (!result) {
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+            pool->returnConnection(conn);
             json error_response;
             error_response["success"] = false;
             error_response["message"] = "获取查询结果失败";
@@ -5056,7 +11861,7 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSalesStatistics
         }
         
         mysql_free_result(result);
-        EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+        pool->returnConnection(conn);
         
         json response;
         response["success"] = true;
@@ -5088,7 +11893,14 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getUserBehaviorAnaly
     }
     
     try {
-        auto conn = EmshopServiceManager::getInstance().getDatabaseService().getConnection();
+        // 统计查询走只读副本，副本取不到连接时退回主库
+        DatabaseConnectionPool* pool = &EmshopServiceManager::getInstance().getReadDatabaseService(static_cast<long>(userId));
+        auto conn = pool->getConnection();
+        if (!conn && pool->isReplica()) {
+            ReplicaRouter::getInstance().reportFailure(pool);
+            pool = &EmshopServiceManager::getInstance().getDatabaseService();
+            conn = pool->getConnection();
+        }
         if (!conn) {
             json error_response;
             error_response["success"] = false;
@@ -5102,7 +11914,7 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getUserBehaviorAnaly
                                  "FROM orders WHERE user_id = " + std::to_string(userId) + " AND status != 'cancelled'";
         
         if (mysql_query(conn, order_query.c_str()) != 0) {
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+            pool->returnConnection(conn);
             json error_response;
             error_response["success"] = false;
             error_response["message"] = "查询用户订单统计失败";
@@ -5123,22 +11935,16 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getUserBehaviorAnaly
             mysql_free_result(order_result);
         }
         
-        // 获取购物车统计
-        std::string cart_query = "SELECT COUNT(*) as cart_items, SUM(quantity) as total_items FROM cart WHERE user_id = " + std::to_string(userId);
+        pool->returnConnection(conn);
         
-        if (mysql_query(conn, cart_query.c_str()) == 0) {
-            MYSQL_RES* cart_result = mysql_store_result(conn);
-            if (cart_result) {
-                MYSQL_ROW cart_row = mysql_fetch_row(cart_result);
-                if (cart_row) {
-                    analysis["cart_items"] = cart_row[0] ? std::stoi(cart_row[0]) : 0;
-                    analysis["total_items_in_cart"] = cart_row[1] ? std::stoi(cart_row[1]) : 0;
-                }
-                mysql_free_result(cart_result);
-            }
+        // 获取购物车统计(以内存购物车为准，cart表可能还没有写回最近的修改)
+        int total_items_in_cart = 0;
+        std::vector<CartStore::Line> cart_lines = CartStore::getInstance().getLines(userId);
+        for (const auto& line : cart_lines) {
+            total_items_in_cart += line.quantity;
         }
-        
-        EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+        analysis["cart_items"] = cart_lines.size();
+        analysis["total_items_in_cart"] = total_items_in_cart;
         
         // 计算用户等级
         int order_count = analysis.value("order_count", 0);
@@ -5267,6 +12073,11 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_processPayment
         return JNIStringConverter::jsonToJstring(env, error_response);
     }
     
+    AdmissionTicket admission("processPayment", 0);
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
     try {
         std::string method_str = JNIStringConverter::jstringToString(env, paymentMethod);
         std::string details_str = jsonPaymentDetails ? JNIStringConverter::jstringToString(env, jsonPaymentDetails) : "{}";
@@ -5329,7 +12140,7 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_processPayment
         // 模拟支付处理
         std::string transaction_id = "TXN" + std::to_string(std::time(nullptr)) + std::to_string(orderId);
         
-        // 支付成功时扣减库存
+        // 支付成功时扣减库存：订单商品整体预留，与订单状态更新在同一事务中提交
         std::string items_query = "SELECT product_id, quantity FROM order_items WHERE order_id = " + std::to_string(orderId);
         if (mysql_query(conn, items_query.c_str()) != 0) {
             EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
@@ -5340,37 +12151,35 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_processPayment
             return JNIStringConverter::jsonToJstring(env, error_response);
         }
         
+        std::vector<StockReservation> reservations;
         MYSQL_RES* items_result = mysql_store_result(conn);
         if (items_result) {
             MYSQL_ROW item_row;
             while ((item_row = mysql_fetch_row(items_result))) {
-                long product_id = std::stol(item_row[0]);
-                int quantity = std::stoi(item_row[1]);
-                
-                // 扣减库存(使用乐观锁防止超卖)
-                std::string update_stock = "UPDATE products SET stock_quantity = stock_quantity - " + 
-                                          std::to_string(quantity) + ", updated_at = NOW() WHERE product_id = " + 
-                                          std::to_string(product_id) + " AND stock_quantity >= " + std::to_string(quantity);
-                
-                if (mysql_query(conn, update_stock.c_str()) != 0 || mysql_affected_rows(conn) == 0) {
-                    mysql_free_result(items_result);
-                    EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-                    json error_response;
-                    error_response["success"] = false;
-                    error_response["message"] = "库存不足或扣减失败,商品ID: " + std::to_string(product_id);
-                    error_response["error_code"] = Constants::VALIDATION_ERROR_CODE;
-                    return JNIStringConverter::jsonToJstring(env, error_response);
-                }
+                reservations.push_back({std::stol(item_row[0]), std::stoi(item_row[1])});
             }
             mysql_free_result(items_result);
         }
         
-        // 更新订单状态
+        mysql_autocommit(conn, 0);
+        json reserve_result = EmshopServiceManager::getInstance().getProductService()
+                                  .reserveStockWithConnection(conn, reservations);
+        if (!reserve_result["success"].get<bool>()) {
+            mysql_rollback(conn);
+            mysql_autocommit(conn, 1);
+            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+            return JNIStringConverter::jsonToJstring(env, reserve_result);
+        }
+        
+        // 更新订单状态(仅pending可更新，防止并发重复支付导致重复扣减)
     // 对齐字段：如果没有transaction_id/payment_time字段，将只更新已存在的状态与支付方式
     std::string update_query = "UPDATE orders SET status = 'paid', payment_method = '" + method_str + 
-                  "', updated_at = NOW() WHERE order_id = " + std::to_string(orderId);
+                  "', updated_at = NOW() WHERE order_id = " + std::to_string(orderId) + " AND status = 'pending'";
         
-        if (mysql_query(conn, update_query.c_str()) != 0) {
+        if (mysql_query(conn, update_query.c_str()) != 0 || mysql_affected_rows(conn) == 0 ||
+            mysql_commit(conn) != 0) {
+            mysql_rollback(conn);
+            mysql_autocommit(conn, 1);
             EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
             json error_response;
             error_response["success"] = false;
@@ -5378,9 +12187,17 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_processPayment
             error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
             return JNIStringConverter::jsonToJstring(env, error_response);
         }
+        mysql_autocommit(conn, 1);
         
         EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
         
+        // 库存扣减已提交，失效对应商品的缓存
+        std::vector<long> reserved_products;
+        for (const auto& item : reservations) {
+            reserved_products.push_back(item.product_id);
+        }
+        EmshopServiceManager::getInstance().getProductService().invalidateStockCache(reserved_products);
+        
         json response;
         response["success"] = true;
         response["message"] = "支付处理成功";
@@ -5550,34 +12367,188 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_refundPayment
         // 更新订单状态
     std::string update_query = "UPDATE orders SET status = 'refunded', updated_at = NOW() WHERE order_id = " + std::to_string(orderId);
         
-        if (mysql_query(conn, update_query.c_str()) != 0) {
-            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
-            json error_response;
-            error_response["success"] = false;
-            error_response["message"] = "更新订单退款状态失败";
-            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-            return JNIStringConverter::jsonToJstring(env, error_response);
-        }
+        if (mysql_query(conn, update_query.c_str()) != 0) {
+            EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+            json error_response;
+            error_response["success"] = false;
+            error_response["message"] = "更新订单退款状态失败";
+            error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+            return JNIStringConverter::jsonToJstring(env, error_response);
+        }
+        
+        EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+        
+        json response;
+        response["success"] = true;
+        response["message"] = "退款处理成功";
+        response["order_id"] = orderId;
+        response["refund_id"] = refund_id;
+        response["refund_amount"] = amount;
+        response["reason"] = reason_str;
+        response["status"] = "refunded";
+        
+        return JNIStringConverter::jsonToJstring(env, response);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "退款处理异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+}
+
+// ==================== 直接缓冲区接口实现 ====================
+// 与同名String接口返回相同的JSON，但以UTF-8写入直接缓冲区：target为null或容量不足时返回借出的池化缓冲区。
+// 返回的缓冲区用完后须调用releaseDirectBuffer(对调用方自备的缓冲区是空操作)
+
+JNIEXPORT jobject JNICALL Java_emshop_EmshopNativeInterface_getProductListDirect
+  (JNIEnv *env, jclass cls, jobject target, jstring category, jint page, jint pageSize) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToDirectBuffer(env, target, error_response);
+    }
+    
+    AdmissionTicket admission("getProductList", 0);
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToDirectBuffer(env, target, admission.rejection());
+    }
+    
+    try {
+        std::string cat = JNIStringConverter::jstringToString(env, category);
+        
+        ProductService& productService = EmshopServiceManager::getInstance().getProductService();
+        JsonWriter& writer = JNIStringConverter::threadLocalWriter();
+        productService.writeProductList(writer, cat, static_cast<int>(page), static_cast<int>(pageSize));
+        
+        return JNIStringConverter::writerToDirectBuffer(env, target, writer);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "获取商品列表异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToDirectBuffer(env, target, error_response);
+    }
+}
+
+JNIEXPORT jobject JNICALL Java_emshop_EmshopNativeInterface_searchProductsDirect
+  (JNIEnv *env, jclass cls, jobject target, jstring keyword, jint page, jint pageSize,
+   jstring sortBy, jdouble minPrice, jdouble maxPrice) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToDirectBuffer(env, target, error_response);
+    }
+    
+    AdmissionTicket admission("searchProducts", 0);
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToDirectBuffer(env, target, admission.rejection());
+    }
+    
+    try {
+        std::string keyword_str = JNIStringConverter::jstringToString(env, keyword);
+        std::string sort_by_str = JNIStringConverter::jstringToString(env, sortBy);
+        
+        ProductService& productService = EmshopServiceManager::getInstance().getProductService();
+        JsonWriter& writer = JNIStringConverter::threadLocalWriter();
+        productService.writeSearchProducts(writer, keyword_str, static_cast<int>(page),
+                                           static_cast<int>(pageSize), sort_by_str,
+                                           static_cast<double>(minPrice),
+                                           static_cast<double>(maxPrice));
+        
+        return JNIStringConverter::writerToDirectBuffer(env, target, writer);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "搜索商品异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToDirectBuffer(env, target, error_response);
+    }
+}
+
+JNIEXPORT jobject JNICALL Java_emshop_EmshopNativeInterface_getOrderListDirect
+  (JNIEnv *env, jclass cls, jobject target, jlong userId) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToDirectBuffer(env, target, error_response);
+    }
+    
+    AdmissionTicket admission("getOrderList", static_cast<long>(userId));
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToDirectBuffer(env, target, admission.rejection());
+    }
+    
+    try {
+        OrderService& orderService = EmshopServiceManager::getInstance().getOrderService();
+        json result = orderService.getUserOrders(static_cast<long>(userId));
+        
+        return JNIStringConverter::jsonToDirectBuffer(env, target, result);
         
-        EmshopServiceManager::getInstance().getDatabaseService().returnConnection(conn);
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "获取订单列表异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToDirectBuffer(env, target, error_response);
+    }
+}
+
+JNIEXPORT jobject JNICALL Java_emshop_EmshopNativeInterface_getAllOrdersDirect
+  (JNIEnv *env, jclass cls, jobject target, jstring status, jint page, jint pageSize,
+   jstring startDate, jstring endDate) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToDirectBuffer(env, target, error_response);
+    }
+    
+    try {
+        std::string status_str = status ? JNIStringConverter::jstringToString(env, status) : std::string("all");
+        std::string start_date_str = startDate ? JNIStringConverter::jstringToString(env, startDate) : std::string("");
+        std::string end_date_str = endDate ? JNIStringConverter::jstringToString(env, endDate) : std::string("");
         
-        json response;
-        response["success"] = true;
-        response["message"] = "退款处理成功";
-        response["order_id"] = orderId;
-        response["refund_id"] = refund_id;
-        response["refund_amount"] = amount;
-        response["reason"] = reason_str;
-        response["status"] = "refunded";
+        OrderService& orderService = EmshopServiceManager::getInstance().getOrderService();
+        JsonWriter& writer = JNIStringConverter::threadLocalWriter();
+        orderService.writeAllOrders(writer, status_str, static_cast<int>(page), static_cast<int>(pageSize),
+                                    start_date_str, end_date_str);
         
-        return JNIStringConverter::jsonToJstring(env, response);
+        return JNIStringConverter::writerToDirectBuffer(env, target, writer);
         
     } catch (const std::exception& e) {
         json error_response;
         error_response["success"] = false;
-        error_response["message"] = "退款处理异常: " + std::string(e.what());
+        error_response["message"] = "获取全部订单异常: " + std::string(e.what());
         error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
-        return JNIStringConverter::jsonToJstring(env, error_response);
+        return JNIStringConverter::jsonToDirectBuffer(env, target, error_response);
+    }
+}
+
+// 归还直接缓冲区接口返回的缓冲区，归还后Java端不能再读取该缓冲区
+JNIEXPORT void JNICALL Java_emshop_EmshopNativeInterface_releaseDirectBuffer
+  (JNIEnv *env, jclass cls, jobject buffer) {
+    
+    if (!buffer) {
+        return;
+    }
+    void* address = env->GetDirectBufferAddress(buffer);
+    if (address) {
+        DirectBufferPool::getInstance().release(address);
     }
 }
 
@@ -5586,25 +12557,47 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_refundPayment
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getServerStatus
   (JNIEnv *env, jclass cls) {
     
-    json status;
-    status["server_name"] = "JLU Emshop System";
-    status["version"] = "2.0.0";
-    status["uptime"] = std::time(nullptr) - 1640995200; // 模拟运行时间
-    status["status"] = "running";
-    status["cpu_usage"] = 45.2;
-    status["memory_usage"] = 67.8;
-    status["disk_usage"] = 32.1;
-    status["active_connections"] = 156;
-    status["total_requests"] = 98765;
-    status["database_status"] = ensureServiceManagerInitialized() ? "connected" : "disconnected";
-    
-    json response;
-    response["success"] = true;
-    response["message"] = "获取服务器状态成功";
-    response["server_status"] = status;
-    response["timestamp"] = std::time(nullptr);
-    
-    return JNIStringConverter::jsonToJstring(env, response);
+    try {
+        json process = ProcessMetrics::getInstance().sample();
+        json query_summary = QueryMetrics::getInstance().getStats(0)["summary"];
+        bool connected = ensureServiceManagerInitialized();
+        
+        json status;
+        status["server_name"] = "JLU Emshop System";
+        status["version"] = "2.0.0";
+        status["uptime"] = process["uptime_seconds"];
+        status["status"] = "running";
+        status["cpu_usage"] = process["cpu_usage_percent"];
+        if (process.contains("rss_mb")) {
+            status["memory_rss_mb"] = process["rss_mb"];
+            if (process.contains("total_memory_mb") && process["total_memory_mb"].get<double>() > 0) {
+                status["memory_usage"] = process["rss_mb"].get<double>() / process["total_memory_mb"].get<double>() * 100.0;
+            }
+        }
+        if (connected) {
+            json pool = EmshopServiceManager::getInstance().getDatabaseService().getPoolStatus();
+            status["active_connections"] = pool["active_connections"];
+            status["total_connections"] = pool["total_connections"];
+        }
+        status["total_queries"] = query_summary["count"];
+        status["failed_queries"] = query_summary["errors"];
+        status["database_status"] = connected ? "connected" : "disconnected";
+        
+        json response;
+        response["success"] = true;
+        response["message"] = "获取服务器状态成功";
+        response["server_status"] = status;
+        response["timestamp"] = std::time(nullptr);
+        
+        return JNIStringConverter::jsonToJstring(env, response);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "获取服务器状态异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
 }
 
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSystemLogs
@@ -5641,25 +12634,155 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSystemLogs
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSystemMetrics
   (JNIEnv *env, jclass cls) {
     
-    json metrics;
-    metrics["cpu_cores"] = 8;
-    metrics["total_memory_mb"] = 16384;
-    metrics["available_memory_mb"] = 5283;
-    metrics["disk_total_gb"] = 500;
-    metrics["disk_available_gb"] = 340;
-    metrics["network_in_bytes"] = 123456789;
-    metrics["network_out_bytes"] = 98765432;
-    metrics["database_connections"] = 15;
-    metrics["cache_hit_rate"] = 85.6;
-    metrics["avg_response_time_ms"] = 245;
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
     
-    json response;
-    response["success"] = true;
-    response["message"] = "获取系统指标成功";
-    response["metrics"] = metrics;
-    response["timestamp"] = std::time(nullptr);
+    try {
+        EmshopServiceManager& manager = EmshopServiceManager::getInstance();
+        json process = ProcessMetrics::getInstance().sample();
+        json queries = QueryMetrics::getInstance().getStats();
+        json pool = manager.getDatabaseService().getPoolStatus();
+        
+        json metrics;
+        metrics["cpu_cores"] = process["cpu_cores"];
+        if (process.contains("total_memory_mb")) {
+            metrics["total_memory_mb"] = process["total_memory_mb"];
+            metrics["available_memory_mb"] = process["available_memory_mb"];
+        }
+        metrics["database_connections"] = pool["total_connections"];
+        metrics["avg_response_time_ms"] = queries["summary"]["avg_ms"];
+        metrics["process"] = process;
+        metrics["queries"] = queries;
+        metrics["connection_pool"] = pool;
+        metrics["replicas"] = ReplicaRouter::getInstance().getStatus();
+        metrics["async_queries"] = AsyncQueryEngine::getInstance().getStats();
+        metrics["executor"] = NativeRequestExecutor::getInstance().getStats();
+        metrics["async_requests"] = NativeCompletionDispatcher::getInstance().getStats();
+        metrics["admission"] = AdmissionController::getInstance().getStats();
+        metrics["single_flight"] = SingleFlightStats::collectStats();
+        metrics["cart_store"] = CartStore::getInstance().getStats();
+        metrics["sessions"] = manager.getUserService().getSessionStats();
+        metrics["tracing"] = Tracer::getInstance().getStats();
+        metrics["direct_buffers"] = DirectBufferPool::getInstance().getStats();
+        
+        json response;
+        response["success"] = true;
+        response["message"] = "获取系统指标成功";
+        response["metrics"] = metrics;
+        response["timestamp"] = std::time(nullptr);
+        
+        return JNIStringConverter::jsonToJstring(env, response);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "获取系统指标异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+}
+
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getSlowQueryLog
+  (JNIEnv *env, jclass cls, jstring jsonOptions) {
     
-    return JNIStringConverter::jsonToJstring(env, response);
+    try {
+        std::string options_str = jsonOptions ? JNIStringConverter::jstringToString(env, jsonOptions) : "";
+        json options = options_str.empty() ? json::object() : json::parse(options_str);
+        
+        if (options.contains("threshold_ms")) {
+            int threshold_ms = options["threshold_ms"].get<int>();
+            if (threshold_ms < 0) {
+                json error_response;
+                error_response["success"] = false;
+                error_response["message"] = "慢查询阈值不能为负数";
+                error_response["error_code"] = Constants::VALIDATION_ERROR_CODE;
+                return JNIStringConverter::jsonToJstring(env, error_response);
+            }
+            BaseService::setSlowQueryThresholdMs(threshold_ms);
+            Logger::info("慢查询阈值已调整为 " + std::to_string(threshold_ms) + "ms");
+        }
+        if (options.value("clear", false)) {
+            SlowQueryLog::getInstance().clear();
+        }
+        
+        int limit = options.value("limit", 50);
+        limit = std::max(1, std::min(limit, static_cast<int>(Constants::SLOW_QUERY_LOG_CAPACITY)));
+        
+        json response;
+        response["success"] = true;
+        response["message"] = "获取慢查询日志成功";
+        response["data"] = SlowQueryLog::getInstance().getEntries(static_cast<size_t>(limit));
+        response["timestamp"] = std::time(nullptr);
+        
+        return JNIStringConverter::jsonToJstring(env, response);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "获取慢查询日志异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+}
+
+// 本地基准测试：在调用线程上同步运行，耗时为场景的测量时长，只供load分组的测试使用
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_runNativeBenchmark
+  (JNIEnv *env, jclass cls, jstring scenario, jstring jsonOptions) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+    
+    try {
+        std::string scenario_str = JNIStringConverter::jstringToString(env, scenario);
+        std::string options_str = jsonOptions ? JNIStringConverter::jstringToString(env, jsonOptions) : "";
+        json options = options_str.empty() ? json::object() : json::parse(options_str);
+        
+        json result = EmshopServiceManager::getInstance().getBenchmarkService().runBenchmark(scenario_str, options);
+        return JNIStringConverter::jsonToJstring(env, result);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "基准测试异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+}
+
+// 链路追踪绑定：每个请求调用一次，不检查服务管理器初始化，追踪未开启时直接返回
+JNIEXPORT void JNICALL Java_emshop_EmshopNativeInterface_beginTrace
+  (JNIEnv *env, jclass cls, jstring traceId, jstring operation) {
+    
+    try {
+        Tracer& tracer = Tracer::getInstance();
+        if (!tracer.isEnabled() && !Tracer::active()) {
+            return;
+        }
+        tracer.beginTrace(JNIStringConverter::jstringToString(env, traceId),
+                          JNIStringConverter::jstringToString(env, operation));
+    } catch (const std::exception& e) {
+        Logger::warn("开始链路追踪失败: " + std::string(e.what()));
+    }
+}
+
+JNIEXPORT void JNICALL Java_emshop_EmshopNativeInterface_endTrace
+  (JNIEnv *env, jclass cls) {
+    
+    try {
+        Tracer::getInstance().endTrace();
+    } catch (const std::exception& e) {
+        Logger::warn("结束链路追踪失败: " + std::string(e.what()));
+    }
 }
 
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getActiveConnections
@@ -6033,44 +13156,174 @@ JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_executeBatch
     }
 }
 
+JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_executeCommandBatch
+  (JNIEnv *env, jclass cls, jstring jsonCommands) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+    
+    AdmissionTicket admission("executeCommandBatch", 0);
+    if (!admission.admitted()) {
+        return JNIStringConverter::jsonToJstring(env, admission.rejection());
+    }
+    
+    try {
+        std::string commands_str = JNIStringConverter::jstringToString(env, jsonCommands);
+        json commands = json::parse(commands_str);
+        if (commands.is_object()) {
+            commands = commands.value("commands", json::array());
+        }
+        
+        return JNIStringConverter::jsonToJstring(env, ServiceCommandRegistry::executeBatch(commands));
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "批量命令执行异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
+}
+
+// ==================== 异步请求接口实现 ====================
+
+JNIEXPORT jboolean JNICALL Java_emshop_EmshopNativeInterface_registerCompletionHandler
+  (JNIEnv *env, jclass cls, jobject handler) {
+    try {
+        return NativeCompletionDispatcher::getInstance().registerHandler(env, handler) ? JNI_TRUE : JNI_FALSE;
+    } catch (const std::exception& e) {
+        Logger::error("注册异步完成处理器异常: " + std::string(e.what()));
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jboolean JNICALL Java_emshop_EmshopNativeInterface_submitCommand
+  (JNIEnv *env, jclass cls, jlong requestId, jstring command, jstring paramsJson) {
+    
+    if (!ensureServiceManagerInitialized()) {
+        return JNI_FALSE;
+    }
+    
+    try {
+        NativeCompletionDispatcher& dispatcher = NativeCompletionDispatcher::getInstance();
+        if (!dispatcher.hasHandler()) {
+            return JNI_FALSE;
+        }
+        std::string name = JNIStringConverter::jstringToString(env, command);
+        const ServiceCommandRegistry::Command* found = ServiceCommandRegistry::find(name);
+        if (!found) {
+            Logger::warn("异步请求命令不存在: " + name);
+            return JNI_FALSE;
+        }
+        std::string params_str = paramsJson ? JNIStringConverter::jstringToString(env, paramsJson) : std::string();
+        json params = params_str.empty() ? json::object() : json::parse(params_str);
+        
+        // 准入名额一直占用到请求完成；被拒绝时Java端改走同步接口，同步入口同样会返回系统繁忙
+        long user_id = params.contains("user_id") && params["user_id"].is_number_integer()
+            ? params["user_id"].get<long>() : 0;
+        auto admission = std::make_shared<AdmissionTicket>(name, user_id);
+        if (!admission->admitted()) {
+            return JNI_FALSE;
+        }
+        
+        // 不接受时返回false，由Java端改为同步调用
+        bool accepted = NativeRequestExecutor::getInstance().trySubmit(
+            [found, params]() { return ServiceCommandRegistry::execute(*found, params); },
+            [requestId, admission](json&& result) {
+                admission->finish();
+                NativeCompletionDispatcher::getInstance().deliver(requestId, result);
+            });
+        if (!accepted) {
+            admission->cancel();
+        }
+        return accepted ? JNI_TRUE : JNI_FALSE;
+        
+    } catch (const std::exception& e) {
+        Logger::error("提交异步请求异常: " + std::string(e.what()));
+        return JNI_FALSE;
+    }
+}
+
 // ==================== 缓存管理接口实现 ====================
 
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_clearCache
   (JNIEnv *env, jclass cls, jstring cacheType) {
     
-    std::string type_str = cacheType ? JNIStringConverter::jstringToString(env, cacheType) : "all";
-    
-    json response;
-    response["success"] = true;
-    response["message"] = "缓存清理成功";
-    response["cache_type"] = type_str;
-    response["cleared_items"] = 150; // 模拟清理的缓存项数量
-    response["freed_memory_mb"] = 25.6; // 模拟释放的内存
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
     
-    return JNIStringConverter::jsonToJstring(env, response);
+    try {
+        std::string type_str = cacheType ? JNIStringConverter::jstringToString(env, cacheType) : "all";
+        if (type_str.empty()) {
+            type_str = "all";
+        }
+        
+        // 进程内缓存商品目录数据和表结构快照，其他类型没有可清理的条目
+        size_t cleared_items = 0;
+        if (type_str == "all" || type_str == "product") {
+            cleared_items += EmshopServiceManager::getInstance().getProductService().clearCatalogCache();
+        }
+        bool schema_refreshed = false;
+        if (type_str == "all" || type_str == "schema") {
+            schema_refreshed = EmshopServiceManager::getInstance().refreshSchemaCatalog();
+        }
+        
+        json response;
+        response["success"] = true;
+        response["message"] = "缓存清理成功";
+        response["cache_type"] = type_str;
+        response["cleared_items"] = cleared_items;
+        response["schema_refreshed"] = schema_refreshed;
+        
+        return JNIStringConverter::jsonToJstring(env, response);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "清理缓存异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
 }
 
 JNIEXPORT jstring JNICALL Java_emshop_EmshopNativeInterface_getCacheStats
   (JNIEnv *env, jclass cls) {
     
-    json stats;
-    stats["total_keys"] = 1250;
-    stats["used_memory_mb"] = 45.8;
-    stats["hit_rate"] = 89.5;
-    stats["miss_rate"] = 10.5;
-    stats["expired_keys"] = 23;
-    stats["evicted_keys"] = 15;
-    stats["connections"] = 8;
-    stats["commands_processed"] = 98765;
-    stats["uptime_seconds"] = 86400;
-    
-    json response;
-    response["success"] = true;
-    response["message"] = "获取缓存统计成功";
-    response["cache_stats"] = stats;
-    response["timestamp"] = std::time(nullptr);
+    if (!ensureServiceManagerInitialized()) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "服务未初始化";
+        error_response["error_code"] = Constants::DATABASE_ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
     
-    return JNIStringConverter::jsonToJstring(env, response);
+    try {
+        json response;
+        response["success"] = true;
+        response["message"] = "获取缓存统计成功";
+        response["cache_stats"] = EmshopServiceManager::getInstance().getProductService().getCacheStats();
+        response["schema_catalog"] = SchemaCatalog::getInstance().getStats();
+        response["timestamp"] = std::time(nullptr);
+        
+        return JNIStringConverter::jsonToJstring(env, response);
+        
+    } catch (const std::exception& e) {
+        json error_response;
+        error_response["success"] = false;
+        error_response["message"] = "获取缓存统计异常: " + std::string(e.what());
+        error_response["error_code"] = Constants::ERROR_CODE;
+        return JNIStringConverter::jsonToJstring(env, error_response);
+    }
 }
 
 // ==================== 优惠券验证接口实现 ====================
@@ -0,0 +1,24 @@
+-- ====================================================================
+-- 优惠券批量分配基准测试用户生成脚本
+-- 生成10万个普通用户(用户名以coupon_bench_开头，密码为不可登录的占位值)，
+-- 供 java/src/test/java/emshop/CouponDistributionBenchmarkTest.java 使用
+-- 需要MySQL 8.0(递归CTE)，仅在测试库上执行；清理:
+--   DELETE uc FROM user_coupons uc JOIN users u ON uc.user_id = u.user_id WHERE u.username LIKE 'coupon\_bench\_%';
+--   DELETE FROM users WHERE username LIKE 'coupon\_bench\_%';
+-- ====================================================================
+
+USE emshop;
+
+SET @bench_users = 100000;
+SET SESSION cte_max_recursion_depth = 100001;
+
+INSERT IGNORE INTO users (username, password, role, status)
+WITH RECURSIVE seq (n) AS (
+    SELECT 1
+    UNION ALL
+    SELECT n + 1 FROM seq WHERE n < @bench_users
+)
+SELECT CONCAT('coupon_bench_', n), '!benchmark-no-login', 'user', 'active'
+FROM seq;
+
+SELECT COUNT(*) AS bench_users FROM users WHERE username LIKE 'coupon\_bench\_%';
@@ -0,0 +1,43 @@
+-- ====================================================================
+-- 直接缓冲区基准测试数据生成脚本
+-- 生成3个测试用户(direct_bench_1k/direct_bench_100k/direct_bench_10m)及其订单，
+-- 订单数分别为4/400/40000，使用户订单列表的JSON响应约为1KB/100KB/10MB，
+-- 供 java/src/test/java/emshop/DirectBufferBenchmarkTest.java 使用
+-- 需要MySQL 8.0(递归CTE)，仅在测试库上执行；清理:
+--   DELETE o FROM orders o JOIN users u ON o.user_id = u.user_id WHERE u.username LIKE 'direct\_bench\_%';
+--   DELETE FROM users WHERE username LIKE 'direct\_bench\_%';
+-- ====================================================================
+
+USE emshop;
+
+SET SESSION cte_max_recursion_depth = 40001;
+
+INSERT IGNORE INTO users (username, password, role, status) VALUES
+('direct_bench_1k', '!benchmark-no-login', 'user', 'active'),
+('direct_bench_100k', '!benchmark-no-login', 'user', 'active'),
+('direct_bench_10m', '!benchmark-no-login', 'user', 'active');
+
+INSERT IGNORE INTO orders (order_no, user_id, total_amount, discount_amount, shipping_fee, final_amount,
+                           status, payment_status)
+WITH RECURSIVE seq (n) AS (
+    SELECT 1
+    UNION ALL
+    SELECT n + 1 FROM seq WHERE n < 40000
+)
+SELECT CONCAT('DB', u.user_id, '-', seq.n), u.user_id,
+       ROUND(50 + (seq.n * 7919 % 100000) / 100, 2), 0.00, 0.00,
+       ROUND(50 + (seq.n * 7919 % 100000) / 100, 2),
+       ELT(1 + seq.n % 3, 'pending', 'paid', 'completed'),
+       ELT(1 + seq.n % 3, 'unpaid', 'paid', 'paid')
+FROM users u
+JOIN seq ON seq.n <= CASE u.username
+                         WHEN 'direct_bench_1k' THEN 4
+                         WHEN 'direct_bench_100k' THEN 400
+                         ELSE 40000
+                     END
+WHERE u.username IN ('direct_bench_1k', 'direct_bench_100k', 'direct_bench_10m');
+
+SELECT u.username, COUNT(o.order_id) AS orders
+FROM users u LEFT JOIN orders o ON o.user_id = u.user_id
+WHERE u.username LIKE 'direct\_bench\_%'
+GROUP BY u.username;
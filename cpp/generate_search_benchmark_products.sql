@@ -0,0 +1,39 @@
+-- ====================================================================
+-- 商品搜索基准测试数据生成脚本
+-- 生成100万个在售商品(SKU以BENCH-开头)，名称、描述、品牌由常见中文词和英文型号组合，
+-- 供 java/src/test/java/emshop/ProductSearchBenchmarkTest.java 使用
+-- 需要MySQL 8.0(递归CTE)，仅在测试库上执行；清理: DELETE FROM products WHERE sku LIKE 'BENCH-%';
+-- ====================================================================
+
+USE emshop;
+
+SET @bench_products = 1000000;
+SET SESSION cte_max_recursion_depth = 1000001;
+
+INSERT INTO products (name, description, short_description, category_id, brand, price, original_price,
+                      stock_quantity, sku, status)
+WITH RECURSIVE seq (n) AS (
+    SELECT 1
+    UNION ALL
+    SELECT n + 1 FROM seq WHERE n < @bench_products
+)
+SELECT
+    CONCAT(ELT(1 + n % 12, '华为', '小米', '苹果', '联想', '海尔', '美的', '耐克', '安踏', '三星', '索尼', '格力', '李宁'),
+           ELT(1 + (n DIV 12) % 10, '智能手机', '笔记本电脑', '蓝牙耳机', '运动鞋', '电饭煲',
+               '空调', '羽绒服', '机械键盘', '显示器', '保温杯'),
+           ' ', ELT(1 + (n DIV 120) % 6, 'Pro', 'Max', 'Lite', 'Plus', 'Air', 'Mini'), ' ', n),
+    CONCAT('基准测试商品，', ELT(1 + (n DIV 7) % 8, '轻薄便携', '高性能', '长续航', '主动降噪',
+                                  '防水防尘', '节能省电', '舒适透气', '大容量'),
+           '，适合', ELT(1 + (n DIV 11) % 5, '学生', '办公', '家庭', '户外运动', '游戏'), '使用，型号', n),
+    CONCAT(ELT(1 + (n DIV 7) % 8, '轻薄便携', '高性能', '长续航', '主动降噪',
+               '防水防尘', '节能省电', '舒适透气', '大容量'), '款'),
+    1 + n % 10,
+    ELT(1 + n % 12, '华为', '小米', '苹果', '联想', '海尔', '美的', '耐克', '安踏', '三星', '索尼', '格力', '李宁'),
+    ROUND(10 + ((n * 7919) % 100000) / 10, 2),
+    ROUND(20 + ((n * 7919) % 100000) / 10, 2),
+    1000,
+    CONCAT('BENCH-', n),
+    'active'
+FROM seq;
+
+SELECT COUNT(*) AS bench_products FROM products WHERE sku LIKE 'BENCH-%';
@@ -47,10 +47,11 @@ json AddressService::addUserAddress(long user_id, const std::string& receiver_na
                          escaped_detail_address + "', '" + escaped_postal_code + "', " + 
                          (is_default ? "1" : "0") + ")";
         
-        logDebug("执行SQL: " + sql);
+        logDebug("执行SQL: ", sql);
         
         json result = executeQuery(sql);
         if (result["success"].get<bool>()) {
+            markUserWrite(user_id);
             json response_data;
             response_data["address_id"] = result["data"]["insert_id"].get<long>();
             response_data["user_id"] = user_id;
@@ -138,6 +139,7 @@ json AddressService::updateUserAddress(long address_id, const std::string& recei
         
         json result = executeQuery(sql);
         if (result["success"].get<bool>()) {
+            markUserWrite(user_id);
             json response_data;
             response_data["address_id"] = address_id;
             response_data["updated"] = true;
@@ -163,10 +165,17 @@ json AddressService::deleteUserAddress(long address_id) {
     }
     
     try {
+        // 先取得地址所属用户，删除后该用户的读请求走主库
+        static const std::string owner_sql = "SELECT user_id FROM user_addresses WHERE address_id = ?";
+        json owner_result = executePrepared(owner_sql, {address_id});
+        long user_id = owner_result["success"].get<bool>() && !owner_result["data"].empty()
+                           ? owner_result["data"][0]["user_id"].get<long>() : 0;
+        
         std::string sql = "DELETE FROM user_addresses WHERE address_id = " + std::to_string(address_id);
         json result = executeQuery(sql);
         
         if (result["success"].get<bool>()) {
+            markUserWrite(user_id);
             json response_data;
             response_data["address_id"] = address_id;
             response_data["deleted"] = true;
@@ -208,6 +217,7 @@ json AddressService::setDefaultAddress(long user_id, long address_id) {
         json result = executeQuery(update_sql2);
         
         if (result["success"].get<bool>()) {
+            markUserWrite(user_id);
             json response_data;
             response_data["user_id"] = user_id;
             response_data["address_id"] = address_id;
@@ -0,0 +1,429 @@
+#include "BenchmarkService.h"
+
+// 构造函数实现
+BenchmarkService::BenchmarkService() : BaseService() {
+    logInfo("本地基准测试服务初始化完成");
+}
+
+// 获取服务名称
+std::string BenchmarkService::getServiceName() const {
+    return "BenchmarkService";
+}
+
+// 运行本地基准测试
+json BenchmarkService::runBenchmark(const std::string& scenario, const json& options) {
+    logInfo("运行本地基准测试: ", scenario);
+
+    try {
+        if (scenario == "prepared_vs_text") {
+            return benchPreparedVsText(options);
+        }
+        if (scenario == "pool_checkout") {
+            return benchPoolCheckout(options);
+        }
+        if (scenario == "json_writer") {
+            return benchJsonWriter(options);
+        }
+        if (scenario == "async_vs_blocking") {
+            return benchAsyncVsBlocking(options);
+        }
+        return createErrorResponse("未知的基准测试场景: " + scenario, Constants::VALIDATION_ERROR_CODE);
+    } catch (const std::exception& e) {
+        logError("基准测试异常: ", e.what());
+        return createErrorResponse("基准测试异常: " + std::string(e.what()));
+    }
+}
+
+int BenchmarkService::intOption(const json& options, const char* key, int default_value,
+                                int min_value, int max_value) {
+    int value = default_value;
+    if (options.contains(key) && options[key].is_number_integer()) {
+        value = options[key].get<int>();
+    }
+    return std::max(min_value, std::min(value, max_value));
+}
+
+// 所有线程就绪后同时开始，统一截止时间，各线程的延迟分别记录后再合并
+BenchmarkService::BenchmarkRun BenchmarkService::runConcurrent(int threads, int duration_ms,
+                                                               const BenchmarkCall& call) const {
+    std::atomic<bool> go(false);
+    std::atomic<int> ready(0);
+    std::chrono::steady_clock::time_point deadline;
+    std::vector<BenchmarkRun> per_thread(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            BenchmarkRun& local = per_thread[t];
+            local.latencies_us.reserve(1 << 14);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            for (long long i = 0;; i++) {
+                auto started = std::chrono::steady_clock::now();
+                if (started >= deadline) {
+                    break;
+                }
+                bool ok = false;
+                try {
+                    ok = call(t, i);
+                } catch (const std::exception&) {
+                    ok = false;
+                }
+                auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - started).count();
+                local.latencies_us.push_back(static_cast<uint32_t>(
+                    std::min<long long>(micros, std::numeric_limits<uint32_t>::max())));
+                local.calls++;
+                if (!ok) {
+                    local.failures++;
+                }
+            }
+        });
+    }
+
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+    auto started = std::chrono::steady_clock::now();
+    deadline = started + std::chrono::milliseconds(duration_ms);
+    go.store(true, std::memory_order_release);
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    BenchmarkRun total;
+    total.elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (BenchmarkRun& local : per_thread) {
+        total.calls += local.calls;
+        total.failures += local.failures;
+        total.latencies_us.insert(total.latencies_us.end(), local.latencies_us.begin(), local.latencies_us.end());
+    }
+    return total;
+}
+
+json BenchmarkService::summarize(const std::string& mode, int threads, BenchmarkRun& run) const {
+    std::vector<uint32_t>& latencies = run.latencies_us;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double p) -> uint32_t {
+        if (latencies.empty()) {
+            return 0;
+        }
+        size_t index = static_cast<size_t>(std::ceil(p / 100.0 * latencies.size()));
+        return latencies[std::min(latencies.size() - 1, index > 0 ? index - 1 : 0)];
+    };
+    double total_us = 0.0;
+    for (uint32_t value : latencies) {
+        total_us += value;
+    }
+
+    json summary;
+    summary["mode"] = mode;
+    summary["threads"] = threads;
+    summary["calls"] = run.calls;
+    summary["failures"] = run.failures;
+    summary["qps"] = run.elapsed_seconds > 0 ? run.calls / run.elapsed_seconds : 0.0;
+    summary["avg_us"] = latencies.empty() ? 0.0 : total_us / latencies.size();
+    summary["p50_us"] = percentile(50);
+    summary["p90_us"] = percentile(90);
+    summary["p99_us"] = percentile(99);
+    summary["max_us"] = latencies.empty() ? 0 : latencies.back();
+    return summary;
+}
+
+std::vector<long> BenchmarkService::loadProductIds(size_t limit) {
+    std::vector<long> ids;
+    json result = executeQuery("SELECT product_id FROM products WHERE status != 'deleted' "
+                               "ORDER BY product_id LIMIT " + std::to_string(limit));
+    if (result["success"].get<bool>() && result["data"].is_array()) {
+        for (const auto& row : result["data"]) {
+            ids.push_back(row["product_id"].get<long>());
+        }
+    }
+    return ids;
+}
+
+// 同一条按主键的商品点查询，分别用文本协议(每次拼接SQL并由服务器解析)和
+// 预处理语句(每条连接缓存语句句柄，只传参数)执行，先各预热一轮再依次测量
+json BenchmarkService::benchPreparedVsText(const json& options) {
+    int threads = intOption(options, "threads", 16, 1, 256);
+    int duration_ms = intOption(options, "duration_ms", 5000, 100, 60000);
+    int warmup_ms = intOption(options, "warmup_ms", 1000, 0, 10000);
+
+    std::vector<long> ids = loadProductIds(1000);
+    if (ids.empty()) {
+        return createErrorResponse("没有可用的商品数据", Constants::VALIDATION_ERROR_CODE);
+    }
+
+    static const std::string columns = "SELECT product_id as id, name, description, price, stock_quantity as stock, "
+                                       "category_id as category, status, created_at, updated_at FROM products ";
+    static const std::string prepared_sql = columns + "WHERE product_id = ? AND status != 'deleted'";
+    auto pick = [&ids](int thread_index, long long i) {
+        return ids[static_cast<size_t>(thread_index * 7919 + i) % ids.size()];
+    };
+    BenchmarkCall text_call = [&](int t, long long i) {
+        json result = executeQuery(columns + "WHERE product_id = " + std::to_string(pick(t, i)) +
+                                   " AND status != 'deleted'");
+        return result["success"].get<bool>();
+    };
+    BenchmarkCall prepared_call = [&](int t, long long i) {
+        json result = executePrepared(prepared_sql, {pick(t, i)});
+        return result["success"].get<bool>();
+    };
+
+    if (warmup_ms > 0) {
+        runConcurrent(threads, warmup_ms, text_call);
+        runConcurrent(threads, warmup_ms, prepared_call);
+    }
+
+    BenchmarkRun text_run = runConcurrent(threads, duration_ms, text_call);
+    json cache_before = db_pool_.getPoolStatus()["statement_cache"];
+    BenchmarkRun prepared_run = runConcurrent(threads, duration_ms, prepared_call);
+    json cache_after = db_pool_.getPoolStatus()["statement_cache"];
+
+    json text = summarize("text", threads, text_run);
+    json prepared = summarize("prepared", threads, prepared_run);
+
+    json data;
+    data["scenario"] = "prepared_vs_text";
+    data["threads"] = threads;
+    data["duration_ms"] = duration_ms;
+    data["products"] = ids.size();
+    data["results"] = json::array({text, prepared});
+    data["qps_ratio"] = text["qps"].get<double>() > 0 ?
+        prepared["qps"].get<double>() / text["qps"].get<double>() : 0.0;
+    data["statement_cache"] = {
+        {"hits", cache_after["hits"].get<long long>() - cache_before["hits"].get<long long>()},
+        {"misses", cache_after["misses"].get<long long>() - cache_before["misses"].get<long long>()}
+    };
+    return createSuccessResponse(data, "基准测试完成");
+}
+
+// 多线程反复借出、(可选)执行SELECT 1、归还主库连接，线程数通常大于连接池上限以制造争用。
+// 旧连接池用一把全局锁保护借还，并在锁内对借出和归还的连接各ping一次；这里在当前连接池之外
+// 套一把全局锁并在锁内ping来模拟，空闲队列操作本身很轻，锁内耗时主要就是两次ping的往返
+json BenchmarkService::benchPoolCheckout(const json& options) {
+    int threads = intOption(options, "threads", 64, 1, 512);
+    int duration_ms = intOption(options, "duration_ms", 5000, 100, 60000);
+    int warmup_ms = intOption(options, "warmup_ms", 1000, 0, 10000);
+    bool with_query = options.value("query", true);
+
+    auto probe = [](MYSQL* conn) {
+        if (mysql_query(conn, "SELECT 1") != 0) {
+            return false;
+        }
+        MYSQL_RES* result = mysql_store_result(conn);
+        if (result) {
+            mysql_free_result(result);
+        }
+        return true;
+    };
+
+    BenchmarkCall sharded_call = [&](int, long long) {
+        ConnectionGuard conn(db_pool_);
+        return conn.isValid() && (!with_query || probe(conn.get()));
+    };
+
+    std::mutex legacy_mutex;
+    BenchmarkCall legacy_call = [&](int, long long) {
+        MYSQL* conn = db_pool_.getConnection();
+        if (!conn) {
+            return false;
+        }
+        bool ok;
+        {
+            std::lock_guard<std::mutex> lock(legacy_mutex);
+            ok = mysql_ping(conn) == 0;
+        }
+        if (ok && with_query) {
+            ok = probe(conn);
+        }
+        {
+            std::lock_guard<std::mutex> lock(legacy_mutex);
+            ok = mysql_ping(conn) == 0 && ok;
+            db_pool_.returnConnection(conn);
+        }
+        return ok;
+    };
+
+    if (warmup_ms > 0) {
+        runConcurrent(threads, warmup_ms, sharded_call);
+    }
+    BenchmarkRun legacy_run = runConcurrent(threads, duration_ms, legacy_call);
+    BenchmarkRun sharded_run = runConcurrent(threads, duration_ms, sharded_call);
+
+    json legacy = summarize("global_lock_ping", threads, legacy_run);
+    json sharded = summarize("sharded", threads, sharded_run);
+    json pool = db_pool_.getPoolStatus();
+
+    json data;
+    data["scenario"] = "pool_checkout";
+    data["threads"] = threads;
+    data["duration_ms"] = duration_ms;
+    data["query"] = with_query;
+    data["max_pool_size"] = pool["max_pool_size"];
+    data["results"] = json::array({legacy, sharded});
+    data["qps_ratio"] = legacy["qps"].get<double>() > 0 ?
+        sharded["qps"].get<double>() / legacy["qps"].get<double>() : 0.0;
+    data["pool"] = pool;
+    return createSuccessResponse(data, "基准测试完成");
+}
+
+// 商品列表形状的结果集只查询一次并缓存在客户端，之后每次调用用mysql_data_seek回到开头，
+// 只测量从MYSQL_ROW到完整响应文本的序列化部分：
+// 旧路径逐个单元格构建nlohmann::json再整体dump()，新路径由JsonWriter直接写出最终文本并复用缓冲区
+json BenchmarkService::benchJsonWriter(const json& options) {
+    int rows = intOption(options, "rows", 100, 1, 10000);
+    int duration_ms = intOption(options, "duration_ms", 3000, 100, 60000);
+    int warmup_ms = intOption(options, "warmup_ms", 500, 0, 10000);
+
+    std::string sql = "SELECT product_id as id, name, description, price, stock_quantity as stock, "
+                      "category_id as category, status, created_at, updated_at FROM products "
+                      "WHERE status != 'deleted' ORDER BY product_id LIMIT " + std::to_string(rows);
+    MYSQL_RES* result = nullptr;
+    {
+        ConnectionGuard conn(db_pool_);
+        if (mysql_query(conn.get(), sql.c_str()) != 0) {
+            return createErrorResponse("SQL执行失败: " + std::string(mysql_error(conn.get())),
+                                       Constants::DATABASE_ERROR_CODE);
+        }
+        result = mysql_store_result(conn.get());
+        if (!result) {
+            return createErrorResponse("获取查询结果失败: " + std::string(mysql_error(conn.get())),
+                                       Constants::DATABASE_ERROR_CODE);
+        }
+    }
+    std::unique_ptr<MYSQL_RES, void (*)(MYSQL_RES*)> result_guard(result, mysql_free_result);
+    my_ulonglong row_count = mysql_num_rows(result);
+    if (row_count == 0) {
+        return createErrorResponse("没有可用的商品数据", Constants::VALIDATION_ERROR_CODE);
+    }
+
+    std::string dom_output;
+    BenchmarkCall dom_call = [&](int, long long) {
+        mysql_data_seek(result, 0);
+        dom_output = createSuccessResponse(parseResultSet(result)).dump();
+        return !dom_output.empty();
+    };
+    JsonWriter writer;
+    BenchmarkCall stream_call = [&](int, long long) {
+        mysql_data_seek(result, 0);
+        writer.clear();
+        beginSuccessResponse(writer);
+        writer.appendResultSet(result);
+        endSuccessResponse(writer);
+        return writer.size() > 0;
+    };
+
+    if (warmup_ms > 0) {
+        runConcurrent(1, warmup_ms, dom_call);
+        runConcurrent(1, warmup_ms, stream_call);
+    }
+    BenchmarkRun dom_run = runConcurrent(1, duration_ms, dom_call);
+    BenchmarkRun stream_run = runConcurrent(1, duration_ms, stream_call);
+
+    json dom = summarize("dom", 1, dom_run);
+    json stream = summarize("json_writer", 1, stream_run);
+    dom["bytes"] = dom_output.size();
+    stream["bytes"] = writer.size();
+    for (json* summary : {&dom, &stream}) {
+        double avg_us = (*summary)["avg_us"].get<double>();
+        (*summary)["mb_per_second"] = avg_us > 0 ? (*summary)["bytes"].get<double>() / avg_us : 0.0;
+    }
+
+    json data;
+    data["scenario"] = "json_writer";
+    data["rows"] = row_count;
+    data["duration_ms"] = duration_ms;
+    data["results"] = json::array({dom, stream});
+    data["qps_ratio"] = dom["qps"].get<double>() > 0 ?
+        stream["qps"].get<double>() / dom["qps"].get<double>() : 0.0;
+    data["outputs_match"] = json::parse(dom_output)["data"] == json::parse(writer.str())["data"];
+    return createSuccessResponse(data, "基准测试完成");
+}
+
+// 少量调用线程执行同样的商品点查询：阻塞路径每次等一条查询返回；异步路径每次向异步引擎
+// 提交depth条查询再依次get()，一个调用线程同时占用多条池化连接。sleep_ms大于0时在查询中
+// 加上SLEEP，模拟跨机房等往返较长的数据库。吞吐按查询条数计算，延迟为一批查询的耗时
+json BenchmarkService::benchAsyncVsBlocking(const json& options) {
+    int threads = intOption(options, "threads", 4, 1, 64);
+    int duration_ms = intOption(options, "duration_ms", 5000, 100, 60000);
+    int warmup_ms = intOption(options, "warmup_ms", 1000, 0, 10000);
+    int sleep_ms = intOption(options, "sleep_ms", 0, 0, 100);
+    std::vector<int> depths = {1, 4, 16};
+    if (options.contains("depths") && options["depths"].is_array() && !options["depths"].empty()) {
+        depths.clear();
+        for (const auto& depth : options["depths"]) {
+            depths.push_back(std::max(1, std::min(depth.get<int>(), 256)));
+        }
+    }
+
+    std::vector<long> ids = loadProductIds(1000);
+    if (ids.empty()) {
+        return createErrorResponse("没有可用的商品数据", Constants::VALIDATION_ERROR_CODE);
+    }
+    std::string sleep_clause = sleep_ms > 0 ?
+        " AND SLEEP(" + std::to_string(sleep_ms / 1000.0) + ") = 0" : "";
+    auto querySql = [&](int t, long long i) {
+        long id = ids[static_cast<size_t>(t * 7919 + i) % ids.size()];
+        return "SELECT product_id, name, price, stock_quantity FROM products WHERE product_id = " +
+               std::to_string(id) + sleep_clause;
+    };
+
+    BenchmarkCall blocking_call = [&](int t, long long i) {
+        return executeQuery(querySql(t, i))["success"].get<bool>();
+    };
+    auto asyncCall = [&](int depth) -> BenchmarkCall {
+        return [&, depth](int t, long long i) {
+            std::vector<std::future<json>> futures;
+            futures.reserve(depth);
+            for (int k = 0; k < depth; k++) {
+                futures.push_back(executeQueryAsync(querySql(t, i * depth + k)));
+            }
+            bool ok = true;
+            for (auto& future : futures) {
+                ok = future.get()["success"].get<bool>() && ok;
+            }
+            return ok;
+        };
+    };
+
+    if (warmup_ms > 0) {
+        runConcurrent(threads, warmup_ms, blocking_call);
+        runConcurrent(threads, warmup_ms, asyncCall(depths.back()));
+    }
+
+    json results = json::array();
+    BenchmarkRun blocking_run = runConcurrent(threads, duration_ms, blocking_call);
+    json blocking = summarize("blocking", threads, blocking_run);
+    blocking["in_flight_per_thread"] = 1;
+    results.push_back(blocking);
+
+    json engine_before = AsyncQueryEngine::getInstance().getStats();
+    for (int depth : depths) {
+        BenchmarkRun async_run = runConcurrent(threads, duration_ms, asyncCall(depth));
+        json async = summarize("async", threads, async_run);
+        async["in_flight_per_thread"] = depth;
+        async["qps"] = async["qps"].get<double>() * depth;
+        async["qps_ratio"] = blocking["qps"].get<double>() > 0 ?
+            async["qps"].get<double>() / blocking["qps"].get<double>() : 0.0;
+        results.push_back(async);
+    }
+    json engine_after = AsyncQueryEngine::getInstance().getStats();
+
+    json data;
+    data["scenario"] = "async_vs_blocking";
+    data["threads"] = threads;
+    data["duration_ms"] = duration_ms;
+    data["sleep_ms"] = sleep_ms;
+    data["results"] = results;
+    data["engine"] = {
+        {"io_threads", engine_after["threads"]},
+        {"peak_in_flight", engine_after["peak_in_flight"]},
+        {"caller_runs", engine_after["caller_runs"].get<long long>() - engine_before["caller_runs"].get<long long>()}
+    };
+    data["max_pool_size"] = db_pool_.getPoolStatus()["max_pool_size"];
+    return createSuccessResponse(data, "基准测试完成");
+}
@@ -0,0 +1,96 @@
+#ifndef BENCHMARKSERVICE_H
+#define BENCHMARKSERVICE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include "../nlohmann_json.hpp"
+
+using json = nlohmann::json;
+
+// 前向声明 - BaseService将在主文件中定义
+class BaseService;
+
+/**
+ * 本地基准测试服务类
+ * 在本地代码内部对比同一操作的不同实现，排除JNI和Java侧的开销，
+ * 供load分组的测试通过 runNativeBenchmark 调用。只读取已有数据，不修改业务表
+ */
+class BenchmarkService : public BaseService {
+private:
+    /**
+     * 一轮测量的原始结果
+     */
+    struct BenchmarkRun {
+        long long calls = 0;                 ///< 完成的调用次数
+        long long failures = 0;              ///< 返回失败的调用次数
+        double elapsed_seconds = 0.0;        ///< 实际测量时长
+        std::vector<uint32_t> latencies_us;  ///< 每次调用的延迟(微秒)
+    };
+
+    /// 单次调用，参数为线程序号和该线程内的调用序号，返回是否成功
+    using BenchmarkCall = std::function<bool(int, long long)>;
+
+    /**
+     * threads个线程同时开始，在duration_ms内反复执行call
+     */
+    BenchmarkRun runConcurrent(int threads, int duration_ms, const BenchmarkCall& call) const;
+
+    /**
+     * 汇总一轮测量: 吞吐、平均延迟和p50/p90/p99/最大延迟
+     */
+    json summarize(const std::string& mode, int threads, BenchmarkRun& run) const;
+
+    /**
+     * 读取整数参数并限制在[min_value, max_value]内
+     */
+    static int intOption(const json& options, const char* key, int default_value, int min_value, int max_value);
+
+    /**
+     * 取一批在售商品ID作为点查询的参数
+     */
+    std::vector<long> loadProductIds(size_t limit);
+
+    /**
+     * 预处理语句与文本协议的点查询对比
+     */
+    json benchPreparedVsText(const json& options);
+
+    /**
+     * 连接池借还对比: 当前的分片连接池与旧的全局锁加ping的做法
+     */
+    json benchPoolCheckout(const json& options);
+
+    /**
+     * 结果集序列化对比: 流式JsonWriter与parseResultSet构建DOM后dump()
+     */
+    json benchJsonWriter(const json& options);
+
+    /**
+     * 阻塞查询与异步引擎的对比: 每个调用线程同时保持1/4/16条查询在途
+     */
+    json benchAsyncVsBlocking(const json& options);
+
+public:
+    /**
+     * 构造函数
+     */
+    BenchmarkService();
+
+    /**
+     * 获取服务名称
+     * @return 服务名称 "BenchmarkService"
+     */
+    std::string getServiceName() const override;
+
+    /**
+     * 运行本地基准测试
+     * @param scenario 场景名称: prepared_vs_text、pool_checkout、json_writer、async_vs_blocking
+     * @param options 场景参数，如 threads、duration_ms
+     * @return 各实现的吞吐和延迟分位数
+     */
+    json runBenchmark(const std::string& scenario, const json& options);
+};
+
+#endif // BENCHMARKSERVICE_H
@@ -13,24 +13,12 @@ std::string CartService::getServiceName() const {
     return "CartService";
 }
 
-// 检查购物车项是否存在
-bool CartService::isCartItemExists(long user_id, long product_id) const {
-    std::string sql = "SELECT COUNT(*) as count FROM cart WHERE user_id = " + 
-                     std::to_string(user_id) + " AND product_id = " + std::to_string(product_id);
-    
-    json result = const_cast<CartService*>(this)->executeQuery(sql);
-    if (result["success"].get<bool>() && result["data"].is_array() && !result["data"].empty()) {
-        return result["data"][0]["count"].get<long>() > 0;
-    }
-    return false;
-}
-
 // 添加商品到购物车
 json CartService::addToCart(long user_id, long product_id, int quantity) {
     logInfo("添加商品到购物车，用户ID: " + std::to_string(user_id) + 
            ", 商品ID: " + std::to_string(product_id) + ", 数量: " + std::to_string(quantity));
     
-    std::lock_guard<std::mutex> lock(cart_mutex_);
+    auto lock = userLocks().lock(user_id);
     
     if (user_id <= 0 || product_id <= 0) {
         return createErrorResponse("无效的用户ID或商品ID", Constants::VALIDATION_ERROR_CODE);
@@ -42,9 +30,10 @@ json CartService::addToCart(long user_id, long product_id, int quantity) {
     
     try {
         // 检查商品是否存在且库存充足
-        std::string product_sql = "SELECT stock_quantity as stock, name, status FROM products WHERE product_id = " + 
-                                 std::to_string(product_id) + " FOR UPDATE";  // 加锁防止并发问题
-        json product_result = executeQuery(product_sql);
+        // 加入购物车不扣库存，这里只做校验，不对商品行加锁
+        static const std::string product_sql = "SELECT stock_quantity as stock, name, status FROM products "
+                                               "WHERE product_id = ?";
+        json product_result = executePrepared(product_sql, {product_id});
         
         if (!product_result["success"].get<bool>()) {
             return product_result;
@@ -79,16 +68,7 @@ json CartService::addToCart(long user_id, long product_id, int quantity) {
         }        
         // ========== 检查商品限购规则 ==========
         // 获取购物车中该商品的现有数量
-        int cart_quantity = 0;
-        if (isCartItemExists(user_id, product_id)) {
-            std::string cart_qty_sql = "SELECT quantity FROM cart WHERE user_id = " + 
-                                       std::to_string(user_id) + " AND product_id = " + 
-                                       std::to_string(product_id);
-            json cart_qty_result = executeQuery(cart_qty_sql);
-            if (cart_qty_result["success"].get<bool>() && !cart_qty_result["data"].empty()) {
-                cart_quantity = cart_qty_result["data"][0]["quantity"].get<int>();
-            }
-        }
+        int cart_quantity = CartStore::getInstance().quantityOf(user_id, product_id);
         
         // 总需求数量 = 购物车现有数量 + 本次添加数量
         int total_requested = cart_quantity + quantity;
@@ -151,12 +131,12 @@ json CartService::addToCart(long user_id, long product_id, int quantity) {
                 limit_period_value = limit_data["limit_period"].get<std::string>();
             }
 
-            logDebug("限购检查(addToCart): user=" + std::to_string(user_id) +
-                     ", product=" + std::to_string(product_id) +
-                     ", requested=" + std::to_string(total_requested) +
-                     ", purchased=" + std::to_string(limit_purchased_count) +
-                     ", limit=" + std::to_string(limit_limit_count) +
-                     ", canPurchase=" + std::string(can_purchase ? "true" : "false"));
+            logDebug("限购检查(addToCart): user=", user_id,
+                     ", product=", product_id,
+                     ", requested=", total_requested,
+                     ", purchased=", limit_purchased_count,
+                     ", limit=", limit_limit_count,
+                     ", canPurchase=", can_purchase);
 
             if (!can_purchase) {
                 limit_violation = true;
@@ -179,45 +159,22 @@ json CartService::addToCart(long user_id, long product_id, int quantity) {
             );
         }
         
-        // 检查购物车中是否已有该商品
-        if (isCartItemExists(user_id, product_id)) {
-            // 更新数量
-            std::string update_sql = "UPDATE cart SET quantity = quantity + " + 
-                                    std::to_string(quantity) + ", updated_at = NOW() "
-                                    "WHERE user_id = " + std::to_string(user_id) + 
-                                    " AND product_id = " + std::to_string(product_id);
-            
-            json result = executeQuery(update_sql);
-            if (result["success"].get<bool>()) {
-                json response_data;
-                response_data["user_id"] = user_id;
-                response_data["product_id"] = product_id;
-                response_data["quantity_added"] = quantity;
-                response_data["action"] = "updated";
-                
-                return createSuccessResponse(response_data, "购物车商品数量已更新");
-            } else {
-                return result;
-            }
-        } else {
-            std::string insert_sql = "INSERT INTO cart (user_id, product_id, quantity, created_at, updated_at) "
-                                    "VALUES (" + std::to_string(user_id) + ", " + std::to_string(product_id) + 
-                                    ", " + std::to_string(quantity) + ", NOW(), NOW())";
-            
-            json result = executeQuery(insert_sql);
-            if (result["success"].get<bool>()) {
-                json response_data;
-                response_data["user_id"] = user_id;
-                response_data["product_id"] = product_id;
-                response_data["quantity"] = quantity;
-                response_data["cart_item_id"] = result["data"]["insert_id"];
-                response_data["action"] = "added";
-                
-                return createSuccessResponse(response_data, "商品已添加到购物车");
-            } else {
-                return result;
-            }
+        // 写入内存购物车，由后台写回cart表
+        bool created = false;
+        CartStore::Line line = CartStore::getInstance().add(user_id, product_id, quantity, created);
+        
+        json response_data;
+        response_data["user_id"] = user_id;
+        response_data["product_id"] = product_id;
+        if (created) {
+            response_data["quantity"] = line.quantity;
+            response_data["action"] = "added";
+            return createSuccessResponse(response_data, "商品已添加到购物车");
         }
+        response_data["quantity_added"] = quantity;
+        response_data["quantity"] = line.quantity;
+        response_data["action"] = "updated";
+        return createSuccessResponse(response_data, "购物车商品数量已更新");
         
     } catch (const std::exception& e) {
         std::string error_msg = "添加商品到购物车异常: " + std::string(e.what());
@@ -228,28 +185,14 @@ json CartService::addToCart(long user_id, long product_id, int quantity) {
 
 // 获取购物车内容
 json CartService::getCart(long user_id) {
-    logDebug("获取购物车内容，用户ID: " + std::to_string(user_id));
+    logDebug("获取购物车内容，用户ID: ", user_id);
     
     if (user_id <= 0) {
         return createErrorResponse("无效的用户ID", Constants::VALIDATION_ERROR_CODE);
     }
     
     try {
-        std::string sql = "SELECT c.cart_id as cart_item_id, c.product_id, c.quantity, c.selected, c.created_at, "
-                         "p.name, p.price, p.stock_quantity as stock, p.category_id as category, "
-                         "(c.quantity * p.price) as subtotal "
-                         "FROM cart c "
-                         "JOIN products p ON c.product_id = p.product_id "
-                         "WHERE c.user_id = " + std::to_string(user_id) + 
-                         " AND p.status = 'active' "
-                         "ORDER BY c.created_at DESC";
-        
-        json result = executeQuery(sql);
-        if (!result["success"].get<bool>()) {
-            return result;
-        }
-        
-        json items = result["data"];
+        json items = buildCartItems(user_id);
         double total_amount = 0.0;
         int total_items = 0;
         
@@ -280,28 +223,22 @@ json CartService::removeFromCart(long user_id, long product_id) {
     logInfo("从购物车移除商品，用户ID: " + std::to_string(user_id) + 
            ", 商品ID: " + std::to_string(product_id));
     
-    std::lock_guard<std::mutex> lock(cart_mutex_);
+    auto lock = userLocks().lock(user_id);
     
     if (user_id <= 0 || product_id <= 0) {
         return createErrorResponse("无效的用户ID或商品ID", Constants::VALIDATION_ERROR_CODE);
     }
     
-    std::string sql = "DELETE FROM cart WHERE user_id = " + std::to_string(user_id) + 
-                     " AND product_id = " + std::to_string(product_id);
-    
-    json result = executeQuery(sql);
-    if (result["success"].get<bool>()) {
-        long affected_rows = result["data"]["affected_rows"].get<long>();
-        if (affected_rows > 0) {
+    try {
+        if (CartStore::getInstance().remove(user_id, product_id)) {
             logInfo("商品已从购物车移除，用户ID: " + std::to_string(user_id) + 
                    ", 商品ID: " + std::to_string(product_id));
             return createSuccessResponse(json::object(), "商品已从购物车移除");
-        } else {
-            return createErrorResponse("购物车中没有该商品", Constants::VALIDATION_ERROR_CODE);
         }
+        return createErrorResponse("购物车中没有该商品", Constants::VALIDATION_ERROR_CODE);
+    } catch (const std::exception& e) {
+        return createErrorResponse("移除购物车商品异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
     }
-    
-    return result;
 }
 
 // 更新购物车商品数量
@@ -309,7 +246,7 @@ json CartService::updateCartItemQuantity(long user_id, long product_id, int quan
     logInfo("更新购物车商品数量，用户ID: " + std::to_string(user_id) + 
            ", 商品ID: " + std::to_string(product_id) + ", 新数量: " + std::to_string(quantity));
     
-    std::lock_guard<std::mutex> lock(cart_mutex_);
+    auto lock = userLocks().lock(user_id);
     
     if (user_id <= 0 || product_id <= 0) {
         return createErrorResponse("无效的用户ID或商品ID", Constants::VALIDATION_ERROR_CODE);
@@ -321,14 +258,13 @@ json CartService::updateCartItemQuantity(long user_id, long product_id, int quan
     
     try {
         // 检查购物车中是否存在该商品
-        if (!isCartItemExists(user_id, product_id)) {
+        if (CartStore::getInstance().quantityOf(user_id, product_id) == 0) {
             return createErrorResponse("购物车中没有该商品", Constants::VALIDATION_ERROR_CODE);
         }
         
         // 检查商品库存和限购
-        std::string product_sql = "SELECT stock_quantity as stock, name, status FROM products WHERE product_id = " + 
-                                 std::to_string(product_id);
-        json product_result = executeQuery(product_sql);
+        static const std::string product_sql = "SELECT stock_quantity as stock, name, status FROM products WHERE product_id = ?";
+        json product_result = executePrepared(product_sql, {product_id});
         
         if (!product_result["success"].get<bool>() || product_result["data"].empty()) {
             return createErrorResponse("商品不存在", Constants::VALIDATION_ERROR_CODE);
@@ -410,12 +346,12 @@ json CartService::updateCartItemQuantity(long user_id, long product_id, int quan
                 limit_period_value = limit_data["limit_period"].get<std::string>();
             }
 
-            logDebug("限购检查(update): user=" + std::to_string(user_id) +
-                     ", product=" + std::to_string(product_id) +
-                     ", requested=" + std::to_string(quantity) +
-                     ", purchased=" + std::to_string(limit_purchased_count) +
-                     ", limit=" + std::to_string(limit_limit_count) +
-                     ", canPurchase=" + std::string(can_purchase ? "true" : "false"));
+            logDebug("限购检查(update): user=", user_id,
+                     ", product=", product_id,
+                     ", requested=", quantity,
+                     ", purchased=", limit_purchased_count,
+                     ", limit=", limit_limit_count,
+                     ", canPurchase=", can_purchase);
 
             if (!can_purchase) {
                 limit_violation = true;
@@ -438,28 +374,18 @@ json CartService::updateCartItemQuantity(long user_id, long product_id, int quan
         }
         
         // 更新商品数量
-        std::string sql = "UPDATE cart SET quantity = " + std::to_string(quantity) + 
-                         ", updated_at = NOW() WHERE user_id = " + std::to_string(user_id) + 
-                         " AND product_id = " + std::to_string(product_id);
-        
-        json result = executeQuery(sql);
-        if (result["success"].get<bool>()) {
-            long affected_rows = result["data"]["affected_rows"].get<long>();
-            if (affected_rows > 0) {
-                json response_data;
-                response_data["user_id"] = user_id;
-                response_data["product_id"] = product_id;
-                response_data["new_quantity"] = quantity;
-                
-                logInfo("购物车商品数量更新成功，用户ID: " + std::to_string(user_id) + 
-                       ", 商品ID: " + std::to_string(product_id) + ", 新数量: " + std::to_string(quantity));
-                return createSuccessResponse(response_data, "购物车商品数量更新成功");
-            } else {
-                return createErrorResponse("更新失败，购物车中没有该商品", Constants::VALIDATION_ERROR_CODE);
-            }
+        if (!CartStore::getInstance().setQuantity(user_id, product_id, quantity)) {
+            return createErrorResponse("更新失败，购物车中没有该商品", Constants::VALIDATION_ERROR_CODE);
         }
         
-        return result;
+        json response_data;
+        response_data["user_id"] = user_id;
+        response_data["product_id"] = product_id;
+        response_data["new_quantity"] = quantity;
+        
+        logInfo("购物车商品数量更新成功，用户ID: " + std::to_string(user_id) + 
+               ", 商品ID: " + std::to_string(product_id) + ", 新数量: " + std::to_string(quantity));
+        return createSuccessResponse(response_data, "购物车商品数量更新成功");
     } catch (const std::exception& e) {
         return createErrorResponse("更新购物车数量异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
     }
@@ -469,29 +395,17 @@ json CartService::updateCartItemQuantity(long user_id, long product_id, int quan
 json CartService::updateCartSelected(long user_id, long product_id, bool selected) {
     logInfo(std::string("更新购物车选中状态，用户ID: ") + std::to_string(user_id) +
             ", 商品ID: " + std::to_string(product_id) + ", 选中: " + (selected ? "true" : "false"));
-    std::lock_guard<std::mutex> lock(cart_mutex_);
+    auto lock = userLocks().lock(user_id);
     if (user_id <= 0) {
         return createErrorResponse("无效的用户ID", Constants::VALIDATION_ERROR_CODE);
     }
     try {
-        std::string sql;
-        if (product_id <= 0) {
-            sql = "UPDATE cart SET selected = " + std::string(selected ? "1" : "0") +
-                  ", updated_at = NOW() WHERE user_id = " + std::to_string(user_id);
-        } else {
-            sql = "UPDATE cart SET selected = " + std::string(selected ? "1" : "0") +
-                  ", updated_at = NOW() WHERE user_id = " + std::to_string(user_id) +
-                  " AND product_id = " + std::to_string(product_id);
-        }
-        json result = executeQuery(sql);
-        if (result["success"].get<bool>()) {
-            json data;
-            data["user_id"] = user_id;
-            if (product_id > 0) data["product_id"] = product_id;
-            data["selected"] = selected;
-            return createSuccessResponse(data, "购物车选中状态已更新");
-        }
-        return result;
+        CartStore::getInstance().setSelected(user_id, product_id, selected);
+        json data;
+        data["user_id"] = user_id;
+        if (product_id > 0) data["product_id"] = product_id;
+        data["selected"] = selected;
+        return createSuccessResponse(data, "购物车选中状态已更新");
     } catch (const std::exception &e) {
         return createErrorResponse("更新购物车选中状态异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
     }
@@ -501,26 +415,94 @@ json CartService::updateCartSelected(long user_id, long product_id, bool selecte
 json CartService::clearCart(long user_id) {
     logInfo("清空购物车，用户ID: " + std::to_string(user_id));
     
-    std::lock_guard<std::mutex> lock(cart_mutex_);
+    auto lock = userLocks().lock(user_id);
     
     if (user_id <= 0) {
         return createErrorResponse("无效的用户ID", Constants::VALIDATION_ERROR_CODE);
     }
     
-    std::string sql = "DELETE FROM cart WHERE user_id = " + std::to_string(user_id);
-    
-    json result = executeQuery(sql);
-    if (result["success"].get<bool>()) {
-        long affected_rows = result["data"]["affected_rows"].get<long>();
+    try {
+        size_t removed = CartStore::getInstance().clear(user_id);
         
         json response_data;
         response_data["user_id"] = user_id;
-        response_data["removed_items"] = affected_rows;
+        response_data["removed_items"] = removed;
         
         logInfo("购物车已清空，用户ID: " + std::to_string(user_id) + 
-               ", 移除商品数: " + std::to_string(affected_rows));
+               ", 移除商品数: " + std::to_string(removed));
         return createSuccessResponse(response_data, "购物车已清空");
+    } catch (const std::exception& e) {
+        return createErrorResponse("清空购物车异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
+    }
+}
+
+// 获取购物车摘要
+json CartService::getCartSummary(long user_id) {
+    if (user_id <= 0) {
+        return createErrorResponse("无效的用户ID", Constants::VALIDATION_ERROR_CODE);
+    }
+    
+    try {
+        json items = buildCartItems(user_id);
+        double total_amount = 0.0;
+        for (const json& item : items) {
+            total_amount += item["subtotal"].get<double>();
+        }
+        
+        json summary;
+        summary["item_count"] = items.size();
+        summary["total_amount"] = total_amount;
+        return createSuccessResponse(summary, "获取购物车摘要成功");
+    } catch (const std::exception& e) {
+        return createErrorResponse("获取购物车摘要异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
+    }
+}
+
+// 内存购物车行按加入时间倒序，补上商品信息；只保留在售商品
+json CartService::buildCartItems(long user_id) {
+    std::vector<CartStore::Line> lines = CartStore::getInstance().getLines(user_id);
+    json items = json::array();
+    if (lines.empty()) {
+        return items;
     }
     
-    return result;
+    std::string sql = "SELECT product_id, name, price, stock_quantity as stock, category_id as category "
+                      "FROM products WHERE status = 'active' AND product_id IN (";
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (i > 0) {
+            sql += ",";
+        }
+        sql += std::to_string(lines[i].product_id);
+    }
+    sql += ")";
+    
+    json result = executeReadQuery(sql, user_id);
+    if (!result["success"].get<bool>()) {
+        throw std::runtime_error(result.value("message", std::string("查询商品信息失败")));
+    }
+    std::unordered_map<long, const json*> products;
+    for (const json& product : result["data"]) {
+        products[product["product_id"].get<long>()] = &product;
+    }
+    
+    for (const CartStore::Line& line : lines) {
+        auto it = products.find(line.product_id);
+        if (it == products.end()) {
+            continue;
+        }
+        const json& product = *it->second;
+        double price = product["price"].get<double>();
+        json item;
+        item["product_id"] = line.product_id;
+        item["quantity"] = line.quantity;
+        item["selected"] = line.selected ? 1 : 0;
+        item["created_at"] = line.created_at;
+        item["name"] = product["name"];
+        item["price"] = price;
+        item["stock"] = product["stock"];
+        item["category"] = product["category"];
+        item["subtotal"] = line.quantity * price;
+        items.push_back(item);
+    }
+    return items;
 }
@@ -21,20 +21,20 @@ class BaseService;
  * - 更新购物车条目选中状态(支持单选/全选)
  * - 清空购物车
  * 
+ * 存储:
+ * - 购物车内容以内存中的CartStore为准，修改由后台线程批量写回cart表
+ * 
  * 线程安全:
- * - 使用cart_mutex_保护购物车操作
+ * - 按用户ID加分段锁(与下单共享)，不同用户的购物车操作并行执行
  */
 class CartService : public BaseService {
 private:
-    std::mutex cart_mutex_;  // 购物车操作互斥锁
-    
     /**
-     * @brief 检查购物车项是否存在
+     * @brief 读取内存购物车并补充商品信息(只保留在售商品)
      * @param user_id 用户ID
-     * @param product_id 商品ID
-     * @return true-存在, false-不存在
+     * @return 购物车条目数组，按加入时间倒序
      */
-    bool isCartItemExists(long user_id, long product_id) const;
+    json buildCartItems(long user_id);
     
 public:
     CartService();
@@ -89,6 +89,13 @@ public:
      * @return JSON响应 {success, data:{user_id,removed_items}}
      */
     json clearCart(long user_id);
+    
+    /**
+     * @brief 获取购物车摘要
+     * @param user_id 用户ID
+     * @return JSON响应 {success, data:{item_count,total_amount}}
+     */
+    json getCartSummary(long user_id);
 };
 
 #endif // CART_SERVICE_H
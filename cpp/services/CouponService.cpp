@@ -241,7 +241,9 @@ json CouponService::assignCouponToUser(long user_id, const std::string& coupon_i
 json CouponService::claimCoupon(long user_id, const std::string& coupon_code) {
     logInfo("领取优惠券，用户ID: " + std::to_string(user_id) + ", 优惠券代码: " + coupon_code);
     
-    std::lock_guard<std::mutex> lock(coupon_mutex_);
+    // 用户锁保证个人领取上限的检查与写入不被同一用户的并发请求穿透；
+    // 优惠券总量由条件UPDATE在数据库侧保证
+    auto lock = userLocks().lock(user_id);
     
     if (user_id <= 0 || coupon_code.empty()) {
         return createErrorResponse("用户ID和优惠券代码不能为空", Constants::VALIDATION_ERROR_CODE);
@@ -281,16 +283,43 @@ json CouponService::claimCoupon(long user_id, const std::string& coupon_code) {
             }
         }
         
+        // 占用额度与写入领取记录在同一事务中完成，任一步失败都整体回滚
+        Transaction tx(*this);
+        
+        // 先占用一张优惠券额度，并发领取时由条件UPDATE保证不超发
+        static const std::string claim_sql = "UPDATE coupons SET used_quantity = used_quantity + 1 "
+                                             "WHERE coupon_id = ? AND used_quantity < total_quantity";
+        json claim_result = tx.prepared(claim_sql, {coupon_id});
+        if (!claim_result["success"].get<bool>()) {
+            return claim_result;
+        }
+        if (claim_result["data"]["affected_rows"].get<int>() == 0) {
+            return createErrorResponse("优惠券已领完", Constants::VALIDATION_ERROR_CODE);
+        }
+        
+        // 上面的UPDATE持有该优惠券的行锁直到提交，同一优惠券的批量分配在此排队。
+        // 在行锁下用加锁读取复核个人领取上限，能看到批量分配已提交的记录，不会重复发放
+        std::string owned_sql = "SELECT COUNT(*) as count FROM user_coupons WHERE user_id = " +
+                                std::to_string(user_id) + " AND coupon_id = " + std::to_string(coupon_id) +
+                                " LOCK IN SHARE MODE";
+        json owned_result = tx.query(owned_sql);
+        if (!owned_result["success"].get<bool>()) {
+            return owned_result;
+        }
+        if (!owned_result["data"].empty() && owned_result["data"][0]["count"].get<int>() >= per_user_limit) {
+            return createErrorResponse("已达到个人领取限制", Constants::VALIDATION_ERROR_CODE);
+        }
+        
         // 领取优惠券
         std::string insert_sql = "INSERT INTO user_coupons (user_id, coupon_id, status) VALUES (" +
                                 std::to_string(user_id) + ", " + std::to_string(coupon_id) + ", 'unused')";
-        json insert_result = executeQuery(insert_sql);
+        json insert_result = tx.query(insert_sql);
         
         if (insert_result["success"].get<bool>()) {
-            // 更新优惠券使用数量
-            std::string update_sql = "UPDATE coupons SET used_quantity = used_quantity + 1 WHERE coupon_id = " +
-                                    std::to_string(coupon_id);
-            executeQuery(update_sql);
+            if (!tx.commit()) {
+                return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
+            }
+            markUserWrite(user_id);
             
             json response_data;
             response_data["user_id"] = user_id;
@@ -311,7 +340,7 @@ json CouponService::claimCoupon(long user_id, const std::string& coupon_code) {
 json CouponService::useCoupon(long user_id, long order_id, const std::string& coupon_code) {
     logInfo("使用优惠券，用户ID: " + std::to_string(user_id) + ", 订单ID: " + std::to_string(order_id));
     
-    std::lock_guard<std::mutex> lock(coupon_mutex_);
+    auto lock = userLocks().lock(user_id);
     
     try {
         // 检查用户是否拥有该优惠券
@@ -320,7 +349,8 @@ json CouponService::useCoupon(long user_id, long order_id, const std::string& co
                                "WHERE uc.user_id = " + std::to_string(user_id) + 
                                " AND c.code = '" + coupon_code + "' AND uc.status = 'unused'";
         
-        json check_result = executeQuery(check_sql);
+        Transaction tx(*this);
+        json check_result = tx.query(check_sql + " FOR UPDATE");
         if (!check_result["success"].get<bool>() || check_result["data"].empty()) {
             return createErrorResponse("优惠券不可用", Constants::VALIDATION_ERROR_CODE);
         }
@@ -331,8 +361,13 @@ json CouponService::useCoupon(long user_id, long order_id, const std::string& co
                                 "order_id = " + std::to_string(order_id) + 
                                 " WHERE id = " + std::to_string(user_coupon_id);
         
-        json result = executeQuery(update_sql);
+        json result = tx.query(update_sql);
         if (result["success"].get<bool>()) {
+            if (!tx.commit()) {
+                return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
+            }
+            markUserWrite(user_id);
+            
             json response_data;
             response_data["user_id"] = user_id;
             response_data["order_id"] = order_id;
@@ -498,7 +533,8 @@ json CouponService::createCouponActivity(const std::string& name, const std::str
                                          long template_id) {
     logInfo("创建优惠券活动，名称: " + name + ", 代码: " + coupon_code);
     
-    std::lock_guard<std::mutex> lock(coupon_mutex_);
+    // 同一优惠券代码的创建互斥，避免并发重复创建
+    auto lock = couponLocks().lock(coupon_code);
     
     if (name.empty() || coupon_code.empty() || type.empty()) {
         return createErrorResponse("优惠券名称、代码和类型不能为空", Constants::VALIDATION_ERROR_CODE);
@@ -688,12 +724,22 @@ json CouponService::getCouponTemplates() {
 json CouponService::distributeCouponsToUsers(const std::string& coupon_code, const json& user_ids) {
     logInfo("批量分配优惠券，优惠券代码: " + coupon_code + ", 用户数: " + std::to_string(user_ids.size()));
     
-    std::lock_guard<std::mutex> lock(coupon_mutex_);
-    
     if (coupon_code.empty() || !user_ids.is_array() || user_ids.empty()) {
         return createErrorResponse("无效的参数", Constants::VALIDATION_ERROR_CODE);
     }
     
+    // 去重后的目标用户(保持传入顺序)，重复的ID只发放一次
+    std::vector<long long> target_users;
+    target_users.reserve(user_ids.size());
+    std::unordered_set<long long> seen;
+    for (const auto& user_id : user_ids) {
+        if (user_id.is_number_integer() && seen.insert(user_id.get<long long>()).second) {
+            target_users.push_back(user_id.get<long long>());
+        }
+    }
+    
+    // 不加用户锁：与单用户领券的互斥由该优惠券的行锁保证(见下方占用额度的UPDATE)，
+    // 锁住整批用户会占满用户锁表，分配期间所有用户的购物车和下单都会被挡住
     try {
         // 查询优惠券ID
         std::string query_sql = "SELECT coupon_id, total_quantity, used_quantity FROM coupons "
@@ -710,55 +756,100 @@ json CouponService::distributeCouponsToUsers(const std::string& coupon_code, con
         
         // 检查库存
         int available_quantity = total_quantity - used_quantity;
-        if (available_quantity < static_cast<int>(user_ids.size())) {
+        int requested = static_cast<int>(target_users.size());
+        if (available_quantity < requested) {
+            return createErrorResponse("优惠券库存不足", Constants::VALIDATION_ERROR_CODE);
+        }
+        
+        // 整批占用额度，并发领取/分配时由条件UPDATE保证不超发，未发出的部分最后归还；
+        // 占用、写入与归还在同一事务中，中途异常不会留下被占用的额度。
+        // UPDATE取得的优惠券行锁持有到提交，同一优惠券的单用户领取在其后排队并复核领取记录
+        Transaction tx(*this);
+        static const std::string claim_sql = "UPDATE coupons SET used_quantity = used_quantity + ? "
+                                             "WHERE coupon_id = ? AND used_quantity + ? <= total_quantity";
+        json claim_result = tx.prepared(claim_sql, {requested, coupon_id, requested});
+        if (!claim_result["success"].get<bool>()) {
+            return claim_result;
+        }
+        if (claim_result["data"]["affected_rows"].get<int>() == 0) {
             return createErrorResponse("优惠券库存不足", Constants::VALIDATION_ERROR_CODE);
         }
         
-        // 批量插入用户优惠券记录
-        int success_count = 0;
-        int failed_count = 0;
+        // 按块查出已拥有该优惠券的用户，已拥有的跳过
+        std::unordered_set<long long> owners;
+        for (size_t begin = 0; begin < target_users.size(); begin += Constants::BULK_INSERT_MAX_ROWS) {
+            size_t end = std::min(target_users.size(), begin + Constants::BULK_INSERT_MAX_ROWS);
+            std::string id_list;
+            for (size_t i = begin; i < end; ++i) {
+                if (i > begin) id_list += ",";
+                id_list += std::to_string(target_users[i]);
+            }
+            std::string owner_sql = "SELECT DISTINCT user_id FROM user_coupons WHERE coupon_id = " +
+                                    std::to_string(coupon_id) + " AND user_id IN (" + id_list + ")";
+            json owner_result = tx.query(owner_sql);
+            if (!owner_result["success"].get<bool>()) {
+                return owner_result;
+            }
+            for (const auto& row : owner_result["data"]) {
+                owners.insert(row["user_id"].get<long long>());
+            }
+        }
         
-        for (const auto& user_id : user_ids) {
-            if (!user_id.is_number_integer()) continue;
-            
-            long uid = user_id.get<long>();
-            
-            // 检查用户是否已拥有该优惠券
-            std::string check_sql = "SELECT id FROM user_coupons WHERE user_id = " + std::to_string(uid) + 
-                                   " AND coupon_id = " + std::to_string(coupon_id);
-            json check_result = executeQuery(check_sql);
-            
-            if (check_result["success"].get<bool>() && !check_result["data"].empty()) {
-                failed_count++;
-                continue; // 用户已拥有,跳过
+        std::vector<long long> grant_users;
+        std::vector<std::vector<SqlParam>> grant_rows;
+        grant_users.reserve(target_users.size());
+        grant_rows.reserve(target_users.size());
+        for (long long uid : target_users) {
+            if (owners.count(uid) == 0) {
+                grant_users.push_back(uid);
+                grant_rows.push_back({uid, coupon_id, "unused"});
             }
-            
-            // 插入用户优惠券记录
-            std::string insert_sql = "INSERT INTO user_coupons (user_id, coupon_id, status, received_at) "
-                                    "VALUES (" + std::to_string(uid) + ", " + std::to_string(coupon_id) + ", 'unused', NOW())";
-            json insert_result = executeQuery(insert_sql);
-            
-            if (insert_result["success"].get<bool>()) {
-                success_count++;
-            } else {
-                failed_count++;
+        }
+        
+        // 多行INSERT批量写入用户优惠券记录，不存在的用户等失败行会被单独定位
+        static const std::vector<std::string> grant_columns = {"user_id", "coupon_id", "status"};
+        json insert_result = tx.bulkInsert("user_coupons", grant_columns, grant_rows);
+        if (!insert_result["success"].get<bool>()) {
+            return insert_result;
+        }
+        
+        json failed_user_ids = json::array();
+        const json& row_results = insert_result["data"]["row_results"];
+        for (size_t i = 0; i < grant_users.size(); ++i) {
+            if (!row_results[i].is_boolean() || !row_results[i].get<bool>()) {
+                failed_user_ids.push_back(grant_users[i]);
+            }
+        }
+        int success_count = static_cast<int>(insert_result["data"]["inserted"].get<long long>());
+        int failed_count = static_cast<int>(failed_user_ids.size());
+        
+        // 归还未发出的额度
+        if (success_count < requested) {
+            static const std::string release_sql = "UPDATE coupons SET used_quantity = used_quantity - ? "
+                                                   "WHERE coupon_id = ? AND used_quantity >= ?";
+            int unused = requested - success_count;
+            json release_result = tx.prepared(release_sql, {unused, coupon_id, unused});
+            if (!release_result["success"].get<bool>()) {
+                return release_result;
             }
         }
         
-        // 更新优惠券已使用数量
-        if (success_count > 0) {
-            std::string update_sql = "UPDATE coupons SET used_quantity = used_quantity + " + std::to_string(success_count) + 
-                                    " WHERE coupon_id = " + std::to_string(coupon_id);
-            executeQuery(update_sql);
+        if (!tx.commit()) {
+            return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
         }
+        // 批量分配是管理员写入，不逐个标记用户：大批量会挤满read-your-writes表，
+        // 把其他用户自己刚写入的标记淘汰掉；被分配的用户在副本延迟内即可看到
         
         json response_data;
         response_data["coupon_code"] = coupon_code;
         response_data["total_users"] = user_ids.size();
         response_data["success_count"] = success_count;
         response_data["failed_count"] = failed_count;
+        response_data["already_owned"] = owners.size();
+        response_data["failed_user_ids"] = std::move(failed_user_ids);
         
-        logInfo("批量分配优惠券完成，成功: " + std::to_string(success_count) + ", 失败: " + std::to_string(failed_count));
+        logInfo("批量分配优惠券完成，成功: " + std::to_string(success_count) + ", 失败: " + std::to_string(failed_count) +
+               ", 语句数: " + std::to_string(insert_result["data"]["statements"].get<int>()));
         return createSuccessResponse(response_data, "批量分配优惠券完成");
         
     } catch (const std::exception& e) {
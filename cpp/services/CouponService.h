@@ -19,9 +19,6 @@ using json = nlohmann::json;
  * @brief 优惠券服务类 - 管理优惠券的领取、分配和使用
  */
 class CouponService : public BaseService {
-private:
-    std::mutex coupon_mutex_; ///< 优惠券操作互斥锁
-
 public:
     /**
      * @brief 构造函数
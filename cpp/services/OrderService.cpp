@@ -7,54 +7,125 @@
 #include "OrderService.h"
 
 
-    const std::string& OrderService::getOrderIdColumnName() const {
-        static const std::string column = [this]() -> std::string {
-            if (hasColumn("orders", "order_id")) return "order_id";
-            if (hasColumn("orders", "id")) return "id";
-            return "order_id";
-        }();
-        return column;
-    }
+    // 按结构快照确定订单相关列名，并预先拼好固定的SELECT片段
+OrderService::OrderSchema OrderService::buildSchema(const SchemaSnapshot& snapshot) const {
+        auto has = [&snapshot](const char* column) { return snapshot.hasColumn("orders", column); };
+        OrderSchema schema;
+        schema.id_column = snapshot.firstColumn("orders", {"order_id", "id"}, "order_id");
+        schema.order_no_column = snapshot.firstColumn("orders", {"order_no"});
+        schema.created_column = snapshot.firstColumn("orders", {"created_at", "create_time"});
+        schema.updated_column = snapshot.firstColumn("orders", {"updated_at", "update_time"});
+        schema.user_column = snapshot.firstColumn("orders", {"user_id", "customer_id"}, "user_id");
+        schema.users_pk_column = snapshot.firstColumn("users", {"user_id", "id"}, "user_id");
+        schema.has_payment_status = has("payment_status");
+        schema.has_paid_at = has("paid_at");
+        schema.has_shipped_at = has("shipped_at");
+        schema.has_delivered_at = has("delivered_at");
 
-    const std::string& OrderService::getOrderNoColumnName() const {
-        static const std::string column = [this]() -> std::string {
-            if (hasColumn("orders", "order_no")) return "order_no";
-            return std::string();
-        }();
-        return column;
+        std::vector<std::string> admin_fields;
+        admin_fields.push_back(aliasColumn("o." + schema.id_column, "order_id"));
+        admin_fields.push_back(schema.order_no_column.empty() ? aliasColumn("", "order_no")
+                                                              : aliasColumn("o." + schema.order_no_column, "order_no"));
+        admin_fields.push_back(aliasColumn("o." + schema.user_column, "user_id"));
+        admin_fields.push_back(aliasColumn("u." + schema.users_pk_column, "user_table_id"));
+        admin_fields.push_back(aliasColumn("u.username", "username"));
+        if (has("total_amount")) {
+            admin_fields.push_back(aliasColumn("o.total_amount", "total_amount"));
+        }
+        if (has("discount_amount")) {
+            admin_fields.push_back(aliasColumn("o.discount_amount", "discount_amount"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "discount_amount"));
+        }
+        if (has("shipping_fee")) {
+            admin_fields.push_back(aliasColumn("o.shipping_fee", "shipping_fee"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "shipping_fee"));
+        }
+        if (has("final_amount")) {
+            admin_fields.push_back(aliasColumn("o.final_amount", "final_amount"));
+        }
+        if (has("status")) {
+            admin_fields.push_back(aliasColumn("o.status", "status"));
+        }
+        if (has("payment_status")) {
+            admin_fields.push_back(aliasColumn("o.payment_status", "payment_status"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "payment_status"));
+        }
+        if (has("payment_method")) {
+            admin_fields.push_back(aliasColumn("o.payment_method", "payment_method"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "payment_method"));
+        }
+        if (has("tracking_number")) {
+            admin_fields.push_back(aliasColumn("o.tracking_number", "tracking_number"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "tracking_number"));
+        }
+        if (has("shipping_method")) {
+            admin_fields.push_back(aliasColumn("o.shipping_method", "shipping_method"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "shipping_method"));
+        }
+        admin_fields.push_back(aliasColumn(schema.created_column.empty() ? std::string() : ("o." + schema.created_column), "created_at"));
+        admin_fields.push_back(aliasColumn(schema.updated_column.empty() ? std::string() : ("o." + schema.updated_column), "updated_at"));
+        if (has("paid_at")) {
+            admin_fields.push_back(aliasColumn("o.paid_at", "paid_at"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "paid_at"));
+        }
+        if (has("shipped_at")) {
+            admin_fields.push_back(aliasColumn("o.shipped_at", "shipped_at"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "shipped_at"));
+        }
+        if (has("delivered_at")) {
+            admin_fields.push_back(aliasColumn("o.delivered_at", "delivered_at"));
+        } else {
+            admin_fields.push_back(aliasColumn("", "delivered_at"));
+        }
+        if (has("remark")) {
+            admin_fields.push_back(aliasColumn("o.remark", "remark"));
+        }
+
+        schema.all_orders_select = "SELECT " + joinColumns(admin_fields) +
+                                   " FROM orders o LEFT JOIN users u ON o." + schema.user_column +
+                                   " = u." + schema.users_pk_column + " WHERE 1=1";
+
+        std::vector<std::string> user_fields = {
+            aliasColumn(schema.id_column, "order_id"),
+            aliasColumn(schema.order_no_column, "order_no"),
+            aliasColumn(has("total_amount") ? "total_amount" : std::string(), "total_amount"),
+            aliasColumn(has("discount_amount") ? "discount_amount" : std::string(), "discount_amount"),
+            aliasColumn(has("shipping_fee") ? "shipping_fee" : std::string(), "shipping_fee"),
+            aliasColumn(has("final_amount") ? "final_amount" : std::string(), "final_amount"),
+            aliasColumn(has("status") ? "status" : std::string(), "status"),
+            aliasColumn(has("payment_status") ? "payment_status" : std::string(), "payment_status"),
+            aliasColumn(schema.created_column, "created_at"),
+            aliasColumn(schema.updated_column, "updated_at")
+        };
+        schema.user_orders_select = "SELECT " + joinColumns(user_fields) + " FROM orders WHERE " +
+                                    schema.user_column + " = ";
+        return schema;
     }
 
-    const std::string& OrderService::getOrderCreatedAtColumnName() const {
-        static const std::string column = [this]() -> std::string {
-            if (hasColumn("orders", "created_at")) return "created_at";
-            if (hasColumn("orders", "create_time")) return "create_time";
-            return std::string();
-        }();
-        return column;
+    std::string OrderService::getOrderIdColumnName() const {
+        return schema_.get()->id_column;
     }
 
-    const std::string& OrderService::getOrderUpdatedAtColumnName() const {
-        static const std::string column = [this]() -> std::string {
-            if (hasColumn("orders", "updated_at")) return "updated_at";
-            if (hasColumn("orders", "update_time")) return "update_time";
-            return std::string();
-        }();
-        return column;
+    std::string OrderService::getOrderNoColumnName() const {
+        return schema_.get()->order_no_column;
     }
 
-    const std::string& OrderService::getUsersPrimaryKeyColumn() const {
-        static const std::string column = [this]() -> std::string {
-            if (hasColumn("users", "user_id")) return "user_id";
-            if (hasColumn("users", "id")) return "id";
-            return "user_id";
-        }();
-        return column;
+    std::string OrderService::getOrderCreatedAtColumnName() const {
+        return schema_.get()->created_column;
     }
 
-bool OrderService::orderHasColumn(const std::string& column) const {
-        return hasColumn("orders", column);
+    std::string OrderService::getOrderUpdatedAtColumnName() const {
+        return schema_.get()->updated_column;
     }
-    
+
     // 生成订单号
 std::string OrderService::generateOrderNo() {
         auto now = std::chrono::system_clock::now();
@@ -68,7 +139,10 @@ std::string OrderService::generateOrderNo() {
         return ss.str();
     }
     
-    OrderService::OrderService() : BaseService() {
+    OrderService::OrderService(ProductService& product_service)
+        : BaseService()
+        , product_service_(product_service)
+        , schema_([this](const SchemaSnapshot& snapshot) { return buildSchema(snapshot); }) {
         logInfo("订单服务初始化完成");
     }
     
@@ -78,18 +152,23 @@ std::string OrderService::getServiceName() const {
     
     // 从购物车创建订单
 json OrderService::createOrderFromCart(long user_id, long address_id, const std::string& coupon_code, const std::string& remark) {
+        TraceSpan span("order.create_from_cart", "service");
         logInfo("从购物车创建订单，用户ID: " + std::to_string(user_id));
         
-        std::lock_guard<std::mutex> lock(order_mutex_);
+        auto lock = userLocks().lock(user_id);
         
         if (user_id <= 0 || address_id <= 0) {
             return createErrorResponse("无效的用户ID或地址ID", Constants::VALIDATION_ERROR_CODE);
         }
         
         try {
-            // 开启事务
-            executeQuery("BEGIN");
-            bool needRollback = true; // 若提前return会在catch中ROLLBACK
+            // 购物车修改由后台写回，先把该用户尚未写回的修改落库再读cart表(持有用户锁，期间不会有新修改)
+            if (!CartStore::getInstance().flushUser(user_id)) {
+                return createErrorResponse("购物车同步失败，请稍后再试", Constants::DATABASE_ERROR_CODE);
+            }
+            
+            // 开启事务(整个下单过程使用同一连接，FOR UPDATE行锁持续到提交)
+            Transaction tx(*this);
             // 获取购物车内容
             std::string cart_sql = "SELECT c.product_id, c.quantity, c.selected, p.name, p.price, "
                                   "(c.quantity * p.price) as subtotal "
@@ -97,7 +176,7 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                                   "WHERE c.user_id = " + std::to_string(user_id) + 
                                   " AND c.selected = 1 AND p.status = 'active'";
             
-            json cart_result = executeQuery(cart_sql);
+            json cart_result = tx.query(cart_sql);
             if (!cart_result["success"].get<bool>() || cart_result["data"].empty()) {
                 return createErrorResponse("购物车为空或商品不可用", Constants::VALIDATION_ERROR_CODE);
             }
@@ -120,7 +199,7 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                 for (size_t i=0;i<productIds.size();++i) { if (i) oss << ","; oss << productIds[i]; }
                 oss << ") FOR UPDATE";  // 悲观锁：锁定这些行直到事务结束
                 
-                json stock_result = executeQuery(oss.str());
+                json stock_result = tx.query(oss.str());
                 if (!stock_result["success"].get<bool>()) {
                     return createErrorResponse("库存查询失败", Constants::DATABASE_ERROR_CODE);
                 }
@@ -174,7 +253,7 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                 std::string addr_sql = "SELECT receiver_name, receiver_phone, province, city, district, detail_address "
                                        "FROM user_addresses WHERE address_id = " + std::to_string(address_id) +
                                        " AND user_id = " + std::to_string(user_id) + " LIMIT 1";
-                json addr_result = executeQuery(addr_sql);
+                json addr_result = tx.query(addr_sql);
                 if (!addr_result["success"].get<bool>() || addr_result["data"].empty()) {
                     return createErrorResponse("地址不存在或不属于该用户", Constants::VALIDATION_ERROR_CODE);
                 }
@@ -201,11 +280,10 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
             if (!coupon_code.empty()) {
                 // 1. 首先查询优惠券基本信息
                 std::string coup_sql = "SELECT coupon_id, code, type, value, min_amount, start_time, end_time, status "
-                                       "FROM coupons WHERE code = '" + escapeSQLString(coupon_code) + "' LIMIT 1";
-                json coup_result = executeQuery(coup_sql);
+                                       "FROM coupons WHERE code = '" + tx.escape(coupon_code) + "' LIMIT 1";
+                json coup_result = tx.query(coup_sql);
                 
                 if (!coup_result["success"].get<bool>() || coup_result["data"].empty()) {
-                    executeQuery("ROLLBACK");
                     return createErrorResponse("优惠券不存在: " + coupon_code, Constants::VALIDATION_ERROR_CODE);
                 }
                 
@@ -215,7 +293,6 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                 std::string coupon_status = c.contains("status") && c["status"].is_string() ? 
                                           c["status"].get<std::string>() : "inactive";
                 if (coupon_status != "active") {
-                    executeQuery("ROLLBACK");
                     return createErrorResponse("优惠券已失效", Constants::VALIDATION_ERROR_CODE);
                 }
                 
@@ -229,7 +306,6 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                 }
                 
                 if (coupon_id_used == 0) {
-                    executeQuery("ROLLBACK");
                     return createErrorResponse("优惠券ID无效", Constants::VALIDATION_ERROR_CODE);
                 }
                 
@@ -238,10 +314,9 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                                              "WHERE user_id = " + std::to_string(user_id) + 
                                              " AND coupon_id = " + std::to_string(coupon_id_used) + 
                                              " AND status = 'unused' LIMIT 1";
-                json user_coupon_result = executeQuery(user_coupon_sql);
+                json user_coupon_result = tx.query(user_coupon_sql);
                 
                 if (!user_coupon_result["success"].get<bool>() || user_coupon_result["data"].empty()) {
-                    executeQuery("ROLLBACK");
                     return createErrorResponse("您没有该优惠券或优惠券已使用", Constants::VALIDATION_ERROR_CODE);
                 }
                 
@@ -255,7 +330,6 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                 }
                 
                 if (user_coupon_id == 0) {
-                    executeQuery("ROLLBACK");
                     return createErrorResponse("用户优惠券记录无效", Constants::VALIDATION_ERROR_CODE);
                 }
                 
@@ -277,7 +351,6 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                 }
                 
                 if (total_amount < minAmt) {
-                    executeQuery("ROLLBACK");
                     return createErrorResponse("订单金额不满足优惠券使用条件(最低:" + 
                                              std::to_string(minAmt) + "元)", Constants::VALIDATION_ERROR_CODE);
                 }
@@ -306,27 +379,35 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                                    "status, payment_status, shipping_address, remark) VALUES ('" +
                                    order_no + "', " + std::to_string(user_id) + ", " +
                                    std::to_string(total_amount) + ", " + std::to_string(discount_amount) + ", " + std::to_string(final_amount) + 
-                                   ", 'pending', 'unpaid', JSON_QUOTE('" + escapeSQLString(shipping_address) + "'), '" + escapeSQLString(remark) + "')";
+                                   ", 'pending', 'unpaid', JSON_QUOTE('" + tx.escape(shipping_address) + "'), '" + tx.escape(remark) + "')";
             
-            json order_result = executeQuery(order_sql);
+            json order_result = tx.query(order_sql);
             if (!order_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
                 return order_result;
             }
             
             long order_id = order_result["data"]["insert_id"].get<long>();
             
-            // 创建订单明细
+            // 创建订单明细(多行INSERT一次写入)
+            std::vector<std::vector<SqlParam>> item_rows;
+            item_rows.reserve(cart_result["data"].size());
             for (const auto& item : cart_result["data"]) {
-                std::string item_sql = "INSERT INTO order_items (order_id, product_id, product_name, "
-                                      "price, quantity, subtotal) VALUES (" +
-                                      std::to_string(order_id) + ", " +
-                                      std::to_string(item["product_id"].get<long>()) + ", '" +
-                                      item["name"].get<std::string>() + "', " +
-                                      std::to_string(item["price"].get<double>()) + ", " +
-                                      std::to_string(item["quantity"].get<int>()) + ", " +
-                                      std::to_string(item["subtotal"].get<double>()) + ")";
-                executeQuery(item_sql);
+                item_rows.push_back({order_id,
+                                     item["product_id"].get<long>(),
+                                     item["name"].get<std::string>(),
+                                     item["price"].get<double>(),
+                                     item["quantity"].get<int>(),
+                                     item["subtotal"].get<double>()});
+            }
+            static const std::vector<std::string> item_columns = {
+                "order_id", "product_id", "product_name", "price", "quantity", "subtotal"};
+            json items_result = tx.bulkInsert("order_items", item_columns, item_rows);
+            if (!items_result["success"].get<bool>()) {
+                return items_result;
+            }
+            if (items_result["data"]["failed"].get<long long>() > 0) {
+                logError("写入订单明细失败: " + items_result["data"].value("last_error", std::string()));
+                return createErrorResponse("创建订单明细失败", Constants::DATABASE_ERROR_CODE);
             }
 
             // 创建订单时不扣减库存,只记录库存信息(库存将在支付时扣减)
@@ -336,7 +417,7 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                 
                 // 查询当前库存
                 std::string qsql = "SELECT stock_quantity FROM products WHERE product_id = " + std::to_string(pid) + " LIMIT 1";
-                json qres = executeQuery(qsql);
+                json qres = tx.query(qsql);
                 int remain = -1;
                 if (qres["success"].get<bool>() && !qres["data"].empty()) {
                     auto row = qres["data"][0];
@@ -353,9 +434,8 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
                 std::string mark_used_sql = "UPDATE user_coupons SET status = 'used', " 
                                           "order_id = " + std::to_string(order_id) + 
                                           ", used_at = NOW() WHERE id = " + std::to_string(user_coupon_id);
-                json mark_result = executeQuery(mark_used_sql);
+                json mark_result = tx.query(mark_used_sql);
                 if (!mark_result["success"].get<bool>()) {
-                    executeQuery("ROLLBACK");
                     logError("标记优惠券失败: user_coupon_id=" + std::to_string(user_coupon_id));
                     return createErrorResponse("标记优惠券失败", Constants::DATABASE_ERROR_CODE);
                 }
@@ -365,7 +445,7 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
             
             // 清空购物车
             std::string clear_cart_sql = "DELETE FROM cart WHERE user_id = " + std::to_string(user_id);
-            executeQuery(clear_cart_sql);
+            tx.query(clear_cart_sql);
             
             json response_data;
             response_data["order_id"] = order_id;
@@ -382,29 +462,53 @@ json OrderService::createOrderFromCart(long user_id, long address_id, const std:
             }
             
             // 提交事务
-            executeQuery("COMMIT");
-            needRollback = false;
+            if (!tx.commit()) {
+                return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
+            }
+            CartStore::getInstance().markPersistedEmpty(user_id);
+            markUserWrite(user_id);
             logInfo("订单创建成功，订单ID: " + std::to_string(order_id));
             return createSuccessResponse(response_data, "订单创建成功");
             
         } catch (const std::exception& e) {
-            try { executeQuery("ROLLBACK"); } catch(...) {}
             return createErrorResponse("创建订单异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
         }
     }
     
+    // 一键结算：选出收货地址后走与createOrderFromCart相同的下单流程(用户锁、写回购物车、库存扣减)
+json OrderService::checkout(long user_id) {
+        if (user_id <= 0) {
+            return createErrorResponse("无效的用户ID", Constants::VALIDATION_ERROR_CODE);
+        }
+        // 在主库上读取：用户可能刚添加第一个地址，副本上还看不到
+        static const std::string address_sql = "SELECT address_id FROM user_addresses WHERE user_id = ? "
+                                               "ORDER BY is_default DESC, address_id DESC LIMIT 1";
+        json address_result = executePrepared(address_sql, {user_id});
+        if (!address_result["success"].get<bool>()) {
+            return address_result;
+        }
+        if (address_result["data"].empty()) {
+            return createErrorResponse("请先添加收货地址", Constants::VALIDATION_ERROR_CODE);
+        }
+        long address_id = address_result["data"][0]["address_id"].get<long>();
+        return createOrderFromCart(user_id, address_id, "", "");
+    }
+    
     // 直接购买创建订单（不依赖购物车，或用于仅选中单个条目下单）
 json OrderService::createOrderDirect(long user_id, long product_id, int quantity, long address_id, const std::string& coupon_code, const std::string& remark) {
+        TraceSpan span("order.create_direct", "service");
         logInfo("直接创建订单，用户ID: " + std::to_string(user_id) + ", 商品ID: " + std::to_string(product_id) + ", 数量: " + std::to_string(quantity));
-        std::lock_guard<std::mutex> lock(order_mutex_);
+        auto lock = userLocks().lock(user_id);
         if (user_id <= 0 || address_id <= 0 || product_id <= 0 || quantity <= 0) {
             return createErrorResponse("无效的下单参数", Constants::VALIDATION_ERROR_CODE);
         }
         try {
+            Transaction tx(*this);
+            
             // 查询商品信息（加锁防止并发）
             std::string prod_sql = "SELECT product_id, name, price, status, stock_quantity FROM products WHERE product_id = " + 
                                   std::to_string(product_id) + " FOR UPDATE";
-            json prod_result = executeQuery(prod_sql);
+            json prod_result = tx.query(prod_sql);
             
             if (!prod_result["success"].get<bool>() || prod_result["data"].empty()) {
                 return createErrorResponse("商品不存在", Constants::VALIDATION_ERROR_CODE);
@@ -445,7 +549,7 @@ json OrderService::createOrderDirect(long user_id, long product_id, int quantity
                 std::string addr_sql = "SELECT receiver_name, receiver_phone, province, city, district, detail_address "
                                        "FROM user_addresses WHERE address_id = " + std::to_string(address_id) +
                                        " AND user_id = " + std::to_string(user_id) + " LIMIT 1";
-                json addr_result = executeQuery(addr_sql);
+                json addr_result = tx.query(addr_sql);
                 if (!addr_result["success"].get<bool>() || addr_result["data"].empty()) {
                     return createErrorResponse("地址不存在或不属于该用户", Constants::VALIDATION_ERROR_CODE);
                 }
@@ -472,8 +576,8 @@ json OrderService::createOrderDirect(long user_id, long product_id, int quantity
             if (!coupon_code.empty()) {
                 // 1. 查询优惠券基本信息(验证存在和active状态)
                 std::string coup_sql = "SELECT coupon_id, code, type, value, min_amount, start_time, end_time, status "
-                                       "FROM coupons WHERE code = '" + escapeSQLString(coupon_code) + "' LIMIT 1";
-                json coup_result = executeQuery(coup_sql);
+                                       "FROM coupons WHERE code = '" + tx.escape(coupon_code) + "' LIMIT 1";
+                json coup_result = tx.query(coup_sql);
                 
                 if (!coup_result["success"].get<bool>() || coup_result["data"].empty()) {
                     return createErrorResponse("优惠券不存在: " + coupon_code, Constants::VALIDATION_ERROR_CODE);
@@ -500,7 +604,7 @@ json OrderService::createOrderDirect(long user_id, long product_id, int quantity
                                              "WHERE user_id = " + std::to_string(user_id) + 
                                              " AND coupon_id = " + std::to_string(coupon_id_used) + 
                                              " AND status = 'unused' LIMIT 1";
-                json user_coupon_result = executeQuery(user_coupon_sql);
+                json user_coupon_result = tx.query(user_coupon_sql);
                 
                 if (!user_coupon_result["success"].get<bool>() || user_coupon_result["data"].empty()) {
                     return createErrorResponse("您没有该优惠券或优惠券已使用", Constants::VALIDATION_ERROR_CODE);
@@ -562,11 +666,9 @@ json OrderService::createOrderDirect(long user_id, long product_id, int quantity
             std::string order_sql = "INSERT INTO orders (order_no, user_id, total_amount, discount_amount, final_amount, status, payment_status, shipping_address, remark) VALUES ('" +
                                    order_no + "', " + std::to_string(user_id) + ", " +
                                    std::to_string(total_amount) + ", " + std::to_string(discount_amount) + ", " + std::to_string(final_amount) +
-                                   ", 'pending', 'unpaid', JSON_QUOTE('" + escapeSQLString(shipping_address) + "'), '" + escapeSQLString(remark) + "')";
-            executeQuery("BEGIN");
-            json order_result = executeQuery(order_sql);
+                                   ", 'pending', 'unpaid', JSON_QUOTE('" + tx.escape(shipping_address) + "'), '" + tx.escape(remark) + "')";
+            json order_result = tx.query(order_sql);
             if (!order_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
                 return order_result;
             }
             long order_id = order_result["data"]["insert_id"].get<long>();
@@ -574,18 +676,20 @@ json OrderService::createOrderDirect(long user_id, long product_id, int quantity
             // 插入订单明细
             std::string item_sql = "INSERT INTO order_items (order_id, product_id, product_name, price, quantity, subtotal) VALUES (" +
                                    std::to_string(order_id) + ", " +
-                                   std::to_string(product_id) + ", '" + escapeSQLString(product_name) + "', " +
+                                   std::to_string(product_id) + ", '" + tx.escape(product_name) + "', " +
                                    std::to_string(unit_price) + ", " + std::to_string(quantity) + ", " + std::to_string(subtotal) + ")";
-            executeQuery(item_sql);
+            json item_result = tx.query(item_sql);
+            if (!item_result["success"].get<bool>()) {
+                return createErrorResponse("创建订单明细失败", Constants::DATABASE_ERROR_CODE);
+            }
 
             // 标记优惠券为已使用
             if (user_coupon_id > 0) {
                 std::string mark_used_sql = "UPDATE user_coupons SET status = 'used', " 
                                           "order_id = " + std::to_string(order_id) + 
                                           ", used_at = NOW() WHERE id = " + std::to_string(user_coupon_id);
-                json mark_result = executeQuery(mark_used_sql);
+                json mark_result = tx.query(mark_used_sql);
                 if (!mark_result["success"].get<bool>()) {
-                    executeQuery("ROLLBACK");
                     logError("标记优惠券失败: user_coupon_id=" + std::to_string(user_coupon_id));
                     return createErrorResponse("标记优惠券失败", Constants::DATABASE_ERROR_CODE);
                 }
@@ -611,7 +715,7 @@ json OrderService::createOrderDirect(long user_id, long product_id, int quantity
             // 创建订单时不扣减库存,只查询当前库存(库存将在支付时扣减)
             int remaining_stock = -1;{
                 std::string qsql = "SELECT stock_quantity FROM products WHERE product_id = " + std::to_string(product_id) + " LIMIT 1";
-                json qres = executeQuery(qsql);
+                json qres = tx.query(qsql);
                 if (qres["success"].get<bool>() && !qres["data"].empty()) {
                     auto row = qres["data"][0];
                     if (row.contains("stock_quantity") && row["stock_quantity"].is_number_integer()) remaining_stock = row["stock_quantity"].get<int>();
@@ -621,11 +725,13 @@ json OrderService::createOrderDirect(long user_id, long product_id, int quantity
             stock_changes.push_back({ {"product_id", product_id}, {"quantity_reserved", quantity}, {"current_stock", remaining_stock} });
             response_data["stock_changes"] = stock_changes;
 
-            executeQuery("COMMIT");
+            if (!tx.commit()) {
+                return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
+            }
+            markUserWrite(user_id);
             logInfo("直接订单创建成功(库存将在支付时扣减)，订单ID: " + std::to_string(order_id));
             return createSuccessResponse(response_data, "订单创建成功");
         } catch (const std::exception& e) {
-            try { executeQuery("ROLLBACK"); } catch(...) {}
             return createErrorResponse("创建订单异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
         }
     }
@@ -639,12 +745,12 @@ json OrderService::getUserOrders(long user_id) {
         }
         
         try {
-            std::string sql = "SELECT order_id, order_no, total_amount, discount_amount, "
-                             "shipping_fee, final_amount, status, payment_status, "
-                             "created_at, updated_at FROM orders WHERE user_id = " +
-                             std::to_string(user_id) + " ORDER BY created_at DESC";
+            static const std::string sql = "SELECT order_id, order_no, total_amount, discount_amount, "
+                                           "shipping_fee, final_amount, status, payment_status, "
+                                           "created_at, updated_at FROM orders WHERE user_id = ? "
+                                           "ORDER BY created_at DESC";
             
-            json result = executeQuery(sql);
+            json result = executeReadPrepared(sql, {user_id}, user_id);
             if (result["success"].get<bool>()) {
                 json response_data;
                 response_data["user_id"] = user_id;
@@ -670,16 +776,16 @@ json OrderService::getOrderDetail(long order_id) {
         
         try {
             // 获取订单基本信息
-            std::string order_sql = "SELECT * FROM orders WHERE order_id = " + std::to_string(order_id);
-            json order_result = executeQuery(order_sql);
+            static const std::string order_sql = "SELECT * FROM orders WHERE order_id = ?";
+            json order_result = executePrepared(order_sql, {order_id});
             
             if (!order_result["success"].get<bool>() || order_result["data"].empty()) {
                 return createErrorResponse("订单不存在", Constants::VALIDATION_ERROR_CODE);
             }
             
             // 获取订单明细
-            std::string items_sql = "SELECT * FROM order_items WHERE order_id = " + std::to_string(order_id);
-            json items_result = executeQuery(items_sql);
+            static const std::string items_sql = "SELECT * FROM order_items WHERE order_id = ?";
+            json items_result = executePrepared(items_sql, {order_id});
             
             json response_data = order_result["data"][0];
             response_data["items"] = items_result["success"].get<bool>() ? items_result["data"] : json::array();
@@ -725,17 +831,19 @@ json OrderService::deleteOrder(long order_id) {
 json OrderService::payOrder(long order_id, const std::string& payment_method) {
         logInfo("支付订单，订单ID: " + std::to_string(order_id) + ", 支付方式: " + payment_method);
         
-        std::lock_guard<std::mutex> lock(order_mutex_);
+        auto lock = orderLocks().lock(order_id);
         
         if (order_id <= 0) {
             return createErrorResponse("无效的订单ID", Constants::VALIDATION_ERROR_CODE);
         }
         
         try {
-            // 检查订单状态
+            Transaction tx(*this);
+            
+            // 检查订单状态(锁定订单行直到提交)
             std::string check_sql = "SELECT status, payment_status FROM orders WHERE order_id = " + 
-                                   std::to_string(order_id);
-            json check_result = executeQuery(check_sql);
+                                   std::to_string(order_id) + " FOR UPDATE";
+            json check_result = tx.query(check_sql);
             
             if (!check_result["success"].get<bool>() || check_result["data"].empty()) {
                 return createErrorResponse("订单不存在", Constants::VALIDATION_ERROR_CODE);
@@ -755,18 +863,14 @@ json OrderService::payOrder(long order_id, const std::string& payment_method) {
             // 模拟支付处理（实际项目中这里会调用第三方支付接口）
             std::string transaction_id = generateTransactionId();
             
-            // 开启事务
-            executeQuery("BEGIN");
-            
             // 更新订单状态
             std::string update_sql = "UPDATE orders SET status = 'paid', payment_status = 'paid', "
                                    "payment_method = '" + payment_method + "', "
                                    "paid_at = NOW(), updated_at = NOW() "
                                    "WHERE order_id = " + std::to_string(order_id);
             
-            json result = executeQuery(update_sql);
+            json result = tx.query(update_sql);
             if (!result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
                 return result;
             }
             
@@ -777,7 +881,7 @@ json OrderService::payOrder(long order_id, const std::string& payment_method) {
                                    "JOIN orders o ON oi.order_id = o.order_id "
                                    "WHERE oi.order_id = " + std::to_string(order_id);
             logInfo("查询订单明细SQL: " + items_sql);
-            json items_result = executeQuery(items_sql);
+            json items_result = tx.query(items_sql);
             
             // 记录查询结果
             logInfo("订单明细查询结果: success=" + std::to_string(items_result["success"].get<bool>()) + 
@@ -785,13 +889,11 @@ json OrderService::payOrder(long order_id, const std::string& payment_method) {
             
             if (!items_result["success"].get<bool>()) {
                 logError("查询订单明细失败: order_id=" + std::to_string(order_id));
-                executeQuery("ROLLBACK");
                 return createErrorResponse("查询订单明细失败", Constants::DATABASE_ERROR_CODE);
             }
             
             if (items_result["data"].empty()) {
                 logError("订单明细为空: order_id=" + std::to_string(order_id));
-                executeQuery("ROLLBACK");
                 return createErrorResponse("订单明细为空", Constants::DATABASE_ERROR_CODE);
             }
             
@@ -813,13 +915,12 @@ json OrderService::payOrder(long order_id, const std::string& payment_method) {
                     "'valid')";
                 
                 logInfo("插入购买记录SQL: " + purchase_record_sql);
-                json record_result = executeQuery(purchase_record_sql);
+                json record_result = tx.query(purchase_record_sql);
                 
                 if (!record_result["success"].get<bool>()) {
                     logError("创建购买记录失败: user_id=" + std::to_string(user_id) + 
                              ", product_id=" + std::to_string(pid) + 
                              ", error=" + (record_result.contains("message") ? record_result["message"].get<std::string>() : "unknown"));
-                    executeQuery("ROLLBACK");
                     return createErrorResponse("创建购买记录失败", Constants::DATABASE_ERROR_CODE);
                 } else {
                     logInfo("购买记录已创建: user_id=" + std::to_string(user_id) + 
@@ -830,7 +931,10 @@ json OrderService::payOrder(long order_id, const std::string& payment_method) {
             }
             
             // 提交事务
-            executeQuery("COMMIT");
+            if (!tx.commit()) {
+                return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
+            }
+            markUserWrite(user_id);
             
             json response_data;
             response_data["order_id"] = order_id;
@@ -864,7 +968,7 @@ std::string OrderService::generateTransactionId() {
 json OrderService::shipOrder(long order_id, const std::string& tracking_number, const std::string& shipping_method) {
         logInfo("发货订单，订单ID: " + std::to_string(order_id) + ", 快递单号: " + tracking_number);
         
-        std::lock_guard<std::mutex> lock(order_mutex_);
+        auto lock = orderLocks().lock(order_id);
         
         if (order_id <= 0) {
             return createErrorResponse("无效的订单ID", Constants::VALIDATION_ERROR_CODE);
@@ -925,7 +1029,7 @@ json OrderService::shipOrder(long order_id, const std::string& tracking_number,
 json OrderService::confirmDelivery(long order_id) {
         logInfo("确认收货，订单ID: " + std::to_string(order_id));
         
-        std::lock_guard<std::mutex> lock(order_mutex_);
+        auto lock = orderLocks().lock(order_id);
         
         if (order_id <= 0) {
             return createErrorResponse("无效的订单ID", Constants::VALIDATION_ERROR_CODE);
@@ -972,7 +1076,7 @@ json OrderService::confirmDelivery(long order_id) {
 json OrderService::requestRefund(long order_id, long user_id, const std::string& reason) {
         logInfo("用户申请退款，订单ID: " + std::to_string(order_id) + ", 用户ID: " + std::to_string(user_id) + ", 原因: " + reason);
         
-        std::lock_guard<std::mutex> lock(order_mutex_);
+        auto lock = orderLocks().lock(order_id);
         
         if (order_id <= 0 || user_id <= 0) {
             return createErrorResponse("无效的订单ID或用户ID", Constants::VALIDATION_ERROR_CODE);
@@ -982,34 +1086,21 @@ json OrderService::requestRefund(long order_id, long user_id, const std::string&
             return createErrorResponse("退款原因不能为空", Constants::VALIDATION_ERROR_CODE);
         }
         
-        // 使用ConnectionGuard管理单一连接,确保事务在同一连接上执行
         try {
-            ConnectionGuard conn(db_pool_);
-            if (!conn.isValid()) {
-                logError("数据库连接无效");
-                return createErrorResponse("数据库连接失败", Constants::DATABASE_ERROR_CODE);
-            }
-            
-            // 开启事务
-            json begin_result = executeQueryWithConnection(conn.get(), "START TRANSACTION");
-            if (!begin_result["success"].get<bool>()) {
-                logError("开启事务失败");
-                return createErrorResponse("数据库事务启动失败", Constants::DATABASE_ERROR_CODE);
-            }
+            // 开启事务(固定使用同一连接)
+            Transaction tx(*this);
             
             // 检查订单状态和归属
             std::string check_sql = "SELECT status, payment_status, total_amount, user_id FROM orders WHERE order_id = " + 
                                    std::to_string(order_id) + " FOR UPDATE";
-            json check_result = executeQueryWithConnection(conn.get(), check_sql);
+            json check_result = tx.query(check_sql);
             
             if (!check_result["success"].get<bool>() || check_result["data"].empty()) {
-                executeQueryWithConnection(conn.get(), "ROLLBACK");
                 return createErrorResponse("订单不存在", Constants::VALIDATION_ERROR_CODE);
             }
             
             long order_user_id = check_result["data"][0]["user_id"].get<long>();
             if (order_user_id != user_id) {
-                executeQueryWithConnection(conn.get(), "ROLLBACK");
                 return createErrorResponse("无权操作此订单", Constants::UNAUTHORIZED_CODE);
             }
             
@@ -1026,32 +1117,28 @@ json OrderService::requestRefund(long order_id, long user_id, const std::string&
                            payment_status == "paid");
             
             if (!is_paid) {
-                executeQueryWithConnection(conn.get(), "ROLLBACK");
                 return createErrorResponse("订单未支付，无法申请退款", Constants::VALIDATION_ERROR_CODE);
             }
             
             if (current_status == "cancelled" || current_status == "refunded" || current_status == "refunding") {
-                executeQueryWithConnection(conn.get(), "ROLLBACK");
                 return createErrorResponse("订单状态不允许申请退款", Constants::VALIDATION_ERROR_CODE);
             }
             
             // 检查是否已有待审核的退款申请
             std::string check_refund_sql = "SELECT refund_id FROM refund_requests WHERE order_id = " + 
                                           std::to_string(order_id) + " AND status = 'pending'";
-            json check_refund_result = executeQueryWithConnection(conn.get(), check_refund_sql);
+            json check_refund_result = tx.query(check_refund_sql);
             
             if (check_refund_result["success"].get<bool>() && !check_refund_result["data"].empty()) {
-                executeQueryWithConnection(conn.get(), "ROLLBACK");
                 return createErrorResponse("该订单已有待审核的退款申请", Constants::VALIDATION_ERROR_CODE);
             }
             
             // 检查是否已有被拒绝的退款申请
             std::string check_rejected_sql = "SELECT refund_id, admin_reply FROM refund_requests WHERE order_id = " + 
                                             std::to_string(order_id) + " AND status = 'rejected'";
-            json check_rejected_result = executeQueryWithConnection(conn.get(), check_rejected_sql);
+            json check_rejected_result = tx.query(check_rejected_sql);
             
             if (check_rejected_result["success"].get<bool>() && !check_rejected_result["data"].empty()) {
-                executeQueryWithConnection(conn.get(), "ROLLBACK");
                 std::string admin_reply = "";
                 if (check_rejected_result["data"][0].contains("admin_reply") && 
                     !check_rejected_result["data"][0]["admin_reply"].is_null()) {
@@ -1067,21 +1154,19 @@ json OrderService::requestRefund(long order_id, long user_id, const std::string&
             // 创建退款申请记录
             std::string insert_refund_sql = "INSERT INTO refund_requests (order_id, user_id, reason, refund_amount, status, created_at) "
                                            "VALUES (" + std::to_string(order_id) + ", " + std::to_string(user_id) + ", '" + 
-                                           escapeSQLString(reason) + "', " + std::to_string(total_amount) + ", 'pending', NOW())";
-            json insert_result = executeQueryWithConnection(conn.get(), insert_refund_sql);
+                                           tx.escape(reason) + "', " + std::to_string(total_amount) + ", 'pending', NOW())";
+            json insert_result = tx.query(insert_refund_sql);
             
             if (!insert_result["success"].get<bool>()) {
-                executeQueryWithConnection(conn.get(), "ROLLBACK");
                 logError("创建退款申请失败: " + insert_result["message"].get<std::string>());
                 return createErrorResponse("创建退款申请失败", Constants::DATABASE_ERROR_CODE);
             }
             
             // 更新订单状态为refunding
             std::string update_sql = "UPDATE orders SET status = 'refunding', updated_at = NOW() WHERE order_id = " + std::to_string(order_id);
-            json update_result = executeQueryWithConnection(conn.get(), update_sql);
+            json update_result = tx.query(update_sql);
             
             if (!update_result["success"].get<bool>()) {
-                executeQueryWithConnection(conn.get(), "ROLLBACK");
                 std::string error_msg = "更新订单状态失败";
                 if (update_result.contains("message") && !update_result["message"].is_null()) {
                     error_msg += ": " + update_result["message"].get<std::string>();
@@ -1097,13 +1182,11 @@ json OrderService::requestRefund(long order_id, long user_id, const std::string&
             }
             
             // 提交事务
-            json commit_result = executeQueryWithConnection(conn.get(), "COMMIT");
-            
-            if (!commit_result["success"].get<bool>()) {
+            if (!tx.commit()) {
                 logError("提交事务失败");
-                executeQueryWithConnection(conn.get(), "ROLLBACK");  // 尝试回滚
                 return createErrorResponse("退款申请提交失败", Constants::DATABASE_ERROR_CODE);
             }
+            markUserWrite(user_id);
             
             // 事务提交成功后,在事务外创建通知(避免通知失败导致事务回滚)
             try {
@@ -1135,37 +1218,35 @@ json OrderService::requestRefund(long order_id, long user_id, const std::string&
 json OrderService::cancelOrder(long order_id, const std::string& reason) {
         logInfo("取消订单，订单ID: " + std::to_string(order_id));
         
-        std::lock_guard<std::mutex> lock(order_mutex_);
+        auto lock = orderLocks().lock(order_id);
         
         try {
             // 开启事务
-            executeQuery("BEGIN");
+            Transaction tx(*this);
             
             // 检查订单状态
-            std::string check_sql = "SELECT status, payment_status FROM orders WHERE order_id = " + 
+            std::string check_sql = "SELECT status, payment_status, user_id FROM orders WHERE order_id = " + 
                                    std::to_string(order_id) + " FOR UPDATE";
-            json check_result = executeQuery(check_sql);
+            json check_result = tx.query(check_sql);
             
             if (!check_result["success"].get<bool>() || check_result["data"].empty()) {
-                executeQuery("ROLLBACK");
                 return createErrorResponse("订单不存在", Constants::VALIDATION_ERROR_CODE);
             }
             
             std::string current_status = check_result["data"][0]["status"].get<std::string>();
+            long order_user_id = check_result["data"][0]["user_id"].get<long>();
             
             // 只允许pending和confirmed状态的订单取消
             if (current_status != "pending" && current_status != "confirmed") {
-                executeQuery("ROLLBACK");
                 return createErrorResponse("订单状态不允许取消", Constants::VALIDATION_ERROR_CODE);
             }
             
             // 更新订单状态
             std::string update_sql = "UPDATE orders SET status = 'cancelled', updated_at = NOW() "
                                    "WHERE order_id = " + std::to_string(order_id);
-            json update_result = executeQuery(update_sql);
+            json update_result = tx.query(update_sql);
             
             if (!update_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
                 return update_result;
             }
             
@@ -1173,7 +1254,7 @@ json OrderService::cancelOrder(long order_id, const std::string& reason) {
             std::string coupon_check_sql = "SELECT id, coupon_id FROM user_coupons "
                                           "WHERE order_id = " + std::to_string(order_id) + 
                                           " AND status = 'used' LIMIT 1";
-            json coupon_check_result = executeQuery(coupon_check_sql);
+            json coupon_check_result = tx.query(coupon_check_sql);
             
             if (coupon_check_result["success"].get<bool>() && !coupon_check_result["data"].empty()) {
                 auto coupon_data = coupon_check_result["data"][0];
@@ -1184,10 +1265,9 @@ json OrderService::cancelOrder(long order_id, const std::string& reason) {
                 std::string restore_coupon_sql = "UPDATE user_coupons SET status = 'unused', "
                                                 "order_id = NULL, used_at = NULL "
                                                 "WHERE id = " + std::to_string(user_coupon_id);
-                json restore_coupon_result = executeQuery(restore_coupon_sql);
+                json restore_coupon_result = tx.query(restore_coupon_sql);
                 
                 if (!restore_coupon_result["success"].get<bool>()) {
-                    executeQuery("ROLLBACK");
                     logError("恢复优惠券失败: user_coupon_id=" + std::to_string(user_coupon_id));
                     return createErrorResponse("恢复优惠券失败", Constants::DATABASE_ERROR_CODE);
                 }
@@ -1199,27 +1279,28 @@ json OrderService::cancelOrder(long order_id, const std::string& reason) {
             // 返还库存 - 查询订单明细
             std::string items_sql = "SELECT product_id, quantity FROM order_items WHERE order_id = " + 
                                    std::to_string(order_id);
-            json items_result = executeQuery(items_sql);
+            json items_result = tx.query(items_sql);
             
+            std::vector<long> restored_products;
             if (items_result["success"].get<bool>() && !items_result["data"].empty()) {
                 for (const auto& item : items_result["data"]) {
                     long product_id = item["product_id"].get<long>();
                     int quantity = item["quantity"].get<int>();
+                    restored_products.push_back(product_id);
                     
                     // 返还库存
                     std::string restore_sql = "UPDATE products SET stock_quantity = stock_quantity + " + 
                                             std::to_string(quantity) + 
                                             ", updated_at = NOW() WHERE product_id = " + 
                                             std::to_string(product_id);
-                    json restore_result = executeQuery(restore_sql);
+                    json restore_result = tx.query(restore_sql);
                     
                     if (!restore_result["success"].get<bool>()) {
-                        executeQuery("ROLLBACK");
                         return createErrorResponse("库存返还失败", Constants::DATABASE_ERROR_CODE);
                     }
                     
                     // 记录库存变动日志
-                    logStockChange(product_id, quantity, "order_canceled", "order", order_id, 0);
+                    logStockChange(product_id, quantity, "order_canceled", "order", order_id, 0, &tx);
                     
                     logInfo("返还库存: 商品ID=" + std::to_string(product_id) + 
                            ", 数量=" + std::to_string(quantity));
@@ -1227,7 +1308,11 @@ json OrderService::cancelOrder(long order_id, const std::string& reason) {
             }
             
             // 提交事务
-            executeQuery("COMMIT");
+            if (!tx.commit()) {
+                return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
+            }
+            product_service_.invalidateStockCache(restored_products);
+            markUserWrite(order_user_id);
             
             json response_data;
             response_data["order_id"] = order_id;
@@ -1238,7 +1323,6 @@ json OrderService::cancelOrder(long order_id, const std::string& reason) {
             return createSuccessResponse(response_data, "订单取消成功");
             
         } catch (const std::exception& e) {
-            try { executeQuery("ROLLBACK"); } catch(...) {}
             return createErrorResponse("取消订单异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
         }
     }
@@ -1247,7 +1331,7 @@ json OrderService::cancelOrder(long order_id, const std::string& reason) {
 json OrderService::updateOrderStatus(long order_id, const std::string& new_status) {
         logInfo("更新订单状态，订单ID: " + std::to_string(order_id) + ", 新状态: " + new_status);
         
-        std::lock_guard<std::mutex> lock(order_mutex_);
+        auto lock = orderLocks().lock(order_id);
         
         if (order_id <= 0) {
             return createErrorResponse("无效的订单ID", Constants::VALIDATION_ERROR_CODE);
@@ -1263,9 +1347,10 @@ json OrderService::updateOrderStatus(long order_id, const std::string& new_statu
         }
         
         try {
-            const std::string& id_column = getOrderIdColumnName();
-            const std::string& updated_column = getOrderUpdatedAtColumnName();
-            bool has_payment_status = orderHasColumn("payment_status");
+            std::shared_ptr<const OrderSchema> schema = schema_.get();
+            const std::string& id_column = schema->id_column;
+            const std::string& updated_column = schema->updated_column;
+            bool has_payment_status = schema->has_payment_status;
             // 获取当前订单状态
             std::string check_sql = "SELECT status";
             if (has_payment_status) {
@@ -1299,18 +1384,18 @@ json OrderService::updateOrderStatus(long order_id, const std::string& new_statu
             
             // 根据状态设置相应的时间戳
             if (new_status == "paid") {
-                if (orderHasColumn("paid_at")) {
+                if (schema->has_paid_at) {
                     update_fields.push_back("paid_at = NOW()");
                 }
                 if (has_payment_status) {
                     update_fields.push_back("payment_status = 'paid'");
                 }
             } else if (new_status == "shipped") {
-                if (orderHasColumn("shipped_at")) {
+                if (schema->has_shipped_at) {
                     update_fields.push_back("shipped_at = NOW()");
                 }
             } else if (new_status == "delivered" || new_status == "completed") {
-                if (orderHasColumn("delivered_at")) {
+                if (schema->has_delivered_at) {
                     update_fields.push_back("delivered_at = NOW()");
                 }
             } else if (new_status == "refunded") {
@@ -1376,36 +1461,17 @@ json OrderService::getOrdersByStatus(long user_id, const std::string& status) {
         }
         
         try {
-            const std::string& id_column = getOrderIdColumnName();
-            const std::string& created_column = getOrderCreatedAtColumnName();
-            const std::string& updated_column = getOrderUpdatedAtColumnName();
-            std::string order_user_column = orderHasColumn("user_id") ? "user_id" :
-                                            (orderHasColumn("customer_id") ? "customer_id" : "user_id");
-
-            std::vector<std::string> select_fields = {
-                aliasColumn("" + id_column, "order_id"),
-                aliasColumn(getOrderNoColumnName().empty() ? std::string() : getOrderNoColumnName(), "order_no"),
-                aliasColumn(orderHasColumn("total_amount") ? "total_amount" : std::string(), "total_amount"),
-                aliasColumn(orderHasColumn("discount_amount") ? "discount_amount" : std::string(), "discount_amount"),
-                aliasColumn(orderHasColumn("shipping_fee") ? "shipping_fee" : std::string(), "shipping_fee"),
-                aliasColumn(orderHasColumn("final_amount") ? "final_amount" : std::string(), "final_amount"),
-                aliasColumn(orderHasColumn("status") ? "status" : std::string(), "status"),
-                aliasColumn(orderHasColumn("payment_status") ? "payment_status" : std::string(), "payment_status"),
-                aliasColumn(created_column.empty() ? std::string() : created_column, "created_at"),
-                aliasColumn(updated_column.empty() ? std::string() : updated_column, "updated_at")
-            };
-
-            std::string sql = "SELECT " + joinColumns(select_fields) + " FROM orders WHERE " +
-                              order_user_column + " = " + std::to_string(user_id);
+            std::shared_ptr<const OrderSchema> schema = schema_.get();
+            std::string sql = schema->user_orders_select + std::to_string(user_id);
 
             if (status != "all" && !status.empty()) {
                 sql += " AND status = '" + escapeSQLString(status) + "'";
             }
             
-            std::string order_by_column = !created_column.empty() ? created_column : id_column;
+            std::string order_by_column = !schema->created_column.empty() ? schema->created_column : schema->id_column;
             sql += " ORDER BY " + order_by_column + " DESC";
             
-            json result = executeQuery(sql);
+            json result = executeReadQuery(sql, user_id);
             if (result["success"].get<bool>()) {
                 json response_data;
                 response_data["user_id"] = user_id;
@@ -1425,6 +1491,36 @@ json OrderService::getOrdersByStatus(long user_id, const std::string& status) {
     // 获取所有订单（管理员功能）
 json OrderService::getAllOrders(const std::string& status, int page, int page_size, 
                      const std::string& start_date, const std::string& end_date) {
+        JsonWriter out;
+        writeAllOrders(out, status, page, page_size, start_date, end_date);
+        return json::parse(out.str());
+    }
+
+    // 管理员订单列表的SELECT部分（不含筛选、排序和分页）
+std::string OrderService::buildAllOrdersSelect() const {
+        return schema_.get()->all_orders_select;
+    }
+
+    // 管理员订单列表的筛选条件（以 AND 开头，表别名为o）
+std::string OrderService::buildAllOrdersFilter(const std::string& status, const std::string& start_date,
+                                               const std::string& end_date) const {
+        const std::string& created_column = getOrderCreatedAtColumnName();
+        std::string filter;
+        if (status != "all" && !status.empty()) {
+            filter += " AND o.status = '" + escapeSQLString(status) + "'";
+        }
+        if (!start_date.empty() && !created_column.empty()) {
+            filter += " AND DATE(o." + created_column + ") >= '" + escapeSQLString(start_date) + "'";
+        }
+        if (!end_date.empty() && !created_column.empty()) {
+            filter += " AND DATE(o." + created_column + ") <= '" + escapeSQLString(end_date) + "'";
+        }
+        return filter;
+    }
+
+    // 获取所有订单（流式输出，订单行直接写入响应）
+void OrderService::writeAllOrders(JsonWriter& out, const std::string& status, int page, int page_size,
+                                  const std::string& start_date, const std::string& end_date) {
         logInfo("获取所有订单，状态: " + status + ", 页码: " + std::to_string(page));
         
         if (page <= 0) page = 1;
@@ -1433,100 +1529,10 @@ json OrderService::getAllOrders(const std::string& status, int page, int page_si
         
         try {
             const std::string& id_column = getOrderIdColumnName();
-            const std::string& order_no_column = getOrderNoColumnName();
             const std::string& created_column = getOrderCreatedAtColumnName();
-            const std::string& updated_column = getOrderUpdatedAtColumnName();
-            std::string order_user_column = orderHasColumn("user_id") ? "user_id" :
-                                            (orderHasColumn("customer_id") ? "customer_id" : "user_id");
-            const std::string& user_pk_column = getUsersPrimaryKeyColumn();
+            std::string filter = buildAllOrdersFilter(status, start_date, end_date);
 
-            std::vector<std::string> select_fields;
-            select_fields.push_back(aliasColumn("o." + id_column, "order_id"));
-            select_fields.push_back(order_no_column.empty() ? aliasColumn("", "order_no")
-                                                           : aliasColumn("o." + order_no_column, "order_no"));
-            select_fields.push_back(aliasColumn("o." + order_user_column, "user_id"));
-            select_fields.push_back(aliasColumn("u." + user_pk_column, "user_table_id"));
-            select_fields.push_back(aliasColumn("u.username", "username"));
-            if (orderHasColumn("total_amount")) {
-                select_fields.push_back(aliasColumn("o.total_amount", "total_amount"));
-            }
-            if (orderHasColumn("discount_amount")) {
-                select_fields.push_back(aliasColumn("o.discount_amount", "discount_amount"));
-            } else {
-                select_fields.push_back(aliasColumn("", "discount_amount"));
-            }
-            if (orderHasColumn("shipping_fee")) {
-                select_fields.push_back(aliasColumn("o.shipping_fee", "shipping_fee"));
-            } else {
-                select_fields.push_back(aliasColumn("", "shipping_fee"));
-            }
-            if (orderHasColumn("final_amount")) {
-                select_fields.push_back(aliasColumn("o.final_amount", "final_amount"));
-            }
-            if (orderHasColumn("status")) {
-                select_fields.push_back(aliasColumn("o.status", "status"));
-            }
-            if (orderHasColumn("payment_status")) {
-                select_fields.push_back(aliasColumn("o.payment_status", "payment_status"));
-            } else {
-                select_fields.push_back(aliasColumn("", "payment_status"));
-            }
-            if (orderHasColumn("payment_method")) {
-                select_fields.push_back(aliasColumn("o.payment_method", "payment_method"));
-            } else {
-                select_fields.push_back(aliasColumn("", "payment_method"));
-            }
-            if (orderHasColumn("tracking_number")) {
-                select_fields.push_back(aliasColumn("o.tracking_number", "tracking_number"));
-            } else {
-                select_fields.push_back(aliasColumn("", "tracking_number"));
-            }
-            if (orderHasColumn("shipping_method")) {
-                select_fields.push_back(aliasColumn("o.shipping_method", "shipping_method"));
-            } else {
-                select_fields.push_back(aliasColumn("", "shipping_method"));
-            }
-            select_fields.push_back(aliasColumn(created_column.empty() ? std::string() : ("o." + created_column), "created_at"));
-            select_fields.push_back(aliasColumn(updated_column.empty() ? std::string() : ("o." + updated_column), "updated_at"));
-            if (orderHasColumn("paid_at")) {
-                select_fields.push_back(aliasColumn("o.paid_at", "paid_at"));
-            } else {
-                select_fields.push_back(aliasColumn("", "paid_at"));
-            }
-            if (orderHasColumn("shipped_at")) {
-                select_fields.push_back(aliasColumn("o.shipped_at", "shipped_at"));
-            } else {
-                select_fields.push_back(aliasColumn("", "shipped_at"));
-            }
-            if (orderHasColumn("delivered_at")) {
-                select_fields.push_back(aliasColumn("o.delivered_at", "delivered_at"));
-            } else {
-                select_fields.push_back(aliasColumn("", "delivered_at"));
-            }
-            if (orderHasColumn("remark")) {
-                select_fields.push_back(aliasColumn("o.remark", "remark"));
-            }
-
-            std::string sql = "SELECT " + joinColumns(select_fields) +
-                              " FROM orders o LEFT JOIN users u ON o." + order_user_column +
-                              " = u." + user_pk_column + " WHERE 1=1";
-            
-            if (status != "all" && !status.empty()) {
-                sql += " AND o.status = '" + status + "'";
-            }
-            
-            if (!start_date.empty()) {
-                if (!created_column.empty()) {
-                    sql += " AND DATE(o." + created_column + ") >= '" + start_date + "'";
-                }
-            }
-            
-            if (!end_date.empty()) {
-                if (!created_column.empty()) {
-                    sql += " AND DATE(o." + created_column + ") <= '" + end_date + "'";
-                }
-            }
-            
+            std::string sql = buildAllOrdersSelect() + filter;
             std::string order_by_column = !created_column.empty() ? "o." + created_column : "o." + id_column;
             sql += " ORDER BY " + order_by_column + " DESC";
             
@@ -1534,42 +1540,79 @@ json OrderService::getAllOrders(const std::string& status, int page, int page_si
             int offset = (page - 1) * page_size;
             sql += " LIMIT " + std::to_string(page_size) + " OFFSET " + std::to_string(offset);
             
-            json result = executeQuery(sql);
-            if (result["success"].get<bool>()) {
-                // 获取总记录数
-                std::string count_sql = "SELECT COUNT(*) as total_count FROM orders o WHERE 1=1";
-                if (status != "all" && !status.empty()) {
-                    count_sql += " AND o.status = '" + status + "'";
-                }
-                if (!start_date.empty()) {
-                    if (!created_column.empty()) {
-                        count_sql += " AND DATE(o." + created_column + ") >= '" + start_date + "'";
-                    }
-                }
-                if (!end_date.empty()) {
-                    if (!created_column.empty()) {
-                        count_sql += " AND DATE(o." + created_column + ") <= '" + end_date + "'";
-                    }
-                }
-                
-                json count_result = executeQuery(count_sql);
-                int total_count = 0;
-                if (count_result["success"].get<bool>() && !count_result["data"].empty()) {
-                    total_count = count_result["data"][0]["total_count"].get<int>();
+            // 总记录数在另一条连接上与订单行查询并行执行
+            std::string count_sql = "SELECT COUNT(*) as total_count FROM orders o WHERE 1=1" + filter;
+            std::future<json> count_future = executeReadQueryAsync(count_sql);
+            
+            out.clear();
+            beginSuccessResponse(out);
+            out.raw('{');
+            out.key("orders", true);
+            std::string error_msg;
+            if (!writeReadQueryRows(sql, out, error_msg)) {
+                writeErrorResponse(out, error_msg, Constants::DATABASE_ERROR_CODE);
+                return;
+            }
+            
+            json count_result = count_future.get();
+            int total_count = 0;
+            if (count_result["success"].get<bool>() && !count_result["data"].empty()) {
+                total_count = count_result["data"][0]["total_count"].get<int>();
+            }
+            out.key("page").number(page);
+            out.key("page_size").number(page_size);
+            out.key("status_filter").string(status);
+            out.key("total_count").number(total_count);
+            out.key("total_pages").number((total_count + page_size - 1) / page_size);
+            out.raw('}');
+            endSuccessResponse(out, "获取订单列表成功");
+        } catch (const std::exception& e) {
+            writeErrorResponse(out, "获取订单列表异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
+        }
+    }
+
+    // 获取所有订单（游标分页，按创建时间和订单ID倒序）
+json OrderService::getAllOrdersByCursor(const std::string& status, const std::string& cursor, int page_size,
+                                        const std::string& start_date, const std::string& end_date,
+                                        bool include_total) {
+        logInfo("按游标获取所有订单，状态: " + status + ", 每页: " + std::to_string(page_size));
+
+        if (page_size <= 0) page_size = 20;
+        if (page_size > 100) page_size = 100;
+
+        try {
+            const std::string& id_column = getOrderIdColumnName();
+            const std::string& created_column = getOrderCreatedAtColumnName();
+            std::string sort_column = created_column.empty() ? std::string() : "o." + created_column;
+            std::string filter = buildAllOrdersFilter(status, start_date, end_date);
+
+            std::string sql = buildAllOrdersSelect() + filter;
+            if (!cursor.empty()) {
+                json sort_key;
+                long long last_id = 0;
+                if (!decodePageCursor(cursor, sort_key, last_id)) {
+                    return createErrorResponse("无效的分页游标", Constants::VALIDATION_ERROR_CODE);
                 }
-                
-                json response_data;
-                response_data["orders"] = result["data"];
-                response_data["page"] = page;
-                response_data["page_size"] = page_size;
-                response_data["total_count"] = total_count;
-                response_data["total_pages"] = (total_count + page_size - 1) / page_size;
-                response_data["status_filter"] = status;
-                
-                return createSuccessResponse(response_data, "获取订单列表成功");
+                sql += " AND " + buildKeysetCondition(sort_column, "o." + id_column, sort_key, last_id);
             }
-            
-            return result;
+            sql += buildKeysetOrderAndLimit(sort_column, "o." + id_column, page_size);
+
+            json result = executeReadQuery(sql);
+            if (!result["success"].get<bool>()) {
+                return result;
+            }
+
+            json rows = result["data"];
+            json response_data = finishKeysetPage(rows, page_size, sort_column.empty() ? "" : "created_at", "order_id");
+            response_data["orders"] = rows;
+            response_data["status_filter"] = status;
+            if (include_total) {
+                bool from_cache = false;
+                response_data["total_count"] = getCachedCount(
+                    "SELECT COUNT(*) as total_count FROM orders o WHERE 1=1" + filter, from_cache);
+                response_data["total_cached"] = from_cache;
+            }
+            return createSuccessResponse(response_data, "获取订单列表成功");
         } catch (const std::exception& e) {
             return createErrorResponse("获取订单列表异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
         }
@@ -1584,11 +1627,10 @@ json OrderService::trackOrder(long order_id) {
         }
         
         try {
-            std::string sql = "SELECT order_id, order_no, status, tracking_number, shipping_method, "
-                             "shipped_at, delivered_at FROM orders WHERE order_id = " + 
-                             std::to_string(order_id);
+            static const std::string sql = "SELECT order_id, order_no, status, tracking_number, shipping_method, "
+                                           "shipped_at, delivered_at FROM orders WHERE order_id = ?";
             
-            json result = executeQuery(sql);
+            json result = executePrepared(sql, {order_id});
             if (!result["success"].get<bool>() || result["data"].empty()) {
                 return createErrorResponse("订单不存在", Constants::VALIDATION_ERROR_CODE);
             }
@@ -1638,14 +1680,23 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
     logInfo("管理员审核退款，退款ID: " + std::to_string(refund_id) + ", 管理员ID: " + std::to_string(admin_id) + 
             ", 审核结果: " + (approve ? "批准" : "拒绝"));
     
-    std::lock_guard<std::mutex> lock(order_mutex_);
     
     if (refund_id <= 0 || admin_id <= 0) {
         return createErrorResponse("无效的退款ID或管理员ID", Constants::VALIDATION_ERROR_CODE);
     }
     
+    // 审核会修改订单状态，需与该订单的其他操作互斥，先查出所属订单再加锁
+    std::unique_lock<std::mutex> lock;
+    {
+        static const std::string owner_sql = "SELECT order_id FROM refund_requests WHERE refund_id = ?";
+        json owner_result = executePrepared(owner_sql, {refund_id});
+        if (owner_result["success"].get<bool>() && !owner_result["data"].empty()) {
+            lock = orderLocks().lock(owner_result["data"][0]["order_id"].get<long long>());
+        }
+    }
+    
     try {
-        executeQuery("BEGIN");
+        Transaction tx(*this);
         
         // 获取退款申请信息
         std::string query_sql = "SELECT r.order_id, r.user_id, r.reason, r.refund_amount, r.status, "
@@ -1653,10 +1704,9 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
                                "FROM refund_requests r "
                                "JOIN orders o ON r.order_id = o.order_id "
                                "WHERE r.refund_id = " + std::to_string(refund_id) + " FOR UPDATE";
-        json query_result = executeQuery(query_sql);
+        json query_result = tx.query(query_sql);
         
         if (!query_result["success"].get<bool>() || query_result["data"].empty()) {
-            executeQuery("ROLLBACK");
             return createErrorResponse("退款申请不存在", Constants::VALIDATION_ERROR_CODE);
         }
         
@@ -1664,7 +1714,6 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
         std::string refund_status = refund_data["status"].get<std::string>();
         
         if (refund_status != "pending") {
-            executeQuery("ROLLBACK");
             return createErrorResponse("该退款申请已处理，无法重复审核", Constants::VALIDATION_ERROR_CODE);
         }
         
@@ -1677,22 +1726,20 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
             // 更新退款申请状态
             std::string update_refund_sql = "UPDATE refund_requests SET status = 'approved', "
                                            "processed_by = " + std::to_string(admin_id) + ", "
-                                           "admin_reply = '" + escapeSQLString(admin_reply) + "', "
+                                           "admin_reply = '" + tx.escape(admin_reply) + "', "
                                            "processed_at = NOW() WHERE refund_id = " + std::to_string(refund_id);
-            json update_refund_result = executeQuery(update_refund_sql);
+            json update_refund_result = tx.query(update_refund_sql);
             
             if (!update_refund_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
                 return createErrorResponse("更新退款申请失败", Constants::DATABASE_ERROR_CODE);
             }
             
             // 更新订单状态为refunded
             std::string update_order_sql = "UPDATE orders SET status = 'refunded', payment_status = 'refunded', "
                                           "updated_at = NOW() WHERE order_id = " + std::to_string(order_id);
-            json update_order_result = executeQuery(update_order_sql);
+            json update_order_result = tx.query(update_order_sql);
             
             if (!update_order_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
                 return createErrorResponse("更新订单状态失败", Constants::DATABASE_ERROR_CODE);
             }
             
@@ -1700,7 +1747,7 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
             std::string coupon_check_sql = "SELECT id, coupon_id FROM user_coupons "
                                           "WHERE order_id = " + std::to_string(order_id) + 
                                           " AND status = 'used' LIMIT 1";
-            json coupon_check_result = executeQuery(coupon_check_sql);
+            json coupon_check_result = tx.query(coupon_check_sql);
             
             if (coupon_check_result["success"].get<bool>() && !coupon_check_result["data"].empty()) {
                 auto coupon_data = coupon_check_result["data"][0];
@@ -1711,10 +1758,9 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
                 std::string restore_coupon_sql = "UPDATE user_coupons SET status = 'unused', "
                                                 "order_id = NULL, used_at = NULL "
                                                 "WHERE id = " + std::to_string(user_coupon_id);
-                json restore_coupon_result = executeQuery(restore_coupon_sql);
+                json restore_coupon_result = tx.query(restore_coupon_sql);
                 
                 if (!restore_coupon_result["success"].get<bool>()) {
-                    executeQuery("ROLLBACK");
                     logError("恢复优惠券失败: user_coupon_id=" + std::to_string(user_coupon_id));
                     return createErrorResponse("恢复优惠券失败", Constants::DATABASE_ERROR_CODE);
                 }
@@ -1725,37 +1771,38 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
             
             // 返还库存
             std::string items_sql = "SELECT product_id, quantity FROM order_items WHERE order_id = " + std::to_string(order_id);
-            json items_result = executeQuery(items_sql);
+            json items_result = tx.query(items_sql);
             
+            std::vector<long> restored_products;
             if (items_result["success"].get<bool>() && !items_result["data"].empty()) {
                 for (const auto& item : items_result["data"]) {
                     long product_id = item["product_id"].get<long>();
                     int quantity = item["quantity"].get<int>();
+                    restored_products.push_back(product_id);
                     
                     // 返还库存
                     std::string restore_sql = "UPDATE products SET stock_quantity = stock_quantity + " + 
                                              std::to_string(quantity) + ", updated_at = NOW() "
                                              "WHERE product_id = " + std::to_string(product_id);
-                    json restore_result = executeQuery(restore_sql);
+                    json restore_result = tx.query(restore_sql);
                     
                     if (!restore_result["success"].get<bool>()) {
-                        executeQuery("ROLLBACK");
                         return createErrorResponse("库存返还失败", Constants::DATABASE_ERROR_CODE);
                     }
                     
                     // 记录库存变动
-                    logStockChange(product_id, quantity, "refund_approved", "refund", refund_id, admin_id);
+                    logStockChange(product_id, quantity, "refund_approved", "refund", refund_id, admin_id, &tx);
                     
                     logInfo("退款返还库存: 商品ID=" + std::to_string(product_id) + ", 数量=" + std::to_string(quantity));
                 }
             }
             
             // 先提交事务
-            json commit_result = executeQuery("COMMIT");
-            if (!commit_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
+            if (!tx.commit()) {
                 return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
             }
+            product_service_.invalidateStockCache(restored_products);
+            markUserWrite(user_id);
             
             // 事务提交后创建通知(确保通知不受事务影响)
             try {
@@ -1780,31 +1827,28 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
             // 拒绝退款
             std::string update_refund_sql = "UPDATE refund_requests SET status = 'rejected', "
                                            "processed_by = " + std::to_string(admin_id) + ", "
-                                           "admin_reply = '" + escapeSQLString(admin_reply) + "', "
+                                           "admin_reply = '" + tx.escape(admin_reply) + "', "
                                            "processed_at = NOW() WHERE refund_id = " + std::to_string(refund_id);
-            json update_refund_result = executeQuery(update_refund_sql);
+            json update_refund_result = tx.query(update_refund_sql);
             
             if (!update_refund_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
                 return createErrorResponse("更新退款申请失败", Constants::DATABASE_ERROR_CODE);
             }
             
             // 恢复订单状态(从refunding恢复到之前的状态,这里简单恢复为paid)
             std::string update_order_sql = "UPDATE orders SET status = 'paid', updated_at = NOW() "
                                           "WHERE order_id = " + std::to_string(order_id);
-            json update_order_result = executeQuery(update_order_sql);
+            json update_order_result = tx.query(update_order_sql);
             
             if (!update_order_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
                 return createErrorResponse("更新订单状态失败", Constants::DATABASE_ERROR_CODE);
             }
             
             // 先提交事务
-            json commit_result = executeQuery("COMMIT");
-            if (!commit_result["success"].get<bool>()) {
-                executeQuery("ROLLBACK");
+            if (!tx.commit()) {
                 return createErrorResponse("提交事务失败", Constants::DATABASE_ERROR_CODE);
             }
+            markUserWrite(user_id);
             
             // 事务提交后创建通知(确保通知不受事务影响)
             try {
@@ -1825,7 +1869,6 @@ json OrderService::approveRefund(long refund_id, long admin_id, bool approve, co
         }
         
     } catch (const std::exception& e) {
-        try { executeQuery("ROLLBACK"); } catch(...) {}
         return createErrorResponse("审核退款异常: " + std::string(e.what()), Constants::DATABASE_ERROR_CODE);
     }
 }
@@ -2065,17 +2108,23 @@ json OrderService::deleteNotification(long notification_id, long user_id) {
 
 // 记录库存变动
 bool OrderService::logStockChange(long product_id, int change_qty, const std::string& reason,
-                                  const std::string& related_type, long related_id, long operator_id) {
+                                  const std::string& related_type, long related_id, long operator_id,
+                                  Transaction* tx) {
+    // 事务内的库存行已被本事务锁定，日志必须走同一连接，否则外键检查会等待本事务自身的行锁
+    auto run = [&](const std::string& sql) { return tx ? tx->query(sql) : executeQuery(sql); };
+    auto escape = [&](const std::string& value) { return tx ? tx->escape(value) : escapeSQLString(value); };
     try {
         // 获取当前库存
         std::string query_sql = "SELECT stock_quantity FROM products WHERE product_id = " + std::to_string(product_id);
-        json query_result = executeQuery(query_sql);
+        json query_result = run(query_sql);
         
-        int stock_before = 0;
+        int current_stock = 0;
         if (query_result["success"].get<bool>() && !query_result["data"].empty()) {
-            stock_before = query_result["data"][0]["stock_quantity"].get<int>();
+            current_stock = query_result["data"][0]["stock_quantity"].get<int>();
         }
         
+        // 事务内读到的是本次变动之后的库存
+        int stock_before = tx ? current_stock - change_qty : current_stock;
         int stock_after = stock_before + change_qty;
         
         // 插入库存变动记录
@@ -2083,10 +2132,10 @@ bool OrderService::logStockChange(long product_id, int change_qty, const std::st
                                 "reason, related_type, related_id, operator_id, created_at) "
                                 "VALUES (" + std::to_string(product_id) + ", " + std::to_string(change_qty) + ", " + 
                                 std::to_string(stock_before) + ", " + std::to_string(stock_after) + ", '" + 
-                                escapeSQLString(reason) + "', '" + escapeSQLString(related_type) + "', " + 
+                                escape(reason) + "', '" + escape(related_type) + "', " + 
                                 std::to_string(related_id) + ", " + std::to_string(operator_id) + ", NOW())";
         
-        json result = executeQuery(insert_sql);
+        json result = run(insert_sql);
         
         if (result["success"].get<bool>()) {
             logInfo("记录库存变动: 商品ID=" + std::to_string(product_id) + 
@@ -22,6 +22,7 @@ using json = nlohmann::json;
 
 // 前向声明
 class BaseService;
+class JsonWriter;
 
 /**
  * @class OrderService
@@ -29,15 +30,37 @@ class BaseService;
  */
 class OrderService : public BaseService {
 private:
-    std::mutex order_mutex_; ///< 订单操作互斥锁
+    // 取消订单/退款返还库存后失效商品缓存
+    ProductService& product_service_;
+    
+    // 按当前表结构确定的订单列名和固定SQL片段，表结构刷新后重新生成
+    struct OrderSchema {
+        std::string id_column;
+        std::string order_no_column;
+        std::string created_column;
+        std::string updated_column;
+        std::string user_column;         // orders表中的用户列(user_id或customer_id)
+        std::string users_pk_column;
+        bool has_payment_status = false;
+        bool has_paid_at = false;
+        bool has_shipped_at = false;
+        bool has_delivered_at = false;
+        std::string all_orders_select;   // 管理员订单列表，以WHERE 1=1结尾
+        std::string user_orders_select;  // 用户订单列表，以"用户列 = "结尾
+    };
+    SchemaBound<OrderSchema> schema_;
+    OrderSchema buildSchema(const SchemaSnapshot& snapshot) const;
 
     // 辅助方法 - 列名映射
-    const std::string& getOrderIdColumnName() const;
-    const std::string& getOrderNoColumnName() const;
-    const std::string& getOrderCreatedAtColumnName() const;
-    const std::string& getOrderUpdatedAtColumnName() const;
-    const std::string& getUsersPrimaryKeyColumn() const;
-    bool orderHasColumn(const std::string& column) const;
+    std::string getOrderIdColumnName() const;
+    std::string getOrderNoColumnName() const;
+    std::string getOrderCreatedAtColumnName() const;
+    std::string getOrderUpdatedAtColumnName() const;
+
+    // 管理员订单列表查询拼装(分页版与游标版共用)
+    std::string buildAllOrdersSelect() const;
+    std::string buildAllOrdersFilter(const std::string& status, const std::string& start_date,
+                                     const std::string& end_date) const;
 
     /**
      * @brief 生成唯一订单号
@@ -68,8 +91,9 @@ private:
 public:
     /**
      * @brief 构造函数
+     * @param product_service 商品服务，库存返还提交后用于失效商品缓存
      */
-    OrderService();
+    explicit OrderService(ProductService& product_service);
 
     /**
      * @brief 获取服务名称
@@ -88,6 +112,14 @@ public:
      */
     json createOrderFromCart(long user_id, long address_id, const std::string& coupon_code, const std::string& remark);
 
+    /**
+     * @brief 一键结算购物车(使用默认收货地址，不使用优惠券)
+     * @param user_id 用户ID
+     * @return JSON响应 同createOrderFromCart
+     * @note 没有默认地址时使用最近添加的地址，没有地址时返回校验错误
+     */
+    json checkout(long user_id);
+
     /**
      * @brief 直接购买创建订单(不依赖购物车)
      * @param user_id 用户ID
@@ -224,6 +256,29 @@ public:
     json getAllOrders(const std::string& status, int page, int page_size, 
                      const std::string& start_date, const std::string& end_date);
 
+    /**
+     * @brief 获取所有订单的流式版本,直接把完整响应写入out
+     * @param out 输出缓冲区(会被清空)
+     * @note 参数含义同getAllOrders,订单行不经过JSON对象直接序列化
+     */
+    void writeAllOrders(JsonWriter& out, const std::string& status, int page, int page_size,
+                        const std::string& start_date, const std::string& end_date);
+
+    /**
+     * @brief 获取所有订单(管理员功能,游标分页)
+     * @param status 订单状态筛选(all表示全部)
+     * @param cursor 上一页返回的next_cursor,首页传空字符串
+     * @param page_size 每页数量
+     * @param start_date 开始日期(可选,格式:YYYY-MM-DD)
+     * @param end_date 结束日期(可选,格式:YYYY-MM-DD)
+     * @param include_total 是否返回总数(总数带短时缓存)
+     * @return JSON响应 包含orders、has_more、next_cursor
+     * @note 按创建时间和订单ID倒序,翻页开销与页码无关
+     */
+    json getAllOrdersByCursor(const std::string& status, const std::string& cursor, int page_size,
+                              const std::string& start_date, const std::string& end_date,
+                              bool include_total);
+
     /**
      * @brief 创建用户通知
      * @param user_id 用户ID
@@ -269,10 +324,12 @@ public:
      * @param related_type 关联类型(order, refund, adjustment)
      * @param related_id 关联ID
      * @param operator_id 操作员ID(0表示系统操作)
+     * @param tx 所在事务(可选),传入时须在库存更新之后调用
      * @return 成功返回true
      */
     bool logStockChange(long product_id, int change_qty, const std::string& reason,
-                       const std::string& related_type, long related_id, long operator_id);
+                       const std::string& related_type, long related_id, long operator_id,
+                       Transaction* tx = nullptr);
 
     /**
      * @brief 订单物流跟踪
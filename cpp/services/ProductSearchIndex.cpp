@@ -0,0 +1,529 @@
+#include "ProductSearchIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+
+// ==================== 分词 ====================
+
+namespace {
+
+// 字段权重：名称命中比描述命中更相关
+const float NAME_WEIGHT = 3.0f;
+const float BRAND_WEIGHT = 2.0f;
+const float CATEGORY_WEIGHT = 2.0f;
+const float SHORT_DESCRIPTION_WEIGHT = 1.5f;
+const float DESCRIPTION_WEIGHT = 1.0f;
+
+// BM25参数
+const double BM25_K1 = 1.2;
+const double BM25_B = 0.75;
+
+const size_t MAX_WORD_LENGTH = 64;
+
+// 解码一个UTF-8字符并前移pos，非法字节按单字节跳过
+uint32_t decodeUtf8(const std::string& text, size_t& pos) {
+    unsigned char c = static_cast<unsigned char>(text[pos]);
+    int extra = 0;
+    uint32_t cp = 0;
+    if (c < 0x80) {
+        pos += 1;
+        return c;
+    } else if ((c & 0xE0) == 0xC0) {
+        extra = 1;
+        cp = c & 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        extra = 2;
+        cp = c & 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+        extra = 3;
+        cp = c & 0x07;
+    } else {
+        pos += 1;
+        return 0xFFFD;
+    }
+    if (pos + extra >= text.size()) {
+        pos = text.size();
+        return 0xFFFD;
+    }
+    for (int i = 1; i <= extra; ++i) {
+        unsigned char next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80) {
+            pos += 1;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (next & 0x3F);
+    }
+    pos += extra + 1;
+    return cp;
+}
+
+bool isCjk(uint32_t cp) {
+    return (cp >= 0x4E00 && cp <= 0x9FFF) ||    // 中日韩统一表意文字
+           (cp >= 0x3400 && cp <= 0x4DBF) ||    // 扩展A
+           (cp >= 0x20000 && cp <= 0x2A6DF) ||  // 扩展B
+           (cp >= 0xF900 && cp <= 0xFAFF) ||    // 兼容表意文字
+           (cp >= 0x3040 && cp <= 0x30FF) ||    // 日文假名
+           (cp >= 0xAC00 && cp <= 0xD7AF);      // 韩文音节
+}
+
+// 词项是否为英文数字词(首字节为ASCII)
+bool isWordTerm(const std::string& term) {
+    return !term.empty() && static_cast<unsigned char>(term[0]) < 0x80;
+}
+
+// 拆出词项中的各个字符(CJK词项为一个或两个字)
+std::vector<uint32_t> termCodepoints(const std::string& term) {
+    std::vector<uint32_t> cps;
+    size_t pos = 0;
+    while (pos < term.size()) {
+        cps.push_back(decodeUtf8(term, pos));
+    }
+    return cps;
+}
+
+void appendTermWeights(std::unordered_map<std::string, float>& weights, float& length,
+                       const std::string& text, float weight) {
+    for (const auto& token : ProductSearchIndex::tokenize(text)) {
+        weights[token] += weight;
+        length += weight;
+    }
+}
+
+} // namespace
+
+std::vector<std::string> ProductSearchIndex::tokenize(const std::string& text) {
+    std::vector<std::string> tokens;
+    std::string word;
+    std::vector<std::string> cjk_run;
+
+    auto flush_word = [&]() {
+        if (!word.empty()) {
+            tokens.push_back(word);
+            word.clear();
+        }
+    };
+    auto flush_cjk = [&]() {
+        if (cjk_run.size() == 1) {
+            tokens.push_back(cjk_run[0]);
+        } else {
+            for (size_t i = 0; i + 1 < cjk_run.size(); ++i) {
+                tokens.push_back(cjk_run[i] + cjk_run[i + 1]);
+            }
+        }
+        cjk_run.clear();
+    };
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t start = pos;
+        uint32_t cp = decodeUtf8(text, pos);
+        // 全角字母数字归一为半角
+        if (cp >= 0xFF01 && cp <= 0xFF5E) {
+            cp -= 0xFEE0;
+        }
+        if (cp < 0x80 && std::isalnum(static_cast<int>(cp))) {
+            flush_cjk();
+            if (word.size() < MAX_WORD_LENGTH) {
+                word += static_cast<char>(std::tolower(static_cast<int>(cp)));
+            }
+        } else if (isCjk(cp)) {
+            flush_word();
+            cjk_run.push_back(text.substr(start, pos - start));
+        } else {
+            flush_word();
+            flush_cjk();
+        }
+    }
+    flush_word();
+    flush_cjk();
+    return tokens;
+}
+
+// ==================== 索引维护 ====================
+
+ProductSearchIndex::ProductSearchIndex()
+    : loaded_(false)
+    , mutation_version_(0) {
+}
+
+uint32_t ProductSearchIndex::internTerm(Core& core, const std::string& term) {
+    auto it = core.term_ids.find(term);
+    if (it != core.term_ids.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(core.terms.size());
+    core.term_ids.emplace(term, id);
+    core.terms.push_back(term);
+    core.postings.emplace_back();
+    core.doc_freq.push_back(0);
+    if (isWordTerm(term)) {
+        core.word_terms.emplace(term, id);
+    } else {
+        std::vector<uint32_t> cps = termCodepoints(term);
+        if (cps.size() == 2) {
+            core.cjk_char_terms[cps[0]].push_back(id);
+            if (cps[1] != cps[0]) {
+                core.cjk_char_terms[cps[1]].push_back(id);
+            }
+        }
+    }
+    return id;
+}
+
+void ProductSearchIndex::addSlot(Core& core, long product_id, double price, const std::string& name,
+                                 const std::string& created_at,
+                                 const std::vector<std::pair<std::string, float>>& terms, float length) {
+    uint32_t slot_id = static_cast<uint32_t>(core.slots.size());
+    Slot slot;
+    slot.product_id = product_id;
+    slot.price = price;
+    slot.name = name;
+    slot.created_at = created_at;
+    slot.length = length;
+    slot.alive = true;
+    slot.terms.reserve(terms.size());
+    for (const auto& term : terms) {
+        uint32_t term_id = internTerm(core, term.first);
+        core.postings[term_id].push_back({slot_id, term.second});
+        core.doc_freq[term_id]++;
+        slot.terms.emplace_back(term_id, term.second);
+    }
+    core.slots.push_back(std::move(slot));
+    core.slot_of[product_id] = slot_id;
+    core.live_count++;
+    core.total_length += length;
+}
+
+void ProductSearchIndex::addDocument(Core& core, const ProductSearchDocument& doc) {
+    std::unordered_map<std::string, float> weights;
+    float length = 0.0f;
+    appendTermWeights(weights, length, doc.name, NAME_WEIGHT);
+    appendTermWeights(weights, length, doc.brand, BRAND_WEIGHT);
+    appendTermWeights(weights, length, doc.category, CATEGORY_WEIGHT);
+    appendTermWeights(weights, length, doc.short_description, SHORT_DESCRIPTION_WEIGHT);
+    appendTermWeights(weights, length, doc.description, DESCRIPTION_WEIGHT);
+
+    std::vector<std::pair<std::string, float>> terms(weights.begin(), weights.end());
+    addSlot(core, doc.product_id, doc.price, doc.name, doc.created_at, terms, length);
+}
+
+bool ProductSearchIndex::removeDocument(Core& core, long product_id) {
+    auto it = core.slot_of.find(product_id);
+    if (it == core.slot_of.end()) {
+        return false;
+    }
+    Slot& slot = core.slots[it->second];
+    for (const auto& term : slot.terms) {
+        core.doc_freq[term.first]--;
+    }
+    slot.alive = false;
+    std::vector<std::pair<uint32_t, float>>().swap(slot.terms);
+    core.live_count--;
+    core.dead_count++;
+    core.total_length -= slot.length;
+    core.slot_of.erase(it);
+    return true;
+}
+
+// 丢弃墓碑slot并重新编号，倒排表保持有序
+void ProductSearchIndex::compact(Core& core) {
+    const uint32_t dead = UINT32_MAX;
+    std::vector<uint32_t> remap(core.slots.size(), dead);
+    std::vector<Slot> slots;
+    slots.reserve(core.live_count);
+    for (size_t i = 0; i < core.slots.size(); ++i) {
+        if (core.slots[i].alive) {
+            remap[i] = static_cast<uint32_t>(slots.size());
+            slots.push_back(std::move(core.slots[i]));
+        }
+    }
+    for (auto& list : core.postings) {
+        size_t out = 0;
+        for (const auto& posting : list) {
+            uint32_t slot = remap[posting.slot];
+            if (slot != dead) {
+                list[out++] = {slot, posting.tf};
+            }
+        }
+        list.resize(out);
+        list.shrink_to_fit();
+    }
+    for (auto& entry : core.slot_of) {
+        entry.second = remap[entry.second];
+    }
+    core.slots = std::move(slots);
+    core.dead_count = 0;
+}
+
+void ProductSearchIndex::compactIfNeeded(Core& core) {
+    if (core.dead_count > 1024 && core.dead_count * 4 > core.live_count) {
+        compact(core);
+    }
+}
+
+bool ProductSearchIndex::isLoaded() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return loaded_;
+}
+
+std::chrono::steady_clock::time_point ProductSearchIndex::loadedAt() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return loaded_at_;
+}
+
+uint64_t ProductSearchIndex::mutationVersion() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return mutation_version_;
+}
+
+void ProductSearchIndex::replaceAll(const std::vector<ProductSearchDocument>& docs, uint64_t since_version) {
+    // 新索引在锁外构建，检索不受影响
+    Core fresh;
+    fresh.slots.reserve(docs.size());
+    for (const auto& doc : docs) {
+        addDocument(fresh, doc);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    // 全量扫描期间发生过增量变更的商品，以当前索引中的版本为准
+    for (const auto& entry : last_mutation_) {
+        if (entry.second <= since_version) {
+            continue;
+        }
+        removeDocument(fresh, entry.first);
+        auto it = core_.slot_of.find(entry.first);
+        if (it == core_.slot_of.end()) {
+            continue;
+        }
+        const Slot& slot = core_.slots[it->second];
+        std::vector<std::pair<std::string, float>> terms;
+        terms.reserve(slot.terms.size());
+        for (const auto& term : slot.terms) {
+            terms.emplace_back(core_.terms[term.first], term.second);
+        }
+        addSlot(fresh, slot.product_id, slot.price, slot.name, slot.created_at, terms, slot.length);
+    }
+    compactIfNeeded(fresh);
+
+    core_ = std::move(fresh);
+    last_mutation_.clear();
+    loaded_ = true;
+    loaded_at_ = std::chrono::steady_clock::now();
+}
+
+void ProductSearchIndex::upsert(const ProductSearchDocument& doc) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    removeDocument(core_, doc.product_id);
+    addDocument(core_, doc);
+    last_mutation_[doc.product_id] = ++mutation_version_;
+    compactIfNeeded(core_);
+}
+
+void ProductSearchIndex::remove(long product_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    removeDocument(core_, product_id);
+    last_mutation_[product_id] = ++mutation_version_;
+    compactIfNeeded(core_);
+}
+
+// ==================== 检索 ====================
+
+std::vector<uint32_t> ProductSearchIndex::expandQueryTerm(const std::string& term) const {
+    std::vector<uint32_t> term_ids;
+    auto exact = core_.term_ids.find(term);
+    if (exact != core_.term_ids.end()) {
+        term_ids.push_back(exact->second);
+    }
+
+    if (isWordTerm(term)) {
+        // 英文数字按前缀展开，如"iph"可命中"iphone"
+        auto it = core_.word_terms.lower_bound(term);
+        while (it != core_.word_terms.end() && term_ids.size() < Constants::SEARCH_PREFIX_EXPANSION_LIMIT &&
+               it->first.compare(0, term.size(), term) == 0) {
+            if (it->first != term && core_.doc_freq[it->second] > 0) {
+                term_ids.push_back(it->second);
+            }
+            ++it;
+        }
+    } else {
+        // 单个汉字只会出现在二字词项中，展开为所有包含该字的词项
+        std::vector<uint32_t> cps = termCodepoints(term);
+        if (cps.size() == 1) {
+            auto it = core_.cjk_char_terms.find(cps[0]);
+            if (it != core_.cjk_char_terms.end()) {
+                for (uint32_t term_id : it->second) {
+                    if (core_.doc_freq[term_id] > 0) {
+                        term_ids.push_back(term_id);
+                    }
+                }
+            }
+        }
+    }
+    return term_ids;
+}
+
+ProductSearchResult ProductSearchIndex::search(const ProductSearchQuery& query) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    ProductSearchResult result;
+
+    std::vector<std::string> query_terms = tokenize(query.keyword);
+    std::sort(query_terms.begin(), query_terms.end());
+    query_terms.erase(std::unique(query_terms.begin(), query_terms.end()), query_terms.end());
+
+    const double doc_count = static_cast<double>(core_.live_count);
+    const double avg_length = core_.live_count > 0 ? core_.total_length / doc_count : 1.0;
+    auto bm25 = [&](uint32_t term_id, const Posting& posting) {
+        double df = core_.doc_freq[term_id];
+        double idf = std::log(1.0 + (doc_count - df + 0.5) / (df + 0.5));
+        double length = core_.slots[posting.slot].length;
+        double norm = BM25_K1 * (1.0 - BM25_B + BM25_B * length / avg_length);
+        return idf * posting.tf * (BM25_K1 + 1.0) / (posting.tf + norm);
+    };
+
+    // 候选集：slot与得分，按slot有序
+    std::vector<std::pair<uint32_t, double>> candidates;
+    if (query_terms.empty()) {
+        candidates.reserve(core_.live_count);
+        for (size_t i = 0; i < core_.slots.size(); ++i) {
+            if (core_.slots[i].alive) {
+                candidates.emplace_back(static_cast<uint32_t>(i), 0.0);
+            }
+        }
+    } else {
+        // 每个查询词项展开为若干倒排表，按总长度从小到大求交
+        std::vector<std::vector<uint32_t>> groups;
+        std::vector<size_t> group_sizes;
+        for (const auto& term : query_terms) {
+            std::vector<uint32_t> term_ids = expandQueryTerm(term);
+            if (term_ids.empty()) {
+                return result;
+            }
+            size_t size = 0;
+            for (uint32_t term_id : term_ids) {
+                size += core_.postings[term_id].size();
+            }
+            groups.push_back(std::move(term_ids));
+            group_sizes.push_back(size);
+        }
+        std::vector<size_t> order(groups.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return group_sizes[a] < group_sizes[b]; });
+
+        // 最小的一组直接展开为候选集，同一文档命中多个展开词项时取最高分
+        for (uint32_t term_id : groups[order[0]]) {
+            for (const auto& posting : core_.postings[term_id]) {
+                if (core_.slots[posting.slot].alive) {
+                    candidates.emplace_back(posting.slot, bm25(term_id, posting));
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        size_t merged = 0;
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (merged > 0 && candidates[merged - 1].first == candidates[i].first) {
+                candidates[merged - 1].second = std::max(candidates[merged - 1].second, candidates[i].second);
+            } else {
+                candidates[merged++] = candidates[i];
+            }
+        }
+        candidates.resize(merged);
+
+        // 其余各组在各自倒排表中二分查找候选文档
+        for (size_t g = 1; g < order.size() && !candidates.empty(); ++g) {
+            std::vector<double> best(candidates.size(), -1.0);
+            for (uint32_t term_id : groups[order[g]]) {
+                const auto& list = core_.postings[term_id];
+                auto from = list.begin();
+                for (size_t i = 0; i < candidates.size() && from != list.end(); ++i) {
+                    from = std::lower_bound(from, list.end(), candidates[i].first,
+                                            [](const Posting& p, uint32_t slot) { return p.slot < slot; });
+                    if (from != list.end() && from->slot == candidates[i].first) {
+                        best[i] = std::max(best[i], bm25(term_id, *from));
+                    }
+                }
+            }
+            size_t kept = 0;
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (best[i] >= 0.0) {
+                    candidates[kept++] = {candidates[i].first, candidates[i].second + best[i]};
+                }
+            }
+            candidates.resize(kept);
+        }
+    }
+
+    // 价格过滤
+    if (query.min_price >= 0 || query.max_price >= 0) {
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+            [&](const std::pair<uint32_t, double>& c) {
+                double price = core_.slots[c.first].price;
+                return (query.min_price >= 0 && price < query.min_price) ||
+                       (query.max_price >= 0 && price > query.max_price);
+            }), candidates.end());
+    }
+
+    result.total = candidates.size();
+    if (query.offset >= candidates.size()) {
+        return result;
+    }
+
+    // 排序：有关键词时默认按相关度，否则按上架时间
+    auto newer = [&](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) {
+        const Slot& x = core_.slots[a.first];
+        const Slot& y = core_.slots[b.first];
+        if (x.created_at != y.created_at) return x.created_at > y.created_at;
+        return x.product_id > y.product_id;
+    };
+    std::function<bool(const std::pair<uint32_t, double>&, const std::pair<uint32_t, double>&)> less;
+    if (query.sort_by == "price_asc") {
+        less = [&](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) {
+            double x = core_.slots[a.first].price, y = core_.slots[b.first].price;
+            return x != y ? x < y : newer(a, b);
+        };
+    } else if (query.sort_by == "price_desc") {
+        less = [&](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) {
+            double x = core_.slots[a.first].price, y = core_.slots[b.first].price;
+            return x != y ? x > y : newer(a, b);
+        };
+    } else if (query.sort_by == "name_asc") {
+        less = [&](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) {
+            const std::string& x = core_.slots[a.first].name;
+            const std::string& y = core_.slots[b.first].name;
+            return x != y ? x < y : newer(a, b);
+        };
+    } else if (query.sort_by == "newest" || query_terms.empty()) {
+        less = newer;
+    } else {
+        less = [&](const std::pair<uint32_t, double>& a, const std::pair<uint32_t, double>& b) {
+            return a.second != b.second ? a.second > b.second : newer(a, b);
+        };
+    }
+
+    size_t end = std::min(candidates.size(), query.offset + query.limit);
+    std::partial_sort(candidates.begin(), candidates.begin() + end, candidates.end(), less);
+    result.product_ids.reserve(end - query.offset);
+    for (size_t i = query.offset; i < end; ++i) {
+        result.product_ids.push_back(core_.slots[candidates[i].first].product_id);
+    }
+    return result;
+}
+
+json ProductSearchIndex::getStats() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    size_t posting_count = 0;
+    for (const auto& list : core_.postings) {
+        posting_count += list.size();
+    }
+    json stats;
+    stats["loaded"] = loaded_;
+    stats["documents"] = core_.live_count;
+    stats["dead_slots"] = core_.dead_count;
+    stats["terms"] = core_.terms.size();
+    stats["postings"] = posting_count;
+    stats["pending_mutations"] = last_mutation_.size();
+    stats["age_seconds"] = loaded_ ? std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now() - loaded_at_).count() : 0;
+    return stats;
+}
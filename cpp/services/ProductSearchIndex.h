@@ -0,0 +1,121 @@
+#ifndef PRODUCT_SEARCH_INDEX_H
+#define PRODUCT_SEARCH_INDEX_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <shared_mutex>
+#include <chrono>
+#include <cstdint>
+#include "../nlohmann_json.hpp"
+
+using json = nlohmann::json;
+
+// 建索引用的商品文档(只包含参与检索、过滤和排序的字段)
+struct ProductSearchDocument {
+    long product_id = 0;
+    std::string name;
+    std::string description;
+    std::string short_description;
+    std::string brand;
+    std::string category;
+    double price = 0.0;
+    std::string created_at;
+};
+
+// 索引内检索条件，价格小于0表示不限
+struct ProductSearchQuery {
+    std::string keyword;
+    double min_price = -1;
+    double max_price = -1;
+    std::string sort_by;
+    size_t offset = 0;
+    size_t limit = 20;
+};
+
+struct ProductSearchResult {
+    size_t total = 0;
+    std::vector<long> product_ids;  // 当前页商品ID，已按排序规则排好
+};
+
+/**
+ * 商品全文检索倒排索引
+ * 覆盖名称、描述、简介、品牌和分类名称；中日韩文字按相邻二字切分(bigram)，
+ * 英文数字按词切分并支持前缀匹配。多个查询词项之间为AND关系，按BM25打分。
+ * 商品变更通过upsert/remove增量更新，删除采用墓碑标记，墓碑过多时整体压缩。
+ * 读写由读写锁保护，检索之间互不阻塞。
+ */
+class ProductSearchIndex {
+private:
+    struct Posting {
+        uint32_t slot;
+        float tf;  // 按字段权重累加的词频
+    };
+
+    struct Slot {
+        long product_id = 0;
+        double price = 0.0;
+        std::string name;
+        std::string created_at;
+        float length = 0.0f;
+        bool alive = false;
+        std::vector<std::pair<uint32_t, float>> terms;  // 正排：词项ID与词频，用于删除和迁移
+    };
+
+    struct Core {
+        std::unordered_map<std::string, uint32_t> term_ids;
+        std::vector<std::string> terms;
+        std::vector<std::vector<Posting>> postings;  // 按slot递增有序
+        std::vector<uint32_t> doc_freq;              // 仅统计存活文档
+        std::map<std::string, uint32_t> word_terms;  // 英文数字词项，用于前缀匹配
+        std::unordered_map<uint32_t, std::vector<uint32_t>> cjk_char_terms;  // 单字 -> 包含该字的词项
+        std::vector<Slot> slots;
+        std::unordered_map<long, uint32_t> slot_of;
+        size_t live_count = 0;
+        size_t dead_count = 0;
+        double total_length = 0.0;
+    };
+
+    mutable std::shared_mutex mutex_;
+    Core core_;
+    bool loaded_;
+    std::chrono::steady_clock::time_point loaded_at_;
+    uint64_t mutation_version_;
+    std::unordered_map<long, uint64_t> last_mutation_;  // 商品ID -> 最近一次增量变更的版本
+
+    static uint32_t internTerm(Core& core, const std::string& term);
+    static void addSlot(Core& core, long product_id, double price, const std::string& name,
+                        const std::string& created_at, const std::vector<std::pair<std::string, float>>& terms,
+                        float length);
+    static void addDocument(Core& core, const ProductSearchDocument& doc);
+    static bool removeDocument(Core& core, long product_id);
+    static void compact(Core& core);
+    static void compactIfNeeded(Core& core);
+
+    // 收集一个查询词项对应的所有倒排表(前缀展开或单字展开)
+    std::vector<uint32_t> expandQueryTerm(const std::string& term) const;
+
+public:
+    ProductSearchIndex();
+
+    ProductSearchIndex(const ProductSearchIndex&) = delete;
+    ProductSearchIndex& operator=(const ProductSearchIndex&) = delete;
+
+    // 按检索规则切分文本：英文数字转小写按词切分，中日韩连续文字切成相邻二字
+    static std::vector<std::string> tokenize(const std::string& text);
+
+    bool isLoaded() const;
+    std::chrono::steady_clock::time_point loadedAt() const;
+    uint64_t mutationVersion() const;
+
+    // 用全量文档替换索引；since_version之后增量变更过的商品保留当前索引中的版本
+    void replaceAll(const std::vector<ProductSearchDocument>& docs, uint64_t since_version);
+    void upsert(const ProductSearchDocument& doc);
+    void remove(long product_id);
+
+    ProductSearchResult search(const ProductSearchQuery& query) const;
+    json getStats() const;
+};
+
+#endif // PRODUCT_SEARCH_INDEX_H
@@ -1,76 +1,42 @@
 #include "ProductService.h"
 #include <sstream>
 #include <cctype>
+#include <map>
 
 // ==================== 私有辅助方法 ====================
 
-const std::string& ProductService::getProductIdColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("products", "product_id")) return "product_id";
-        if (hasColumn("products", "id")) return "id";
-        return "product_id";
-    }();
-    return column;
-}
-
-const std::string& ProductService::getProductStockColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("products", "stock_quantity")) return "stock_quantity";
-        if (hasColumn("products", "stock")) return "stock";
-        return "stock_quantity";
-    }();
-    return column;
-}
-
-const std::string& ProductService::getProductCategoryColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("products", "category_id")) return "category_id";
-        if (hasColumn("products", "category")) return "category";
-        return std::string();
-    }();
-    return column;
-}
-
-const std::string& ProductService::getProductStatusColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("products", "status")) return "status";
-        return std::string();
-    }();
-    return column;
-}
+// 按结构快照确定商品相关列名，并预先拼好库存概览的固定SQL片段
+ProductService::ProductSchema ProductService::buildSchema(const SchemaSnapshot& snapshot) const {
+    ProductSchema schema;
+    schema.id_column = snapshot.firstColumn("products", {"product_id", "id"}, "product_id");
+    schema.stock_column = snapshot.firstColumn("products", {"stock_quantity", "stock"}, "stock_quantity");
+    schema.category_column = snapshot.firstColumn("products", {"category_id", "category"});
+    schema.status_column = snapshot.firstColumn("products", {"status"});
+    schema.image_column = snapshot.firstColumn("products", {"main_image", "image_url"});
+    schema.created_column = snapshot.firstColumn("products", {"created_at", "create_time"});
+    schema.updated_column = snapshot.firstColumn("products", {"updated_at", "update_time"});
 
-const std::string& ProductService::getProductImageColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("products", "main_image")) return "main_image";
-        if (hasColumn("products", "image_url")) return "image_url";
-        return std::string();
-    }();
-    return column;
-}
-
-const std::string& ProductService::getProductCreatedAtColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("products", "created_at")) return "created_at";
-        if (hasColumn("products", "create_time")) return "create_time";
-        return std::string();
-    }();
-    return column;
-}
-
-const std::string& ProductService::getProductUpdatedAtColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("products", "updated_at")) return "updated_at";
-        if (hasColumn("products", "update_time")) return "update_time";
-        return std::string();
-    }();
-    return column;
+    std::vector<std::string> select_fields = {
+        aliasColumn(schema.id_column, "product_id"),
+        "name",
+        aliasColumn(schema.stock_column, "stock"),
+        snapshot.hasColumn("products", "price") ? std::string("price") : aliasColumn("", "price"),
+        aliasColumn(schema.category_column, "category"),
+        aliasColumn(schema.status_column, "status"),
+        aliasColumn(schema.image_column, "main_image"),
+        aliasColumn(schema.created_column, "created_at"),
+        aliasColumn(schema.updated_column, "updated_at")
+    };
+    schema.inventory_select = joinColumns(select_fields);
+    schema.inventory_where = "WHERE 1=1";
+    if (!schema.status_column.empty()) {
+        schema.inventory_where += " AND " + schema.status_column + " <> 'deleted'";
+    }
+    return schema;
 }
 
-std::string ProductService::qualifyProductColumn(const std::string& alias, const std::string& column_name) const {
-    if (column_name.empty()) {
-        return "";
-    }
-    return alias.empty() ? column_name : alias + "." + column_name;
+std::string ProductService::getProductIdColumnName() const {
+    return schema_.get()->id_column;
 }
 
 json ProductService::validateProductInput(const json& product_info) const {
@@ -113,10 +79,9 @@ json ProductService::validateProductInput(const json& product_info) const {
 }
 
 bool ProductService::isProductExists(long product_id) const {
-    std::string sql = "SELECT COUNT(*) as count FROM products WHERE product_id = " + 
-                     std::to_string(product_id) + " AND status != 'deleted'";
+    static const std::string sql = "SELECT COUNT(*) as count FROM products WHERE product_id = ? AND status != 'deleted'";
     
-    json result = const_cast<ProductService*>(this)->executeQuery(sql);
+    json result = const_cast<ProductService*>(this)->executePrepared(sql, {product_id});
     if (result["success"].get<bool>() && result["data"].is_array() && !result["data"].empty()) {
         return result["data"][0]["count"].get<long>() > 0;
     }
@@ -124,23 +89,63 @@ bool ProductService::isProductExists(long product_id) const {
 }
 
 json ProductService::getProductById(long product_id) const {
-    std::string sql = "SELECT product_id as id, name, description, price, stock_quantity as stock, "
-                     "category_id as category, status, created_at, updated_at FROM products WHERE product_id = " + 
-                     std::to_string(product_id) + " AND status != 'deleted'";
+    static const std::string sql = "SELECT product_id as id, name, description, price, stock_quantity as stock, "
+                                   "category_id as category, status, created_at, updated_at FROM products "
+                                   "WHERE product_id = ? AND status != 'deleted'";
     
-    json result = const_cast<ProductService*>(this)->executeQuery(sql);
+    json result = const_cast<ProductService*>(this)->executePrepared(sql, {product_id});
     if (result["success"].get<bool>() && result["data"].is_array() && !result["data"].empty()) {
         return result["data"][0];
     }
     return json::object();
 }
 
+json ProductService::getProductByIdShared(long product_id) {
+    return product_row_flight_.run(std::to_string(product_id), [this, product_id]() {
+        return getProductById(product_id);
+    }, [](const json& row) { return !row.empty(); });
+}
+
+void ProductService::invalidateProductCache(long product_id) {
+    if (product_id > 0) {
+        product_detail_cache_.erase(std::to_string(product_id));
+        product_row_flight_.forget(std::to_string(product_id));
+    }
+    // 列表页可能包含该商品，且新增/下架会改变分页结果，统一清空
+    product_list_cache_.clear();
+}
+
+void ProductService::invalidateStockCache(const std::vector<long>& product_ids) {
+    for (long product_id : product_ids) {
+        product_detail_cache_.erase(std::to_string(product_id));
+        product_row_flight_.forget(std::to_string(product_id));
+    }
+}
+
 // ==================== 公共接口方法 ====================
 
-ProductService::ProductService() : BaseService() {
+ProductService::ProductService()
+    : BaseService()
+    , product_detail_cache_(Constants::CATALOG_CACHE_SHARDS, Constants::CATALOG_CACHE_CAPACITY,
+                            std::chrono::seconds(Constants::CATALOG_DETAIL_TTL_SECONDS))
+    , category_cache_(1, 16, std::chrono::seconds(Constants::CATALOG_DETAIL_TTL_SECONDS))
+    , product_list_cache_(Constants::CATALOG_CACHE_SHARDS, Constants::CATALOG_CACHE_CAPACITY,
+                          std::chrono::seconds(Constants::CATALOG_LIST_TTL_SECONDS))
+    , product_row_flight_("product_by_id", Constants::SINGLE_FLIGHT_SHARDS,
+                          singleFlightTtl("product_ttl_ms", Constants::SINGLE_FLIGHT_PRODUCT_TTL_MS))
+    , search_index_building_(false)
+    , search_index_retry_at_ms_(0)
+    , schema_([this](const SchemaSnapshot& snapshot) { return buildSchema(snapshot); }) {
     logInfo("商品服务初始化完成");
 }
 
+ProductService::~ProductService() {
+    std::lock_guard<std::mutex> build_lock(search_index_build_mutex_);
+    if (search_index_builder_.joinable()) {
+        search_index_builder_.join();
+    }
+}
+
 std::string ProductService::getServiceName() const {
     return "ProductService";
 }
@@ -189,6 +194,8 @@ json ProductService::addProduct(const json& product_info) {
         json result = executeQuery(sql);
         if (result["success"].get<bool>()) {
             long product_id = result["data"]["insert_id"].get<long>();
+            invalidateProductCache(0);
+            refreshSearchDocument(product_id);
             
             json response_data;
             response_data["product_id"] = product_id;
@@ -296,6 +303,8 @@ json ProductService::updateProduct(long product_id, const json& update_info) {
         
         json result = executeQuery(sql);
         if (result["success"].get<bool>()) {
+            invalidateProductCache(product_id);
+            refreshSearchDocument(product_id);
             logInfo("商品信息更新成功，商品ID: " + std::to_string(product_id));
             return createSuccessResponse(json::object(), "商品信息更新成功");
         } else {
@@ -321,6 +330,8 @@ json ProductService::deleteProduct(long product_id) {
     
     json result = executeQuery(sql);
     if (result["success"].get<bool>()) {
+        invalidateProductCache(product_id);
+        search_index_.remove(product_id);
         logInfo("商品删除成功，商品ID: " + std::to_string(product_id));
         return createSuccessResponse(json::object(), "商品删除成功");
     }
@@ -329,71 +340,106 @@ json ProductService::deleteProduct(long product_id) {
 }
 
 json ProductService::getProductDetail(long product_id) {
-    logDebug("获取商品详情，商品ID: " + std::to_string(product_id));
+    logDebug("获取商品详情，商品ID: ", product_id);
     
-    json product_info = getProductById(product_id);
+    std::string cache_key = std::to_string(product_id);
+    std::shared_ptr<const json> cached;
+    if (product_detail_cache_.get(cache_key, cached)) {
+        return createSuccessResponse(*cached);
+    }
+    
+    // 回源期间发生失效时不写回缓存
+    uint64_t generation = product_detail_cache_.generation(cache_key);
+    json product_info = getProductByIdShared(product_id);
     if (product_info.empty()) {
         return createErrorResponse("商品不存在", Constants::VALIDATION_ERROR_CODE);
     }
     
+    product_detail_cache_.put(cache_key, std::make_shared<const json>(product_info), generation);
     return createSuccessResponse(product_info);
 }
 
+// 把分类筛选条件追加到where_clause，分类名称不存在时返回false
+bool ProductService::appendCategoryFilter(const std::string& category, std::string& where_clause) {
+    if (category == "all" || category.empty() || category == "0") {
+        logDebug("显示所有分类商品");
+        return true;
+    }
+    // 如果category是数字，直接用作category_id
+    if (std::all_of(category.begin(), category.end(), ::isdigit)) {
+        where_clause += " AND category_id = " + category;
+        logDebug("按分类ID筛选: ", category);
+        return true;
+    }
+    // 如果是分类名称，先查找分类ID
+    std::string category_sql = "SELECT category_id FROM categories WHERE name = '" + 
+                             escapeSQLString(category) + "' AND status = 'active'";
+    json category_result = executeQuery(category_sql);
+    
+    if (category_result["success"].get<bool>() && 
+        !category_result["data"].empty()) {
+        long category_id = category_result["data"][0]["category_id"].get<long>();
+        where_clause += " AND category_id = " + std::to_string(category_id);
+        logDebug("按分类名称筛选: ", category, " -> ID: ", category_id);
+        return true;
+    }
+    logInfo("分类不存在: " + category);
+    return false;
+}
+
 json ProductService::getProductList(const std::string& category, int page, int page_size) {
-    logDebug("获取商品列表，分类: [" + category + "], 页码: " + std::to_string(page) + 
-            ", 页大小: " + std::to_string(page_size));
+    JsonWriter out;
+    writeProductList(out, category, page, page_size);
+    return json::parse(out.str());
+}
+
+void ProductService::writeProductList(JsonWriter& out, const std::string& category, int page, int page_size) {
+    logDebug("获取商品列表，分类: [", category, "], 页码: ", page,
+            ", 页大小: ", page_size);
     
     std::pair<int, int> validation_result = validatePaginationParams(page, page_size);
     int validated_page = validation_result.first;
     int validated_page_size = validation_result.second;
     
+    // 命中缓存时只需重新包装响应外层
+    std::string cache_key = category + "|" + std::to_string(validated_page) + "|" + std::to_string(validated_page_size);
+    std::shared_ptr<const std::string> cached;
+    if (product_list_cache_.get(cache_key, cached)) {
+        out.clear();
+        beginSuccessResponse(out);
+        out.raw(*cached);
+        endSuccessResponse(out);
+        return;
+    }
+    
+    // 回源期间发生失效时不写回缓存
+    uint64_t generation = product_list_cache_.generation(cache_key);
     try {
         std::string where_clause = "WHERE status = 'active'";
         
         // 处理分类筛选
-        if (category != "all" && !category.empty() && category != "0") {
-            // 如果category是数字，直接用作category_id
-            if (std::all_of(category.begin(), category.end(), ::isdigit)) {
-                where_clause += " AND category_id = " + category;
-                logDebug("按分类ID筛选: " + category);
-            } else {
-                // 如果是分类名称，先查找分类ID
-                std::string category_sql = "SELECT category_id FROM categories WHERE name = '" + 
-                                         escapeSQLString(category) + "' AND status = 'active'";
-                json category_result = executeQuery(category_sql);
-                
-                if (category_result["success"].get<bool>() && 
-                    !category_result["data"].empty()) {
-                    long category_id = category_result["data"][0]["category_id"].get<long>();
-                    where_clause += " AND category_id = " + std::to_string(category_id);
-                    logDebug("按分类名称筛选: " + category + " -> ID: " + std::to_string(category_id));
-                } else {
-                    // 分类不存在，返回空结果
-                    logInfo("分类不存在: " + category);
-                    json empty_response = createSuccessResponse("操作成功");
-                    json data;
-                    data["products"] = json::array();
-                    data["total"] = 0;
-                    data["total_pages"] = 0;
-                    data["page"] = validated_page;
-                    data["page_size"] = validated_page_size;
-                    empty_response["data"] = data;
-                    return empty_response;
-                }
-            }
-        } else {
-            logDebug("显示所有分类商品");
+        if (!appendCategoryFilter(category, where_clause)) {
+            // 分类不存在，返回空结果
+            out.clear();
+            beginSuccessResponse(out);
+            size_t data_start = out.size();
+            out.raw('{');
+            out.key("page", true).number(validated_page);
+            out.key("page_size").number(validated_page_size);
+            out.key("products").raw("[]");
+            out.key("total").number(0);
+            out.key("total_pages").number(0);
+            out.raw('}');
+            product_list_cache_.put(cache_key, std::make_shared<const std::string>(out.str().substr(data_start)), generation);
+            endSuccessResponse(out);
+            return;
         }
         
-        // 获取总数
+        // 结果会写入缓存，两条查询都在主库上执行：副本可能还没追上刚发生的失效，
+        // 从副本读到的旧页面会在缓存中停留整个TTL
+        // 总数在另一条连接上与商品行查询并行执行
         std::string count_sql = "SELECT COUNT(*) as total FROM products " + where_clause;
-        json count_result = executeQuery(count_sql);
-        
-        if (!count_result["success"].get<bool>()) {
-            return count_result;
-        }
-        
-        long total = count_result["data"][0]["total"].get<long>();
+        std::future<json> count_future = executeQueryAsync(count_sql);
         
         // 获取商品列表
         std::string sql = "SELECT product_id as id, name, description, price, stock_quantity as stock, "
@@ -401,20 +447,89 @@ json ProductService::getProductList(const std::string& category, int page, int p
                          "FROM products " + where_clause + " ORDER BY created_at DESC";
         sql = addPaginationToSQL(sql, validated_page, validated_page_size);
         
-        json result = executeQuery(sql);
-        if (result["success"].get<bool>()) {
+        // 行数据直接写入响应，键按字母序排列以保持与原JSON输出一致
+        out.clear();
+        beginSuccessResponse(out);
+        size_t data_start = out.size();
+        out.raw('{');
+        out.key("page", true).number(validated_page);
+        out.key("page_size").number(validated_page_size);
+        out.key("products");
+        std::string error_msg;
+        if (!writeQueryRows(sql, out, error_msg)) {
+            writeErrorResponse(out, error_msg, Constants::DATABASE_ERROR_CODE);
+            return;
+        }
+        
+        json count_result = count_future.get();
+        if (!count_result["success"].get<bool>()) {
+            out.clear();
+            out.raw(count_result.dump());
+            return;
+        }
+        long total = count_result["data"][0]["total"].get<long>();
+        out.key("total").number(total);
+        out.key("total_pages").number((total + validated_page_size - 1) / validated_page_size);
+        out.raw('}');
+        product_list_cache_.put(cache_key, std::make_shared<const std::string>(out.str().substr(data_start)), generation);
+        endSuccessResponse(out);
+        
+    } catch (const std::exception& e) {
+        std::string error_msg = "获取商品列表异常: " + std::string(e.what());
+        logError(error_msg);
+        writeErrorResponse(out, error_msg, Constants::DATABASE_ERROR_CODE);
+    }
+}
+
+json ProductService::getProductListByCursor(const std::string& category, const std::string& cursor,
+                                            int page_size, bool include_total) {
+    logDebug("按游标获取商品列表，分类: [", category, "], 页大小: ", page_size);
+    
+    int validated_page_size = validatePaginationParams(1, page_size).second;
+    
+    try {
+        std::string where_clause = "WHERE status = 'active'";
+        if (!appendCategoryFilter(category, where_clause)) {
             json response_data;
-            response_data["products"] = result["data"];
-            response_data["total"] = total;
-            response_data["page"] = validated_page;
+            response_data["products"] = json::array();
             response_data["page_size"] = validated_page_size;
-            response_data["total_pages"] = (total + validated_page_size - 1) / validated_page_size;
-            
+            response_data["has_more"] = false;
+            response_data["next_cursor"] = nullptr;
+            if (include_total) {
+                response_data["total"] = 0;
+            }
             return createSuccessResponse(response_data);
-        } else {
+        }
+        
+        std::string sql = "SELECT product_id as id, name, description, price, stock_quantity as stock, "
+                         "category_id as category, created_at, updated_at "
+                         "FROM products " + where_clause;
+        if (!cursor.empty()) {
+            json sort_key;
+            long long last_id = 0;
+            if (!decodePageCursor(cursor, sort_key, last_id)) {
+                return createErrorResponse("无效的分页游标", Constants::VALIDATION_ERROR_CODE);
+            }
+            sql += " AND " + buildKeysetCondition("created_at", "product_id", sort_key, last_id);
+        }
+        sql += buildKeysetOrderAndLimit("created_at", "product_id", validated_page_size);
+        
+        json result = executeQuery(sql);
+        if (!result["success"].get<bool>()) {
             return result;
         }
         
+        json rows = result["data"];
+        json response_data = finishKeysetPage(rows, validated_page_size, "created_at", "id");
+        response_data["products"] = rows;
+        if (include_total) {
+            bool from_cache = false;
+            response_data["total"] = getCachedCount("SELECT COUNT(*) as total FROM products " + where_clause,
+                                                    from_cache);
+            response_data["total_cached"] = from_cache;
+        }
+        return createSuccessResponse(response_data);
+        
     } catch (const std::exception& e) {
         std::string error_msg = "获取商品列表异常: " + std::string(e.what());
         logError(error_msg);
@@ -424,12 +539,83 @@ json ProductService::getProductList(const std::string& category, int page, int p
 
 json ProductService::searchProducts(const std::string& keyword, int page, int page_size, 
                    const std::string& sort_by, double min_price, double max_price) {
-    logDebug("搜索商品，关键词: " + keyword);
+    JsonWriter out;
+    writeSearchProducts(out, keyword, page, page_size, sort_by, min_price, max_price);
+    return json::parse(out.str());
+}
+
+void ProductService::writeSearchProducts(JsonWriter& out, const std::string& keyword, int page, int page_size,
+                                         const std::string& sort_by, double min_price, double max_price) {
+    logDebug("搜索商品，关键词: ", keyword);
     
     std::pair<int, int> validation_result = validatePaginationParams(page, page_size);
     int validated_page = validation_result.first;
     int validated_page_size = validation_result.second;
     
+    // 索引尚未加载完成(首次加载中或加载失败)时退回数据库LIKE查询
+    if (!ensureSearchIndex()) {
+        writeSearchProductsBySql(out, keyword, validated_page, validated_page_size, sort_by, min_price, max_price);
+        return;
+    }
+    
+    try {
+        ProductSearchQuery query;
+        query.keyword = keyword;
+        query.min_price = min_price;
+        query.max_price = max_price;
+        query.sort_by = sort_by;
+        query.offset = static_cast<size_t>(validated_page - 1) * validated_page_size;
+        query.limit = static_cast<size_t>(validated_page_size);
+        ProductSearchResult found = search_index_.search(query);
+        long total = static_cast<long>(found.total);
+        
+        out.clear();
+        beginSuccessResponse(out);
+        out.raw('{');
+        out.key("keyword", true).string(keyword);
+        out.key("max_price").value(max_price);
+        out.key("min_price").value(min_price);
+        out.key("page").number(validated_page);
+        out.key("page_size").number(validated_page_size);
+        out.key("products");
+        if (found.product_ids.empty()) {
+            out.raw("[]");
+        } else {
+            // 索引只给出当前页的商品ID和顺序，行数据仍按主键从数据库读取
+            std::string id_list;
+            for (size_t i = 0; i < found.product_ids.size(); ++i) {
+                if (i > 0) id_list += ",";
+                id_list += std::to_string(found.product_ids[i]);
+            }
+            std::string sql = "SELECT p.product_id as id, p.name, p.description, p.price, "
+                             "p.stock_quantity as stock, c.name as category, p.brand, "
+                             "p.main_image, p.rating, p.review_count, p.created_at, p.updated_at "
+                             "FROM products p "
+                             "LEFT JOIN categories c ON p.category_id = c.category_id "
+                             "WHERE p.product_id IN (" + id_list + ") AND p.status = 'active' "
+                             "ORDER BY FIELD(p.product_id, " + id_list + ")";
+            std::string error_msg;
+            if (!writeReadQueryRows(sql, out, error_msg)) {
+                writeErrorResponse(out, error_msg, Constants::DATABASE_ERROR_CODE);
+                return;
+            }
+        }
+        out.key("sort_by").string(sort_by);
+        out.key("total").number(total);
+        out.key("total_pages").number((total + validated_page_size - 1) / validated_page_size);
+        out.raw('}');
+        endSuccessResponse(out);
+        
+    } catch (const std::exception& e) {
+        std::string error_msg = "搜索商品异常: " + std::string(e.what());
+        logError(error_msg);
+        writeErrorResponse(out, error_msg, Constants::DATABASE_ERROR_CODE);
+    }
+}
+
+void ProductService::writeSearchProductsBySql(JsonWriter& out, const std::string& keyword, int validated_page,
+                                              int validated_page_size, const std::string& sort_by,
+                                              double min_price, double max_price) {
     try {
         std::string where_clause = "WHERE p.status = 'active'";
         
@@ -467,7 +653,9 @@ json ProductService::searchProducts(const std::string& keyword, int page, int pa
         json count_result = executeQuery(count_sql);
         
         if (!count_result["success"].get<bool>()) {
-            return count_result;
+            out.clear();
+            out.raw(count_result.dump());
+            return;
         }
         
         long total = count_result["data"][0]["total"].get<long>();
@@ -481,34 +669,167 @@ json ProductService::searchProducts(const std::string& keyword, int page, int pa
                          where_clause + " " + order_clause;
         sql = addPaginationToSQL(sql, validated_page, validated_page_size);
         
-        json result = executeQuery(sql);
-        if (result["success"].get<bool>()) {
-            json response_data;
-            response_data["products"] = result["data"];
-            response_data["total"] = total;
-            response_data["page"] = validated_page;
-            response_data["page_size"] = validated_page_size;
-            response_data["total_pages"] = (total + validated_page_size - 1) / validated_page_size;
-            response_data["keyword"] = keyword;
-            response_data["min_price"] = min_price;
-            response_data["max_price"] = max_price;
-            response_data["sort_by"] = sort_by;
-            
-            return createSuccessResponse(response_data);
-        } else {
-            return result;
+        out.clear();
+        beginSuccessResponse(out);
+        out.raw('{');
+        out.key("keyword", true).string(keyword);
+        out.key("max_price").value(max_price);
+        out.key("min_price").value(min_price);
+        out.key("page").number(validated_page);
+        out.key("page_size").number(validated_page_size);
+        out.key("products");
+        std::string error_msg;
+        if (!writeReadQueryRows(sql, out, error_msg)) {
+            writeErrorResponse(out, error_msg, Constants::DATABASE_ERROR_CODE);
+            return;
         }
+        out.key("sort_by").string(sort_by);
+        out.key("total").number(total);
+        out.key("total_pages").number((total + validated_page_size - 1) / validated_page_size);
+        out.raw('}');
+        endSuccessResponse(out);
         
     } catch (const std::exception& e) {
         std::string error_msg = "搜索商品异常: " + std::string(e.what());
         logError(error_msg);
-        return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+        writeErrorResponse(out, error_msg, Constants::DATABASE_ERROR_CODE);
+    }
+}
+
+// ==================== 搜索索引 ====================
+
+const std::string& ProductService::searchDocumentSelect() {
+    static const std::string sql = "SELECT p.product_id, p.name, p.description, p.short_description, p.brand, "
+                                   "c.name AS category_name, p.price, p.created_at, p.status "
+                                   "FROM products p LEFT JOIN categories c ON p.category_id = c.category_id ";
+    return sql;
+}
+
+ProductSearchDocument ProductService::toSearchDocument(const json& row) {
+    auto text = [&row](const char* field) {
+        return row.contains(field) && row[field].is_string() ? row[field].get<std::string>() : std::string();
+    };
+    
+    ProductSearchDocument doc;
+    doc.product_id = row["product_id"].get<long>();
+    doc.name = text("name");
+    doc.description = text("description");
+    doc.short_description = text("short_description");
+    doc.brand = text("brand");
+    doc.category = text("category_name");
+    doc.created_at = text("created_at");
+    if (row.contains("price") && row["price"].is_number()) {
+        doc.price = row["price"].get<double>();
+    } else if (row.contains("price") && row["price"].is_string()) {
+        doc.price = std::strtod(row["price"].get<std::string>().c_str(), nullptr);
+    }
+    return doc;
+}
+
+bool ProductService::ensureSearchIndex() {
+    const auto refresh_interval = std::chrono::seconds(Constants::SEARCH_INDEX_REFRESH_SECONDS);
+    if (search_index_.isLoaded()) {
+        // 过期后在后台重建，检索请求不等待重建，继续使用旧索引
+        if (std::chrono::steady_clock::now() - search_index_.loadedAt() >= refresh_interval) {
+            scheduleSearchIndexRebuild();
+        }
+        return true;
+    }
+    
+    scheduleSearchIndexRebuild();
+    return false;
+}
+
+void ProductService::scheduleSearchIndexRebuild() {
+    auto steadyMs = []() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    };
+    if (search_index_building_.load() || steadyMs() < search_index_retry_at_ms_.load()) {
+        return;
+    }
+    std::unique_lock<std::mutex> build_lock(search_index_build_mutex_, std::try_to_lock);
+    if (!build_lock.owns_lock() || search_index_building_.load()) {
+        return;
+    }
+    // 上一次重建已经结束(building_已复位)，回收其线程
+    if (search_index_builder_.joinable()) {
+        search_index_builder_.join();
+    }
+    search_index_building_ = true;
+    search_index_builder_ = std::thread([this, steadyMs]() {
+        bool rebuilt = false;
+        try {
+            rebuilt = rebuildSearchIndex();
+        } catch (const std::exception& e) {
+            logError("重建商品搜索索引异常: " + std::string(e.what()));
+        }
+        if (!rebuilt) {
+            search_index_retry_at_ms_ = steadyMs() + Constants::SEARCH_INDEX_RETRY_SECONDS * 1000LL;
+        }
+        search_index_building_ = false;
+    });
+}
+
+bool ProductService::rebuildSearchIndex() {
+    auto started = std::chrono::steady_clock::now();
+    uint64_t since_version = search_index_.mutationVersion();
+    
+    // 按主键分批读取在售商品，避免一次性拉取整张表
+    static const std::string batch_sql = searchDocumentSelect() +
+        "WHERE p.status = 'active' AND p.product_id > ? ORDER BY p.product_id LIMIT ?";
+    std::vector<ProductSearchDocument> docs;
+    long long last_id = 0;
+    while (true) {
+        json result = executePrepared(batch_sql, {last_id, Constants::SEARCH_INDEX_LOAD_BATCH});
+        if (!result["success"].get<bool>()) {
+            logError("加载商品搜索索引失败: " + result.value("message", std::string()));
+            return false;
+        }
+        const json& rows = result["data"];
+        for (const auto& row : rows) {
+            docs.push_back(toSearchDocument(row));
+        }
+        if (rows.size() < static_cast<size_t>(Constants::SEARCH_INDEX_LOAD_BATCH)) {
+            break;
+        }
+        last_id = docs.back().product_id;
+    }
+    
+    search_index_.replaceAll(docs, since_version);
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    logInfo("商品搜索索引已重建，商品数: " + std::to_string(docs.size()) + ", 耗时: " +
+            std::to_string(elapsed) + "ms");
+    return true;
+}
+
+void ProductService::refreshSearchDocument(long product_id) {
+    static const std::string sql = searchDocumentSelect() + "WHERE p.product_id = ?";
+    json result = executePrepared(sql, {product_id});
+    if (!result["success"].get<bool>()) {
+        // 下次全量重建时会补上
+        logWarn("刷新商品搜索索引失败，商品ID: " + std::to_string(product_id));
+        return;
+    }
+    
+    const json& rows = result["data"];
+    if (rows.empty() || !rows[0]["status"].is_string() || rows[0]["status"].get<std::string>() != "active") {
+        search_index_.remove(product_id);
+    } else {
+        search_index_.upsert(toSearchDocument(rows[0]));
     }
 }
 
 json ProductService::getCategories() {
     logDebug("获取商品分类列表");
     
+    std::shared_ptr<const json> cached;
+    if (category_cache_.get("active", cached)) {
+        return createSuccessResponse(*cached);
+    }
+    uint64_t generation = category_cache_.generation("active");
+    
     std::string sql = "SELECT category_id as id, name, description, icon, sort_order "
                      "FROM categories WHERE status = 'active' ORDER BY sort_order, name";
     
@@ -516,6 +837,7 @@ json ProductService::getCategories() {
     if (result["success"].get<bool>()) {
         json response_data;
         response_data["categories"] = result["data"];
+        category_cache_.put("active", std::make_shared<const json>(response_data), generation);
         return createSuccessResponse(response_data);
     }
     
@@ -523,7 +845,7 @@ json ProductService::getCategories() {
 }
 
 json ProductService::getCategoryProducts(const std::string& category, int page, int page_size, const std::string& sort_by) {
-    logDebug("获取分类商品，分类: " + category);
+    logDebug("获取分类商品，分类: ", category);
     
     if (category.empty()) {
         return createErrorResponse("分类名称不能为空", Constants::VALIDATION_ERROR_CODE);
@@ -536,59 +858,87 @@ json ProductService::updateStock(long product_id, int quantity, const std::strin
     logInfo("更新库存，商品ID: " + std::to_string(product_id) + 
            ", 数量: " + std::to_string(quantity) + ", 操作: " + operation);
     
-    std::lock_guard<std::mutex> lock(stock_mutex_);
-    
-    if (!isProductExists(product_id)) {
-        return createErrorResponse("商品不存在", Constants::VALIDATION_ERROR_CODE);
+    if (quantity < 0 || quantity > Constants::MAX_PRODUCT_QUANTITY) {
+        return createErrorResponse("库存数量超出有效范围", Constants::VALIDATION_ERROR_CODE);
     }
     
+    // 库存变更由单条带条件的UPDATE完成，数据库行锁保证并发安全(多进程部署同样有效)，
+    // 新库存通过LAST_INSERT_ID(expr)随同一语句带回，无需再读一次
+    static const std::string add_sql =
+        "UPDATE products SET stock_quantity = LAST_INSERT_ID(stock_quantity + ?), updated_at = NOW() "
+        "WHERE product_id = ? AND status != 'deleted' AND stock_quantity + ? <= ?";
+    static const std::string subtract_sql =
+        "UPDATE products SET stock_quantity = LAST_INSERT_ID(stock_quantity - ?), updated_at = NOW() "
+        "WHERE product_id = ? AND status != 'deleted' AND stock_quantity >= ?";
+    static const std::string set_sql =
+        "UPDATE products SET stock_quantity = LAST_INSERT_ID(?), updated_at = NOW() "
+        "WHERE product_id = ? AND status != 'deleted'";
+    
     try {
-        // 获取当前库存
-        json product_info = getProductById(product_id);
-        if (product_info.empty()) {
-            return createErrorResponse("获取商品信息失败", Constants::DATABASE_ERROR_CODE);
-        }
-        
-        int current_stock = product_info["stock"].get<int>();
-        int new_stock = current_stock;
-        
+        json result;
+        int old_stock = 0;
         if (operation == "add") {
-            new_stock = current_stock + quantity;
+            result = executePrepared(add_sql, {quantity, product_id, quantity, Constants::MAX_PRODUCT_QUANTITY});
         } else if (operation == "subtract") {
-            new_stock = current_stock - quantity;
-            if (new_stock < 0) {
-                return createErrorResponse("库存不足", Constants::VALIDATION_ERROR_CODE);
-            }
+            result = executePrepared(subtract_sql, {quantity, product_id, quantity});
         } else if (operation == "set") {
-            new_stock = quantity;
+            // 覆盖写入与旧值无关，旧库存仅用于返回展示
+            json product_info = getProductById(product_id);
+            if (product_info.empty()) {
+                return createErrorResponse("商品不存在", Constants::VALIDATION_ERROR_CODE);
+            }
+            old_stock = product_info["stock"].get<int>();
+            result = executePrepared(set_sql, {quantity, product_id});
         } else {
             return createErrorResponse("无效的操作类型", Constants::VALIDATION_ERROR_CODE);
         }
         
-        if (new_stock < 0 || new_stock > Constants::MAX_PRODUCT_QUANTITY) {
-            return createErrorResponse("库存数量超出有效范围", Constants::VALIDATION_ERROR_CODE);
+        if (!result["success"].get<bool>()) {
+            return result;
         }
         
-        // 更新库存
-        std::string sql = "UPDATE products SET stock_quantity = " + std::to_string(new_stock) + 
-                         ", updated_at = NOW() WHERE product_id = " + std::to_string(product_id);
-        
-        json result = executeQuery(sql);
-        if (result["success"].get<bool>()) {
-            json response_data;
-            response_data["product_id"] = product_id;
-            response_data["old_stock"] = current_stock;
-            response_data["new_stock"] = new_stock;
-            response_data["operation"] = operation;
-            response_data["quantity"] = quantity;
-            
-            logInfo("库存更新成功，商品ID: " + std::to_string(product_id) + 
-                   ", 新库存: " + std::to_string(new_stock));
-            return createSuccessResponse(response_data, "库存更新成功");
+        int new_stock = 0;
+        if (result["data"]["affected_rows"].get<int>() > 0) {
+            new_stock = static_cast<int>(result["data"]["insert_id"].get<long>());
+            if (operation == "add") {
+                old_stock = new_stock - quantity;
+            } else if (operation == "subtract") {
+                old_stock = new_stock + quantity;
+            }
+            invalidateProductCache(product_id);
         } else {
-            return result;
+            // 未命中任何行：区分商品不存在、库存不足/越界和值未变化(数量为0或set为原值)
+            json product_info = getProductById(product_id);
+            if (product_info.empty()) {
+                return createErrorResponse("商品不存在", Constants::VALIDATION_ERROR_CODE);
+            }
+            int current_stock = product_info["stock"].get<int>();
+            if (operation == "subtract" && current_stock < quantity) {
+                return createErrorResponse("库存不足", Constants::VALIDATION_ERROR_CODE);
+            }
+            if (operation == "add" && current_stock + quantity > Constants::MAX_PRODUCT_QUANTITY) {
+                return createErrorResponse("库存数量超出有效范围", Constants::VALIDATION_ERROR_CODE);
+            }
+            if (operation == "set" && current_stock != quantity) {
+                return createErrorResponse("库存更新失败，请重试", Constants::DATABASE_ERROR_CODE);
+            }
+            if (operation != "set") {
+                old_stock = current_stock;
+            }
+            new_stock = current_stock;
         }
         
+        json response_data;
+        response_data["product_id"] = product_id;
+        response_data["old_stock"] = old_stock;
+        response_data["new_stock"] = new_stock;
+        response_data["operation"] = operation;
+        response_data["quantity"] = quantity;
+        
+        logInfo("库存更新成功，商品ID: " + std::to_string(product_id) + 
+               ", 新库存: " + std::to_string(new_stock));
+        return createSuccessResponse(response_data, "库存更新成功");
+        
     } catch (const std::exception& e) {
         std::string error_msg = "更新库存异常: " + std::string(e.what());
         logError(error_msg);
@@ -596,10 +946,75 @@ json ProductService::updateStock(long product_id, int quantity, const std::strin
     }
 }
 
+json ProductService::reserveStock(const std::vector<StockReservation>& items) {
+    logInfo("批量预留库存，商品数: " + std::to_string(items.size()));
+    
+    try {
+        Transaction tx(*this);
+        json result = reserveStockWithConnection(tx.connection(), items);
+        if (!result["success"].get<bool>()) {
+            return result;
+        }
+        if (!tx.commit()) {
+            return createErrorResponse("提交库存预留失败", Constants::DATABASE_ERROR_CODE);
+        }
+        std::vector<long> product_ids;
+        for (const auto& entry : result["data"]["reserved"]) {
+            product_ids.push_back(entry["product_id"].get<long>());
+        }
+        invalidateStockCache(product_ids);
+        return result;
+    } catch (const std::exception& e) {
+        std::string error_msg = "预留库存异常: " + std::string(e.what());
+        logError(error_msg);
+        return createErrorResponse(error_msg, Constants::DATABASE_ERROR_CODE);
+    }
+}
+
+json ProductService::reserveStockWithConnection(MYSQL* conn, const std::vector<StockReservation>& items) {
+    // 合并同一商品的数量并按商品ID排序，所有事务以相同顺序加行锁，避免相互死锁
+    std::map<long, long long> merged;
+    for (const auto& item : items) {
+        if (item.product_id <= 0 || item.quantity <= 0) {
+            return createErrorResponse("无效的库存预留参数", Constants::VALIDATION_ERROR_CODE);
+        }
+        merged[item.product_id] += item.quantity;
+    }
+    
+    static const std::string reserve_sql =
+        "UPDATE products SET stock_quantity = stock_quantity - ?, updated_at = NOW() "
+        "WHERE product_id = ? AND status = 'active' AND stock_quantity >= ?";
+    
+    json reserved = json::array();
+    for (const auto& kv : merged) {
+        json result = executePreparedWithConnection(conn, reserve_sql, {kv.second, kv.first, kv.second});
+        if (!result["success"].get<bool>()) {
+            return result;
+        }
+        if (result["data"]["affected_rows"].get<int>() == 0) {
+            // 已扣减的行由调用方回滚事务恢复
+            json error = createErrorResponse("库存不足或商品不可售，商品ID: " + std::to_string(kv.first),
+                                             Constants::VALIDATION_ERROR_CODE);
+            error["data"]["product_id"] = kv.first;
+            error["data"]["quantity"] = kv.second;
+            return error;
+        }
+        json entry;
+        entry["product_id"] = kv.first;
+        entry["quantity"] = kv.second;
+        reserved.push_back(entry);
+    }
+    
+    // 缓存由调用方在提交后失效，提交前失效会让并发读在提交前把旧库存重新写回缓存
+    json response_data;
+    response_data["reserved"] = reserved;
+    return createSuccessResponse(response_data, "库存预留成功");
+}
+
 json ProductService::checkStock(long product_id) {
-    logDebug("检查库存，商品ID: " + std::to_string(product_id));
+    logDebug("检查库存，商品ID: ", product_id);
     
-    json product_info = getProductById(product_id);
+    json product_info = getProductByIdShared(product_id);
     if (product_info.empty()) {
         return createErrorResponse("商品不存在", Constants::VALIDATION_ERROR_CODE);
     }
@@ -614,51 +1029,16 @@ json ProductService::checkStock(long product_id) {
 }
 
 json ProductService::getLowStockProducts(int threshold) {
-    logDebug("获取库存概览，低库存阈值: " + std::to_string(threshold));
+    logDebug("获取库存概览，低库存阈值: ", threshold);
     if (threshold < 0) {
         threshold = 0;
     }
 
-    const std::string& id_column = getProductIdColumnName();
-    const std::string& stock_column = getProductStockColumnName();
-    const std::string& category_column = getProductCategoryColumnName();
-    const std::string& status_column = getProductStatusColumnName();
-    const std::string& image_column = getProductImageColumnName();
-    const std::string& created_column = getProductCreatedAtColumnName();
-    const std::string& updated_column = getProductUpdatedAtColumnName();
-
-    std::vector<std::string> select_fields = {
-        aliasColumn(qualifyProductColumn("", id_column), "product_id"),
-        "name",
-        aliasColumn(qualifyProductColumn("", stock_column), "stock")
-    };
-
-    if (hasColumn("products", "price")) {
-        select_fields.push_back("price");
-    } else {
-        select_fields.push_back(aliasColumn("", "price"));
-    }
-
-    select_fields.push_back(aliasColumn(qualifyProductColumn("", category_column), "category"));
-    select_fields.push_back(aliasColumn(qualifyProductColumn("", status_column), "status"));
-    select_fields.push_back(aliasColumn(qualifyProductColumn("", image_column), "main_image"));
-    select_fields.push_back(aliasColumn(created_column.empty() ? std::string() : qualifyProductColumn("", created_column), "created_at"));
-    select_fields.push_back(aliasColumn(updated_column.empty() ? std::string() : qualifyProductColumn("", updated_column), "updated_at"));
-
-    const std::string stock_expr = qualifyProductColumn("", stock_column);
-    std::string low_stock_expr = "0";
-    if (!stock_expr.empty()) {
-        low_stock_expr = "CASE WHEN " + stock_expr + " <= " + std::to_string(threshold) + " THEN 1 ELSE 0 END";
-    }
-    select_fields.push_back(low_stock_expr + " AS is_low_stock");
-
-    std::string where_clause = "WHERE 1=1";
-    if (!status_column.empty()) {
-        where_clause += " AND " + status_column + " <> 'deleted'";
-    }
-
-    std::string sql = "SELECT " + joinColumns(select_fields) + " FROM products " + where_clause +
-                      " ORDER BY is_low_stock DESC, stock ASC";
+    std::shared_ptr<const ProductSchema> schema = schema_.get();
+    std::string low_stock_expr = "CASE WHEN " + schema->stock_column + " <= " + std::to_string(threshold) +
+                                 " THEN 1 ELSE 0 END";
+    std::string sql = "SELECT " + schema->inventory_select + ", " + low_stock_expr + " AS is_low_stock FROM products " +
+                      schema->inventory_where + " ORDER BY is_low_stock DESC, stock ASC";
 
     json query_result = executeQuery(sql);
     if (!query_result["success"].get<bool>()) {
@@ -711,8 +1091,8 @@ json ProductService::getLowStockProducts(int threshold) {
  * @param period 限购周期: total(总限购), daily(每日), weekly(每周), monthly(每月)
  */
 json ProductService::setPurchaseLimit(long product_id, int limit, const std::string& period) {
-    logDebug("设置商品限购，商品ID: " + std::to_string(product_id) + 
-             ", 限购数量: " + std::to_string(limit) + ", 周期: " + period);
+    logDebug("设置商品限购，商品ID: ", product_id,
+             ", 限购数量: ", limit, ", 周期: ", period);
     
     // 检查商品是否存在
     if (!isProductExists(product_id)) {
@@ -756,9 +1136,9 @@ json ProductService::setPurchaseLimit(long product_id, int limit, const std::str
  * @param quantity 购买数量
  */
 json ProductService::checkPurchaseLimit(long user_id, long product_id, int quantity) {
-    logDebug("检查限购，用户ID: " + std::to_string(user_id) + 
-             ", 商品ID: " + std::to_string(product_id) + 
-             ", 数量: " + std::to_string(quantity));
+    logDebug("检查限购，用户ID: ", user_id,
+             ", 商品ID: ", product_id,
+             ", 数量: ", quantity);
     
     // 调用存储过程检查限购
     std::string sql = "CALL check_user_purchase_limit(" + 
@@ -827,8 +1207,8 @@ json ProductService::checkPurchaseLimit(long user_id, long product_id, int quant
  * @param period 统计周期: all(全部), daily(今日), weekly(本周), monthly(本月)
  */
 json ProductService::getUserPurchaseHistory(long user_id, long product_id, const std::string& period) {
-    logDebug("获取用户购买历史，用户ID: " + std::to_string(user_id) + 
-             ", 商品ID: " + std::to_string(product_id) + ", 周期: " + period);
+    logDebug("获取用户购买历史，用户ID: ", user_id,
+             ", 商品ID: ", product_id, ", 周期: ", period);
     
     std::string time_condition;
     if (period == "daily") {
@@ -883,3 +1263,49 @@ json ProductService::getUserPurchaseHistory(long user_id, long product_id, const
     return createSuccessResponse(response_data, "获取购买历史成功");
 }
 
+
+// ==================== 缓存管理 ====================
+
+json ProductService::getCacheStats() const {
+    json caches;
+    caches["product_detail"] = product_detail_cache_.stats();
+    caches["product_list"] = product_list_cache_.stats();
+    caches["categories"] = category_cache_.stats();
+    
+    long long hits = 0;
+    long long misses = 0;
+    long long total_keys = 0;
+    long long expired_keys = 0;
+    long long evicted_keys = 0;
+    long long invalidated_keys = 0;
+    for (const auto& item : caches.items()) {
+        const json& cache = item.value();
+        hits += cache["hits"].get<long long>();
+        misses += cache["misses"].get<long long>();
+        total_keys += cache["keys"].get<long long>();
+        expired_keys += cache["expired_keys"].get<long long>();
+        evicted_keys += cache["evicted_keys"].get<long long>();
+        invalidated_keys += cache["invalidated_keys"].get<long long>();
+    }
+    
+    long long lookups = hits + misses;
+    json stats;
+    stats["total_keys"] = total_keys;
+    stats["hits"] = hits;
+    stats["misses"] = misses;
+    stats["hit_rate"] = lookups > 0 ? 100.0 * hits / lookups : 0.0;
+    stats["miss_rate"] = lookups > 0 ? 100.0 * misses / lookups : 0.0;
+    stats["expired_keys"] = expired_keys;
+    stats["evicted_keys"] = evicted_keys;
+    stats["invalidated_keys"] = invalidated_keys;
+    stats["caches"] = caches;
+    stats["search_index"] = search_index_.getStats();
+    stats["search_index"]["rebuilding"] = search_index_building_.load();
+    return stats;
+}
+
+size_t ProductService::clearCatalogCache() {
+    size_t cleared = product_detail_cache_.clear() + product_list_cache_.clear() + category_cache_.clear();
+    logInfo("商品目录缓存已清空，清除条目数: " + std::to_string(cleared));
+    return cleared;
+}
@@ -3,14 +3,23 @@
 
 #include <string>
 #include <mutex>
+#include <memory>
 #include <vector>
 #include <algorithm>
 #include "../nlohmann_json.hpp"
+#include "ProductSearchIndex.h"
 
 using json = nlohmann::json;
 
 // 前向声明 - BaseService将在主文件中定义
 class BaseService;
+class JsonWriter;
+
+// 库存预留条目
+struct StockReservation {
+    long product_id;
+    int quantity;
+};
 
 /**
  * 商品服务类
@@ -19,17 +28,59 @@ class BaseService;
  */
 class ProductService : public BaseService {
 private:
-    std::mutex stock_mutex_;  // 库存操作互斥锁
+    // 商品目录缓存：详情和分类缓存JSON对象，列表缓存data部分的JSON文本
+    ShardedTtlCache<std::shared_ptr<const json>> product_detail_cache_;
+    ShardedTtlCache<std::shared_ptr<const json>> category_cache_;
+    ShardedTtlCache<std::shared_ptr<const std::string>> product_list_cache_;
+    
+    // 单商品查询的请求合并：详情缓存未命中和库存查询时，同一商品的并发查询只执行一次
+    SingleFlight<json> product_row_flight_;
+    
+    // 商品搜索倒排索引：首次搜索时全量加载，商品变更时增量刷新，定期全量重建。
+    // 全量加载和重建都在后台线程进行，期间检索继续使用旧索引(首次加载期间走数据库检索)
+    ProductSearchIndex search_index_;
+    std::mutex search_index_build_mutex_;  // 保护后台重建线程的启动与回收
+    std::thread search_index_builder_;
+    std::atomic<bool> search_index_building_;
+    std::atomic<long long> search_index_retry_at_ms_;  // 重建失败后在此时刻(steady_clock毫秒)之前不再重试
+    
+    static const std::string& searchDocumentSelect();
+    static ProductSearchDocument toSearchDocument(const json& row);
+    // 索引已加载时返回true(过期则安排后台重建)；尚未加载时安排后台加载并返回false
+    bool ensureSearchIndex();
+    // 没有进行中的重建且不在失败等待期内时，启动后台线程全量重建索引
+    void scheduleSearchIndexRebuild();
+    bool rebuildSearchIndex();
+    // 从数据库重新读取单个商品并更新索引，下架/删除的商品从索引移除
+    void refreshSearchDocument(long product_id);
+    // 索引不可用时的数据库LIKE检索
+    void writeSearchProductsBySql(JsonWriter& out, const std::string& keyword, int validated_page,
+                                  int validated_page_size, const std::string& sort_by,
+                                  double min_price, double max_price);
+    
+    // 商品数据变更后失效相关缓存
+    void invalidateProductCache(long product_id);
+    
+    // 按当前表结构确定的商品列名和固定SQL片段，表结构刷新后重新生成
+    struct ProductSchema {
+        std::string id_column;
+        std::string stock_column;
+        std::string category_column;
+        std::string status_column;
+        std::string image_column;
+        std::string created_column;
+        std::string updated_column;
+        std::string inventory_select;  // 库存概览的SELECT列表(不含低库存标记)
+        std::string inventory_where;   // 库存概览的WHERE条件
+    };
+    SchemaBound<ProductSchema> schema_;
+    ProductSchema buildSchema(const SchemaSnapshot& snapshot) const;
     
     // 列名辅助方法
-    const std::string& getProductIdColumnName() const;
-    const std::string& getProductStockColumnName() const;
-    const std::string& getProductCategoryColumnName() const;
-    const std::string& getProductStatusColumnName() const;
-    const std::string& getProductImageColumnName() const;
-    const std::string& getProductCreatedAtColumnName() const;
-    const std::string& getProductUpdatedAtColumnName() const;
-    std::string qualifyProductColumn(const std::string& alias, const std::string& column_name) const;
+    std::string getProductIdColumnName() const;
+    
+    // 追加分类筛选条件，分类名称不存在时返回false
+    bool appendCategoryFilter(const std::string& category, std::string& where_clause);
     
     // 验证商品输入
     json validateProductInput(const json& product_info) const;
@@ -39,9 +90,12 @@ private:
     
     // 获取商品详细信息（内部方法）
     json getProductById(long product_id) const;
+    // 经请求合并的只读查询，供详情和库存查询使用；事务内的读取仍直接调用getProductById
+    json getProductByIdShared(long product_id);
     
 public:
     ProductService();
+    ~ProductService() override;
     
     std::string getServiceName() const override;
     
@@ -52,10 +106,19 @@ public:
     json getProductDetail(long product_id);
     json getProductList(const std::string& category, int page, int page_size);
     
+    // 游标分页版商品列表，cursor为上一页返回的next_cursor，首页传空字符串
+    json getProductListByCursor(const std::string& category, const std::string& cursor,
+                                int page_size, bool include_total);
+    
     // 商品搜索
     json searchProducts(const std::string& keyword, int page, int page_size, 
                        const std::string& sort_by, double min_price, double max_price);
     
+    // 流式版本 - 直接把完整响应写入out，供JNI层跳过JSON对象构建
+    void writeProductList(JsonWriter& out, const std::string& category, int page, int page_size);
+    void writeSearchProducts(JsonWriter& out, const std::string& keyword, int page, int page_size,
+                             const std::string& sort_by, double min_price, double max_price);
+    
     // 分类管理
     json getCategories();
     json getCategoryProducts(const std::string& category, int page, int page_size, const std::string& sort_by);
@@ -63,8 +126,19 @@ public:
     // 库存管理
     json updateStock(long product_id, int quantity, const std::string& operation);
     json checkStock(long product_id);
+    
+    // 批量预留库存(多商品订单)：全部扣减成功才提交，任一商品不足则整体回滚
+    json reserveStock(const std::vector<StockReservation>& items);
+    // 在调用方已开启的事务中预留库存，失败时由调用方回滚；提交后由调用方调用invalidateStockCache
+    json reserveStockWithConnection(MYSQL* conn, const std::vector<StockReservation>& items);
+    // 库存变更提交后失效这些商品的详情缓存和合并结果。列表缓存有效期短，不因库存变化整体清空
+    void invalidateStockCache(const std::vector<long>& product_ids);
     json getLowStockProducts(int threshold);
     
+    // 缓存管理
+    json getCacheStats() const;
+    size_t clearCatalogCache();
+    
     // 限购管理
     json setPurchaseLimit(long product_id, int limit, const std::string& period);
     json checkPurchaseLimit(long user_id, long product_id, int quantity);
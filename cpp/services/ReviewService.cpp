@@ -45,6 +45,7 @@ json ReviewService::addProductReview(long user_id, long product_id, long order_i
         json result = executeQuery(sql);
         if (result["success"].get<bool>()) {
             long review_id = result["data"]["insert_id"].get<long>();
+            markUserWrite(user_id);
             
             // 更新商品评分统计
             updateProductRating(product_id);
@@ -3,31 +3,37 @@
 
 // ==================== 私有辅助方法 ====================
 
-const std::string& UserService::getUserIdColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("users", "user_id")) return "user_id";
-        if (hasColumn("users", "id")) return "id";
-        return "user_id";
-    }();
-    return column;
+// 按结构快照确定用户相关列名，并预先拼好用户查询的SELECT部分
+UserService::UserSchema UserService::buildSchema(const SchemaSnapshot& snapshot) const {
+    UserSchema schema;
+    schema.id_column = snapshot.firstColumn("users", {"user_id", "id"}, "user_id");
+    schema.created_column = snapshot.firstColumn("users", {"created_at", "create_time"});
+    schema.updated_column = snapshot.firstColumn("users", {"updated_at", "update_time"});
+
+    std::vector<std::string> select_fields = {
+        aliasColumn(schema.id_column, "user_id"),
+        "username",
+        "phone",
+        "email",
+        "role",
+        "status",
+        aliasColumn(schema.created_column, "created_at"),
+        aliasColumn(schema.updated_column, "updated_at")
+    };
+    schema.user_select = "SELECT " + joinColumns(select_fields) + " FROM users";
+    return schema;
+}
+
+std::string UserService::getUserIdColumnName() const {
+    return schema_.get()->id_column;
 }
 
-const std::string& UserService::getUserCreatedAtColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("users", "created_at")) return "created_at";
-        if (hasColumn("users", "create_time")) return "create_time";
-        return std::string();
-    }();
-    return column;
+std::string UserService::getUserCreatedAtColumnName() const {
+    return schema_.get()->created_column;
 }
 
-const std::string& UserService::getUserUpdatedAtColumnName() const {
-    static const std::string column = [this]() -> std::string {
-        if (hasColumn("users", "updated_at")) return "updated_at";
-        if (hasColumn("users", "update_time")) return "update_time";
-        return std::string();
-    }();
-    return column;
+std::string UserService::getUserUpdatedAtColumnName() const {
+    return schema_.get()->updated_column;
 }
 
 std::string UserService::qualifyUserColumn(const std::string& alias, const std::string& column_name) const {
@@ -44,12 +50,7 @@ std::string UserService::hashPassword(const std::string& password) const {
 }
 
 std::string UserService::generateToken(long user_id) {
-    std::string token = StringUtils::generateRandomString(32) + "_" + std::to_string(user_id);
-    
-    std::lock_guard<std::mutex> lock(session_mutex_);
-    active_sessions_[user_id] = token;
-    
-    return token;
+    return sessions_.create(user_id);
 }
 
 json UserService::validateUserInput(const std::string& username, const std::string& password, 
@@ -86,6 +87,24 @@ bool UserService::isUsernameExists(const std::string& username) const {
     return false;
 }
 
+std::string UserService::buildUserListSelect() const {
+    return schema_.get()->user_select + " WHERE 1=1";
+}
+
+std::string UserService::buildUserListFilter(const std::string& status, const std::string& keyword) const {
+    std::string filter;
+    if (!status.empty() && StringUtils::toLower(status) != "all") {
+        filter += " AND status = '" + escapeSQLString(status) + "'";
+    }
+
+    if (!keyword.empty()) {
+        std::string escapedKeyword = escapeSQLString(keyword);
+        filter += " AND (username LIKE '%" + escapedKeyword + "%'";
+        filter += " OR CAST(" + getUserIdColumnName() + " AS CHAR) = '" + escapedKeyword + "')";
+    }
+    return filter;
+}
+
 json UserService::fetchUsers(int page, int pageSize, const std::string& status, const std::string& keyword) {
     if (page < 1) {
         page = 1;
@@ -97,43 +116,63 @@ json UserService::fetchUsers(int page, int pageSize, const std::string& status,
     }
     int offset = (page - 1) * pageSize;
 
-    const std::string& id_column = getUserIdColumnName();
-    const std::string& created_column = getUserCreatedAtColumnName();
-    const std::string& updated_column = getUserUpdatedAtColumnName();
+    std::string id_column = getUserIdColumnName();
+    std::string created_column = getUserCreatedAtColumnName();
 
-    std::vector<std::string> select_fields = {
-        aliasColumn(qualifyUserColumn("", id_column), "user_id"),
-        "username",
-        "phone",
-        "email",
-        "role",
-        "status"
-    };
-    select_fields.push_back(aliasColumn(qualifyUserColumn("", created_column), "created_at"));
-    select_fields.push_back(aliasColumn(qualifyUserColumn("", updated_column), "updated_at"));
+    std::string sql = buildUserListSelect() + buildUserListFilter(status, keyword);
 
-    std::string sql = "SELECT " + joinColumns(select_fields) + " FROM users WHERE 1=1";
+    std::string order_column = !created_column.empty() ? created_column : id_column;
+    sql += " ORDER BY " + order_column + " DESC";
+    sql += " LIMIT " + std::to_string(pageSize) + " OFFSET " + std::to_string(offset);
 
-    if (!status.empty() && StringUtils::toLower(status) != "all") {
-        sql += " AND status = '" + escapeSQLString(status) + "'";
+    return executeQuery(sql);
+}
+
+json UserService::getAllUsersByCursor(const std::string& cursor, int pageSize, const std::string& status,
+                                      const std::string& keyword, bool include_total) {
+    if (pageSize <= 0) {
+        pageSize = Constants::DEFAULT_PAGE_SIZE;
+    } else if (pageSize > Constants::MAX_PAGE_SIZE) {
+        pageSize = Constants::MAX_PAGE_SIZE;
     }
 
-    if (!keyword.empty()) {
-        std::string escapedKeyword = escapeSQLString(keyword);
-        sql += " AND (username LIKE '%" + escapedKeyword + "%'";
-        sql += " OR CAST(" + id_column + " AS CHAR) = '" + escapedKeyword + "')";
+    std::string id_column = getUserIdColumnName();
+    std::string created_column = getUserCreatedAtColumnName();
+    std::string filter = buildUserListFilter(status, keyword);
+
+    std::string sql = buildUserListSelect() + filter;
+    if (!cursor.empty()) {
+        json sort_key;
+        long long last_id = 0;
+        if (!decodePageCursor(cursor, sort_key, last_id)) {
+            return createErrorResponse("无效的分页游标", Constants::VALIDATION_ERROR_CODE);
+        }
+        sql += " AND " + buildKeysetCondition(created_column, id_column, sort_key, last_id);
     }
+    sql += buildKeysetOrderAndLimit(created_column, id_column, pageSize);
 
-    std::string order_column = !created_column.empty() ? created_column : id_column;
-    sql += " ORDER BY " + order_column + " DESC";
-    sql += " LIMIT " + std::to_string(pageSize) + " OFFSET " + std::to_string(offset);
+    json result = executeQuery(sql);
+    if (!result["success"].get<bool>()) {
+        return result;
+    }
 
-    return executeQuery(sql);
+    json rows = result["data"];
+    json response_data = finishKeysetPage(rows, pageSize, created_column.empty() ? "" : "created_at", "user_id");
+    response_data["users"] = rows;
+    if (include_total) {
+        bool from_cache = false;
+        response_data["total"] = getCachedCount("SELECT COUNT(*) as total FROM users WHERE 1=1" + filter, from_cache);
+        response_data["total_cached"] = from_cache;
+    }
+    return createSuccessResponse(response_data, "获取用户列表成功");
 }
 
 // ==================== 公共接口方法 ====================
 
-UserService::UserService() : BaseService() {
+UserService::UserService()
+    : BaseService()
+    , schema_([this](const SchemaSnapshot& snapshot) { return buildSchema(snapshot); }) {
+    sessions_.start();
     logInfo("用户服务初始化完成");
 }
 
@@ -142,23 +181,9 @@ std::string UserService::getServiceName() const {
 }
 
 json UserService::getUserById(long user_id) const {
-    const std::string& id_column = getUserIdColumnName();
-    const std::string& created_column = getUserCreatedAtColumnName();
-    const std::string& updated_column = getUserUpdatedAtColumnName();
-
-    std::vector<std::string> select_fields = {
-        aliasColumn(qualifyUserColumn("", id_column), "user_id"),
-        "username",
-        "phone",
-        "email",
-        "role",
-        "status"
-    };
-    select_fields.push_back(aliasColumn(qualifyUserColumn("", created_column), "created_at"));
-    select_fields.push_back(aliasColumn(qualifyUserColumn("", updated_column), "updated_at"));
-
-    std::string sql = "SELECT " + joinColumns(select_fields) + " FROM users WHERE " +
-                      id_column + " = " + std::to_string(user_id) + " AND status = 'active'";
+    std::shared_ptr<const UserSchema> schema = schema_.get();
+    std::string sql = schema->user_select + " WHERE " + schema->id_column + " = " + std::to_string(user_id) +
+                      " AND status = 'active'";
 
     json result = const_cast<UserService*>(this)->executeQuery(sql);
     if (result["success"].get<bool>() && result["data"].is_array() && !result["data"].empty()) {
@@ -200,6 +225,7 @@ json UserService::registerUser(const std::string& username, const std::string& p
         json result = executeQuery(sql);
         if (result["success"].get<bool>()) {
             long user_id = result["data"]["insert_id"].get<long>();
+            markUserWrite(user_id);
             
             json response_data;
             response_data["user_id"] = user_id;
@@ -228,7 +254,7 @@ json UserService::loginUser(const std::string& username, const std::string& pass
     try {
         // 先尝试原有的hash方式
         std::string hashed_password = hashPassword(password);
-        const std::string& id_column = getUserIdColumnName();
+        std::string id_column = getUserIdColumnName();
         std::string select_clause = aliasColumn(qualifyUserColumn("", id_column), "user_id") +
                                     ", username, phone, role";
         std::string sql = "SELECT " + select_clause + " FROM users WHERE username = '" +
@@ -278,16 +304,30 @@ json UserService::loginUser(const std::string& username, const std::string& pass
 json UserService::logoutUser(long user_id) {
     logInfo("用户登出请求，用户ID: " + std::to_string(user_id));
     
-    {
-        std::lock_guard<std::mutex> lock(session_mutex_);
-        active_sessions_.erase(user_id);
-    }
+    sessions_.revoke(user_id);
     
     return createSuccessResponse(json::object(), "登出成功");
 }
 
+json UserService::validateToken(const std::string& token) {
+    uint32_t expires_in = 0;
+    long user_id = sessions_.validate(token, &expires_in);
+    if (user_id <= 0) {
+        return createErrorResponse("登录已失效,请重新登录", Constants::UNAUTHORIZED_CODE);
+    }
+    
+    json data;
+    data["user_id"] = user_id;
+    data["expires_in_seconds"] = expires_in;
+    return createSuccessResponse(data, "令牌有效");
+}
+
+json UserService::getSessionStats() const {
+    return sessions_.getStats();
+}
+
 json UserService::getUserInfo(long user_id) {
-    logDebug("获取用户信息请求，用户ID: " + std::to_string(user_id));
+    logDebug("获取用户信息请求，用户ID: ", user_id);
     
     if (user_id <= 0) {
         return createErrorResponse("无效的用户ID", Constants::VALIDATION_ERROR_CODE);
@@ -316,8 +356,8 @@ json UserService::updateUserInfo(long user_id, const json& update_info) {
     
     try {
         std::vector<std::string> update_fields;
-        const std::string& updated_column = getUserUpdatedAtColumnName();
-        const std::string& id_column = getUserIdColumnName();
+        std::string updated_column = getUserUpdatedAtColumnName();
+        std::string id_column = getUserIdColumnName();
         
         // 构建更新字段
         if (update_info.contains("phone") && update_info["phone"].is_string()) {
@@ -355,6 +395,7 @@ json UserService::updateUserInfo(long user_id, const json& update_info) {
         
         json result = executeQuery(sql);
         if (result["success"].get<bool>()) {
+            markUserWrite(user_id);
             logInfo("用户信息更新成功，用户ID: " + std::to_string(user_id));
             return createSuccessResponse(json::object(), "用户信息更新成功");
         } else {
@@ -385,8 +426,8 @@ json UserService::setUserStatus(long user_id, const std::string& status_or_actio
     } else {
         return createErrorResponse("无效的状态类型", Constants::VALIDATION_ERROR_CODE);
     }
-    const std::string& id_column = getUserIdColumnName();
-    const std::string& updated_column = getUserUpdatedAtColumnName();
+    std::string id_column = getUserIdColumnName();
+    std::string updated_column = getUserUpdatedAtColumnName();
 
     std::string sql = "UPDATE users SET status = '" + escapeSQLString(normalized) + "'";
     if (!updated_column.empty()) {
@@ -406,6 +447,7 @@ json UserService::setUserStatus(long user_id, const std::string& status_or_actio
         }
 
         if (affected_rows > 0) {
+            markUserWrite(user_id);
             json response_data;
             response_data["user_id"] = user_id;
             response_data["status"] = normalized;
@@ -425,7 +467,7 @@ json UserService::getUserRoles(long user_id) {
     }
 
     try {
-        const std::string& id_column = getUserIdColumnName();
+        std::string id_column = getUserIdColumnName();
         std::string sql = "SELECT role FROM users WHERE " + id_column + " = " + std::to_string(user_id) + " LIMIT 1";
         json query_result = executeQuery(sql);
 
@@ -488,8 +530,8 @@ json UserService::setUserRole(long user_id, const std::string& role) {
     }
 
     try {
-        const std::string& id_column = getUserIdColumnName();
-        const std::string& updated_column = getUserUpdatedAtColumnName();
+        std::string id_column = getUserIdColumnName();
+        std::string updated_column = getUserUpdatedAtColumnName();
 
         std::string sql = "UPDATE users SET role = '" + escapeSQLString(normalized) + "'";
         if (!updated_column.empty()) {
@@ -512,6 +554,7 @@ json UserService::setUserRole(long user_id, const std::string& role) {
         }
 
         if (affected_rows > 0) {
+            markUserWrite(user_id);
             json response_data;
             response_data["user_id"] = user_id;
             response_data["role"] = normalized;
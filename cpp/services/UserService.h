@@ -22,14 +22,23 @@ class BaseService;
  */
 class UserService : public BaseService {
 private:
-    // 会话管理
-    std::unordered_map<long, std::string> active_sessions_;
-    std::mutex session_mutex_;
+    // 会话管理(按用户分片，带过期清理)
+    SessionStore sessions_;
+
+    // 按当前表结构确定的用户列名和查询SELECT部分，表结构刷新后重新生成
+    struct UserSchema {
+        std::string id_column;
+        std::string created_column;
+        std::string updated_column;
+        std::string user_select;  // "SELECT ... FROM users"，不含WHERE
+    };
+    SchemaBound<UserSchema> schema_;
+    UserSchema buildSchema(const SchemaSnapshot& snapshot) const;
 
     // 列名辅助方法
-    const std::string& getUserIdColumnName() const;
-    const std::string& getUserCreatedAtColumnName() const;
-    const std::string& getUserUpdatedAtColumnName() const;
+    std::string getUserIdColumnName() const;
+    std::string getUserCreatedAtColumnName() const;
+    std::string getUserUpdatedAtColumnName() const;
     std::string qualifyUserColumn(const std::string& alias, const std::string& column_name) const;
     
     // 密码加密
@@ -47,6 +56,8 @@ private:
     
     // 通用获取用户列表方法
     json fetchUsers(int page, int pageSize, const std::string& status, const std::string& keyword);
+    std::string buildUserListSelect() const;
+    std::string buildUserListFilter(const std::string& status, const std::string& keyword) const;
     
 public:
     UserService();
@@ -57,6 +68,8 @@ public:
     json registerUser(const std::string& username, const std::string& password, const std::string& phone);
     json loginUser(const std::string& username, const std::string& password);
     json logoutUser(long user_id);
+    // 校验登录令牌，有效时顺延会话有效期
+    json validateToken(const std::string& token);
     json getUserInfo(long user_id);
     json updateUserInfo(long user_id, const json& update_info);
     
@@ -69,9 +82,15 @@ public:
     json getUserById(long user_id) const;
     json getAllUsers(int page, int pageSize, const std::string& status);
     json searchUsers(const std::string& keyword, int page, int pageSize);
+    // 游标分页版用户列表，cursor为上一页返回的next_cursor，首页传空字符串
+    json getAllUsersByCursor(const std::string& cursor, int pageSize, const std::string& status,
+                             const std::string& keyword, bool include_total);
     
     // 权限检查
     json checkUserPermission(long user_id, const std::string& permission);
+    
+    // 会话数与登录/过期/登出速率
+    json getSessionStats() const;
 };
 
 #endif // USERSERVICE_H
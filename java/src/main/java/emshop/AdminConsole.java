@@ -894,6 +894,7 @@ public class AdminConsole {
             System.out.println("3. 查看系统指标");
             System.out.println("4. 清理缓存");
             System.out.println("5. 数据库管理");
+            System.out.println("6. 慢查询日志");
             System.out.println("0. 返回主菜单");
             System.out.print("请选择: ");
             
@@ -915,6 +916,9 @@ public class AdminConsole {
                 case "5":
                     databaseManagement();
                     break;
+                case "6":
+                    viewSlowQueries();
+                    break;
                 case "0":
                     return;
                 default:
@@ -984,6 +988,32 @@ public class AdminConsole {
         }
     }
     
+    /**
+     * 查看慢查询日志
+     */
+    private static void viewSlowQueries() {
+        System.out.print("显示条数 (默认20): ");
+        String limitStr = scanner.nextLine();
+        System.out.print("调整慢查询阈值(毫秒，0为关闭，直接回车不修改): ");
+        String thresholdStr = scanner.nextLine().trim();
+        
+        try {
+            int limit = limitStr.isEmpty() ? 20 : Integer.parseInt(limitStr);
+            String options = "{\"limit\":" + limit;
+            if (!thresholdStr.isEmpty()) {
+                options += ",\"threshold_ms\":" + Integer.parseInt(thresholdStr);
+            }
+            options += "}";
+            String result = EmshopNativeInterface.getSlowQueryLog(options);
+            System.out.println("\n慢查询日志：");
+            printFormattedResponse(result);
+        } catch (NumberFormatException e) {
+            System.out.println("请输入有效的数字");
+        } catch (Exception e) {
+            System.err.println("获取慢查询日志失败：" + e.getMessage());
+        }
+    }
+    
     /**
      * 清理系统缓存
      */
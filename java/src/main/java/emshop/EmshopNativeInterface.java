@@ -1,5 +1,7 @@
 package emshop;
 
+import java.nio.ByteBuffer;
+
 /**
  * JLU Emshop System - Native Interface
  * 包含所有需要在C++中实现的JNI接口声明
@@ -111,6 +113,13 @@ public class EmshopNativeInterface {
      */
     public static native String logout(long userId);
     
+    /**
+     * 校验登录令牌，有效时顺延会话有效期
+     * @param token 登录时返回的令牌
+     * @return JSON格式的校验结果，成功时data包含user_id和expires_in_seconds
+     */
+    public static native String validateToken(String token);
+    
     /**
      * 获取用户信息
      * @param userId 用户ID
@@ -137,6 +146,16 @@ public class EmshopNativeInterface {
      */
     public static native String getProductList(String category, int page, int pageSize);
     
+    /**
+     * 获取商品列表（游标分页）
+     * @param category 商品分类
+     * @param cursor 上一页返回的next_cursor，首页传空字符串
+     * @param pageSize 每页数量
+     * @param includeTotal 是否返回总数
+     * @return JSON格式的商品列表，包含has_more和next_cursor
+     */
+    public static native String getProductListByCursor(String category, String cursor, int pageSize, boolean includeTotal);
+    
     /**
      * 获取商品详情
      * @param productId 商品ID
@@ -280,9 +299,10 @@ public class EmshopNativeInterface {
     // ==================== 订单管理接口 ====================
     
     /**
-     * 结算购物车
+     * 结算购物车，使用默认收货地址(没有默认地址时取最近添加的地址)，不使用优惠券
+     * 与createOrderFromCart走同一下单流程
      * @param userId 用户ID
-     * @return JSON格式的结算结果
+     * @return JSON格式的结算结果，与createOrderFromCart相同
      */
     public static native String checkout(long userId);
     
@@ -370,6 +390,19 @@ public class EmshopNativeInterface {
      * @return JSON格式的订单列表
      */
     public static native String getAllOrders(String status, int page, int pageSize, String startDate, String endDate);
+    
+    /**
+     * 获取所有订单（管理员功能，游标分页）
+     * @param status 订单状态筛选
+     * @param cursor 上一页返回的next_cursor，首页传空字符串
+     * @param pageSize 每页数量
+     * @param startDate 开始日期
+     * @param endDate 结束日期
+     * @param includeTotal 是否返回总数
+     * @return JSON格式的订单列表，包含has_more和next_cursor
+     */
+    public static native String getAllOrdersByCursor(String status, String cursor, int pageSize,
+                                                     String startDate, String endDate, boolean includeTotal);
 
     // ==================== 促销策略接口 ====================
     
@@ -603,6 +636,75 @@ public class EmshopNativeInterface {
      */
     public static native String getSystemMetrics();
     
+    /**
+     * 获取慢查询日志（管理员功能）
+     * @param jsonOptions 可选参数：limit（返回条数）、threshold_ms（调整慢查询阈值，0为关闭）、clear（清空记录）
+     * @return JSON格式的慢查询记录及各指纹的EXPLAIN执行计划
+     */
+    public static native String getSlowQueryLog(String jsonOptions);
+    
+    /**
+     * 运行本地基准测试（仅供load分组的测试使用，同步执行，耗时约为测量时长）
+     * @param scenario 场景名称：prepared_vs_text、pool_checkout、json_writer、async_vs_blocking
+     * @param jsonOptions 可选参数：threads（并发线程数）、duration_ms（每种实现的测量时长）、warmup_ms（预热时长）
+     * @return JSON格式的各实现吞吐(qps)与延迟分位数(p50_us/p90_us/p99_us)
+     */
+    public static native String runNativeBenchmark(String scenario, String jsonOptions);
+    
+    /**
+     * 把追踪ID绑定到当前线程，之后本线程上的本地调用按该追踪记录耗时分段
+     * （本地追踪未开启时直接返回）
+     * @param traceId 追踪ID，通常为TraceIdUtil.getTraceId()
+     * @param operation 请求名称，如命令名
+     */
+    public static native void beginTrace(String traceId, String operation);
+    
+    /**
+     * 结束当前线程的追踪，交给本地后台线程写入追踪文件
+     */
+    public static native void endTrace();
+    
+    // ==================== 直接缓冲区接口 ====================
+    // 与同名String接口返回相同的JSON，以UTF-8写入直接缓冲区，省去本地层的字符串转码。
+    // target为容量足够的直接缓冲区时写入target(position=0, limit=响应长度)并返回它，
+    // 否则返回本地内存池借出的缓冲区。返回值用完后必须调用releaseDirectBuffer，之后不能再读取
+    
+    /**
+     * 获取商品列表（直接缓冲区版本）
+     * @param target 调用方自备的直接缓冲区，可为null
+     * @return 包含UTF-8 JSON的直接缓冲区
+     */
+    public static native ByteBuffer getProductListDirect(ByteBuffer target, String category, int page, int pageSize);
+    
+    /**
+     * 搜索商品（直接缓冲区版本）
+     * @param target 调用方自备的直接缓冲区，可为null
+     * @return 包含UTF-8 JSON的直接缓冲区
+     */
+    public static native ByteBuffer searchProductsDirect(ByteBuffer target, String keyword, int page, int pageSize,
+                                                         String sortBy, double minPrice, double maxPrice);
+    
+    /**
+     * 获取用户订单列表（直接缓冲区版本）
+     * @param target 调用方自备的直接缓冲区，可为null
+     * @return 包含UTF-8 JSON的直接缓冲区
+     */
+    public static native ByteBuffer getOrderListDirect(ByteBuffer target, long userId);
+    
+    /**
+     * 获取全部订单（管理员功能，直接缓冲区版本）
+     * @param target 调用方自备的直接缓冲区，可为null
+     * @return 包含UTF-8 JSON的直接缓冲区
+     */
+    public static native ByteBuffer getAllOrdersDirect(ByteBuffer target, String status, int page, int pageSize,
+                                                       String startDate, String endDate);
+    
+    /**
+     * 归还直接缓冲区接口返回的缓冲区
+     * @param buffer 直接缓冲区接口的返回值（调用方自备的缓冲区传入时不做任何事）
+     */
+    public static native void releaseDirectBuffer(ByteBuffer buffer);
+    
     /**
      * 获取活跃连接
      * @return JSON格式的活跃连接信息
@@ -639,6 +741,30 @@ public class EmshopNativeInterface {
      * @return JSON格式的批量执行结果
      */
     public static native String executeBatch(String jsonBatchQueries);
+    
+    /**
+     * 批量执行只读服务命令，各命令在本地工作线程上并发执行，结果按请求顺序一次返回
+     * @param jsonCommands JSON数组：[{"id":"cart","command":"getCart","params":{"user_id":1}}, ...]，
+     *                     命令名与对应的本地方法一致（getCart、getUserAddresses、getUserCoupons等）
+     * @return JSON格式结果，data.results中每项包含id、command、success和result（该命令的完整响应）
+     */
+    public static native String executeCommandBatch(String jsonCommands);
+    
+    /**
+     * 注册异步请求的完成处理器，本地执行器线程完成请求后回调其onNativeComplete
+     * @param handler 完成处理器，传null注销
+     * @return 是否注册成功
+     */
+    public static native boolean registerCompletionHandler(NativeCompletionHandler handler);
+    
+    /**
+     * 把服务命令提交到本地执行器后立即返回，结果通过已注册的完成处理器送回
+     * @param requestId 调用方生成的请求ID，回调时原样带回
+     * @param command 命令名，与executeCommandBatch相同，另支持addToCart、createOrderFromCart、createOrderDirect
+     * @param jsonParams JSON格式的命令参数
+     * @return true表示已受理；false表示未受理（未注册处理器、命令不存在或执行器队列已满），调用方应改用同步接口
+     */
+    public static native boolean submitCommand(long requestId, String command, String jsonParams);
 
     // ==================== 用户地址管理接口 ====================
     
@@ -857,6 +983,18 @@ public class EmshopNativeInterface {
      * @return JSON格式的用户列表
      */
     public static native String getAllUsers(int page, int pageSize, String status);
+    
+    /**
+     * 获取所有用户（管理员，游标分页）
+     * @param cursor 上一页返回的next_cursor，首页传空字符串
+     * @param pageSize 每页数量
+     * @param status 用户状态过滤
+     * @param keyword 用户名或ID关键字（可为空）
+     * @param includeTotal 是否返回总数
+     * @return JSON格式的用户列表，包含has_more和next_cursor
+     */
+    public static native String getAllUsersByCursor(String cursor, int pageSize, String status,
+                                                    String keyword, boolean includeTotal);
 
     /**
      * 搜索用户（管理员）
@@ -2,6 +2,7 @@ package emshop;
 
 import com.fasterxml.jackson.databind.JsonNode;
 import com.fasterxml.jackson.databind.ObjectMapper;
+import com.fasterxml.jackson.databind.node.ArrayNode;
 import com.fasterxml.jackson.databind.node.ObjectNode;
 import io.netty.bootstrap.ServerBootstrap;
 import io.netty.channel.*;
@@ -17,9 +18,13 @@ import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
 import java.util.LinkedHashSet;
 import java.util.Map;
+import java.util.concurrent.CompletableFuture;
 import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.TimeoutException;
 
 /**
  * 基于Netty的Emshop服务器端
@@ -184,6 +189,11 @@ public class EmshopNettyServer {
     private static class EmshopServerHandler extends SimpleChannelInboundHandler<String> {
         private static final Logger handlerLogger = LoggerFactory.getLogger(EmshopServerHandler.class);
         
+        // 每个I/O线程一块直接缓冲区，列表类响应放得下时由本地层直接写入，放不下时本地层另借池化缓冲区
+        private static final int DIRECT_RESPONSE_BUFFER_SIZE = 256 * 1024;
+        private static final ThreadLocal<ByteBuffer> directResponseBuffer =
+            ThreadLocal.withInitial(() -> ByteBuffer.allocateDirect(DIRECT_RESPONSE_BUFFER_SIZE));
+        
         @Override
         public void channelActive(ChannelHandlerContext ctx) {
             // 初始化trace ID
@@ -225,12 +235,20 @@ public class EmshopNettyServer {
         @Override
         protected void channelRead0(ChannelHandlerContext ctx, String request) {
             // 初始化trace ID (每个请求独立的trace ID)
-            TraceIdUtil.initTraceId();
+            String traceId = TraceIdUtil.initTraceId();
             
             try {
                 String remoteAddr = ctx.channel().remoteAddress().toString();
                 handlerLogger.debug("Received request - remoteAddress={}, request={}", remoteAddr, request);
                 
+                // 同一trace ID传入本地层，本线程上的JNI调用按该请求记录耗时分段
+                EmshopNativeInterface.beginTrace(traceId, traceOperation(request));
+                
+                // 耗时的写命令异步提交，响应由完成回调写回
+                if (tryProcessAsync(ctx, request.trim(), traceId)) {
+                    return;
+                }
+                
                 // 调用JNI接口处理请求
                 String response = processRequest(ctx, request.trim());
                 handlerLogger.debug("Sending response - remoteAddress={}, response={}", remoteAddr, response);
@@ -239,9 +257,202 @@ public class EmshopNettyServer {
                 handlerLogger.error("Error processing request - error={}", e.getMessage(), e);
                 ctx.writeAndFlush("ERROR: " + e.getMessage() + "\n");
             } finally {
+                EmshopNativeInterface.endTrace();
                 TraceIdUtil.clear();
             }
         }
+        
+        /**
+         * 记录购物车下单结果（同步与异步两条路径共用）
+         */
+        private void logOrderCreateResult(UserSession session, long addressId, String couponCode, String createResult) {
+            if (createResult != null && createResult.contains("\"success\":true")) {
+                try {
+                    String orderIdStr = HumanReadable.extract(createResult, "order_id");
+                    long orderId = orderIdStr != null ? Long.parseLong(orderIdStr) : -1;
+                    String totalStr = HumanReadable.extract(createResult, "total_amount");
+                    String finalStr = HumanReadable.extract(createResult, "final_amount");
+                    double totalAmount = totalStr != null ? Double.parseDouble(totalStr) : 0.0;
+                    double finalAmount = finalStr != null ? Double.parseDouble(finalStr) : 0.0;
+                    
+                    handlerLogger.info("Order created successfully - userId={}, orderId={}, addressId={}, couponCode={}", 
+                        session.getUserId(), orderId, addressId, couponCode);
+                    BusinessLogger.logOrderCreate(orderId, session.getUserId(), session.getUsername(), 
+                        totalAmount, finalAmount);
+                } catch (Exception e) {
+                    handlerLogger.error("Failed to parse order create response - error={}", e.getMessage(), e);
+                }
+            } else {
+                handlerLogger.warn("Order creation failed - userId={}", session.getUserId());
+            }
+        }
+        
+        /**
+         * 下单、加购等耗时的写命令交给本地执行器异步执行，I/O线程不再阻塞等待本地调用；
+         * 结果回到本连接的I/O线程后写回。本地层未受理（队列已满等）时返回false，由调用方走同步路径
+         */
+        private boolean tryProcessAsync(ChannelHandlerContext ctx, String request, String traceId) {
+            if (request.startsWith("{")) {
+                return false;
+            }
+            String[] parts = parseCommand(request);
+            if (parts.length < 1) {
+                return false;
+            }
+            UserSession session = userSessions.get(ctx.channel().id());
+            if (session == null || !session.isLoggedIn()) {
+                return false;
+            }
+            
+            String method = parts[0].toUpperCase();
+            String command;
+            ObjectNode params = JSON_MAPPER.createObjectNode();
+            params.put("user_id", session.getUserId());
+            long addressId = 0;
+            String couponCode = null;
+            try {
+                switch (method) {
+                    case "CREATE_ORDER":
+                        // 仅会话形式：CREATE_ORDER addressId [couponCode] [remark]
+                        if (parts.length < 2 || parts.length >= 5) {
+                            return false;
+                        }
+                        addressId = Long.parseLong(parts[1].trim());
+                        couponCode = parts.length > 2 && !parts[2].equals("0") && !parts[2].trim().isEmpty() ? parts[2].trim() : null;
+                        command = "createOrderFromCart";
+                        params.put("address_id", addressId);
+                        if (couponCode != null) {
+                            params.put("coupon_code", couponCode);
+                        }
+                        params.put("remark", parts.length > 3 ? parts[3].trim() : "");
+                        break;
+                    case "ADD_TO_CART":
+                        // 仅会话形式：ADD_TO_CART productId quantity
+                        if (parts.length != 3) {
+                            return false;
+                        }
+                        command = "addToCart";
+                        params.put("product_id", Long.parseLong(parts[1]));
+                        params.put("quantity", Integer.parseInt(parts[2]));
+                        break;
+                    default:
+                        return false;
+                }
+            } catch (NumberFormatException e) {
+                return false;  // 参数错误交给同步路径返回原有的错误信息
+            }
+            
+            CompletableFuture<String> future = NativeAsyncDispatcher.getInstance().submit(command, params.toString());
+            if (future == null) {
+                return false;
+            }
+            
+            final long orderAddressId = addressId;
+            final String orderCouponCode = couponCode;
+            future.whenCompleteAsync((response, error) -> {
+                TraceIdUtil.setTraceId(traceId);
+                try {
+                    if (error instanceof TimeoutException) {
+                        handlerLogger.error("Async request timed out - method={}", method);
+                        ctx.writeAndFlush("{\"success\":false,\"message\":\"请求处理超时，结果未知，请稍后查询\",\"error_code\":504}\n");
+                        return;
+                    }
+                    if (error != null) {
+                        handlerLogger.error("Async request failed - method={}, error={}", method, error.getMessage(), error);
+                        ctx.writeAndFlush("ERROR: " + error.getMessage() + "\n");
+                        return;
+                    }
+                    if ("CREATE_ORDER".equals(method)) {
+                        logOrderCreateResult(session, orderAddressId, orderCouponCode, response);
+                    }
+                    handlerLogger.debug("Sending async response - method={}, response={}", method, response);
+                    ctx.writeAndFlush(response + "\n");
+                } finally {
+                    TraceIdUtil.clear();
+                }
+            }, ctx.executor());
+            return true;
+        }
+        
+        /**
+         * 把BATCH命令中的各条文本命令转换为本地批量命令，用户相关参数一律取自会话
+         */
+        private String buildBatchCommands(UserSession session, String[] parts) {
+            ArrayNode commands = JSON_MAPPER.createArrayNode();
+            for (int i = 1; i < parts.length; i++) {
+                String[] args = parts[i].split(":");
+                String name = args[0].toUpperCase();
+                ObjectNode item = commands.addObject();
+                item.put("id", parts[i]);
+                ObjectNode params = item.putObject("params");
+                switch (name) {
+                    case "GET_CART":
+                    case "VIEW_CART":
+                        item.put("command", "getCart");
+                        params.put("user_id", session.getUserId());
+                        break;
+                    case "VIEW_ADDRESSES":
+                        item.put("command", "getUserAddresses");
+                        params.put("user_id", session.getUserId());
+                        break;
+                    case "GET_USER_COUPONS":
+                        item.put("command", "getUserCoupons");
+                        params.put("user_id", session.getUserId());
+                        break;
+                    case "GET_AVAILABLE_COUPONS":
+                        item.put("command", "getAvailableCoupons");
+                        break;
+                    case "GET_USER_ORDERS":
+                    case "VIEW_ORDERS":
+                        item.put("command", "getOrderList");
+                        params.put("user_id", session.getUserId());
+                        break;
+                    case "GET_NOTIFICATIONS":
+                        item.put("command", "getNotifications");
+                        params.put("user_id", session.getUserId());
+                        params.put("unread_only", args.length > 1 && Boolean.parseBoolean(args[1]));
+                        break;
+                    case "GET_PRODUCTS":
+                    case "VIEW_PRODUCTS":
+                        item.put("command", "getProductList");
+                        params.put("category", args.length > 1 ? args[1] : "all");
+                        params.put("page", args.length > 2 ? Integer.parseInt(args[2]) : 1);
+                        params.put("page_size", args.length > 3 ? Integer.parseInt(args[3]) : 10);
+                        break;
+                    default:
+                        // 不支持批量执行的命令原样传下去，由本地层返回该项的错误
+                        item.put("command", name);
+                        break;
+                }
+            }
+            return commands.toString();
+        }
+        
+        /**
+         * 按UTF-8读取直接缓冲区接口的响应并归还缓冲区
+         */
+        private String readDirectResponse(ByteBuffer buffer) {
+            if (buffer == null) {
+                return "{\"success\":false,\"message\":\"Native response unavailable\"}";
+            }
+            try {
+                return StandardCharsets.UTF_8.decode(buffer).toString();
+            } finally {
+                EmshopNativeInterface.releaseDirectBuffer(buffer);
+            }
+        }
+        
+        /**
+         * 追踪中的请求名称：文本命令取命令名，JSON消息统一为JSON_REQUEST
+         */
+        private String traceOperation(String request) {
+            String trimmed = request.trim();
+            if (trimmed.startsWith("{")) {
+                return "JSON_REQUEST";
+            }
+            int end = trimmed.indexOf(' ');
+            return (end < 0 ? trimmed : trimmed.substring(0, end)).toUpperCase();
+        }
 
         @Override
         public void exceptionCaught(ChannelHandlerContext ctx, Throwable cause) {
@@ -321,6 +532,33 @@ public class EmshopNettyServer {
                         }
                         break;
                         
+                    case "RESUME":
+                        // 断线重连或服务重启后凭登录令牌恢复会话，无需重新输入密码
+                        if (parts.length >= 2) {
+                            String resumeResult = EmshopNativeInterface.validateToken(parts[1]);
+                            if (resumeResult.contains("\"success\":true")) {
+                                try {
+                                    long userId = extractUserIdFromResponse(resumeResult);
+                                    JsonNode userInfo = JSON_MAPPER.readTree(EmshopNativeInterface.getUserInfo(userId)).path("data");
+                                    String username = userInfo.path("username").asText("");
+                                    // 恢复的会话只采用数据库中的角色
+                                    String role = UserSession.normalizeRole(userInfo.path("role").asText(""));
+                                    
+                                    session = new UserSession(userId, username, role);
+                                    userSessions.put(ctx.channel().id(), session);
+                                    TraceIdUtil.setUserContext(userId, username);
+                                    handlerLogger.info("User session resumed - username={}, userId={}, role={}",
+                                        username, userId, role);
+                                } catch (Exception e) {
+                                    handlerLogger.error("Failed to resume session - error={}", e.getMessage(), e);
+                                }
+                            } else {
+                                handlerLogger.warn("Session resume rejected - remote={}", ctx.channel().remoteAddress());
+                            }
+                            return resumeResult;
+                        }
+                        break;
+                        
                     case "REGISTER":
                         if (parts.length >= 4) {
                             String regUsername = parts[1];
@@ -381,6 +619,34 @@ public class EmshopNettyServer {
                             return EmshopNativeInterface.getAllUsers(userPage, userPageSize, statusFilter);
                         }
 
+                    case "GET_ALL_USERS_CURSOR":
+                        // Admin only: GET_ALL_USERS_CURSOR [cursor|-] [pageSize] [status=..] [keyword=..] [total]
+                        if (session == null || !session.isAdmin()) {
+                            return "{\"success\":false,\"message\":\"Permission denied: admin only\",\"error_code\":403}";
+                        }
+                        {
+                            String userCursor = parts.length > 1 && !"-".equals(parts[1]) ? parts[1] : "";
+                            int userPageSize = parts.length > 2 ? Integer.parseInt(parts[2]) : 20;
+                            String statusFilter = "all";
+                            String keyword = "";
+                            boolean includeTotal = false;
+                            for (int i = 3; i < parts.length; i++) {
+                                String arg = parts[i];
+                                if (arg == null || arg.isEmpty()) continue;
+                                String lower = arg.toLowerCase();
+                                if (lower.startsWith("status=")) {
+                                    statusFilter = arg.substring(arg.indexOf('=') + 1);
+                                } else if (lower.startsWith("keyword=") || lower.startsWith("search=")) {
+                                    keyword = arg.substring(arg.indexOf('=') + 1);
+                                } else if ("total".equals(lower)) {
+                                    includeTotal = true;
+                                }
+                            }
+                            userPageSize = Math.min(Math.max(userPageSize, 1), 100);
+                            return EmshopNativeInterface.getAllUsersByCursor(userCursor, userPageSize, statusFilter,
+                                                                             keyword, includeTotal);
+                        }
+
                     case "SET_USER_ROLE":
                         if (session == null || !session.isAdmin()) {
                             return "{\"success\":false,\"message\":\"Permission denied: admin only\",\"error_code\":403}";
@@ -423,7 +689,19 @@ public class EmshopNettyServer {
                         String category = parts.length > 1 ? parts[1] : "all";
                         int page = parts.length > 2 ? Integer.parseInt(parts[2]) : 1;
                         int pageSize = parts.length > 3 ? Integer.parseInt(parts[3]) : 10;
-                        return EmshopNativeInterface.getProductList(category, page, pageSize);
+                        return readDirectResponse(EmshopNativeInterface.getProductListDirect(
+                            directResponseBuffer.get(), category, page, pageSize));
+                        
+                    case "GET_PRODUCTS_CURSOR":
+                        // GET_PRODUCTS_CURSOR [category] [cursor|-] [pageSize] [total]
+                        {
+                            String cursorCategory = parts.length > 1 ? parts[1] : "all";
+                            String productCursor = parts.length > 2 && !"-".equals(parts[2]) ? parts[2] : "";
+                            int cursorPageSize = parts.length > 3 ? Integer.parseInt(parts[3]) : 10;
+                            boolean includeTotal = parts.length > 4 && "total".equalsIgnoreCase(parts[4]);
+                            return EmshopNativeInterface.getProductListByCursor(cursorCategory, productCursor,
+                                                                                cursorPageSize, includeTotal);
+                        }
                         
                     case "SEARCH_PRODUCTS":
                         if (parts.length >= 2) {
@@ -433,7 +711,8 @@ public class EmshopNettyServer {
                             String sortBy = parts.length > 4 ? parts[4] : "id";
                             double minPrice = parts.length > 5 ? Double.parseDouble(parts[5]) : 0.0;
                             double maxPrice = parts.length > 6 ? Double.parseDouble(parts[6]) : 99999.0;
-                            return EmshopNativeInterface.searchProducts(keyword, searchPage, searchPageSize, sortBy, minPrice, maxPrice);
+                            return readDirectResponse(EmshopNativeInterface.searchProductsDirect(
+                                directResponseBuffer.get(), keyword, searchPage, searchPageSize, sortBy, minPrice, maxPrice));
                         }
                         break;
                         
@@ -619,26 +898,7 @@ public class EmshopNettyServer {
                                 String remark = parts.length > 3 ? parts[3].trim() : "";
                                 String createResult = EmshopNativeInterface.createOrderFromCart(
                                     session.getUserId(), addressId, couponCode, remark);
-                                
-                                if (createResult.contains("\"success\":true")) {
-                                    try {
-                                        String orderIdStr = HumanReadable.extract(createResult, "order_id");
-                                        long orderId = orderIdStr != null ? Long.parseLong(orderIdStr) : -1;
-                                        String totalStr = HumanReadable.extract(createResult, "total_amount");
-                                        String finalStr = HumanReadable.extract(createResult, "final_amount");
-                                        double totalAmount = totalStr != null ? Double.parseDouble(totalStr) : 0.0;
-                                        double finalAmount = finalStr != null ? Double.parseDouble(finalStr) : 0.0;
-                                        
-                                        handlerLogger.info("Order created successfully - userId={}, orderId={}, addressId={}, couponCode={}", 
-                                            session.getUserId(), orderId, addressId, couponCode);
-                                        BusinessLogger.logOrderCreate(orderId, session.getUserId(), session.getUsername(), 
-                                            totalAmount, finalAmount);
-                                    } catch (Exception e) {
-                                        handlerLogger.error("Failed to parse order create response - error={}", e.getMessage(), e);
-                                    }
-                                } else {
-                                    handlerLogger.warn("Order creation failed - userId={}", session.getUserId());
-                                }
+                                logOrderCreateResult(session, addressId, couponCode, createResult);
                                 return createResult;
                             }
                         } else if (parts.length >= 5) {
@@ -688,11 +948,13 @@ public class EmshopNettyServer {
                     case "VIEW_ORDERS":
                         if (session != null && session.getUserId() != -1) {
                             // Session-based: VIEW_ORDERS
-                            return EmshopNativeInterface.getOrderList(session.getUserId());
+                            return readDirectResponse(EmshopNativeInterface.getOrderListDirect(
+                                directResponseBuffer.get(), session.getUserId()));
                         } else if (parts.length >= 2) {
                             // Backward compatible: VIEW_ORDERS userId
                             long userId = Long.parseLong(parts[1]);
-                            return EmshopNativeInterface.getOrderList(userId);
+                            return readDirectResponse(EmshopNativeInterface.getOrderListDirect(
+                                directResponseBuffer.get(), userId));
                         }
                         break;
 
@@ -707,7 +969,24 @@ public class EmshopNettyServer {
                             int pageSizeAll = parts.length > 3 ? Integer.parseInt(parts[3]) : 20;
                             String startDate = parts.length > 4 ? parts[4] : "";
                             String endDate = parts.length > 5 ? parts[5] : "";
-                            return EmshopNativeInterface.getAllOrders(status, pageAll, pageSizeAll, startDate, endDate);
+                            return readDirectResponse(EmshopNativeInterface.getAllOrdersDirect(
+                                directResponseBuffer.get(), status, pageAll, pageSizeAll, startDate, endDate));
+                        }
+
+                    case "GET_ALL_ORDERS_CURSOR":
+                        // Admin only: GET_ALL_ORDERS_CURSOR [status] [cursor|-] [pageSize] [startDate|-] [endDate|-] [total]
+                        if (session == null || !session.isAdmin()) {
+                            return "{\"success\":false,\"message\":\"Permission denied: admin only\",\"error_code\":403}";
+                        }
+                        {
+                            String status = parts.length > 1 ? parts[1] : "all";
+                            String orderCursor = parts.length > 2 && !"-".equals(parts[2]) ? parts[2] : "";
+                            int pageSizeAll = parts.length > 3 ? Integer.parseInt(parts[3]) : 20;
+                            String startDate = parts.length > 4 && !"-".equals(parts[4]) ? parts[4] : "";
+                            String endDate = parts.length > 5 && !"-".equals(parts[5]) ? parts[5] : "";
+                            boolean includeTotal = parts.length > 6 && "total".equalsIgnoreCase(parts[6]);
+                            return EmshopNativeInterface.getAllOrdersByCursor(status, orderCursor, pageSizeAll,
+                                                                              startDate, endDate, includeTotal);
                         }
                         
                     case "GET_ORDER_DETAIL":
@@ -1007,6 +1286,36 @@ public class EmshopNettyServer {
                         }
                         break;
                         
+                    case "GET_SLOW_QUERIES":
+                        // Admin only: GET_SLOW_QUERIES [limit] [thresholdMs|-] [clear]
+                        if (session == null || !session.isAdmin()) {
+                            return "{\"success\":false,\"message\":\"Permission denied: admin only\",\"error_code\":403}";
+                        }
+                        {
+                            StringBuilder options = new StringBuilder("{");
+                            options.append("\"limit\":").append(parts.length > 1 ? Integer.parseInt(parts[1]) : 50);
+                            if (parts.length > 2 && !"-".equals(parts[2])) {
+                                options.append(",\"threshold_ms\":").append(Integer.parseInt(parts[2]));
+                            }
+                            if (parts.length > 3 && "clear".equalsIgnoreCase(parts[3])) {
+                                options.append(",\"clear\":true");
+                            }
+                            options.append("}");
+                            return EmshopNativeInterface.getSlowQueryLog(options.toString());
+                        }
+                        
+                    // === Batch Commands ===
+                    case "BATCH":
+                        // BATCH COMMAND[:arg...] ...  一次请求执行多条只读命令，由本地层并发执行
+                        // 例如：BATCH GET_CART VIEW_ADDRESSES GET_USER_COUPONS
+                        if (session == null || session.getUserId() == -1) {
+                            return "{\"success\":false,\"message\":\"请先登录\"}";
+                        }
+                        if (parts.length < 2) {
+                            return "{\"success\":false,\"message\":\"Usage: BATCH COMMAND[:arg...] ...\"}";
+                        }
+                        return EmshopNativeInterface.executeCommandBatch(buildBatchCommands(session, parts));
+                        
                     // === System Commands ===
                     case "PING":
                         return "{\"success\":true,\"message\":\"Server is running\",\"timestamp\":" + System.currentTimeMillis() + "}";
@@ -1360,6 +1669,7 @@ public class EmshopNettyServer {
         private boolean isPublicCommand(String method) {
             switch (method) {
                 case "LOGIN":
+                case "RESUME":
                 case "REGISTER":
                 case "PING":
                 case "INIT":
@@ -0,0 +1,108 @@
+package emshop;
+
+import org.slf4j.Logger;
+import org.slf4j.LoggerFactory;
+
+import java.util.Map;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.TimeoutException;
+import java.util.concurrent.atomic.AtomicLong;
+
+/**
+ * 本地异步请求分发器
+ * 通过submitCommand把服务命令交给本地执行器并立即返回CompletableFuture，
+ * 本地执行器线程完成后回调onNativeComplete，按请求ID完成对应的future。
+ * 回调运行在本地执行器线程上，这里只做查表和complete，后续处理由调用方指定的线程执行。
+ * 本地层没有送达回调时(如回调被丢弃)，future在RESPONSE_TIMEOUT_SECONDS后以TimeoutException结束并移除登记
+ */
+public final class NativeAsyncDispatcher implements NativeCompletionHandler {
+    private static final Logger logger = LoggerFactory.getLogger(NativeAsyncDispatcher.class);
+    private static final NativeAsyncDispatcher INSTANCE = new NativeAsyncDispatcher();
+    private static final long RESPONSE_TIMEOUT_SECONDS = 30;
+    
+    private final AtomicLong nextRequestId = new AtomicLong(1);
+    private final AtomicLong timedOut = new AtomicLong();
+    private final Map<Long, CompletableFuture<String>> pending = new ConcurrentHashMap<>();
+    private volatile boolean registered;
+    
+    private NativeAsyncDispatcher() {
+    }
+    
+    public static NativeAsyncDispatcher getInstance() {
+        return INSTANCE;
+    }
+    
+    /**
+     * 向本地层注册为完成处理器，已注册时直接返回
+     * @return 是否已注册
+     */
+    public synchronized boolean register() {
+        if (!registered) {
+            registered = EmshopNativeInterface.registerCompletionHandler(this);
+            if (!registered) {
+                logger.warn("Failed to register native completion handler");
+            }
+        }
+        return registered;
+    }
+    
+    /**
+     * 提交服务命令
+     * @param command 本地命令名（如createOrderFromCart）
+     * @param jsonParams JSON格式的命令参数
+     * @return 完成时得到JSON响应的future；本地层未受理时返回null，调用方应改走同步接口
+     */
+    public CompletableFuture<String> submit(String command, String jsonParams) {
+        if (!registered && !register()) {
+            return null;
+        }
+        long requestId = nextRequestId.getAndIncrement();
+        CompletableFuture<String> future = new CompletableFuture<>();
+        // 先登记再提交，回调可能在submitCommand返回前到达
+        pending.put(requestId, future);
+        boolean accepted = false;
+        try {
+            accepted = EmshopNativeInterface.submitCommand(requestId, command, jsonParams);
+        } finally {
+            if (!accepted) {
+                pending.remove(requestId);
+            }
+        }
+        if (!accepted) {
+            return null;
+        }
+        future.orTimeout(RESPONSE_TIMEOUT_SECONDS, TimeUnit.SECONDS).whenComplete((response, error) -> {
+            if (error instanceof TimeoutException && pending.remove(requestId, future)) {
+                timedOut.incrementAndGet();
+                logger.warn("Native completion timed out - requestId={}, command={}", requestId, command);
+            }
+        });
+        return future;
+    }
+    
+    @Override
+    public void onNativeComplete(long requestId, String response) {
+        CompletableFuture<String> future = pending.remove(requestId);
+        if (future == null) {
+            logger.warn("Native completion for unknown request - requestId={}", requestId);
+            return;
+        }
+        future.complete(response);
+    }
+    
+    /**
+     * 已提交尚未完成的请求数
+     */
+    public int pendingCount() {
+        return pending.size();
+    }
+    
+    /**
+     * 等待本地回调超时的请求数
+     */
+    public long timedOutCount() {
+        return timedOut.get();
+    }
+}
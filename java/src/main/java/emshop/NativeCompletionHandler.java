@@ -0,0 +1,15 @@
+package emshop;
+
+/**
+ * 本地异步请求的完成回调
+ * 由本地执行器线程调用，实现应尽快返回，后续处理交给其他线程
+ */
+public interface NativeCompletionHandler {
+    
+    /**
+     * 请求执行完成
+     * @param requestId 提交时传入的请求ID
+     * @param response JSON格式的完整响应
+     */
+    void onNativeComplete(long requestId, String response);
+}
@@ -0,0 +1,129 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicLong;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 准入控制过载测试
+ * 先用闭环压测测出本机商品列表接口的吞吐，再按1倍和5倍吞吐的速率开环发送请求，
+ * 统计在时限内成功返回的请求数(goodput)和系统繁忙(1006)拒绝数。
+ * 过载时多出的请求应被快速拒绝，goodput保持在基线附近而不是随排队崩溃
+ * 只输出各负载下的goodput/超时/拒绝数，不对墙钟结果做断言，结果随机器而变
+ * 需要JNI库和可用的数据库，库加载失败时跳过；属于load分组，默认测试不运行，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+@TestMethodOrder(MethodOrderer.OrderAnnotation.class)
+public class AdmissionOverloadTest {
+
+    private static final int ERROR_SYSTEM_BUSY = 1006;
+    private static final int CLIENT_THREADS = 256;
+    private static final long DEADLINE_MS = 500;
+    private static final int RUN_SECONDS = 5;
+
+    private static double capacityPerSecond;
+    private static double baselineGoodput;
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("过载测试");
+    }
+
+    @Test
+    @Order(1)
+    @DisplayName("闭环压测测出接口吞吐")
+    void measureCapacity() throws Exception {
+        int threads = Runtime.getRuntime().availableProcessors() * 2;
+        ExecutorService pool = Executors.newFixedThreadPool(threads);
+        AtomicLong completed = new AtomicLong();
+        long end = System.nanoTime() + TimeUnit.SECONDS.toNanos(RUN_SECONDS);
+        for (int i = 0; i < threads; i++) {
+            pool.submit(() -> {
+                while (System.nanoTime() < end) {
+                    if (TestUtils.isSuccess(call())) {
+                        completed.incrementAndGet();
+                    }
+                }
+            });
+        }
+        pool.shutdown();
+        assertTrue(pool.awaitTermination(RUN_SECONDS + 30, TimeUnit.SECONDS));
+        capacityPerSecond = completed.get() / (double) RUN_SECONDS;
+        System.out.printf("闭环吞吐: %.0f req/s (%d 线程)%n", capacityPerSecond, threads);
+        assertTrue(capacityPerSecond > 0, "闭环压测没有成功请求");
+    }
+
+    @Test
+    @Order(2)
+    @DisplayName("1倍负载的goodput基线")
+    void baselineLoad() throws Exception {
+        baselineGoodput = runOpenLoop(1.0);
+    }
+
+    @Test
+    @Order(3)
+    @DisplayName("5倍过载时的goodput")
+    void overloadGoodput() throws Exception {
+        double goodput = runOpenLoop(5.0);
+        System.out.printf("5倍过载goodput为基线的 %.0f%%%n",
+            baselineGoodput > 0 ? goodput * 100 / baselineGoodput : 0.0);
+    }
+
+    /**
+     * 按capacity * factor的速率开环发送请求，返回每秒在时限内成功的请求数
+     */
+    private double runOpenLoop(double factor) throws Exception {
+        double rate = capacityPerSecond * factor;
+        long intervalNanos = Math.max(1, (long) (TimeUnit.SECONDS.toNanos(1) / rate));
+        ThreadPoolExecutor pool = new ThreadPoolExecutor(CLIENT_THREADS, CLIENT_THREADS, 0, TimeUnit.SECONDS,
+            new LinkedBlockingQueue<>());
+        AtomicLong good = new AtomicLong();
+        AtomicLong late = new AtomicLong();
+        AtomicLong busy = new AtomicLong();
+        AtomicLong failed = new AtomicLong();
+
+        long start = System.nanoTime();
+        long end = start + TimeUnit.SECONDS.toNanos(RUN_SECONDS);
+        long next = start;
+        while (next < end) {
+            long scheduled = next;
+            long wait = scheduled - System.nanoTime();
+            if (wait > 0) {
+                TimeUnit.NANOSECONDS.sleep(wait);
+            }
+            pool.execute(() -> {
+                String response = call();
+                long elapsedMs = TimeUnit.NANOSECONDS.toMillis(System.nanoTime() - scheduled);
+                JsonNode node = TestUtils.parseResponse(response);
+                if (node.path("success").asBoolean(false)) {
+                    if (elapsedMs <= DEADLINE_MS) {
+                        good.incrementAndGet();
+                    } else {
+                        late.incrementAndGet();
+                    }
+                } else if (node.path("error_code").asInt() == ERROR_SYSTEM_BUSY) {
+                    busy.incrementAndGet();
+                } else {
+                    failed.incrementAndGet();
+                }
+            });
+            next += intervalNanos;
+        }
+        pool.shutdown();
+        assertTrue(pool.awaitTermination(120, TimeUnit.SECONDS));
+
+        double goodput = good.get() / (double) RUN_SECONDS;
+        System.out.printf("%.0f倍负载(%.0f req/s): goodput %.0f/s, 超时 %d, 系统繁忙 %d, 其他失败 %d%n",
+            factor, rate, goodput, late.get(), busy.get(), failed.get());
+        System.out.println("准入统计: " + TestUtils.parseResponse(EmshopNativeInterface.getSystemMetrics()).path("metrics").path("admission"));
+        return goodput;
+    }
+
+    private static String call() {
+        return EmshopNativeInterface.getProductList("all", 1, 20);
+    }
+}
@@ -0,0 +1,51 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 异步查询引擎基准测试
+ * 通过 runNativeBenchmark("async_vs_blocking") 用4个本地调用线程执行商品点查询：
+ *   blocking: 每次阻塞等待一条查询返回，一个线程同一时刻只占用一条连接
+ *   async: 每次向异步查询引擎提交1/4/16条查询再依次等待，一个线程同时保持多条查询在途
+ * 分别在本机往返(sleep_ms=0)和模拟2ms往返(查询中加SLEEP)下测量，输出按查询条数计的吞吐和每批延迟
+ * 需要JNI库和可用的数据库(至少有一个在售商品)，库加载失败时跳过；属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class AsyncQueryBenchmarkTest {
+
+    private static final int THREADS = 4;
+    private static final int[] SLEEP_MILLIS = {0, 2};
+    private static final int RUN_MILLIS = 5000;
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("异步查询基准测试");
+    }
+
+    @Test
+    @DisplayName("每线程在途查询数: 异步引擎与阻塞查询对比")
+    void compareAsyncAndBlocking() {
+        for (int sleepMillis : SLEEP_MILLIS) {
+            JsonNode response = TestUtils.parseResponse(EmshopNativeInterface.runNativeBenchmark("async_vs_blocking",
+                "{\"threads\":" + THREADS + ",\"duration_ms\":" + RUN_MILLIS + ",\"sleep_ms\":" + sleepMillis
+                    + ",\"depths\":[1,4,16]}"));
+            Assumptions.assumeTrue(response.path("success").asBoolean(false), "基准测试未运行: " + response);
+            JsonNode data = response.path("data");
+            JsonNode engine = data.path("engine");
+            System.out.printf("往返附加 %d ms, %d 个调用线程, %d 个I/O线程, 连接上限 %d:%n",
+                sleepMillis, THREADS, engine.path("io_threads").asInt(), data.path("max_pool_size").asInt());
+
+            for (JsonNode result : data.path("results")) {
+                assertEquals(0, result.path("failures").asLong(), result.path("mode").asText() + " 查询出现失败");
+                System.out.printf("  %-8s 每线程在途 %2d: %8.0f 查询/秒, 每批 p50 %6d us, p99 %7d us%n",
+                    result.path("mode").asText(), result.path("in_flight_per_thread").asInt(),
+                    result.path("qps").asDouble(), result.path("p50_us").asLong(), result.path("p99_us").asLong());
+            }
+            System.out.printf("  引擎峰值在途 %d, 队列满时由调用线程执行 %d 次%n",
+                engine.path("peak_in_flight").asLong(), engine.path("caller_runs").asLong());
+        }
+    }
+}
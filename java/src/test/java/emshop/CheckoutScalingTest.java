@@ -0,0 +1,108 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicLong;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 下单吞吐随线程数扩展的基准测试
+ * 每个线程对应一个独立用户，循环执行"加入购物车 -> 从购物车下单"，
+ * 依次用1/2/4/8/16个线程各跑RUN_SECONDS秒，输出每秒下单数和相对单线程的加速比。
+ * 不同用户落在用户锁表的不同分段上，吞吐应随线程数增长，直到数据库连接池或数据库成为瓶颈
+ * 下单不扣减库存(支付时扣减)，测试会留下待支付订单，应在测试库上运行
+ * 需要JNI库和可用的数据库，库加载失败时跳过；属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class CheckoutScalingTest {
+
+    private static final int ERROR_SYSTEM_BUSY = 1006;
+    private static final int[] THREAD_COUNTS = {1, 2, 4, 8, 16};
+    private static final int RUN_SECONDS = 5;
+
+    private static final List<long[]> buyers = new ArrayList<>();  // {用户ID, 地址ID}
+    private static long productId;
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("下单扩展性基准测试");
+
+        JsonNode products = TestUtils.parseResponse(EmshopNativeInterface.getProductList("all", 1, 20))
+            .path("data").path("products");
+        for (JsonNode product : products) {
+            if (product.path("stock").asInt() > 0) {
+                productId = product.path("product_id").asLong();
+                break;
+            }
+        }
+        Assumptions.assumeTrue(productId > 0, "数据库中没有有库存的商品，跳过下单扩展性基准测试");
+
+        String runId = Long.toString(System.currentTimeMillis() % 1_000_000_000L);
+        int maxThreads = THREAD_COUNTS[THREAD_COUNTS.length - 1];
+        for (int i = 0; i < maxThreads; i++) {
+            long userId = TestUtils.registerBenchmarkUser("bench_co_" + runId + "_" + i);
+            Assumptions.assumeTrue(userId > 0, "创建测试用户失败，跳过下单扩展性基准测试");
+            JsonNode address = TestUtils.parseResponse(EmshopNativeInterface.addUserAddress(userId, "基准测试",
+                TestUtils.randomPhone(), "吉林省", "长春市", "朝阳区", "前进大街2699号", "130012", true));
+            long addressId = address.path("data").path("address_id").asLong();
+            Assumptions.assumeTrue(addressId > 0, "创建测试地址失败，跳过下单扩展性基准测试");
+            buyers.add(new long[] {userId, addressId});
+        }
+    }
+
+    @Test
+    @DisplayName("下单吞吐随线程数扩展")
+    void checkoutThroughputScales() throws Exception {
+        double singleThread = 0;
+        for (int threads : THREAD_COUNTS) {
+            double ordersPerSecond = runCheckoutLoop(threads);
+            if (threads == 1) {
+                singleThread = ordersPerSecond;
+            }
+            System.out.printf("%2d 线程: %.1f 单/秒, 加速比 %.2f%n", threads, ordersPerSecond,
+                singleThread > 0 ? ordersPerSecond / singleThread : 0.0);
+        }
+        System.out.println("准入统计: " + TestUtils.parseResponse(EmshopNativeInterface.getSystemMetrics())
+            .path("metrics").path("admission"));
+        assertTrue(singleThread > 0, "单线程下单没有成功");
+    }
+
+    /**
+     * threads个用户并发循环下单RUN_SECONDS秒，返回每秒成功的订单数
+     */
+    private double runCheckoutLoop(int threads) throws Exception {
+        ExecutorService pool = Executors.newFixedThreadPool(threads);
+        AtomicLong orders = new AtomicLong();
+        AtomicLong busy = new AtomicLong();
+        AtomicLong failed = new AtomicLong();
+        long end = System.nanoTime() + TimeUnit.SECONDS.toNanos(RUN_SECONDS);
+        for (int t = 0; t < threads; t++) {
+            long[] buyer = buyers.get(t);
+            pool.submit(() -> {
+                while (System.nanoTime() < end) {
+                    EmshopNativeInterface.addToCart(buyer[0], productId, 1);
+                    JsonNode result = TestUtils.parseResponse(
+                        EmshopNativeInterface.createOrderFromCart(buyer[0], buyer[1], null, "checkout benchmark"));
+                    if (result.path("success").asBoolean(false)) {
+                        orders.incrementAndGet();
+                    } else if (result.path("error_code").asInt() == ERROR_SYSTEM_BUSY) {
+                        busy.incrementAndGet();
+                    } else {
+                        failed.incrementAndGet();
+                    }
+                }
+            });
+        }
+        pool.shutdown();
+        assertTrue(pool.awaitTermination(RUN_SECONDS + 60, TimeUnit.SECONDS));
+        if (busy.get() > 0 || failed.get() > 0) {
+            System.out.printf("%2d 线程: 系统繁忙 %d, 其他失败 %d%n", threads, busy.get(), failed.get());
+        }
+        return orders.get() / (double) RUN_SECONDS;
+    }
+}
@@ -0,0 +1,50 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 连接池借还争用基准测试
+ * 通过 runNativeBenchmark("pool_checkout") 让64个以上的本地线程反复借出主库连接、执行SELECT 1、归还，
+ * 线程数远大于连接池上限，对比两种做法的吞吐和单次借还延迟分位数：
+ *   global_lock_ping: 分片之前的做法，借还都经过一把全局锁，并在锁内对借出和归还的连接各ping一次
+ *   sharded: 当前的分片连接池，只在空闲较久时ping，归还不ping
+ * 另外以不执行查询的方式各测一轮，只看借还本身的开销
+ * 需要JNI库和可用的数据库，库加载失败时跳过；属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class ConnectionPoolContentionBenchmarkTest {
+
+    private static final int[] THREADS = {64, 256};
+    private static final int RUN_MILLIS = 5000;
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("连接池争用基准测试");
+    }
+
+    @Test
+    @DisplayName("64/256线程借还连接: 全局锁加ping与分片连接池对比")
+    void compareGlobalLockAndShardedPool() {
+        for (boolean query : new boolean[] {true, false}) {
+            for (int threads : THREADS) {
+                JsonNode response = TestUtils.parseResponse(EmshopNativeInterface.runNativeBenchmark("pool_checkout",
+                    "{\"threads\":" + threads + ",\"duration_ms\":" + RUN_MILLIS + ",\"query\":" + query + "}"));
+                Assumptions.assumeTrue(response.path("success").asBoolean(false), "基准测试未运行: " + response);
+                JsonNode data = response.path("data");
+
+                for (JsonNode result : data.path("results")) {
+                    assertEquals(0, result.path("failures").asLong(), result.path("mode").asText() + " 借还出现失败");
+                    System.out.printf("%-16s %3d 线程 (连接上限 %d, %s): %8.0f 次/秒, p50 %6d us, p90 %6d us, p99 %7d us, 最大 %7d us%n",
+                        result.path("mode").asText(), threads, data.path("max_pool_size").asInt(),
+                        query ? "SELECT 1" : "仅借还", result.path("qps").asDouble(),
+                        result.path("p50_us").asLong(), result.path("p90_us").asLong(),
+                        result.path("p99_us").asLong(), result.path("max_us").asLong());
+                }
+                System.out.printf("分片/全局锁 吞吐比 %.2f%n", data.path("qps_ratio").asDouble());
+            }
+        }
+    }
+}
@@ -0,0 +1,66 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.stream.Collectors;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 优惠券批量分配基准测试
+ * 先用 cpp/generate_coupon_benchmark_users.sql 生成10万个测试用户，再运行本测试：
+ * 依次对1千/1万/10万个用户各分配一张新建的优惠券，输出耗时和每秒分配数，
+ * 并检查成功数等于用户数、失败数为0(失败数按实际写入失败的用户统计，不含已拥有的用户)
+ * 会在测试库中留下优惠券和用户优惠券记录；需要JNI库和可用的数据库，库加载失败或用户不足时跳过；
+ * 属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class CouponDistributionBenchmarkTest {
+
+    private static final int[] BATCH_SIZES = {1_000, 10_000, 100_000};
+
+    private static final List<Long> userIds = new ArrayList<>();
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("优惠券分配基准测试");
+
+        int maxUsers = BATCH_SIZES[BATCH_SIZES.length - 1];
+        JsonNode rows = TestUtils.parseResponse(EmshopNativeInterface.executeSelectQuery(
+            "SELECT user_id FROM users WHERE username LIKE 'coupon\\_bench\\_%' ORDER BY user_id LIMIT " + maxUsers, "{}"))
+            .path("rows");
+        for (JsonNode row : rows) {
+            userIds.add(Long.parseLong(row.path("user_id").asText()));
+        }
+        Assumptions.assumeTrue(userIds.size() >= maxUsers,
+            "测试用户只有" + userIds.size() + "个，请先执行 generate_coupon_benchmark_users.sql");
+    }
+
+    @Test
+    @DisplayName("批量分配耗时随用户数增长")
+    void distributeToGrowingBatches() {
+        String runId = Long.toString(System.currentTimeMillis() % 1_000_000_000L);
+        for (int size : BATCH_SIZES) {
+            String code = "BENCH" + runId + "_" + size;
+            String created = EmshopNativeInterface.createCouponActivity("分配基准测试" + size, code, "fixed_amount",
+                1.0, 0.0, size, "2020-01-01 00:00:00", "2099-12-31 23:59:59", 0);
+            assertTrue(TestUtils.isSuccess(created), "创建优惠券失败: " + created);
+
+            String userIdsJson = userIds.subList(0, size).stream()
+                .map(String::valueOf).collect(Collectors.joining(",", "[", "]"));
+            long start = System.nanoTime();
+            JsonNode result = TestUtils.parseResponse(EmshopNativeInterface.distributeCouponsToUsers(code, userIdsJson));
+            double seconds = (System.nanoTime() - start) / 1e9;
+
+            assertTrue(result.path("success").asBoolean(false), "分配失败: " + result);
+            JsonNode data = result.path("data");
+            System.out.printf("分配 %d 个用户: %.3f 秒, %.0f 张/秒, 成功 %d, 失败 %d%n",
+                size, seconds, size / seconds, data.path("success_count").asInt(), data.path("failed_count").asInt());
+            assertEquals(size, data.path("success_count").asInt());
+            assertEquals(0, data.path("failed_count").asInt());
+        }
+    }
+}
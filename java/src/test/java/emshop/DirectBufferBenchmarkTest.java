@@ -0,0 +1,101 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 直接缓冲区与String返回路径的对比基准测试
+ * 先用 cpp/generate_direct_buffer_benchmark_orders.sql 生成3个测试用户，其订单列表响应约为1KB/100KB/10MB，再运行本测试：
+ * 对每种大小分别测量
+ *   String路径: getOrderList 返回String
+ *   直接缓冲区路径: getOrderListDirect 写入自备的256KB直接缓冲区(放不下时借用本地池)，
+ *                  按服务器 readDirectResponse 的方式解码为String后归还
+ * 单线程各跑RUN_SECONDS秒，输出单次平均延迟和每秒MB数。两条路径执行相同的数据库查询，差值即返回转换的开销
+ * 需要JNI库和可用的数据库，库加载失败或数据未生成时跳过；属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class DirectBufferBenchmarkTest {
+
+    private static final String[] BENCH_USERS = {"direct_bench_1k", "direct_bench_100k", "direct_bench_10m"};
+    private static final int DIRECT_RESPONSE_BUFFER_SIZE = 256 * 1024;  // 与EmshopNettyServer相同
+    private static final int WARMUP_CALLS = 3;
+    private static final int RUN_SECONDS = 3;
+
+    private final ByteBuffer target = ByteBuffer.allocateDirect(DIRECT_RESPONSE_BUFFER_SIZE);
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("直接缓冲区基准测试");
+    }
+
+    @Test
+    @DisplayName("1KB/100KB/10MB响应的String与直接缓冲区路径对比")
+    void compareStringAndDirectPaths() {
+        for (String username : BENCH_USERS) {
+            long userId = benchUserId(username);
+            Assumptions.assumeTrue(userId > 0, "缺少测试用户" + username + "，请先执行 generate_direct_buffer_benchmark_orders.sql");
+
+            String viaString = EmshopNativeInterface.getOrderList(userId);
+            String viaDirect = readDirect(userId);
+            assertTrue(TestUtils.isSuccess(viaString), "String路径失败: " + viaString);
+            assertEquals(TestUtils.parseResponse(viaString), TestUtils.parseResponse(viaDirect), "两条路径返回的JSON不一致");
+            int bytes = viaString.getBytes(StandardCharsets.UTF_8).length;
+
+            double stringMicros = measure(() -> EmshopNativeInterface.getOrderList(userId));
+            double directMicros = measure(() -> readDirect(userId));
+            System.out.printf("%-18s %9d 字节: String %10.1f us (%7.1f MB/s), Direct %10.1f us (%7.1f MB/s), 差 %+.1f%%%n",
+                username, bytes,
+                stringMicros, bytes / stringMicros,
+                directMicros, bytes / directMicros,
+                100.0 * (directMicros - stringMicros) / stringMicros);
+        }
+    }
+
+    /**
+     * 与EmshopNettyServer.readDirectResponse相同：解码为String后归还缓冲区
+     */
+    private String readDirect(long userId) {
+        ByteBuffer buffer = EmshopNativeInterface.getOrderListDirect(target, userId);
+        assertNotNull(buffer, "直接缓冲区接口返回null");
+        try {
+            return StandardCharsets.UTF_8.decode(buffer).toString();
+        } finally {
+            EmshopNativeInterface.releaseDirectBuffer(buffer);
+        }
+    }
+
+    /**
+     * 预热后在RUN_SECONDS内反复调用，返回单次平均微秒数
+     */
+    private static double measure(Call call) {
+        for (int i = 0; i < WARMUP_CALLS; i++) {
+            call.run();
+        }
+        long calls = 0;
+        long start = System.nanoTime();
+        long end = start + RUN_SECONDS * 1_000_000_000L;
+        long now;
+        do {
+            assertNotNull(call.run());
+            calls++;
+            now = System.nanoTime();
+        } while (now < end);
+        return (now - start) / 1000.0 / calls;
+    }
+
+    private static long benchUserId(String username) {
+        JsonNode rows = TestUtils.parseResponse(EmshopNativeInterface.executeSelectQuery(
+            "SELECT user_id FROM users WHERE username = '" + username + "'", "{}")).path("rows");
+        return rows.size() > 0 ? Long.parseLong(rows.get(0).path("user_id").asText()) : -1;
+    }
+
+    @FunctionalInterface
+    private interface Call {
+        String run();
+    }
+}
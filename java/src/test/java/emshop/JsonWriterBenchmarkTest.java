@@ -0,0 +1,47 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 结果集JSON序列化微基准测试
+ * 通过 runNativeBenchmark("json_writer") 把同一个商品列表结果集(查询一次，缓存在客户端)反复序列化成完整响应：
+ *   dom: 原来的做法，parseResultSet逐个单元格构建nlohmann::json，再整体dump()
+ *   json_writer: JsonWriter直接从MYSQL_ROW写出最终文本，列名每个结果集只转义一次，缓冲区复用
+ * 不含数据库往返，只比较序列化本身；对10/100/1000行分别输出单次延迟、吞吐和MB/s，并检查两条路径的data一致
+ * 需要JNI库和可用的数据库(1000行的一档需要至少1000个在售商品，不足时按实际行数)，库加载失败时跳过；
+ * 属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class JsonWriterBenchmarkTest {
+
+    private static final int[] ROWS = {10, 100, 1000};
+    private static final int RUN_MILLIS = 3000;
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("JSON序列化基准测试");
+    }
+
+    @Test
+    @DisplayName("商品列表结果集: JsonWriter与DOM序列化对比")
+    void compareJsonWriterAndDom() {
+        for (int rows : ROWS) {
+            JsonNode response = TestUtils.parseResponse(EmshopNativeInterface.runNativeBenchmark("json_writer",
+                "{\"rows\":" + rows + ",\"duration_ms\":" + RUN_MILLIS + "}"));
+            Assumptions.assumeTrue(response.path("success").asBoolean(false), "基准测试未运行: " + response);
+            JsonNode data = response.path("data");
+            assertTrue(data.path("outputs_match").asBoolean(false), "两条路径序列化出的data不一致");
+
+            for (JsonNode result : data.path("results")) {
+                System.out.printf("%-11s %4d 行 %8d 字节: 平均 %8.1f us, p99 %6d us, %9.0f 次/秒, %7.1f MB/s%n",
+                    result.path("mode").asText(), data.path("rows").asInt(), result.path("bytes").asLong(),
+                    result.path("avg_us").asDouble(), result.path("p99_us").asLong(),
+                    result.path("qps").asDouble(), result.path("mb_per_second").asDouble());
+            }
+            System.out.printf("JsonWriter/DOM 吞吐比 %.2f%n", data.path("qps_ratio").asDouble());
+        }
+    }
+}
@@ -0,0 +1,132 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicInteger;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 本地异步请求负载测试
+ * 固定数量的Java线程分别以同步JNI调用和submitCommand异步提交执行同一批请求，
+ * 比较同时在途的请求数和吞吐：同步方式在途请求数不会超过Java线程数，
+ * 异步方式由本地执行器承载，在途请求数只受本地排队上限约束
+ * 准入控制拒绝的系统繁忙(1006)响应单独计数，不算作失败
+ * 需要JNI库和可用的数据库，库加载失败时跳过；属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+@TestMethodOrder(MethodOrderer.OrderAnnotation.class)
+public class NativeAsyncLoadTest {
+
+    private static final int ERROR_SYSTEM_BUSY = 1006;
+    private static final int JAVA_THREADS = 4;
+    private static final int REQUESTS = 400;
+
+    private static long syncMillis;
+    private static int syncPeakInFlight;
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("负载测试");
+        assertTrue(NativeAsyncDispatcher.getInstance().register(), "完成处理器注册失败");
+    }
+
+    @Test
+    @Order(1)
+    @DisplayName("同步调用：在途请求数受Java线程数限制")
+    void testSynchronousBaseline() throws Exception {
+        ExecutorService pool = Executors.newFixedThreadPool(JAVA_THREADS);
+        AtomicInteger inFlight = new AtomicInteger();
+        AtomicInteger peak = new AtomicInteger();
+        AtomicInteger failures = new AtomicInteger();
+        AtomicInteger busy = new AtomicInteger();
+        List<Future<?>> futures = new ArrayList<>();
+
+        long start = System.nanoTime();
+        for (int i = 0; i < REQUESTS; i++) {
+            futures.add(pool.submit(() -> {
+                peak.accumulateAndGet(inFlight.incrementAndGet(), Math::max);
+                try {
+                    countFailure(EmshopNativeInterface.getProductList("all", 1, 20), busy, failures);
+                } finally {
+                    inFlight.decrementAndGet();
+                }
+            }));
+        }
+        for (Future<?> future : futures) {
+            future.get(60, TimeUnit.SECONDS);
+        }
+        syncMillis = TimeUnit.NANOSECONDS.toMillis(System.nanoTime() - start);
+        syncPeakInFlight = peak.get();
+        pool.shutdown();
+
+        System.out.printf("同步: %d 请求, %d ms, 峰值在途 %d, 系统繁忙 %d%n", REQUESTS, syncMillis, syncPeakInFlight, busy.get());
+        assertEquals(0, failures.get(), "同步请求出现失败");
+        assertTrue(syncPeakInFlight <= JAVA_THREADS);
+    }
+
+    @Test
+    @Order(2)
+    @DisplayName("异步提交：相同Java线程数下承载更多在途请求")
+    void testAsynchronousCapacity() throws Exception {
+        ExecutorService pool = Executors.newFixedThreadPool(JAVA_THREADS);
+        NativeAsyncDispatcher dispatcher = NativeAsyncDispatcher.getInstance();
+        AtomicInteger peak = new AtomicInteger();
+        AtomicInteger failures = new AtomicInteger();
+        AtomicInteger busy = new AtomicInteger();
+        AtomicInteger fallbacks = new AtomicInteger();
+        List<CompletableFuture<String>> responses = new CopyOnWriteArrayList<>();
+        String params = "{\"category\":\"all\",\"page\":1,\"page_size\":20}";
+
+        long start = System.nanoTime();
+        List<Future<?>> submitters = new ArrayList<>();
+        for (int t = 0; t < JAVA_THREADS; t++) {
+            submitters.add(pool.submit(() -> {
+                for (int i = 0; i < REQUESTS / JAVA_THREADS; i++) {
+                    CompletableFuture<String> future = dispatcher.submit("getProductList", params);
+                    if (future == null) {
+                        // 本地队列已满，按服务器的做法退回同步调用
+                        fallbacks.incrementAndGet();
+                        future = CompletableFuture.completedFuture(EmshopNativeInterface.getProductList("all", 1, 20));
+                    }
+                    responses.add(future);
+                    peak.accumulateAndGet(dispatcher.pendingCount(), Math::max);
+                }
+            }));
+        }
+        for (Future<?> submitter : submitters) {
+            submitter.get(60, TimeUnit.SECONDS);
+        }
+        for (CompletableFuture<String> future : responses) {
+            countFailure(future.get(60, TimeUnit.SECONDS), busy, failures);
+        }
+        long asyncMillis = TimeUnit.NANOSECONDS.toMillis(System.nanoTime() - start);
+        pool.shutdown();
+
+        System.out.printf("异步: %d 请求, %d ms, 峰值在途 %d, 退回同步 %d, 系统繁忙 %d (同步基线 %d ms, 峰值在途 %d)%n",
+            REQUESTS, asyncMillis, peak.get(), fallbacks.get(), busy.get(), syncMillis, syncPeakInFlight);
+        assertEquals(REQUESTS, responses.size());
+        assertEquals(0, failures.get(), "异步请求出现失败");
+        assertTrue(peak.get() > JAVA_THREADS, "异步在途请求数应超过Java线程数");
+        assertEquals(0, dispatcher.pendingCount(), "所有异步请求都应完成");
+    }
+
+    /**
+     * 失败的响应按系统繁忙和其他失败分别计数
+     */
+    private static void countFailure(String response, AtomicInteger busy, AtomicInteger failures) {
+        JsonNode node = TestUtils.parseResponse(response);
+        if (node.path("success").asBoolean(false)) {
+            return;
+        }
+        if (node.path("error_code").asInt() == ERROR_SYSTEM_BUSY) {
+            busy.incrementAndGet();
+        } else {
+            failures.incrementAndGet();
+        }
+    }
+}
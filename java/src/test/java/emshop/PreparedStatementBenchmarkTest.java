@@ -0,0 +1,48 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 预处理语句与文本协议的对比基准测试
+ * 通过 runNativeBenchmark("prepared_vs_text") 在本地代码内对同一条按主键的商品点查询分别测量：
+ *   文本协议: 每次拼接SQL，由服务器解析后执行(引入预处理语句缓存之前的做法)
+ *   预处理语句: 每条连接缓存语句句柄，只传参数
+ * 两种实现各预热后在相同线程数下跑RUN_MILLIS毫秒，输出吞吐和 p50/p99 延迟，测量期间预处理语句应几乎全部命中缓存
+ * 需要JNI库和可用的数据库(至少有一个在售商品)，库加载失败时跳过；属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class PreparedStatementBenchmarkTest {
+
+    private static final int[] THREADS = {1, 16, 64};
+    private static final int RUN_MILLIS = 5000;
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("预处理语句基准测试");
+    }
+
+    @Test
+    @DisplayName("商品点查询: 预处理语句与文本协议的QPS和延迟对比")
+    void comparePreparedAndTextProtocol() {
+        for (int threads : THREADS) {
+            JsonNode response = TestUtils.parseResponse(EmshopNativeInterface.runNativeBenchmark("prepared_vs_text",
+                "{\"threads\":" + threads + ",\"duration_ms\":" + RUN_MILLIS + "}"));
+            Assumptions.assumeTrue(response.path("success").asBoolean(false), "基准测试未运行: " + response);
+            JsonNode data = response.path("data");
+
+            for (JsonNode result : data.path("results")) {
+                assertEquals(0, result.path("failures").asLong(), result.path("mode").asText() + " 查询出现失败");
+                System.out.printf("%-8s %3d 线程: %8.0f QPS, p50 %5d us, p99 %6d us%n",
+                    result.path("mode").asText(), threads, result.path("qps").asDouble(),
+                    result.path("p50_us").asLong(), result.path("p99_us").asLong());
+            }
+            JsonNode cache = data.path("statement_cache");
+            System.out.printf("预处理/文本 QPS 比 %.2f, 语句缓存命中 %d, 未命中 %d%n",
+                data.path("qps_ratio").asDouble(), cache.path("hits").asLong(), cache.path("misses").asLong());
+            assertTrue(cache.path("hits").asLong() > cache.path("misses").asLong(), "测量期间语句缓存应以命中为主");
+        }
+    }
+}
@@ -0,0 +1,108 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import java.util.ArrayList;
+import java.util.Collections;
+import java.util.List;
+import java.util.concurrent.*;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 商品搜索基准测试
+ * 先用 cpp/generate_search_benchmark_products.sql 生成100万个商品，再运行本测试：
+ * 1. 索引在后台构建期间，搜索走SQL LIKE兜底，记录这段时间的单次延迟
+ * 2. 轮询缓存统计直到索引加载完成，输出构建耗时和文档数
+ * 3. 多线程按关键字搜索，输出索引路径的吞吐和 p50/p99 延迟
+ * 需要JNI库和可用的数据库，库加载失败或商品数不足时跳过；属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class ProductSearchBenchmarkTest {
+
+    private static final int MIN_DOCUMENTS = 1_000_000;
+    private static final int THREADS = 32;
+    private static final int RUN_SECONDS = 10;
+    private static final int INDEX_WAIT_SECONDS = 600;
+    private static final String[] KEYWORDS = {"手机", "蓝牙耳机", "笔记本电脑", "华为", "pro", "降噪 耳机", "运动鞋 李宁", "max"};
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("商品搜索基准测试");
+    }
+
+    @Test
+    @DisplayName("百万商品目录下的关键字搜索")
+    void searchOnMillionProductCatalog() throws Exception {
+        // 第一次搜索触发后台构建，构建期间的请求走SQL兜底，不应被阻塞
+        List<Long> fallbackMicros = new ArrayList<>();
+        long buildStart = System.nanoTime();
+        for (String keyword : KEYWORDS) {
+            long start = System.nanoTime();
+            assertTrue(TestUtils.isSuccess(search(keyword)), "搜索失败: " + keyword);
+            fallbackMicros.add((System.nanoTime() - start) / 1000);
+        }
+
+        JsonNode index = searchIndexStats();
+        long deadline = System.nanoTime() + TimeUnit.SECONDS.toNanos(INDEX_WAIT_SECONDS);
+        while (!index.path("loaded").asBoolean() && System.nanoTime() < deadline) {
+            Thread.sleep(200);
+            index = searchIndexStats();
+        }
+        assertTrue(index.path("loaded").asBoolean(), "搜索索引在" + INDEX_WAIT_SECONDS + "秒内没有加载完成");
+        long documents = index.path("documents").asLong();
+        Assumptions.assumeTrue(documents >= MIN_DOCUMENTS,
+            "索引只有" + documents + "个商品，请先执行 generate_search_benchmark_products.sql");
+
+        System.out.printf("索引构建: %d 个文档, %d 个词项, 约 %.1f 秒; 构建期间SQL兜底 p50 %d us, 最大 %d us%n",
+            documents, index.path("terms").asLong(),
+            (System.nanoTime() - buildStart) / 1e9,
+            percentile(fallbackMicros, 50), percentile(fallbackMicros, 100));
+
+        ExecutorService pool = Executors.newFixedThreadPool(THREADS);
+        List<Future<List<Long>>> futures = new ArrayList<>();
+        long end = System.nanoTime() + TimeUnit.SECONDS.toNanos(RUN_SECONDS);
+        for (int t = 0; t < THREADS; t++) {
+            int offset = t;
+            futures.add(pool.submit(() -> {
+                List<Long> micros = new ArrayList<>();
+                for (int i = offset; System.nanoTime() < end; i++) {
+                    long start = System.nanoTime();
+                    String response = search(KEYWORDS[i % KEYWORDS.length]);
+                    micros.add((System.nanoTime() - start) / 1000);
+                    assertTrue(TestUtils.isSuccess(response), "搜索失败: " + response);
+                }
+                return micros;
+            }));
+        }
+        pool.shutdown();
+        assertTrue(pool.awaitTermination(RUN_SECONDS + 60, TimeUnit.SECONDS));
+
+        List<Long> latencies = new ArrayList<>();
+        for (Future<List<Long>> future : futures) {
+            latencies.addAll(future.get());
+        }
+        System.out.printf("索引搜索: %d 线程, %d 次, %.0f req/s, p50 %d us, p99 %d us%n",
+            THREADS, latencies.size(), latencies.size() / (double) RUN_SECONDS,
+            percentile(latencies, 50), percentile(latencies, 99));
+    }
+
+    private static String search(String keyword) {
+        return EmshopNativeInterface.searchProducts(keyword, 1, 20, "relevance", -1, -1);
+    }
+
+    private static JsonNode searchIndexStats() {
+        return TestUtils.parseResponse(EmshopNativeInterface.getCacheStats()).path("cache_stats").path("search_index");
+    }
+
+    private static long percentile(List<Long> values, int p) {
+        if (values.isEmpty()) {
+            return 0;
+        }
+        List<Long> sorted = new ArrayList<>(values);
+        Collections.sort(sorted);
+        int index = (int) Math.ceil(p / 100.0 * sorted.size()) - 1;
+        return sorted.get(Math.max(0, Math.min(index, sorted.size() - 1)));
+    }
+}
@@ -0,0 +1,103 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicLong;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 请求合并热点基准测试
+ * 大量线程反复查询少数几个热点商品的库存和有效促销列表，模拟秒杀时的读流量，
+ * 输出吞吐和各合并点的计数：实际执行数应远小于调用数，被合并的调用数大于0
+ * 需要JNI库和可用的数据库，库加载失败时跳过；属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class SingleFlightHotKeyTest {
+
+    private static final int THREADS = 64;
+    private static final int RUN_SECONDS = 5;
+    private static final int HOT_PRODUCTS = 4;
+
+    private static final List<Long> hotProductIds = new ArrayList<>();
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("请求合并基准测试");
+
+        JsonNode products = TestUtils.parseResponse(EmshopNativeInterface.getProductList("all", 1, HOT_PRODUCTS)).path("data").path("products");
+        for (JsonNode product : products) {
+            hotProductIds.add(product.path("product_id").asLong());
+        }
+        Assumptions.assumeFalse(hotProductIds.isEmpty(), "数据库中没有商品，跳过请求合并基准测试");
+    }
+
+    @Test
+    @DisplayName("热点商品库存查询被合并")
+    void hotStockReadsAreCoalesced() throws Exception {
+        JsonNode before = singleFlightStats().path("product_by_id");
+        long calls = runHotLoop(i -> EmshopNativeInterface.checkStock(hotProductIds.get(i % hotProductIds.size())));
+        JsonNode after = singleFlightStats().path("product_by_id");
+
+        long executions = after.path("executions").asLong() - before.path("executions").asLong();
+        long coalesced = after.path("coalesced").asLong() - before.path("coalesced").asLong();
+        System.out.printf("库存查询: %d 次调用, %.0f req/s, 数据库执行 %d, 合并 %d%n",
+            calls, calls / (double) RUN_SECONDS, executions, coalesced);
+        assertTrue(coalesced > 0, "热点库存查询没有被合并");
+        assertTrue(executions < calls, "数据库执行次数应少于调用次数");
+    }
+
+    @Test
+    @DisplayName("有效促销列表在并发和复用时间内共享结果")
+    void activePromotionsAreShared() throws Exception {
+        JsonNode before = singleFlightStats().path("active_promotions");
+        long calls = runHotLoop(i -> EmshopNativeInterface.getActivePromotions());
+        JsonNode after = singleFlightStats().path("active_promotions");
+
+        long executions = after.path("executions").asLong() - before.path("executions").asLong();
+        long shared = after.path("coalesced").asLong() - before.path("coalesced").asLong()
+            + after.path("ttl_hits").asLong() - before.path("ttl_hits").asLong();
+        System.out.printf("促销列表: %d 次调用, %.0f req/s, 数据库执行 %d, 共享 %d%n",
+            calls, calls / (double) RUN_SECONDS, executions, shared);
+        assertTrue(shared > 0, "促销列表查询没有共享结果");
+    }
+
+    /**
+     * THREADS个线程在RUN_SECONDS内反复调用call，返回成功的调用数
+     */
+    private long runHotLoop(IntFunction call) throws Exception {
+        ExecutorService pool = Executors.newFixedThreadPool(THREADS);
+        AtomicLong completed = new AtomicLong();
+        AtomicLong failed = new AtomicLong();
+        long end = System.nanoTime() + TimeUnit.SECONDS.toNanos(RUN_SECONDS);
+        for (int t = 0; t < THREADS; t++) {
+            int offset = t;
+            pool.submit(() -> {
+                for (int i = offset; System.nanoTime() < end; i++) {
+                    if (TestUtils.isSuccess(call.apply(i))) {
+                        completed.incrementAndGet();
+                    } else {
+                        failed.incrementAndGet();
+                    }
+                }
+            });
+        }
+        pool.shutdown();
+        assertTrue(pool.awaitTermination(RUN_SECONDS + 30, TimeUnit.SECONDS));
+        assertEquals(0, failed.get(), "热点查询出现失败");
+        return completed.get();
+    }
+
+    private static JsonNode singleFlightStats() {
+        return TestUtils.parseResponse(EmshopNativeInterface.getSystemMetrics()).path("metrics").path("single_flight");
+    }
+
+    @FunctionalInterface
+    private interface IntFunction {
+        String apply(int i);
+    }
+}
@@ -0,0 +1,175 @@
+package emshop;
+
+import com.fasterxml.jackson.databind.JsonNode;
+import org.junit.jupiter.api.*;
+
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.*;
+import java.util.concurrent.atomic.AtomicLong;
+
+import static org.junit.jupiter.api.Assertions.*;
+
+/**
+ * 热点商品库存超卖压力测试
+ * 新建一个测试商品，用数百个线程同时争抢它的库存：
+ * 1. 扣减路径: 每个线程循环 updateStock(subtract, 1)，直到库存不足
+ * 2. 预留路径: 先创建多于库存的待支付订单，再由同样多的线程同时支付，支付时整单预留库存
+ * 两条路径都要求成功次数恰好等于初始库存、最终库存为0且不为负，并输出吞吐
+ * 会在测试库中留下测试商品、用户和订单；需要JNI库和可用的数据库，库加载失败时跳过；
+ * 属于load分组，用 mvn test -Pload-test 运行
+ */
+@Tag("load")
+public class StockOversellStressTest {
+
+    private static final int ERROR_SYSTEM_BUSY = 1006;
+    private static final int THREADS = 256;
+    private static final int DECREMENT_STOCK = 1000;
+    private static final int RESERVE_STOCK = 100;
+    private static final int RESERVE_ORDERS = 300;
+    private static final int BUYERS = 8;
+
+    private static long productId;
+
+    @BeforeAll
+    static void setUp() {
+        TestUtils.assumeNativeService("库存超卖压力测试");
+
+        String runId = Long.toString(System.currentTimeMillis() % 1_000_000_000L);
+        JsonNode product = TestUtils.parseResponse(EmshopNativeInterface.addProduct(
+            "{\"name\":\"超卖压力测试商品" + runId + "\",\"description\":\"压力测试\",\"price\":1.0,"
+                + "\"stock\":0,\"category_id\":1}"));
+        productId = product.path("data").path("product_id").asLong();
+        Assumptions.assumeTrue(productId > 0, "创建测试商品失败，跳过库存超卖压力测试: " + product);
+    }
+
+    @Test
+    @DisplayName("数百线程扣减同一商品库存不超卖")
+    void concurrentDecrementsNeverOversell() throws Exception {
+        setStock(DECREMENT_STOCK);
+
+        AtomicLong succeeded = new AtomicLong();
+        AtomicLong busy = new AtomicLong();
+        AtomicLong failed = new AtomicLong();
+        long elapsed = runConcurrently(THREADS, t -> {
+            while (true) {
+                JsonNode result = TestUtils.parseResponse(EmshopNativeInterface.updateStock(productId, 1, "subtract"));
+                if (result.path("success").asBoolean(false)) {
+                    succeeded.incrementAndGet();
+                } else if (result.path("error_code").asInt() == ERROR_SYSTEM_BUSY) {
+                    busy.incrementAndGet();
+                } else if (result.path("message").asText().contains("库存不足")) {
+                    return;
+                } else {
+                    failed.incrementAndGet();
+                    return;
+                }
+            }
+        });
+
+        System.out.printf("扣减: %d 线程, 成功 %d, 系统繁忙重试 %d, %.0f 次/秒%n",
+            THREADS, succeeded.get(), busy.get(), succeeded.get() / (elapsed / 1e9));
+        assertEquals(0, failed.get(), "库存扣减出现非库存不足的失败");
+        assertEquals(DECREMENT_STOCK, succeeded.get(), "成功扣减次数应等于初始库存");
+        assertEquals(0, currentStock(), "库存应恰好扣完");
+    }
+
+    @Test
+    @DisplayName("数百线程同时支付同一商品的订单不超卖")
+    void concurrentPaymentReservationsNeverOversell() throws Exception {
+        // 下单不扣减库存，先在库存充足时创建全部订单，再把库存降到RESERVE_STOCK
+        setStock(RESERVE_ORDERS);
+        String runId = Long.toString(System.currentTimeMillis() % 1_000_000_000L);
+        List<long[]> orders = new ArrayList<>();  // {订单ID, 金额(分)}
+        for (int b = 0; b < BUYERS; b++) {
+            long userId = TestUtils.registerBenchmarkUser("bench_stock_" + runId + "_" + b);
+            Assumptions.assumeTrue(userId > 0, "创建测试用户失败，跳过库存超卖压力测试");
+            long addressId = TestUtils.parseResponse(EmshopNativeInterface.addUserAddress(userId, "压力测试",
+                TestUtils.randomPhone(), "吉林省", "长春市", "朝阳区", "前进大街2699号", "130012", true))
+                .path("data").path("address_id").asLong();
+            Assumptions.assumeTrue(addressId > 0, "创建测试地址失败，跳过库存超卖压力测试");
+            for (int i = b; i < RESERVE_ORDERS; i += BUYERS) {
+                JsonNode order = TestUtils.parseResponse(EmshopNativeInterface.createOrderDirect(
+                    userId, productId, 1, addressId, null, "oversell stress"));
+                assertTrue(order.path("success").asBoolean(false), "创建订单失败: " + order);
+                orders.add(new long[] {order.path("data").path("order_id").asLong(),
+                    Math.round(order.path("data").path("final_amount").asDouble() * 100)});
+            }
+        }
+        setStock(RESERVE_STOCK);
+
+        AtomicLong paid = new AtomicLong();
+        AtomicLong rejected = new AtomicLong();
+        AtomicLong failed = new AtomicLong();
+        long elapsed = runConcurrently(orders.size(), t -> {
+            long[] order = orders.get(t);
+            while (true) {
+                JsonNode result = TestUtils.parseResponse(
+                    EmshopNativeInterface.processPayment(order[0], "alipay", order[1] / 100.0, "{}"));
+                if (result.path("success").asBoolean(false)) {
+                    paid.incrementAndGet();
+                } else if (result.path("error_code").asInt() == ERROR_SYSTEM_BUSY) {
+                    continue;
+                } else if (result.path("message").asText().contains("库存不足")) {
+                    rejected.incrementAndGet();
+                } else {
+                    failed.incrementAndGet();
+                }
+                return;
+            }
+        });
+
+        System.out.printf("支付预留: %d 个并发支付, 成功 %d, 库存不足 %d, 其他失败 %d, 耗时 %.1f ms%n",
+            orders.size(), paid.get(), rejected.get(), failed.get(), elapsed / 1e6);
+        assertEquals(0, failed.get(), "支付出现非库存不足的失败");
+        assertEquals(RESERVE_STOCK, paid.get(), "支付成功数应等于初始库存");
+        assertEquals(0, currentStock(), "库存应恰好扣完");
+    }
+
+    /**
+     * threads个线程同时开始执行task(参数为线程序号)，返回全部结束用的纳秒数
+     */
+    private static long runConcurrently(int threads, IntTask task) throws Exception {
+        ExecutorService pool = Executors.newFixedThreadPool(threads);
+        CountDownLatch start = new CountDownLatch(1);
+        List<Future<?>> futures = new ArrayList<>();
+        for (int t = 0; t < threads; t++) {
+            int index = t;
+            futures.add(pool.submit(() -> {
+                start.await();
+                task.run(index);
+                return null;
+            }));
+        }
+        long begin = System.nanoTime();
+        start.countDown();
+        for (Future<?> future : futures) {
+            future.get(120, TimeUnit.SECONDS);
+        }
+        long elapsed = System.nanoTime() - begin;
+        pool.shutdown();
+        return elapsed;
+    }
+
+    private static void setStock(int stock) {
+        String result = EmshopNativeInterface.updateStock(productId, stock, "set");
+        assertTrue(TestUtils.isSuccess(result), "设置库存失败: " + result);
+    }
+
+    /**
+     * 绕过商品缓存，直接从主库读取库存
+     */
+    private static int currentStock() {
+        JsonNode rows = TestUtils.parseResponse(EmshopNativeInterface.executeSelectQuery(
+            "SELECT stock_quantity FROM products WHERE product_id = " + productId, "{}")).path("rows");
+        assertEquals(1, rows.size(), "查询库存失败");
+        int stock = Integer.parseInt(rows.get(0).path("stock_quantity").asText());
+        assertTrue(stock >= 0, "库存为负: " + stock);
+        return stock;
+    }
+
+    @FunctionalInterface
+    private interface IntTask {
+        void run(int index);
+    }
+}
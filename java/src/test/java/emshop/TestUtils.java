@@ -3,6 +3,8 @@ package emshop;
 import com.fasterxml.jackson.databind.JsonNode;
 import com.fasterxml.jackson.databind.ObjectMapper;
 
+import org.junit.jupiter.api.Assumptions;
+
 import java.io.InputStream;
 import java.nio.charset.StandardCharsets;
 
@@ -80,6 +82,54 @@ public class TestUtils {
         return objectMapper.readTree(json);
     }
     
+    /**
+     * 加载JNI库并初始化本地服务，库不可用或初始化失败时跳过当前测试类
+     * 供需要真实本地服务的负载/基准测试在@BeforeAll中调用
+     * @param testName 测试名称，用于跳过提示
+     */
+    public static void assumeNativeService(String testName) {
+        try {
+            System.loadLibrary("emshop_native_oop");
+        } catch (UnsatisfiedLinkError e) {
+            Assumptions.assumeTrue(false, "JNI库不可用，跳过" + testName + ": " + e.getMessage());
+        }
+        String init = EmshopNativeInterface.initializeService();
+        Assumptions.assumeTrue(init.contains("\"success\":true"), "本地服务初始化失败，跳过" + testName);
+    }
+    
+    /**
+     * 注册基准测试用户，用户名已存在时改为登录，供需要大量真实用户的负载/基准测试使用
+     * @param username 用户名(字母、数字、下划线)
+     * @return 用户ID，注册和登录都失败时返回-1
+     */
+    public static long registerBenchmarkUser(String username) {
+        String password = "bench_" + username.length() + "_pass";
+        JsonNode registered = parseResponse(EmshopNativeInterface.register(username, password, ""));
+        if (registered.path("success").asBoolean(false)) {
+            return registered.path("data").path("user_id").asLong(-1);
+        }
+        JsonNode login = parseResponse(EmshopNativeInterface.login(username, password));
+        return login.path("success").asBoolean(false) ? login.path("data").path("user_id").asLong(-1) : -1;
+    }
+    
+    /**
+     * 解析本地接口返回的JSON，解析失败时返回空对象
+     */
+    public static JsonNode parseResponse(String response) {
+        try {
+            return objectMapper.readTree(response);
+        } catch (Exception e) {
+            return objectMapper.createObjectNode();
+        }
+    }
+    
+    /**
+     * 本地接口响应是否成功
+     */
+    public static boolean isSuccess(String response) {
+        return parseResponse(response).path("success").asBoolean(false);
+    }
+    
     /**
      * 对象转JSON字符串
      */
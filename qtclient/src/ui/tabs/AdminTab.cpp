@@ -399,6 +399,8 @@ void AdminTab::setupUi()
     m_startDate = new QDateEdit(QDate::currentDate().addMonths(-1), ordersPage); m_startDate->setCalendarPopup(true);
     m_endDate = new QDateEdit(QDate::currentDate(), ordersPage); m_endDate->setCalendarPopup(true);
     m_page = new QSpinBox(ordersPage); m_page->setRange(1, 100000); m_page->setValue(1);
+    // 订单按游标翻页，页码只作显示，不能直接跳页
+    m_page->setReadOnly(true); m_page->setButtonSymbols(QAbstractSpinBox::NoButtons);
     m_pageSize = new QSpinBox(ordersPage); m_pageSize->setRange(1, 500); m_pageSize->setValue(20);
     auto *ordersRefresh = new QPushButton(tr("刷新订单"), ordersPage);
     m_prevPage = new QPushButton(tr("上一页"), ordersPage);
@@ -538,6 +540,11 @@ void AdminTab::setupUi()
     connect(ordersRefresh, &QPushButton::clicked, this, &AdminTab::refreshAllOrders);
     connect(m_prevPage, &QPushButton::clicked, this, &AdminTab::prevPage);
     connect(m_nextPage, &QPushButton::clicked, this, &AdminTab::nextPage);
+    // 筛选条件变化后旧游标失效，回到第一页
+    connect(m_orderStatus, &QComboBox::currentIndexChanged, this, [this](int){ resetOrderCursor(); });
+    connect(m_startDate, &QDateEdit::dateChanged, this, [this](const QDate &){ resetOrderCursor(); });
+    connect(m_endDate, &QDateEdit::dateChanged, this, [this](const QDate &){ resetOrderCursor(); });
+    connect(m_pageSize, qOverload<int>(&QSpinBox::valueChanged), this, [this](int){ resetOrderCursor(); });
     connect(promoRefresh, &QPushButton::clicked, this, &AdminTab::refreshPromotions);
     connect(m_promoCreateBtn, &QPushButton::clicked, this, &AdminTab::createPromotion);
 
@@ -932,15 +939,21 @@ void AdminTab::refreshAllOrders()
     const int pageSize = m_pageSize->value();
     const QString s = m_startDate->date().toString("yyyy-MM-dd");
     const QString e = m_endDate->date().toString("yyyy-MM-dd");
-    // 管理员：GET_ALL_ORDERS status page pageSize start end
-    QString cmd = QString("GET_ALL_ORDERS %1 %2 %3 %4 %5")
+    if (m_orderCursors.isEmpty()) m_orderCursors << QString();
+    const QString cursor = m_orderCursors.value(page - 1);
+    // 管理员：GET_ALL_ORDERS_CURSOR status cursor pageSize start end（首页游标为 -）
+    QString cmd = QString("GET_ALL_ORDERS_CURSOR %1 %2 %3 %4 %5")
                       .arg(st.isEmpty()?"all":st)
-                      .arg(page)
+                      .arg(cursor.isEmpty() ? QStringLiteral("-") : cursor)
                       .arg(pageSize)
                       .arg(s)
                       .arg(e);
     sendCommand(cmd,
         [this](const QJsonDocument &doc){
+            const QJsonValue next = JsonUtils::extract(doc, "data.next_cursor");
+            m_nextOrderCursor = next.isString() ? next.toString() : QString();
+            m_nextPage->setEnabled(!m_nextOrderCursor.isEmpty());
+            m_prevPage->setEnabled(m_page->value() > 1);
             QJsonArray arr;
             QJsonValue v = JsonUtils::extract(doc, "data.orders");
             if (v.isArray()) arr = v.toArray();
@@ -1061,7 +1074,21 @@ void AdminTab::refreshAllOrders()
 }
 
 void AdminTab::prevPage(){ if (m_page->value()>1){ m_page->setValue(m_page->value()-1); refreshAllOrders(); } }
-void AdminTab::nextPage(){ m_page->setValue(m_page->value()+1); refreshAllOrders(); }
+void AdminTab::nextPage()
+{
+    if (m_nextOrderCursor.isEmpty()) { emit statusMessage(tr("已经是最后一页"), true); return; }
+    const int page = m_page->value();
+    while (m_orderCursors.size() > page) m_orderCursors.removeLast();
+    m_orderCursors << m_nextOrderCursor;
+    m_page->setValue(page + 1);
+    refreshAllOrders();
+}
+void AdminTab::resetOrderCursor()
+{
+    m_orderCursors = QStringList{QString()};
+    m_nextOrderCursor.clear();
+    m_page->setValue(1);
+}
 
 void AdminTab::changeOrderStatus(qlonglong orderId)
 {
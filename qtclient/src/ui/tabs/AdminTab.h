@@ -4,6 +4,7 @@
 #include <functional>
 #include <QCheckBox>
 #include <QTimer>
+#include <QStringList>
 
 class QTabWidget;
 class QTableWidget;
@@ -40,6 +41,7 @@ private slots:
     void refreshAllOrders();
     void prevPage();
     void nextPage();
+    void resetOrderCursor();
     void changeOrderStatus(qlonglong orderId);
     void viewOrderDetail(qlonglong orderId);
     void refundOrder(qlonglong orderId);
@@ -84,6 +86,8 @@ private:
     QSpinBox *m_pageSize {nullptr};
     QPushButton *m_prevPage {nullptr};
     QPushButton *m_nextPage {nullptr};
+    QStringList m_orderCursors;     // 已访问各页的起始游标，第一页为空串
+    QString m_nextOrderCursor;      // 服务端返回的下一页游标，为空表示已到末页
     // 优惠券/促销
     QTableWidget *m_promotionsTable {nullptr};
     QLineEdit *m_promoName {nullptr};
@@ -538,10 +538,8 @@ void CartTab::handleSessionChanged(const UserSession &session)
 {
     setLoggedIn(session.isValid());
     if (session.isValid()) {
-        refreshCart();
-        refreshAddresses();
         m_couponCount = 0;
-        refreshUserCoupons();
+        refreshSessionData();
         if (m_refreshTimer && !m_refreshTimer->isActive()) {
             m_refreshTimer->start();
         }
@@ -811,6 +809,118 @@ void CartTab::createOrder()
                         });
 }
 
+void CartTab::applyUserCoupons(const QJsonDocument &doc)
+{
+    // 期望数据路径 data.user_coupons / data.list / data.items
+    static const QStringList couponPaths = {
+        QStringLiteral("data.user_coupons"),
+        QStringLiteral("data.userCoupons"),
+        QStringLiteral("data.coupons"),
+        QStringLiteral("data.list"),
+        QStringLiteral("data.items"),
+        QStringLiteral("data"),
+        QStringLiteral("user_coupons"),
+        QStringLiteral("coupons")
+    };
+
+    QJsonArray arr;
+    for (const QString &path : couponPaths) {
+        QJsonValue v = JsonUtils::extract(doc, path);
+        if (v.isArray()) {
+            arr = v.toArray();
+            break;
+        }
+    }
+
+    auto pickString = [](const QJsonObject &obj, std::initializer_list<QString> keys) -> QString {
+        for (const QString &key : keys) {
+            const QJsonValue val = obj.value(key);
+            if (val.isString()) {
+                const QString text = val.toString().trimmed();
+                if (!text.isEmpty()) {
+                    return text;
+                }
+            }
+        }
+        return {};
+    };
+
+    // 重建下拉
+    m_couponCombo->clear();
+    m_couponCombo->addItem(tr("不使用优惠券"), QString());
+    m_couponCount = arr.size();
+    for (const QJsonValue &val : arr) {
+        const QJsonObject o = val.toObject();
+        const QString code = pickString(o, {QStringLiteral("code"), QStringLiteral("coupon_code"), QStringLiteral("couponCode"), QStringLiteral("coupon_id_str")});
+        const QString name = pickString(o, {QStringLiteral("name"), QStringLiteral("title"), QStringLiteral("description")});
+        if (!code.isEmpty()) {
+            const int idx = m_couponCombo->count();
+            const QString display = name.isEmpty() ? code : QStringLiteral("%1 (%2)").arg(name, code);
+            m_couponCombo->addItem(display, code);
+            m_couponCombo->setItemData(idx, QString::fromUtf8(QJsonDocument(o).toJson(QJsonDocument::Compact)), Qt::UserRole + 1);
+        }
+    }
+
+    if (m_couponCount > 0) {
+        emit statusMessage(tr("已同步优惠券 (%1 张)").arg(m_couponCount), true);
+    } else {
+        emit statusMessage(tr("未找到可用优惠券"), true);
+    }
+    updateCouponInfoHint();
+}
+
+void CartTab::refreshSessionData()
+{
+    NetworkClient *client = m_context.networkClient();
+    QPointer<CartTab> guard(this);
+    // 购物车、地址、优惠券合并为一次BATCH请求；服务端不支持或整体失败时退回逐个刷新
+    auto fallback = [this]() {
+        refreshCart();
+        refreshAddresses();
+        refreshUserCoupons();
+    };
+    client->sendCommand(QStringLiteral("BATCH GET_CART VIEW_ADDRESSES GET_USER_COUPONS"),
+                        [this, guard, fallback](const QString &response) {
+                            if (!guard) return;
+                            bool ok = false; QString error;
+                            QJsonDocument doc = JsonUtils::parse(response, &ok, &error);
+                            const QJsonValue results = JsonUtils::extract(doc, QStringLiteral("data.results"));
+                            if (!ok || !JsonUtils::isSuccess(doc) || !results.isArray()) {
+                                fallback();
+                                return;
+                            }
+                            for (const QJsonValue &val : results.toArray()) {
+                                const QJsonObject item = val.toObject();
+                                const QString id = item.value(QStringLiteral("id")).toString();
+                                const QJsonDocument resultDoc(item.value(QStringLiteral("result")).toObject());
+                                const bool itemOk = item.value(QStringLiteral("success")).toBool();
+                                if (id == QLatin1String("GET_CART")) {
+                                    if (itemOk) {
+                                        populateCart(resultDoc);
+                                    } else {
+                                        emit statusMessage(tr("获取购物车失败: %1").arg(JsonUtils::message(resultDoc)), false);
+                                    }
+                                } else if (id == QLatin1String("VIEW_ADDRESSES")) {
+                                    if (itemOk) {
+                                        populateAddresses(resultDoc);
+                                    } else {
+                                        emit statusMessage(tr("刷新地址失败: %1").arg(JsonUtils::message(resultDoc)), false);
+                                    }
+                                } else if (id == QLatin1String("GET_USER_COUPONS")) {
+                                    if (itemOk) {
+                                        applyUserCoupons(resultDoc);
+                                    } else {
+                                        refreshUserCoupons();
+                                    }
+                                }
+                            }
+                        },
+                        [guard, fallback](const QString &) {
+                            if (!guard) return;
+                            fallback();
+                        });
+}
+
 void CartTab::refreshUserCoupons()
 {
     if (!m_loggedIn) {
@@ -829,62 +939,7 @@ void CartTab::refreshUserCoupons()
                                 emit statusMessage(tr("刷新优惠券失败: %1").arg(msg.isEmpty() ? response : msg), false);
                                 return;
                             }
-                            // 期望数据路径 data.user_coupons / data.list / data.items
-                            static const QStringList couponPaths = {
-                                QStringLiteral("data.user_coupons"),
-                                QStringLiteral("data.userCoupons"),
-                                QStringLiteral("data.coupons"),
-                                QStringLiteral("data.list"),
-                                QStringLiteral("data.items"),
-                                QStringLiteral("data"),
-                                QStringLiteral("user_coupons"),
-                                QStringLiteral("coupons")
-                            };
-
-                            QJsonArray arr;
-                            for (const QString &path : couponPaths) {
-                                QJsonValue v = JsonUtils::extract(doc, path);
-                                if (v.isArray()) {
-                                    arr = v.toArray();
-                                    break;
-                                }
-                            }
-
-                            auto pickString = [](const QJsonObject &obj, std::initializer_list<QString> keys) -> QString {
-                                for (const QString &key : keys) {
-                                    const QJsonValue val = obj.value(key);
-                                    if (val.isString()) {
-                                        const QString text = val.toString().trimmed();
-                                        if (!text.isEmpty()) {
-                                            return text;
-                                        }
-                                    }
-                                }
-                                return {};
-                            };
-
-                            // 重建下拉
-                            m_couponCombo->clear();
-                            m_couponCombo->addItem(tr("不使用优惠券"), QString());
-                            m_couponCount = arr.size();
-                            for (const QJsonValue &val : arr) {
-                                const QJsonObject o = val.toObject();
-                                const QString code = pickString(o, {QStringLiteral("code"), QStringLiteral("coupon_code"), QStringLiteral("couponCode"), QStringLiteral("coupon_id_str")});
-                                const QString name = pickString(o, {QStringLiteral("name"), QStringLiteral("title"), QStringLiteral("description")});
-                                if (!code.isEmpty()) {
-                                    const int idx = m_couponCombo->count();
-                                    const QString display = name.isEmpty() ? code : QStringLiteral("%1 (%2)").arg(name, code);
-                                    m_couponCombo->addItem(display, code);
-                                    m_couponCombo->setItemData(idx, QString::fromUtf8(QJsonDocument(o).toJson(QJsonDocument::Compact)), Qt::UserRole + 1);
-                                }
-                            }
-
-                            if (m_couponCount > 0) {
-                                emit statusMessage(tr("已同步优惠券 (%1 张)").arg(m_couponCount), true);
-                            } else {
-                                emit statusMessage(tr("未找到可用优惠券"), true);
-                            }
-                            updateCouponInfoHint();
+                            applyUserCoupons(doc);
                         },
                         [this, guard](const QString &error) {
                             if (!guard) return;
@@ -60,6 +60,8 @@ private:
     void populateAddresses(const QJsonDocument &doc);
     qlonglong selectedProductId() const;
     void refreshUserCoupons(); // 新增：刷新用户优惠券
+    void applyUserCoupons(const QJsonDocument &doc);
+    void refreshSessionData();
     QJsonObject selectedCartItem() const;
     AddressRecord currentAddress() const;
     void setLoggedIn(bool loggedIn);